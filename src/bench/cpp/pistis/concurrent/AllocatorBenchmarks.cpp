@@ -0,0 +1,74 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/ArenaAllocator.hpp>
+#include <pistis/concurrent/PoolAllocator.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  // Enough items to make the queue's deque allocate and free several
+  // blocks on each fill and drain
+  static const uint64_t BATCH_SIZE = 4096;
+
+  /** @brief Fill @c q with BATCH_SIZE items and drain it again until
+   *         @c n items have passed through it
+   */
+  template <typename QueueType>
+  void fillAndDrain(QueueType& q, uint64_t n) {
+    uint64_t item = 0;
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+      const uint64_t count = std::min(BATCH_SIZE, n - done);
+      for (uint64_t i = 0; i < count; ++i) {
+	q.put(i);
+      }
+      for (uint64_t i = 0; i < count; ++i) {
+	q.get(item, 0);
+      }
+    }
+  }
+
+  /** @brief Pass @c n items from one thread to another through @c q,
+   *         so blocks are allocated on one thread and freed on the other
+   */
+  template <typename QueueType>
+  void handOff(QueueType& q, uint64_t n) {
+    std::thread consumer([&q, n]() {
+	for (uint64_t i = 0; i < n; ++i) {
+	  q.get();
+	}
+    });
+    for (uint64_t i = 0; i < n; ++i) {
+      q.put(i);
+    }
+    consumer.join();
+  }
+
+  template <typename Allocator>
+  void queueBenchmarks(Session& session, const std::string& allocator) {
+    typedef Queue<uint64_t, Allocator> QueueType;
+    {
+      QueueType q{ Allocator() };
+      session.measure("allocator/queue_fill_drain/" + allocator,
+		      { { "batch", (int64_t)BATCH_SIZE } },
+		      [&](uint64_t n) { fillAndDrain(q, n); });
+    }
+    {
+      QueueType q(BATCH_SIZE, Allocator());
+      session.measure("allocator/queue_hand_off/" + allocator,
+		      { { "max_size", (int64_t)BATCH_SIZE } },
+		      [&](uint64_t n) { handOff(q, n); });
+    }
+  }
+}
+
+PISTIS_BENCHMARK(QueueAllocators) {
+  queueBenchmarks< std::allocator<uint64_t> >(session, "std");
+  queueBenchmarks< PoolAllocator<uint64_t> >(session, "pool");
+  queueBenchmarks< ArenaAllocator<uint64_t> >(session, "arena");
+}
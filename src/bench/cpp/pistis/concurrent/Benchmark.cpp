@@ -0,0 +1,219 @@
+#include "Benchmark.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <time.h>
+
+#ifndef PISTIS_CONCURRENT_VERSION
+#define PISTIS_CONCURRENT_VERSION "unknown"
+#endif
+
+#ifndef PISTIS_CONCURRENT_CONFIGURATION
+#define PISTIS_CONCURRENT_CONFIGURATION "unknown"
+#endif
+
+using namespace pistis::concurrent::bench;
+
+namespace {
+  struct Entry {
+    const char* name;
+    BenchmarkFunction f;
+  };
+
+  std::vector<Entry>& registry() {
+    static std::vector<Entry> entries;
+    return entries;
+  }
+
+  // Stop growing the iteration count here, even if the body is still
+  // faster than the minimum time
+  static const uint64_t MAX_ITERATIONS = (uint64_t)1 << 40;
+
+  std::string quote(const std::string& s) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : s) {
+      if ((c == '"') || (c == '\\')) {
+	out << '\\' << c;
+      } else if ((unsigned char)c < 0x20) {
+	out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+	    << (int)c << std::dec;
+      } else {
+	out << c;
+      }
+    }
+    out << '"';
+    return out.str();
+  }
+
+  std::string label(const std::string& name, const Params& params) {
+    std::ostringstream out;
+    out << name;
+    for (const auto& p : params) {
+      out << ' ' << p.first << '=' << p.second;
+    }
+    return out.str();
+  }
+
+  void writeParams(std::ostream& out, const Params& params) {
+    out << "      \"params\": {";
+    for (size_t j = 0; j < params.size(); ++j) {
+      out << (j ? ", " : " ") << quote(params[j].first) << ": "
+	  << params[j].second;
+    }
+    out << (params.empty() ? "},\n" : " },\n");
+  }
+
+  std::string utcTimestamp() {
+    const time_t now = ::time(nullptr);
+    struct tm t;
+    ::gmtime_r(&now, &t);
+    char buffer[32];
+    ::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &t);
+    return buffer;
+  }
+}
+
+Options::Options():
+    filter(), minSeconds(0.2),
+    maxThreads(std::max((unsigned)2, std::thread::hardware_concurrency())),
+    jsonFile(), numaNodes(0) {
+}
+
+Session::Session(const Options& options):
+    options_(options), measurements_(), latencies_() {
+}
+
+std::vector<size_t> Session::threadCounts() const {
+  std::vector<size_t> counts;
+  for (size_t n = 1; n < options_.maxThreads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(options_.maxThreads);
+  return counts;
+}
+
+bool Session::selected(const std::string& name) const {
+  return options_.filter.empty() ||
+         (name.find(options_.filter) != std::string::npos);
+}
+
+void Session::measure(const std::string& name, const Params& params,
+		      const Body& body) {
+  if (!selected(name)) {
+    return;
+  }
+
+  uint64_t n = 1;
+  double seconds = 0.0;
+  for (;;) {
+    const int64_t start = nowNs();
+    body(n);
+    seconds = (double)(nowNs() - start) * 1e-9;
+
+    if ((seconds >= options_.minSeconds) || (n >= MAX_ITERATIONS)) {
+      break;
+    }
+
+    // Aim a little past the minimum time, growing at least 2x and at
+    // most 100x per round
+    double target = (seconds > 0.0)
+                        ? (double)n * options_.minSeconds * 1.2 / seconds
+                        : (double)n * 100.0;
+    target = std::min(std::max(target, (double)n * 2.0), (double)n * 100.0);
+    n = std::min((uint64_t)target, MAX_ITERATIONS);
+  }
+
+  Measurement m{ name, params, n, seconds };
+  measurements_.push_back(m);
+  report_(m);
+}
+
+void Session::recordLatency(const std::string& name, const Params& params,
+			    const HdrHistogram& ns) {
+  LatencyMeasurement m{ name, params, ns.snapshot() };
+  latencies_.push_back(m);
+  report_(m);
+}
+
+void Session::writeJson(std::ostream& out) const {
+  out << "{\n"
+      << "  \"library\": \"pistis_concurrent\",\n"
+      << "  \"version\": " << quote(PISTIS_CONCURRENT_VERSION) << ",\n"
+      << "  \"configuration\": "
+      << quote(PISTIS_CONCURRENT_CONFIGURATION) << ",\n"
+      << "  \"timestamp\": " << quote(utcTimestamp()) << ",\n"
+      << "  \"hardware_concurrency\": "
+      << std::thread::hardware_concurrency() << ",\n"
+      << "  \"min_seconds\": " << options_.minSeconds << ",\n"
+      << "  \"simulated_numa_nodes\": " << options_.numaNodes << ",\n"
+      << "  \"benchmarks\": [";
+
+  out << std::setprecision(6);
+  for (size_t i = 0; i < measurements_.size(); ++i) {
+    const Measurement& m = measurements_[i];
+    out << (i ? ",\n" : "\n")
+	<< "    {\n"
+	<< "      \"name\": " << quote(m.name) << ",\n";
+    writeParams(out, m.params);
+    out << "      \"iterations\": " << m.iterations << ",\n"
+	<< "      \"seconds\": " << m.seconds << ",\n"
+	<< "      \"ns_per_op\": " << m.nsPerOp() << ",\n"
+	<< "      \"ops_per_second\": " << m.opsPerSecond() << "\n"
+	<< "    }";
+  }
+  out << (measurements_.empty() ? "],\n" : "\n  ],\n")
+      << "  \"latencies\": [";
+
+  for (size_t i = 0; i < latencies_.size(); ++i) {
+    const LatencyMeasurement& m = latencies_[i];
+    out << (i ? ",\n" : "\n")
+	<< "    {\n"
+	<< "      \"name\": " << quote(m.name) << ",\n";
+    writeParams(out, m.params);
+    out << "      \"samples\": " << m.ns.total() << ",\n"
+	<< "      \"mean_ns\": " << m.ns.mean() << ",\n"
+	<< "      \"p50_ns\": " << m.ns.percentile(50) << ",\n"
+	<< "      \"p99_ns\": " << m.ns.percentile(99) << ",\n"
+	<< "      \"p99_9_ns\": " << m.ns.percentile(99.9) << ",\n"
+	<< "      \"max_ns\": " << m.ns.max() << "\n"
+	<< "    }";
+  }
+  out << (latencies_.empty() ? "]\n" : "\n  ]\n") << "}\n";
+}
+
+std::ostream& Session::reportStream_() const {
+  // Keep stdout free for the results when they are written there
+  return (options_.jsonFile == "-") ? std::cerr : std::cout;
+}
+
+void Session::report_(const Measurement& m) const {
+  std::ostream& out = reportStream_();
+  out << std::left << std::setw(60) << label(m.name, m.params) << std::right
+      << std::fixed << std::setprecision(1) << std::setw(14)
+      << m.nsPerOp() << " ns/op" << std::setw(16) << std::setprecision(0)
+      << m.opsPerSecond() << " ops/s" << std::endl;
+  out.unsetf(std::ios::floatfield);
+}
+
+void Session::report_(const LatencyMeasurement& m) const {
+  std::ostream& out = reportStream_();
+  out << std::left << std::setw(60) << label(m.name, m.params) << std::right
+      << " p50 " << std::setw(8) << m.ns.percentile(50)
+      << " p99 " << std::setw(8) << m.ns.percentile(99)
+      << " p99.9 " << std::setw(8) << m.ns.percentile(99.9)
+      << " max " << std::setw(9) << m.ns.max() << " ns ("
+      << m.ns.total() << " samples)" << std::endl;
+}
+
+Registration::Registration(const char* name, BenchmarkFunction f) {
+  registry().push_back(Entry{ name, f });
+}
+
+void pistis::concurrent::bench::runAll(Session& session) {
+  for (const Entry& e : registry()) {
+    e.f(session);
+  }
+}
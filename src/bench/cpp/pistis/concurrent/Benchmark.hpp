@@ -0,0 +1,160 @@
+#ifndef __PISTIS__CONCURRENT__BENCHMARK_HPP__
+#define __PISTIS__CONCURRENT__BENCHMARK_HPP__
+
+#include <pistis/concurrent/HdrHistogram.hpp>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace bench {
+
+      /** @brief Named integer parameters of one measurement, such as
+       *         the number of producer threads
+       */
+      typedef std::vector< std::pair<std::string, int64_t> > Params;
+
+      /** @brief The result of timing one benchmark with one set of
+       *         parameters
+       */
+      struct Measurement {
+	std::string name;
+	Params params;
+	uint64_t iterations;
+	double seconds;
+
+	double nsPerOp() const {
+	  return iterations ? seconds * 1e9 / (double)iterations : 0.0;
+	}
+
+	double opsPerSecond() const {
+	  return (seconds > 0.0) ? (double)iterations / seconds : 0.0;
+	}
+      };
+
+      /** @brief The distribution of latencies, in nanoseconds, recorded
+       *         by one benchmark with one set of parameters
+       */
+      struct LatencyMeasurement {
+	std::string name;
+	Params params;
+	HdrHistogram::Snapshot ns;
+      };
+
+      /** @brief Options from the command line */
+      struct Options {
+	std::string filter;     ///< Run benchmarks whose name contains this
+	double minSeconds;      ///< Time each measurement at least this long
+	size_t maxThreads;      ///< Largest thread count to try
+	std::string jsonFile;   ///< Where to write results; "-" is stdout
+	size_t numaNodes;       ///< Simulate this many nodes, or 0 for none
+
+	Options();
+      };
+
+      /** @brief Runs benchmarks and collects their measurements.
+       *
+       *  measure() calls a function that performs a given number of
+       *  operations, starting with one and growing the count until the
+       *  call takes at least Options::minSeconds, then records the
+       *  last call as one Measurement.  Multithreaded benchmarks divide
+       *  the operations among their threads, so the reported time per
+       *  operation is the reciprocal of the aggregate throughput.
+       */
+      class Session {
+      public:
+	typedef std::function<void (uint64_t)> Body;
+
+      public:
+	Session(const Options& options);
+	Session(const Session&) = delete;
+
+	const Options& options() const { return options_; }
+	const std::vector<Measurement>& measurements() const {
+	  return measurements_;
+	}
+	const std::vector<LatencyMeasurement>& latencies() const {
+	  return latencies_;
+	}
+
+	/** @brief Powers of two from one to Options::maxThreads, plus
+	 *         maxThreads itself if it is not a power of two
+	 */
+	std::vector<size_t> threadCounts() const;
+
+	/** @brief True if benchmarks named @c name should run */
+	bool selected(const std::string& name) const;
+
+	/** @brief Time @c body and record the result under @c name and
+	 *         @c params, if @c name is selected
+	 */
+	void measure(const std::string& name, const Params& params,
+		     const Body& body);
+
+	/** @brief Record a distribution of latencies, in nanoseconds,
+	 *         under @c name and @c params
+	 */
+	void recordLatency(const std::string& name, const Params& params,
+			   const HdrHistogram& ns);
+
+	/** @brief Write every measurement as a JSON document */
+	void writeJson(std::ostream& out) const;
+
+	Session& operator=(const Session&) = delete;
+
+      private:
+	Options options_;
+	std::vector<Measurement> measurements_;
+	std::vector<LatencyMeasurement> latencies_;
+
+	std::ostream& reportStream_() const;
+	void report_(const Measurement& m) const;
+	void report_(const LatencyMeasurement& m) const;
+      };
+
+      /** @brief A benchmark function.  It calls Session::measure() once
+       *         for each set of parameters it covers.
+       */
+      typedef void (*BenchmarkFunction)(Session&);
+
+      /** @brief Adds a benchmark to the global list at static
+       *         initialization time.  Use PISTIS_BENCHMARK instead.
+       */
+      class Registration {
+      public:
+	Registration(const char* name, BenchmarkFunction f);
+      };
+
+      /** @brief Run every registered benchmark in registration order */
+      void runAll(Session& session);
+
+      /** @brief Nanoseconds since an arbitrary epoch, from the steady
+       *         clock
+       */
+      inline int64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+      }
+
+    }
+  }
+}
+
+/** @brief Define a benchmark, in the manner of gtest's TEST.
+ *
+ *  The body receives a Session named @c session.
+ */
+#define PISTIS_BENCHMARK(NAME)						\
+  static void NAME##Benchmark_(::pistis::concurrent::bench::Session&); \
+  static ::pistis::concurrent::bench::Registration			\
+      NAME##Registration_(#NAME, &NAME##Benchmark_);			\
+  static void NAME##Benchmark_(					\
+      ::pistis::concurrent::bench::Session& session)
+
+#endif
@@ -0,0 +1,72 @@
+#include "Benchmark.hpp"
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace pistis::concurrent::bench;
+
+namespace {
+  void usage(const char* program) {
+    std::cerr
+	<< "Usage: " << program << " [options]\n"
+	<< "  --filter=TEXT       Run benchmarks whose name contains TEXT\n"
+	<< "  --min-time=SECONDS  Time each measurement at least this long "
+	<< "(default 0.2)\n"
+	<< "  --max-threads=N     Largest thread count to try (default: "
+	<< "hardware threads)\n"
+	<< "  --json=FILE         Write results as JSON to FILE, or to "
+	<< "stdout if FILE is -\n"
+	<< "  --numa-nodes=N      Run NUMA benchmarks on a simulated "
+	<< "topology of N nodes\n";
+  }
+
+  bool hasPrefix(const char* arg, const char* prefix, const char*& value) {
+    const size_t n = ::strlen(prefix);
+    if (::strncmp(arg, prefix, n)) {
+      return false;
+    }
+    value = arg + n;
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const char* value = nullptr;
+    if (hasPrefix(argv[i], "--filter=", value)) {
+      options.filter = value;
+    } else if (hasPrefix(argv[i], "--min-time=", value)) {
+      options.minSeconds = ::atof(value);
+    } else if (hasPrefix(argv[i], "--max-threads=", value)) {
+      options.maxThreads = (size_t)::atol(value);
+    } else if (hasPrefix(argv[i], "--json=", value)) {
+      options.jsonFile = value;
+    } else if (hasPrefix(argv[i], "--numa-nodes=", value)) {
+      options.numaNodes = (size_t)::atol(value);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if ((options.minSeconds <= 0.0) || !options.maxThreads) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  Session session(options);
+  runAll(session);
+
+  if (options.jsonFile == "-") {
+    session.writeJson(std::cout);
+  } else if (!options.jsonFile.empty()) {
+    std::ofstream out(options.jsonFile);
+    session.writeJson(out);
+    if (!out) {
+      std::cerr << "Failed to write " << options.jsonFile << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <memory>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  // Stays under the usual limit of 1024 open descriptors
+  static const size_t FD_COUNTS[] = { 1, 8, 64, 512 };
+}
+
+/** Measures one EpollSet::wait(0) on a set of semaphores, with either
+ *  one or all of them ready.
+ */
+PISTIS_BENCHMARK(EpollSetWait) {
+  for (size_t numFds : FD_COUNTS) {
+    for (bool allReady : { false, true }) {
+      if (allReady && (numFds == 1)) {
+	continue;
+      }
+
+      std::vector< std::unique_ptr<Semaphore> > semaphores;
+      EpollSet epoll;
+      for (size_t i = 0; i < numFds; ++i) {
+	semaphores.emplace_back(new Semaphore((allReady || !i) ? 1 : 0));
+	epoll.add(semaphores.back()->fd(), EpollEventType::READ);
+      }
+
+      session.measure("epoll_set/wait",
+		      { { "fds", (int64_t)numFds },
+			{ "ready", allReady ? (int64_t)numFds : 1 } },
+		      [&](uint64_t n) {
+			for (uint64_t i = 0; i < n; ++i) {
+			  epoll.wait(0);
+			}
+		      });
+    }
+  }
+}
@@ -0,0 +1,81 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/Executor.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <atomic>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  /** @brief Counts tasks down to zero and wakes the thread waiting for
+   *         them.
+   *
+   *  Semaphore::up() does not touch the semaphore after the write that
+   *  wakes the waiter, so the waiter may destroy it as soon as it
+   *  returns.
+   */
+  class Countdown {
+  public:
+    Countdown(uint64_t n): remaining_(n), done_() { }
+
+    void countDown() {
+      if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+	done_.up();
+      }
+    }
+
+    void wait() { done_.down(); }
+
+  private:
+    std::atomic<uint64_t> remaining_;
+    Semaphore done_;
+  };
+
+  /** @brief Run @c n empty tasks submitted from outside the executor,
+   *         which all pass through its injection queue
+   */
+  void injected(Executor& executor, uint64_t n) {
+    Countdown done(n);
+    for (uint64_t i = 0; i < n; ++i) {
+      executor.execute([&done]() { done.countDown(); });
+    }
+    done.wait();
+  }
+
+  /** @brief Split @c n into two tasks until each covers one leaf, the
+   *         fork-join pattern that work stealing exists for
+   */
+  void split(Executor& executor, Countdown& done, uint64_t n) {
+    while (n > 1) {
+      const uint64_t half = n / 2;
+      executor.execute([&executor, &done, half]() {
+	  split(executor, done, half);
+      });
+      n -= half;
+    }
+    done.countDown();
+  }
+
+  void forkJoin(Executor& executor, uint64_t n) {
+    Countdown done(n);
+    executor.execute([&executor, &done, n]() { split(executor, done, n); });
+    done.wait();
+  }
+}
+
+/** Fine-grained tasks: each task does nothing but decrement a counter,
+ *  so these measure the executor's per-task overhead and how it scales
+ *  with the number of workers.
+ */
+PISTIS_BENCHMARK(ExecutorFineGrainedTasks) {
+  for (size_t workers : session.threadCounts()) {
+    Executor executor(workers);
+    session.measure("executor/injected_tasks",
+		    { { "workers", (int64_t)workers } },
+		    [&](uint64_t n) { injected(executor, n); });
+    session.measure("executor/fork_join_tasks",
+		    { { "workers", (int64_t)workers } },
+		    [&](uint64_t n) { forkJoin(executor, n); });
+  }
+}
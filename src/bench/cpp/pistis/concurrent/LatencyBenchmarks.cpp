@@ -0,0 +1,288 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/HdrHistogram.hpp>
+#include <pistis/concurrent/TscClock.hpp>
+#include <pistis/concurrent/pollable/Condition.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+/** @file
+ *
+ *  Wakeup latency: the time from the moment one thread calls put(),
+ *  up() or notifyOne() to the moment the thread waiting for it runs,
+ *  either in the blocking call or after EpollSet::wait() returns.
+ *
+ *  Each sample is taken with the waiting thread asleep.  The waking
+ *  thread waits for the waiter to announce it is about to wait, gives
+ *  it time to reach the kernel, then stamps the TSC and signals.  The
+ *  waiter stamps the TSC again as soon as it returns.  Runs are
+ *  repeated with the two threads pinned to different CPUs (the same
+ *  CPU on a one-CPU machine) and left to the scheduler.
+ */
+
+namespace {
+  // A TSC value that never occurs, sent to stop the waiting thread
+  static const uint64_t STOP = 0;
+
+  static const uint64_t MIN_SAMPLES = 1000;
+  static const uint64_t MAX_SAMPLES = 1000000;
+
+  // How long the waker pauses so the waiter is asleep when it signals
+  static const std::chrono::microseconds SETTLE_TIME(50);
+
+  /** @brief The first two CPUs this process may run on, or the first
+   *         CPU twice if it may only run on one
+   */
+  std::pair<int, int> chooseCpus() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    std::vector<int> cpus;
+    if (!::sched_getaffinity(0, sizeof(allowed), &allowed)) {
+      for (int i = 0; (i < CPU_SETSIZE) && (cpus.size() < 2); ++i) {
+	if (CPU_ISSET(i, &allowed)) {
+	  cpus.push_back(i);
+	}
+      }
+    }
+    if (cpus.empty()) {
+      cpus.push_back(0);
+    }
+    return std::make_pair(cpus.front(), cpus.back());
+  }
+
+  void pinTo(int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+  }
+
+  /** @brief Take wakeup samples through @c channel for at least the
+   *         session's minimum time, then record them under @c name.
+   *
+   *  A Channel has signal(stamp), which wakes the waiter with a TSC
+   *  stamp, and await(), which waits for and returns the next stamp.
+   */
+  template <typename Channel>
+  void sampleWakeups(Session& session, const std::string& name,
+		     Channel& channel, bool pinned) {
+    HdrHistogram latency;
+    std::atomic<uint64_t> ready(0);
+    const std::pair<int, int> cpus = chooseCpus();
+
+    std::thread waiter([&]() {
+	if (pinned) {
+	  pinTo(cpus.second);
+	}
+	for (uint64_t i = 1; ; ++i) {
+	  ready.store(i, std::memory_order_release);
+	  const uint64_t stamp = channel.await();
+	  const uint64_t now = TscClock::now();
+	  if (stamp == STOP) {
+	    break;
+	  }
+	  latency.record((uint64_t)TscClock::toNs(now - stamp));
+	}
+    });
+
+    std::thread waker([&]() {
+	if (pinned) {
+	  pinTo(cpus.first);
+	}
+	const int64_t end =
+	    nowNs() + (int64_t)(session.options().minSeconds * 1e9);
+	uint64_t n = 0;
+	bool done = false;
+	while (!done) {
+	  ++n;
+	  while (ready.load(std::memory_order_acquire) != n) {
+	    std::this_thread::yield();
+	  }
+	  std::this_thread::sleep_for(SETTLE_TIME);
+
+	  done = (n > MAX_SAMPLES) || ((n > MIN_SAMPLES) && (nowNs() >= end));
+	  channel.signal(done ? STOP : TscClock::now());
+	}
+    });
+
+    waker.join();
+    waiter.join();
+    session.recordLatency(name, { { "pinned", pinned } }, latency);
+  }
+
+  template <typename Channel>
+  void sampleWakeups(Session& session, const std::string& name) {
+    if (!session.selected(name)) {
+      return;
+    }
+    for (bool pinned : { false, true }) {
+      Channel channel;
+      sampleWakeups(session, name, channel, pinned);
+    }
+  }
+
+  class BlockingSemaphore {
+  public:
+    BlockingSemaphore(): s_(), stamp_(0) { }
+
+    void signal(uint64_t stamp) {
+      stamp_.store(stamp, std::memory_order_release);
+      s_.up();
+    }
+
+    uint64_t await() {
+      s_.down();
+      return stamp_.load(std::memory_order_acquire);
+    }
+
+  private:
+    Semaphore s_;
+    std::atomic<uint64_t> stamp_;
+  };
+
+  class PolledSemaphore {
+  public:
+    PolledSemaphore():
+        s_(0, OnExecMode::CLOSE, BlockingMode::DONT_BLOCK),
+        epoll_(s_.fd(), EpollEventType::READ), stamp_(0) {
+    }
+
+    void signal(uint64_t stamp) {
+      stamp_.store(stamp, std::memory_order_release);
+      s_.up();
+    }
+
+    uint64_t await() {
+      while (!s_.tryDown()) {
+	epoll_.wait(-1);
+      }
+      return stamp_.load(std::memory_order_acquire);
+    }
+
+  private:
+    Semaphore s_;
+    EpollSet epoll_;
+    std::atomic<uint64_t> stamp_;
+  };
+
+  class BlockingCondition {
+  public:
+    BlockingCondition(): cv_(), sync_(), posted_(0), seen_(0), stamp_(0) { }
+
+    void signal(uint64_t stamp) {
+      std::unique_lock<std::mutex> lock(sync_);
+      stamp_ = stamp;
+      ++posted_;
+      cv_.notifyOne();
+    }
+
+    uint64_t await() {
+      std::unique_lock<std::mutex> lock(sync_);
+      while (posted_ == seen_) {
+	cv_.wait(lock, -1);
+      }
+      seen_ = posted_;
+      return stamp_;
+    }
+
+  private:
+    Condition cv_;
+    std::mutex sync_;
+    uint64_t posted_;
+    uint64_t seen_;
+    uint64_t stamp_;
+  };
+
+  class PolledCondition {
+  public:
+    PolledCondition():
+        cv_(BlockingMode::DONT_BLOCK), fd_(cv_.observe()),
+        epoll_(fd_, EpollEventType::READ), sync_(), posted_(0), seen_(0),
+        stamp_(0) {
+    }
+
+    ~PolledCondition() { cv_.stopObserving(fd_); }
+
+    void signal(uint64_t stamp) {
+      std::unique_lock<std::mutex> lock(sync_);
+      stamp_ = stamp;
+      ++posted_;
+      cv_.notifyOne();
+    }
+
+    uint64_t await() {
+      for (;;) {
+	{
+	  std::unique_lock<std::mutex> lock(sync_);
+	  if (posted_ != seen_) {
+	    seen_ = posted_;
+	    return stamp_;
+	  }
+	}
+	epoll_.wait(-1);
+	cv_.tryAck(fd_);
+      }
+    }
+
+  private:
+    Condition cv_;
+    int fd_;
+    EpollSet epoll_;
+    std::mutex sync_;
+    uint64_t posted_;
+    uint64_t seen_;
+    uint64_t stamp_;
+  };
+
+  class BlockingQueue {
+  public:
+    BlockingQueue(): q_() { }
+
+    void signal(uint64_t stamp) { q_.put(stamp); }
+    uint64_t await() { return q_.get(); }
+
+  private:
+    Queue<uint64_t> q_;
+  };
+
+  class PolledQueue {
+  public:
+    PolledQueue():
+        q_(BlockingMode::DONT_BLOCK),
+        epoll_(q_.queueStateFd(), EpollEventType::READ) {
+    }
+
+    void signal(uint64_t stamp) { q_.put(stamp); }
+
+    uint64_t await() {
+      uint64_t stamp;
+      while (!q_.tryGet(stamp)) {
+	epoll_.wait(-1);
+      }
+      return stamp;
+    }
+
+  private:
+    Queue<uint64_t> q_;
+    EpollSet epoll_;
+  };
+}
+
+PISTIS_BENCHMARK(WakeupLatency) {
+  sampleWakeups<BlockingSemaphore>(session, "latency/semaphore/blocking");
+  sampleWakeups<PolledSemaphore>(session, "latency/semaphore/epoll");
+  sampleWakeups<BlockingCondition>(session, "latency/condition/blocking");
+  sampleWakeups<PolledCondition>(session, "latency/condition/epoll");
+  sampleWakeups<BlockingQueue>(session, "latency/queue/blocking");
+  sampleWakeups<PolledQueue>(session, "latency/queue/epoll");
+}
@@ -0,0 +1,41 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/LockProfiler.hpp>
+#include <pistis/concurrent/ProfiledMutex.hpp>
+#include <mutex>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+
+/** Measures an uncontended lock and unlock of std::mutex and of
+ *  ProfiledMutex with the profiler off, on with the default sample
+ *  interval and on timing every hold.
+ */
+PISTIS_BENCHMARK(ProfiledMutexLockUnlock) {
+  std::mutex plain;
+  session.measure("lock_profiler/lock_unlock", { { "profiled", 0 } },
+		  [&](uint64_t n) {
+		    for (uint64_t i = 0; i < n; ++i) {
+		      std::unique_lock<std::mutex> lock(plain);
+		    }
+		  });
+
+  const int64_t intervals[] = {
+    0, LockProfiler::DEFAULT_SAMPLE_INTERVAL, 1
+  };
+  for (int64_t interval : intervals) {
+    ProfiledMutex m(&m, "Benchmark");
+    if (interval) {
+      LockProfiler::setSampleInterval((uint32_t)interval);
+      LockProfiler::enable();
+    }
+    session.measure("lock_profiler/lock_unlock",
+		    { { "profiled", 1 }, { "sample_interval", interval } },
+		    [&](uint64_t n) {
+		      for (uint64_t i = 0; i < n; ++i) {
+			std::unique_lock<ProfiledMutex> lock(m);
+		      }
+		    });
+    LockProfiler::disable();
+  }
+  LockProfiler::setSampleInterval(LockProfiler::DEFAULT_SAMPLE_INTERVAL);
+}
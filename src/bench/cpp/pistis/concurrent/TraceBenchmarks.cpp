@@ -0,0 +1,36 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/Trace.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+/** Measures one Trace::record() with tracing disabled and enabled, and
+ *  the cost tracing adds to an uncontended Queue put() and get().
+ */
+PISTIS_BENCHMARK(TraceRecord) {
+  int object = 0;
+  for (bool enabled : { false, true }) {
+    if (enabled) {
+      Trace::enable();
+    }
+    session.measure("trace/record", { { "enabled", enabled } },
+		    [&](uint64_t n) {
+		      for (uint64_t i = 0; i < n; ++i) {
+			Trace::record(TraceEventType::PUT, &object, i);
+		      }
+		    });
+
+    Queue<uint64_t> q;
+    session.measure("trace/queue_put_get", { { "enabled", enabled } },
+		    [&](uint64_t n) {
+		      for (uint64_t i = 0; i < n; ++i) {
+			q.put(i);
+			q.get();
+		      }
+		    });
+    Trace::disable();
+    Trace::clear();
+  }
+}
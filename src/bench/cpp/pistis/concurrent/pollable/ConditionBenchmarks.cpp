@@ -0,0 +1,101 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/pollable/Condition.hpp>
+#include <mutex>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef std::unique_lock<std::mutex> Lock;
+
+  /** @brief Two threads taking turns, each notifying the other through
+   *         a Condition and waiting to be notified back.  One operation
+   *         is one round trip, i.e. two notify-to-wake latencies.
+   */
+  class TurnTaking {
+  public:
+    TurnTaking(): turn_(0), sync_(), cv_() { }
+
+    /** @brief Wait for our turn by blocking in Condition::wait() */
+    void waitForTurn(int self) {
+      Lock lock(sync_);
+      while (turn_ != self) {
+	cv_[self].wait(lock, -1);
+      }
+    }
+
+    /** @brief Wait for our turn by polling an observer descriptor */
+    void pollForTurn(int self, int fd, EpollSet& epoll) {
+      for (;;) {
+	{
+	  Lock lock(sync_);
+	  if (turn_ == self) {
+	    return;
+	  }
+	}
+	epoll.wait(-1);
+	cv_[self].ack(fd);
+      }
+    }
+
+    void pass(int self) {
+      Lock lock(sync_);
+      turn_ = 1 - self;
+      cv_[1 - self].notifyOne();
+    }
+
+    int observe(int self) { return cv_[self].observe(); }
+    void stopObserving(int self, int fd) { cv_[self].stopObserving(fd); }
+
+  private:
+    int turn_;
+    std::mutex sync_;
+    Condition cv_[2];
+  };
+
+  void roundTrips(uint64_t n) {
+    TurnTaking t;
+    std::thread partner([&]() {
+	for (uint64_t i = 0; i < n; ++i) {
+	  t.waitForTurn(1);
+	  t.pass(1);
+	}
+    });
+    for (uint64_t i = 0; i < n; ++i) {
+      t.pass(0);
+      t.waitForTurn(0);
+    }
+    partner.join();
+  }
+
+  void observedRoundTrips(uint64_t n) {
+    TurnTaking t;
+    std::thread partner([&]() {
+	const int fd = t.observe(1);
+	EpollSet epoll(fd, EpollEventType::READ);
+	for (uint64_t i = 0; i < n; ++i) {
+	  t.pollForTurn(1, fd, epoll);
+	  t.pass(1);
+	}
+	t.stopObserving(1, fd);
+    });
+
+    const int fd = t.observe(0);
+    EpollSet epoll(fd, EpollEventType::READ);
+    for (uint64_t i = 0; i < n; ++i) {
+      t.pass(0);
+      t.pollForTurn(0, fd, epoll);
+    }
+    t.stopObserving(0, fd);
+    partner.join();
+  }
+}
+
+PISTIS_BENCHMARK(ConditionNotifyWake) {
+  session.measure("condition/notify_wait_round_trip", { }, &roundTrips);
+  session.measure("condition/notify_observe_round_trip", { },
+		  &observedRoundTrips);
+}
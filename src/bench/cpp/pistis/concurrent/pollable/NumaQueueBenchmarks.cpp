@@ -0,0 +1,85 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/NumaTopology.hpp>
+#include <pistis/concurrent/pollable/NumaShardedQueue.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  /** @brief Move @c n items through @c q with one producer and one
+   *         consumer bound to each node of @c topology.
+   *
+   *  @c get takes one item from @c q, waiting if necessary.
+   */
+  template <typename Q, typename GetFunction>
+  void putAndGetOnNodes(Q& q, const NumaTopology& topology, uint64_t n,
+			GetFunction get) {
+    const size_t numNodes = topology.numNodes();
+    std::atomic<uint64_t> claimed(0);
+    std::vector<std::thread> threads;
+
+    for (size_t node = 0; node < numNodes; ++node) {
+      threads.emplace_back([&, node]() {
+	  topology.bindCurrentThread(node);
+	  while (claimed.fetch_add(1, std::memory_order_relaxed) < n) {
+	    get(q);
+	  }
+      });
+      const uint64_t count = n / numNodes + (node < n % numNodes);
+      threads.emplace_back([&, node, count]() {
+	  topology.bindCurrentThread(node);
+	  for (uint64_t i = 0; i < count; ++i) {
+	    q.put(i);
+	  }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+}
+
+/** Measures a producer and a consumer per NUMA node exchanging items
+ *  through one Queue, through a ShardedQueue with a shard per node
+ *  assigned to threads round-robin, and through a NumaShardedQueue.
+ *  Run with --numa-nodes=N to simulate N nodes on any machine.
+ */
+PISTIS_BENCHMARK(NumaQueueThroughput) {
+  const NumaTopology topology =
+      session.options().numaNodes
+          ? NumaTopology::simulate(session.options().numaNodes)
+          : NumaTopology::system();
+  const Params params{
+    { "nodes", (int64_t)topology.numNodes() },
+    { "simulated", topology.simulated() }
+  };
+
+  Queue<uint64_t> single;
+  session.measure("numa_queue/single", params, [&](uint64_t n) {
+      putAndGetOnNodes(single, topology, n,
+		       [](Queue<uint64_t>& q) { q.get(); });
+  });
+
+  ShardedQueue<uint64_t> byThread(topology.numNodes());
+  session.measure("numa_queue/sharded_by_thread", params, [&](uint64_t n) {
+      putAndGetOnNodes(byThread, topology, n,
+		       [](ShardedQueue<uint64_t>& q) {
+			 uint64_t item;
+			 q.get(item, -1);
+		       });
+  });
+
+  NumaShardedQueue<uint64_t> byNode(topology);
+  session.measure("numa_queue/sharded_by_node", params, [&](uint64_t n) {
+      putAndGetOnNodes(byNode, topology, n,
+		       [](NumaShardedQueue<uint64_t>& q) {
+			 uint64_t item;
+			 q.get(item, -1);
+		       });
+  });
+}
@@ -0,0 +1,69 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  static const size_t QUEUE_SIZE = 1024;
+
+  /** @brief Move @c n items through @c q with the given numbers of
+   *         producer and consumer threads
+   */
+  void putAndGet(Queue<uint64_t>& q, uint64_t n, size_t numProducers,
+		 size_t numConsumers) {
+    std::atomic<uint64_t> claimed(0);
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < numConsumers; ++i) {
+      threads.emplace_back([&q, &claimed, n]() {
+	  // Claim an item before taking it, so every consumer knows when
+	  // to stop without a sentinel
+	  while (claimed.fetch_add(1, std::memory_order_relaxed) < n) {
+	    q.get();
+	  }
+      });
+    }
+    for (size_t i = 0; i < numProducers; ++i) {
+      const uint64_t count = n / numProducers + (i < n % numProducers);
+      threads.emplace_back([&q, count]() {
+	  for (uint64_t j = 0; j < count; ++j) {
+	    q.put(j);
+	  }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+}
+
+PISTIS_BENCHMARK(QueueThroughput) {
+  for (size_t producers : session.threadCounts()) {
+    for (size_t consumers : session.threadCounts()) {
+      Queue<uint64_t> q(QUEUE_SIZE);
+      session.measure("queue/put_get",
+		      { { "producers", (int64_t)producers },
+			{ "consumers", (int64_t)consumers },
+			{ "max_size", (int64_t)QUEUE_SIZE } },
+		      [&](uint64_t n) {
+			putAndGet(q, n, producers, consumers);
+		      });
+    }
+  }
+}
+
+PISTIS_BENCHMARK(QueueTryPutTryGet) {
+  Queue<uint64_t> q(BlockingMode::DONT_BLOCK, QUEUE_SIZE);
+  uint64_t item = 0;
+  session.measure("queue/try_put_try_get", { }, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+	q.tryPut(i);
+	q.tryGet(item);
+      }
+  });
+}
@@ -0,0 +1,54 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/pollable/ReadWriteToggle.hpp>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  struct Transition {
+    const char* name;
+    ReadWriteToggle::State from;
+    ReadWriteToggle::State to;
+    int64_t directions;  ///< Number of directions whose readiness changes
+  };
+
+  static const Transition TRANSITIONS[] = {
+    { "read_write_toggle/read_write_to_read_only",
+      ReadWriteToggle::READ_WRITE, ReadWriteToggle::READ_ONLY, 1 },
+    { "read_write_toggle/read_write_to_write_only",
+      ReadWriteToggle::READ_WRITE, ReadWriteToggle::WRITE_ONLY, 1 },
+    { "read_write_toggle/write_only_to_none",
+      ReadWriteToggle::WRITE_ONLY, ReadWriteToggle::NONE, 1 },
+    { "read_write_toggle/read_only_to_write_only",
+      ReadWriteToggle::READ_ONLY, ReadWriteToggle::WRITE_ONLY, 2 },
+    { "read_write_toggle/read_write_to_none",
+      ReadWriteToggle::READ_WRITE, ReadWriteToggle::NONE, 2 },
+  };
+}
+
+/** Each operation is one transition, alternating between going there
+ *  and coming back, so both directions of each pair are included.
+ */
+PISTIS_BENCHMARK(ReadWriteToggleTransitions) {
+  for (const Transition& t : TRANSITIONS) {
+    ReadWriteToggle toggle;
+    toggle.setState(t.from);
+    session.measure(t.name, { { "directions", t.directions } },
+		    [&](uint64_t n) {
+		      for (uint64_t i = 0; i < n; ++i) {
+			toggle.setState((i & 1) ? t.from : t.to);
+		      }
+		      toggle.setState(t.from);
+		    });
+  }
+}
+
+PISTIS_BENCHMARK(ReadWriteToggleUnchanged) {
+  ReadWriteToggle toggle;
+  session.measure("read_write_toggle/unchanged", { }, [&](uint64_t n) {
+      for (uint64_t i = 0; i < n; ++i) {
+	toggle.setState(ReadWriteToggle::READ_WRITE);
+      }
+  });
+}
@@ -0,0 +1,52 @@
+#include <pistis/concurrent/Benchmark.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::bench;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  /** @brief Pass a token back and forth between two threads @c n times
+   *         through a pair of semaphores
+   */
+  void pingPong(Semaphore& ping, Semaphore& pong, uint64_t n) {
+    std::thread partner([&]() {
+	for (uint64_t i = 0; i < n; ++i) {
+	  ping.down();
+	  pong.up();
+	}
+    });
+    for (uint64_t i = 0; i < n; ++i) {
+      ping.up();
+      pong.down();
+    }
+    partner.join();
+  }
+}
+
+PISTIS_BENCHMARK(SemaphorePingPong) {
+  for (BlockingMode mode : { BlockingMode::BLOCK,
+	                     BlockingMode::DONT_BLOCK }) {
+    Semaphore ping(0, OnExecMode::CLOSE, mode);
+    Semaphore pong(0, OnExecMode::CLOSE, mode);
+    session.measure("semaphore/ping_pong",
+		    { { "nonblocking", mode == BlockingMode::DONT_BLOCK } },
+		    [&](uint64_t n) { pingPong(ping, pong, n); });
+  }
+}
+
+PISTIS_BENCHMARK(SemaphoreUncontended) {
+  for (BlockingMode mode : { BlockingMode::BLOCK,
+	                     BlockingMode::DONT_BLOCK }) {
+    Semaphore s(0, OnExecMode::CLOSE, mode);
+    session.measure("semaphore/up_down",
+		    { { "nonblocking", mode == BlockingMode::DONT_BLOCK } },
+		    [&](uint64_t n) {
+		      for (uint64_t i = 0; i < n; ++i) {
+			s.up();
+			s.down();
+		      }
+		    });
+  }
+}
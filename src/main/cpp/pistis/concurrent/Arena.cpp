@@ -0,0 +1,77 @@
+#include "Arena.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <algorithm>
+#include <cstddef>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+namespace {
+  typedef std::unique_lock<std::mutex> Lock;
+
+  static const size_t ARENA_ALIGNMENT = alignof(std::max_align_t);
+
+  static size_t roundSize(size_t size) {
+    size = std::max(size, sizeof(void*));
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+  }
+
+  static size_t checkChunkSize(size_t chunkSize) {
+    if (chunkSize < ARENA_ALIGNMENT) {
+      throw IllegalValueError("Illegal value for chunk size (too small)",
+			      PISTIS_EX_HERE);
+    }
+    return roundSize(chunkSize);
+  }
+}
+
+const size_t Arena::DEFAULT_CHUNK_SIZE;
+
+Arena::Arena(size_t chunkSize):
+    chunkSize_(checkChunkSize(chunkSize)), bytesReserved_(0),
+    current_(nullptr), end_(nullptr), chunks_(), freeLists_(), sync_() {
+}
+
+size_t Arena::bytesReserved() const {
+  Lock lock(sync_);
+  return bytesReserved_;
+}
+
+void* Arena::allocate(size_t size) {
+  size = roundSize(size);
+  Lock lock(sync_);
+
+  auto i = freeLists_.find(size);
+  if ((i != freeLists_.end()) && i->second) {
+    FreeBlock_* block = i->second;
+    i->second = block->next;
+    return block;
+  }
+
+  if (size > (size_t)(end_ - current_)) {
+    // Oversized requests get a chunk of their own, so they don't waste
+    // the rest of the current chunk
+    const size_t n = std::max(size, chunkSize_);
+    chunks_.emplace_back(new char[n]);
+    bytesReserved_ += n;
+    if (n > chunkSize_) {
+      return chunks_.back().get();
+    }
+    current_ = chunks_.back().get();
+    end_ = current_ + n;
+  }
+
+  void* p = current_;
+  current_ += size;
+  return p;
+}
+
+void Arena::deallocate(void* p, size_t size) {
+  if (p) {
+    FreeBlock_* block = static_cast<FreeBlock_*>(p);
+    Lock lock(sync_);
+    FreeBlock_*& head = freeLists_[roundSize(size)];
+    block->next = head;
+    head = block;
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef __PISTIS__CONCURRENT__ARENA_HPP__
+#define __PISTIS__CONCURRENT__ARENA_HPP__
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A memory arena that recycles freed blocks.
+     *
+     *  The arena hands out memory by bumping a pointer through large
+     *  chunks obtained from the global allocator.  Freed blocks are kept
+     *  on a free list for their size and reused by later requests of the
+     *  same size, so a container whose allocation pattern repeats -- a
+     *  queue that keeps allocating and freeing nodes of one size --
+     *  settles into a fixed footprint.  Memory returns to the global
+     *  allocator only when the arena is destroyed.
+     *
+     *  Arena is thread-safe.  A container such as a Queue already
+     *  serializes its own allocations, but getAll() and swapOut() hand
+     *  containers that share the queue's arena to consumers, who
+     *  destroy or grow them outside the queue's lock.  An uncontended
+     *  lock is cheap next to the allocations the arena saves.
+     */
+    class Arena {
+    public:
+      static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    public:
+      Arena(size_t chunkSize = DEFAULT_CHUNK_SIZE);
+      Arena(const Arena&) = delete;
+
+      size_t chunkSize() const { return chunkSize_; }
+
+      /** @brief Total memory obtained from the global allocator */
+      size_t bytesReserved() const;
+
+      void* allocate(size_t size);
+      void deallocate(void* p, size_t size);
+
+      Arena& operator=(const Arena&) = delete;
+
+    private:
+      struct FreeBlock_ {
+	FreeBlock_* next;
+      };
+
+      size_t chunkSize_;
+      size_t bytesReserved_;
+      char* current_;
+      char* end_;
+      std::vector< std::unique_ptr<char[]> > chunks_;
+      std::unordered_map<size_t, FreeBlock_*> freeLists_;
+      mutable std::mutex sync_;
+    };
+
+  }
+}
+#endif
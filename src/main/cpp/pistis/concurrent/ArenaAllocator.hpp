@@ -0,0 +1,73 @@
+#ifndef __PISTIS__CONCURRENT__ARENAALLOCATOR_HPP__
+#define __PISTIS__CONCURRENT__ARENAALLOCATOR_HPP__
+
+#include <pistis/concurrent/Arena.hpp>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A standard allocator that serves requests from an Arena.
+     *
+     *  A default-constructed allocator creates its own arena, so
+     *  @c Queue<Item, ArenaAllocator<Item>> gets a private arena per
+     *  queue.  Copies of an allocator, including rebound copies, share
+     *  the arena and compare equal.  The containers returned by
+     *  Queue::getAll(), Queue::swapOut() and PriorityQueue::getAll()
+     *  share the queue's arena, and Arena locks every allocation, so
+     *  consumers may use them while producers keep putting.
+     *  ShardedQueue's shards would all contend for that lock, so it
+     *  should use PoolAllocator instead.
+     */
+    template <typename T>
+    class ArenaAllocator {
+    public:
+      typedef T value_type;
+      typedef std::true_type propagate_on_container_copy_assignment;
+      typedef std::true_type propagate_on_container_move_assignment;
+      typedef std::true_type propagate_on_container_swap;
+
+      template <typename U>
+      struct rebind {
+	typedef ArenaAllocator<U> other;
+      };
+
+    public:
+      ArenaAllocator(): arena_(std::make_shared<Arena>()) { }
+      explicit ArenaAllocator(const std::shared_ptr<Arena>& arena):
+	  arena_(arena) {
+      }
+      template <typename U>
+      ArenaAllocator(const ArenaAllocator<U>& other): arena_(other.arena()) { }
+
+      const std::shared_ptr<Arena>& arena() const { return arena_; }
+
+      T* allocate(size_t n) {
+	static_assert(alignof(T) <= alignof(std::max_align_t),
+		      "ArenaAllocator does not support over-aligned types");
+	return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+      }
+
+      void deallocate(T* p, size_t n) {
+	arena_->deallocate(p, n * sizeof(T));
+      }
+
+      template <typename U>
+      bool operator==(const ArenaAllocator<U>& other) const {
+	return arena_ == other.arena();
+      }
+
+      template <typename U>
+      bool operator!=(const ArenaAllocator<U>& other) const {
+	return arena_ != other.arena();
+      }
+
+    private:
+      std::shared_ptr<Arena> arena_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,134 @@
+#include "BlockPool.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <cstddef>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+namespace {
+  static const size_t BLOCK_ALIGNMENT = alignof(std::max_align_t);
+
+  static size_t roundBlockSize(size_t blockSize) {
+    if (!blockSize) {
+      throw IllegalValueError("Illegal value for block size (must be > 0)",
+			      PISTIS_EX_HERE);
+    }
+    return (blockSize + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+  }
+
+  static size_t checkBlocksPerChunk(size_t blocksPerChunk) {
+    if (!blocksPerChunk) {
+      throw IllegalValueError(
+	  "Illegal value for blocks per chunk (must be > 0)", PISTIS_EX_HERE
+      );
+    }
+    return blocksPerChunk;
+  }
+
+  // From <numaif.h>, which is only installed with libnuma
+  static const int MPOL_PREFERRED_ = 1;
+  static const size_t MAX_NUMA_NODES = 1024;
+  static const size_t BITS_PER_WORD = 8 * sizeof(unsigned long);
+
+  /** @brief Map @c size bytes whose pages the kernel will prefer to
+   *         take from @c node when they are first touched
+   */
+  static void* mapOnNode(size_t size, int node) {
+    void* chunk = ::mmap(nullptr, size, PROT_READ|PROT_WRITE,
+			 MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+    if (chunk == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    if ((size_t)node < MAX_NUMA_NODES) {
+      unsigned long mask[MAX_NUMA_NODES / BITS_PER_WORD] = { 0 };
+      mask[node / BITS_PER_WORD] = 1UL << (node % BITS_PER_WORD);
+
+      // Failure leaves the default policy in place, which is the best
+      // that can be done without NUMA support
+      ::syscall(SYS_mbind, chunk, size, MPOL_PREFERRED_, mask,
+		MAX_NUMA_NODES, 0);
+    }
+    return chunk;
+  }
+}
+
+const size_t BlockPool::DEFAULT_BLOCK_SIZE;
+const size_t BlockPool::DEFAULT_BLOCKS_PER_CHUNK;
+
+BlockPool::BlockPool(size_t blockSize, size_t blocksPerChunk,
+		     int numaNode):
+    blockSize_(roundBlockSize(blockSize)),
+    blocksPerChunk_(checkBlocksPerChunk(blocksPerChunk)),
+    numaNode_(numaNode < 0 ? -1 : numaNode), free_(nullptr), numFree_(0),
+    chunks_(), sync_() {
+}
+
+BlockPool::~BlockPool() {
+  for (char* chunk : chunks_) {
+    if (numaNode_ < 0) {
+      ::operator delete(chunk);
+    } else {
+      ::munmap(chunk, blockSize_ * blocksPerChunk_);
+    }
+  }
+}
+
+size_t BlockPool::numChunks() const {
+  std::unique_lock<std::mutex> lock(sync_);
+  return chunks_.size();
+}
+
+size_t BlockPool::numFreeBlocks() const {
+  std::unique_lock<std::mutex> lock(sync_);
+  return numFree_;
+}
+
+void* BlockPool::allocate() {
+  std::unique_lock<std::mutex> lock(sync_);
+  if (!free_) {
+    addChunk_();
+  }
+  FreeBlock_* block = free_;
+  free_ = block->next;
+  --numFree_;
+  return block;
+}
+
+void BlockPool::deallocate(void* block) {
+  if (block) {
+    FreeBlock_* b = static_cast<FreeBlock_*>(block);
+    std::unique_lock<std::mutex> lock(sync_);
+    b->next = free_;
+    free_ = b;
+    ++numFree_;
+  }
+}
+
+void BlockPool::addChunk_() {
+  // Make room to record the chunk first, so it cannot leak if
+  // recording it fails
+  if (chunks_.size() == chunks_.capacity()) {
+    chunks_.reserve(2 * chunks_.size() + 1);
+  }
+
+  const size_t size = blockSize_ * blocksPerChunk_;
+  char* chunk = static_cast<char*>(
+      (numaNode_ < 0) ? ::operator new(size) : mapOnNode(size, numaNode_)
+  );
+  chunks_.push_back(chunk);
+
+  // Thread the new blocks onto the free list so they are handed out
+  // in address order
+  for (size_t i = blocksPerChunk_; i > 0; --i) {
+    FreeBlock_* b = reinterpret_cast<FreeBlock_*>(
+	chunk + (i - 1) * blockSize_
+    );
+    b->next = free_;
+    free_ = b;
+  }
+  numFree_ += blocksPerChunk_;
+}
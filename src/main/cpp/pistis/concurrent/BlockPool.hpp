@@ -0,0 +1,85 @@
+#ifndef __PISTIS__CONCURRENT__BLOCKPOOL_HPP__
+#define __PISTIS__CONCURRENT__BLOCKPOOL_HPP__
+
+#include <mutex>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A thread-safe pool of fixed-size memory blocks.
+     *
+     *  The pool carves blocks out of chunks obtained from the global
+     *  allocator, and never returns chunks to the global allocator until
+     *  the pool is destroyed.  Freed blocks go on a free list and are
+     *  handed out again by later calls to allocate().  All blocks are
+     *  aligned for any fundamental type.
+     *
+     *  A pool can place its chunks on a NUMA node, so containers whose
+     *  allocators use the pool keep their storage next to the threads
+     *  that use it.  The node is a preference: when the node is out of
+     *  memory, or the kernel does not support NUMA, chunks come from
+     *  wherever the kernel's default policy puts them.
+     *
+     *  Destroying a pool while blocks obtained from it are still in use
+     *  produces undefined behavior.
+     */
+    class BlockPool {
+    public:
+      /** @brief Default block size.  Matches the node size std::deque
+       *         uses for small items, so a Queue's blocks fit exactly.
+       */
+      static const size_t DEFAULT_BLOCK_SIZE = 512;
+      static const size_t DEFAULT_BLOCKS_PER_CHUNK = 64;
+
+    public:
+      /** @brief Create an empty pool.
+       *
+       *  @param numaNode  The kernel's number for the NUMA node to place
+       *                   chunks on, as from NumaTopology::kernelNode(),
+       *                   or -1 to use the global allocator
+       */
+      BlockPool(size_t blockSize = DEFAULT_BLOCK_SIZE,
+		size_t blocksPerChunk = DEFAULT_BLOCKS_PER_CHUNK,
+		int numaNode = -1);
+      BlockPool(const BlockPool&) = delete;
+      ~BlockPool();
+
+      size_t blockSize() const { return blockSize_; }
+      size_t blocksPerChunk() const { return blocksPerChunk_; }
+      int numaNode() const { return numaNode_; }
+      size_t numChunks() const;
+      size_t numFreeBlocks() const;
+
+      /** @brief Obtain a block of blockSize() bytes
+       *
+       *  @throws std::bad_alloc if a new chunk is needed and cannot be
+       *          allocated
+       */
+      void* allocate();
+
+      /** @brief Return a block obtained from allocate() to the pool */
+      void deallocate(void* block);
+
+      BlockPool& operator=(const BlockPool&) = delete;
+
+    private:
+      struct FreeBlock_ {
+	FreeBlock_* next;
+      };
+
+      size_t blockSize_;
+      size_t blocksPerChunk_;
+      int numaNode_;
+      FreeBlock_* free_;
+      size_t numFree_;
+      std::vector<char*> chunks_;
+      mutable std::mutex sync_;
+
+      void addChunk_();
+    };
+
+  }
+}
+#endif
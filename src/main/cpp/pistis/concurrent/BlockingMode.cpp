@@ -2,7 +2,8 @@
 
 using namespace pistis::concurrent;
 
-std::ostream& operator<<(std::ostream& out, BlockingMode mode) {
+std::ostream& pistis::concurrent::operator<<(std::ostream& out,
+					     BlockingMode mode) {
   if (mode == BlockingMode::BLOCK) {
     return out << "BLOCK";
   } else if (mode == BlockingMode::DONT_BLOCK) {
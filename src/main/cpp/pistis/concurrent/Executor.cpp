@@ -0,0 +1,226 @@
+#include "Executor.hpp"
+#include <pistis/exceptions/IllegalStateError.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef std::unique_lock<std::mutex> Lock;
+
+  /** @brief Executor whose worker is running on this thread, if any */
+  thread_local Executor* currentExecutor = nullptr;
+
+  /** @brief Index of the worker running on this thread */
+  thread_local size_t currentWorker = 0;
+
+  inline size_t defaultNumWorkers() {
+    const size_t n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+  }
+
+  inline uint64_t xorshift(uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+}
+
+Executor::Executor(size_t numWorkers, OnExecMode onExec,
+		   const ThreadConfig& threads):
+    workers_(), injected_(), injectedSync_(), numInjected_(0),
+    wakeup_(onExec), parked_(0), pending_(0), failed_(0), stopping_(false),
+    onExec_(onExec), shutdownSync_() {
+  if (!numWorkers) {
+    numWorkers = defaultNumWorkers();
+  }
+  for (size_t i = 0; i < numWorkers; ++i) {
+    workers_.emplace_back(new Worker_((i + 1) * 0x9E3779B97F4A7C15ull));
+  }
+  // Start the threads only after every worker exists, since they steal
+  // from each other
+  try {
+    for (size_t i = 0; i < numWorkers; ++i) {
+      workers_[i]->thread = threads.start(i, [this, i]() { run_(i); });
+    }
+  } catch(...) {
+    shutdown();
+    throw;
+  }
+}
+
+Executor::~Executor() {
+  shutdown();
+}
+
+Completion Executor::submit(Task task) {
+  std::unique_ptr<Completion> completion(new Completion(onExec_));
+  Completion result(*completion);
+  schedule_(new Task_(std::move(task), std::move(completion)));
+  return result;
+}
+
+void Executor::execute(Task task) {
+  schedule_(new Task_(std::move(task), std::unique_ptr<Completion>()));
+}
+
+void Executor::shutdown() {
+  Lock lock(shutdownSync_);
+  stopping_.store(true);
+  if (!pending_.load()) {
+    wakeAll_();
+  }
+  for (auto& w : workers_) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+  }
+}
+
+void Executor::schedule_(Task_* task) {
+  const bool onWorker = currentExecutor == this;
+  if (!onWorker && stopping_.load()) {
+    delete task;
+    throw IllegalStateError("Executor is shutting down", PISTIS_EX_HERE);
+  }
+
+  pending_.fetch_add(1);
+  if (onWorker) {
+    workers_[currentWorker]->deque.push(task);
+  } else {
+    Lock lock(injectedSync_);
+    injected_.push_back(task);
+    numInjected_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Pairs with the fence in park_(), so either a parked worker sees the
+  // new task or we see the parked worker
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  wakeOne_();
+}
+
+void Executor::run_(size_t index) {
+  currentExecutor = this;
+  currentWorker = index;
+  Worker_& self = *workers_[index];
+
+  while (true) {
+    Task_* task = findTask_(self, index);
+    if (task) {
+      runTask_(task);
+    } else if (exiting_()) {
+      break;
+    } else {
+      park_();
+    }
+  }
+  currentExecutor = nullptr;
+}
+
+Executor::Task_* Executor::findTask_(Worker_& self, size_t index) {
+  Task_* task = nullptr;
+  if (self.deque.pop(task)) {
+    return task;
+  }
+
+  task = takeInjected_();
+  if (task) {
+    return task;
+  }
+
+  const size_t n = workers_.size();
+  const size_t start = xorshift(self.rng) % n;
+  for (size_t i = 0; i < n; ++i) {
+    const size_t victim = (start + i) % n;
+    if ((victim != index) && workers_[victim]->deque.steal(task)) {
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+Executor::Task_* Executor::takeInjected_() {
+  if (!numInjected_.load(std::memory_order_relaxed)) {
+    return nullptr;
+  }
+
+  Lock lock(injectedSync_);
+  if (injected_.empty()) {
+    return nullptr;
+  }
+  Task_* task = injected_.front();
+  injected_.pop_front();
+  numInjected_.fetch_sub(1, std::memory_order_relaxed);
+  return task;
+}
+
+void Executor::runTask_(Task_* task) {
+  std::exception_ptr error;
+  try {
+    task->fn();
+  } catch(...) {
+    error = std::current_exception();
+  }
+
+  if (task->completion) {
+    task->completion->complete(error);
+  } else if (error) {
+    failed_.fetch_add(1, std::memory_order_relaxed);
+  }
+  delete task;
+
+  if ((pending_.fetch_sub(1) == 1) && stopping_.load()) {
+    wakeAll_();
+  }
+}
+
+bool Executor::hasWork_() const {
+  if (numInjected_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  for (const auto& w : workers_) {
+    if (!w->deque.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Executor::exiting_() const {
+  return stopping_.load() && !pending_.load();
+}
+
+void Executor::park_() {
+  parked_.fetch_add(1);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (hasWork_() || exiting_()) {
+    // Take back our place among the parked workers, unless a waker
+    // already claimed it and posted a token for us to consume
+    int64_t p = parked_.load();
+    while (p > 0) {
+      if (parked_.compare_exchange_weak(p, p - 1)) {
+	return;
+      }
+    }
+  }
+  wakeup_.down();
+}
+
+void Executor::wakeOne_() {
+  int64_t p = parked_.load();
+  while (p > 0) {
+    if (parked_.compare_exchange_weak(p, p - 1)) {
+      wakeup_.up();
+      return;
+    }
+  }
+}
+
+void Executor::wakeAll_() {
+  const int64_t p = parked_.exchange(0);
+  if (p > 0) {
+    wakeup_.up(p);
+  }
+}
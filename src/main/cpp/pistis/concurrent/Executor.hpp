@@ -0,0 +1,184 @@
+#ifndef __PISTIS__CONCURRENT__EXECUTOR_HPP__
+#define __PISTIS__CONCURRENT__EXECUTOR_HPP__
+
+#include <pistis/concurrent/ThreadConfig.hpp>
+#include <pistis/concurrent/WorkStealingDeque.hpp>
+#include <pistis/concurrent/pollable/Completion.hpp>
+#include <pistis/concurrent/pollable/Future.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A work-stealing thread pool.
+     *
+     *  Each worker has its own WorkStealingDeque.  A task submitted from
+     *  a worker goes on that worker's deque, and a task submitted from
+     *  any other thread goes on a shared injection queue.  A worker
+     *  looks for work on its own deque first, then the injection queue,
+     *  then steals from the other workers, starting from a random one.
+     *  A worker that finds nothing parks on a pollable::Semaphore, and
+     *  submit() only touches the semaphore when a worker is parked, so
+     *  a busy pool makes no system calls.
+     *
+     *  submit() returns a pollable::Completion whose fd can be polled in
+     *  an EpollSet, and async() returns a pollable::Future for the
+     *  task's result.  execute() skips both, which saves an eventfd per
+     *  task; exceptions thrown by tasks run with execute() are counted
+     *  by numFailed() and otherwise discarded.
+     */
+    class Executor {
+    public:
+      typedef std::function<void ()> Task;
+
+    public:
+      /** @brief Start an executor with the given number of workers.
+       *
+       *  @param numWorkers  Number of worker threads.  Zero means one per
+       *                     hardware thread.
+       *  @param threads     Configuration for the workers.  Worker i
+       *                     applies threads.forThread(i) before it runs
+       *                     any tasks.
+       *  @throws IllegalValueError, SystemError if a worker cannot
+       *          apply its configuration
+       */
+      Executor(size_t numWorkers = 0, OnExecMode onExec = OnExecMode::CLOSE,
+	       const ThreadConfig& threads = ThreadConfig());
+      Executor(const Executor&) = delete;
+
+      /** @brief Calls shutdown() */
+      ~Executor();
+
+      size_t numWorkers() const { return workers_.size(); }
+
+      /** @brief Number of workers parked waiting for work */
+      size_t numParked() const {
+	return (size_t)parked_.load(std::memory_order_relaxed);
+      }
+
+      /** @brief Number of execute() tasks that threw an exception */
+      uint64_t numFailed() const {
+	return failed_.load(std::memory_order_relaxed);
+      }
+
+      /** @brief True if shutdown() has been called */
+      bool shuttingDown() const {
+	return stopping_.load(std::memory_order_relaxed);
+      }
+
+      /** @brief Run @c task on one of the workers.
+       *
+       *  @returns  A Completion that finishes when the task returns,
+       *            carrying any exception it threw
+       *  @throws IllegalStateError if the executor is shutting down
+       */
+      pollable::Completion submit(Task task);
+
+      /** @brief Run @c task on one of the workers without tracking its
+       *         completion.
+       *
+       *  @throws IllegalStateError if the executor is shutting down
+       */
+      void execute(Task task);
+
+      /** @brief Run @c f on one of the workers.
+       *
+       *  @returns  A pollable::Future for the value @c f returns, or the
+       *            exception it throws
+       *  @throws IllegalStateError if the executor is shutting down
+       */
+      template <typename F>
+      pollable::Future<decltype(std::declval<F&>()())> async(F f) {
+	return async(std::allocator_arg, std::allocator<char>(), std::move(f));
+      }
+
+      /** @brief Same as async(F), with the future's state allocated by
+       *         @c allocator
+       */
+      template <typename Allocator, typename F>
+      pollable::Future<decltype(std::declval<F&>()())>
+          async(std::allocator_arg_t, const Allocator& allocator, F f) {
+	typedef decltype(std::declval<F&>()()) Result;
+	auto promise = std::allocate_shared< pollable::Promise<Result> >(
+	    allocator, std::allocator_arg, allocator
+	);
+	pollable::Future<Result> result = promise->future();
+	execute([promise, f]() { promise->setFrom(f); });
+	return result;
+      }
+
+      /** @brief Run every task already submitted, then stop the
+       *         workers.  Tasks may still submit more tasks while the
+       *         executor drains.  Safe to call more than once, but not
+       *         from a worker.
+       */
+      void shutdown();
+
+      Executor& operator=(const Executor&) = delete;
+
+    private:
+      struct Task_ {
+	Task fn;
+	std::unique_ptr<pollable::Completion> completion;
+
+	Task_(Task&& f, std::unique_ptr<pollable::Completion>&& c):
+	    fn(std::move(f)), completion(std::move(c)) {
+	}
+      };
+
+      struct Worker_ {
+	WorkStealingDeque<Task_*> deque;
+	std::thread thread;
+	uint64_t rng;
+
+	Worker_(uint64_t seed): deque(), thread(), rng(seed) { }
+
+	// The deque keeps its indices on separate cache lines, which plain
+	// new does not honor before C++17
+	static void* operator new(size_t size) {
+	  void* p = nullptr;
+	  if (::posix_memalign(&p, alignof(Worker_), size)) {
+	    throw std::bad_alloc();
+	  }
+	  return p;
+	}
+
+	static void operator delete(void* p) { ::free(p); }
+      };
+
+      std::vector< std::unique_ptr<Worker_> > workers_;
+      std::deque<Task_*> injected_;
+      std::mutex injectedSync_;
+      std::atomic<size_t> numInjected_;
+      pollable::Semaphore wakeup_;
+      std::atomic<int64_t> parked_;    ///< Parked workers not yet woken
+      std::atomic<int64_t> pending_;   ///< Tasks submitted but not finished
+      std::atomic<uint64_t> failed_;
+      std::atomic<bool> stopping_;
+      OnExecMode onExec_;
+      std::mutex shutdownSync_;
+
+      void schedule_(Task_* task);
+      void run_(size_t index);
+      Task_* findTask_(Worker_& self, size_t index);
+      Task_* takeInjected_();
+      void runTask_(Task_* task);
+      bool hasWork_() const;
+      bool exiting_() const;
+      void park_();
+      void wakeOne_();
+      void wakeAll_();
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,82 @@
+#include "HdrHistogram.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+const uint32_t HdrHistogram::DEFAULT_PRECISION;
+const uint32_t HdrHistogram::MAX_PRECISION;
+
+HdrHistogram::Snapshot::Snapshot(uint32_t precision,
+				 std::vector<uint64_t>&& counts,
+				 uint64_t max):
+    precision_(precision), counts_(std::move(counts)), total_(0),
+    max_(max) {
+  for (uint64_t c : counts_) {
+    total_ += c;
+  }
+}
+
+double HdrHistogram::Snapshot::mean() const {
+  if (!total_) {
+    return 0.0;
+  }
+
+  double sum = 0.0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    if (counts_[i]) {
+      const double mid = ((double)bucketMin(i, precision_) +
+			  (double)bucketMax(i, precision_)) / 2.0;
+      sum += mid * (double)counts_[i];
+    }
+  }
+  return sum / (double)total_;
+}
+
+uint64_t HdrHistogram::Snapshot::percentile(double p) const {
+  if (!total_) {
+    return 0;
+  }
+
+  // Rank of the value at the given percentile, counting from one
+  uint64_t rank = (uint64_t)((p / 100.0) * total_ + 0.5);
+  rank = rank ? (rank > total_ ? total_ : rank) : 1;
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      const uint64_t upper = bucketMax(i, precision_);
+      return upper < max_ ? upper : max_;
+    }
+  }
+  return max_;
+}
+
+HdrHistogram::HdrHistogram(uint32_t precision):
+    precision_(precision), numBuckets_(0), counts_(), max_(0) {
+  if (!precision || (precision > MAX_PRECISION)) {
+    throw IllegalValueError("Precision must be from 1 to 16 bits",
+			    PISTIS_EX_HERE);
+  }
+  numBuckets_ = numBuckets(precision);
+  counts_.reset(new std::atomic<uint64_t>[numBuckets_]);
+  reset();
+}
+
+HdrHistogram::Snapshot HdrHistogram::snapshot() const {
+  std::vector<uint64_t> counts;
+  counts.reserve(numBuckets_);
+  for (size_t i = 0; i < numBuckets_; ++i) {
+    counts.push_back(counts_[i].load(std::memory_order_relaxed));
+  }
+  return Snapshot(precision_, std::move(counts),
+		  max_.load(std::memory_order_relaxed));
+}
+
+void HdrHistogram::reset() {
+  for (size_t i = 0; i < numBuckets_; ++i) {
+    counts_[i].store(0, std::memory_order_relaxed);
+  }
+  max_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,138 @@
+#ifndef __PISTIS__CONCURRENT__HDRHISTOGRAM_HPP__
+#define __PISTIS__CONCURRENT__HDRHISTOGRAM_HPP__
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A high-dynamic-range histogram whose counters can be
+     *         updated concurrently.
+     *
+     *  Values below 2^precision each have their own bucket.  Above
+     *  that, each power of two is split into 2^precision equal buckets,
+     *  so any value from zero to 2^64 - 1 is recorded with a relative
+     *  error below 2^-precision.  The default precision of 7 bits keeps
+     *  the error under 1% with 7424 buckets.
+     *
+     *  Recording a value is one relaxed atomic increment, plus a
+     *  compare-and-swap when it is a new maximum.  The maximum is kept
+     *  exactly.
+     */
+    class HdrHistogram {
+    public:
+      static const uint32_t DEFAULT_PRECISION = 7;
+      static const uint32_t MAX_PRECISION = 16;
+
+      /** @brief A point-in-time copy of a histogram's counters */
+      class Snapshot {
+      public:
+	Snapshot(uint32_t precision, std::vector<uint64_t>&& counts,
+		 uint64_t max);
+
+	uint32_t precision() const { return precision_; }
+	const std::vector<uint64_t>& counts() const { return counts_; }
+
+	/** @brief Total number of values recorded */
+	uint64_t total() const { return total_; }
+
+	/** @brief Largest value recorded, or zero if none were */
+	uint64_t max() const { return max_; }
+
+	/** @brief Mean of the recorded values, taking each as the
+	 *         midpoint of its bucket
+	 */
+	double mean() const;
+
+	/** @brief Upper bound of the bucket containing the given
+	 *         percentile, but no more than max(), or zero if the
+	 *         histogram is empty.
+	 *
+	 *  @param p  Percentile, from 0 to 100
+	 */
+	uint64_t percentile(double p) const;
+
+      private:
+	uint32_t precision_;
+	std::vector<uint64_t> counts_;
+	uint64_t total_;
+	uint64_t max_;
+      };
+
+    public:
+      /** @brief Create an empty histogram.
+       *
+       *  @param precision  Number of significant bits kept for each
+       *                    value, from 1 to MAX_PRECISION
+       *  @throws IllegalValueError if @c precision is out of range
+       */
+      HdrHistogram(uint32_t precision = DEFAULT_PRECISION);
+      HdrHistogram(const HdrHistogram&) = delete;
+
+      uint32_t precision() const { return precision_; }
+      size_t numBuckets() const { return numBuckets_; }
+
+      void record(uint64_t value) {
+	counts_[bucketFor(value, precision_)].fetch_add(
+	    1, std::memory_order_relaxed
+	);
+	uint64_t m = max_.load(std::memory_order_relaxed);
+	while ((value > m) &&
+	       !max_.compare_exchange_weak(m, value,
+					   std::memory_order_relaxed)) {
+	}
+      }
+
+      Snapshot snapshot() const;
+      void reset();
+
+      /** @brief Number of buckets for the given precision */
+      static size_t numBuckets(uint32_t precision) {
+	return (size_t)(65 - precision) << precision;
+      }
+
+      static size_t bucketFor(uint64_t value, uint32_t precision) {
+	if (value < ((uint64_t)1 << precision)) {
+	  return (size_t)value;
+	}
+	// Keep the top precision + 1 bits, whose leading bit is always 1
+	const uint32_t shift = 63 - __builtin_clzll(value) - precision;
+	return ((size_t)shift << precision) + (size_t)(value >> shift);
+      }
+
+      /** @brief Smallest value counted by the given bucket */
+      static uint64_t bucketMin(size_t bucket, uint32_t precision) {
+	const size_t sub = (size_t)1 << precision;
+	if (bucket < sub) {
+	  return (uint64_t)bucket;
+	}
+	const uint32_t shift = (uint32_t)(bucket >> precision) - 1;
+	return (uint64_t)(bucket - ((size_t)shift << precision)) << shift;
+      }
+
+      /** @brief Largest value counted by the given bucket */
+      static uint64_t bucketMax(size_t bucket, uint32_t precision) {
+	const size_t sub = (size_t)1 << precision;
+	if (bucket < sub) {
+	  return (uint64_t)bucket;
+	}
+	const uint32_t shift = (uint32_t)(bucket >> precision) - 1;
+	return bucketMin(bucket, precision) + (((uint64_t)1 << shift) - 1);
+      }
+
+      HdrHistogram& operator=(const HdrHistogram&) = delete;
+
+    private:
+      uint32_t precision_;
+      size_t numBuckets_;
+      std::unique_ptr< std::atomic<uint64_t>[] > counts_;
+      std::atomic<uint64_t> max_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,154 @@
+#include "LockProfiler.hpp"
+#include <pistis/concurrent/TscClock.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+const uint32_t LockProfiler::DEFAULT_SAMPLE_INTERVAL;
+std::atomic<bool> LockProfiler::enabled_(false);
+std::atomic<uint32_t> LockProfiler::sampleInterval_(
+    LockProfiler::DEFAULT_SAMPLE_INTERVAL
+);
+
+namespace {
+  struct Registry {
+    std::mutex sync;
+    std::unordered_map< const LockProfile*,
+			std::shared_ptr<LockProfile> > profiles;
+    std::unordered_map<const void*, std::string> names;
+  };
+
+  Registry& registry() {
+    static Registry* r = new Registry();  // Mutexes may outlive statics
+    return *r;
+  }
+
+  bool moreContended(const LockContention& x, const LockContention& y) {
+    if (x.waitNs != y.waitNs) {
+      return x.waitNs > y.waitNs;
+    }
+    return x.acquisitions > y.acquisitions;
+  }
+}
+
+LockProfile::LockProfile(const void* owner, const char* kind):
+    owner_(owner), kind_(kind), acquisitions_(0), contended_(0),
+    waitTicks_(0), maxWaitTicks_(0), holdSamples_(0), holdTicks_(0),
+    maxHoldTicks_(0) {
+}
+
+void LockProfile::reset() {
+  acquisitions_.store(0, std::memory_order_relaxed);
+  contended_.store(0, std::memory_order_relaxed);
+  waitTicks_.store(0, std::memory_order_relaxed);
+  maxWaitTicks_.store(0, std::memory_order_relaxed);
+  holdSamples_.store(0, std::memory_order_relaxed);
+  holdTicks_.store(0, std::memory_order_relaxed);
+  maxHoldTicks_.store(0, std::memory_order_relaxed);
+}
+
+void LockProfiler::setSampleInterval(uint32_t n) {
+  if (!n) {
+    throw IllegalValueError("Sample interval must be greater than zero",
+			    PISTIS_EX_HERE);
+  }
+  sampleInterval_.store(n, std::memory_order_relaxed);
+}
+
+void LockProfiler::name(const void* owner, const std::string& name) {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.names[owner] = name;
+}
+
+void LockProfiler::forget(const void* owner) {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.names.erase(owner);
+}
+
+std::vector<LockContention> LockProfiler::report(size_t n) {
+  std::vector<LockContention> rows;
+  {
+    Registry& r = registry();
+    std::unique_lock<std::mutex> lock(r.sync);
+    rows.reserve(r.profiles.size());
+    for (const auto& entry : r.profiles) {
+      const LockProfile* p = entry.first;
+      auto i = r.names.find(p->owner());
+      const uint64_t holdSamples = p->holdSamples();
+      rows.push_back(LockContention{
+	  p->owner(), p->kind(),
+	  (i == r.names.end()) ? std::string() : i->second,
+	  p->acquisitions(), p->contended(),
+	  TscClock::toNs(p->waitTicks()), TscClock::toNs(p->maxWaitTicks()),
+	  holdSamples,
+	  holdSamples ? TscClock::toNs(p->holdTicks()) / (double)holdSamples
+	              : 0.0,
+	  TscClock::toNs(p->maxHoldTicks())
+      });
+    }
+  }
+
+  const size_t top = std::min(n, rows.size());
+  std::partial_sort(rows.begin(), rows.begin() + top, rows.end(),
+		    moreContended);
+  rows.resize(top);
+  return rows;
+}
+
+void LockProfiler::writeReport(std::ostream& out, size_t n) {
+  const std::vector<LockContention> rows = report(n);
+  out << std::left << std::setw(32) << "object" << std::right
+      << std::setw(14) << "acquisitions" << std::setw(12) << "contended"
+      << std::setw(14) << "wait ms" << std::setw(14) << "max wait us"
+      << std::setw(14) << "mean hold ns" << std::setw(14) << "max hold us"
+      << std::endl;
+
+  out << std::fixed;
+  for (const LockContention& c : rows) {
+    std::ostringstream label;
+    label << c.kind << ' ';
+    if (c.name.empty()) {
+      label << c.owner;
+    } else {
+      label << c.name;
+    }
+    out << std::left << std::setw(32) << label.str() << std::right
+	<< std::setw(14) << c.acquisitions << std::setw(12) << c.contended
+	<< std::setprecision(3) << std::setw(14) << c.waitNs / 1e6
+	<< std::setprecision(1) << std::setw(14) << c.maxWaitNs / 1e3
+	<< std::setw(14) << c.meanHoldNs
+	<< std::setw(14) << c.maxHoldNs / 1e3 << std::endl;
+  }
+  out.unsetf(std::ios::floatfield);
+}
+
+void LockProfiler::reset() {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  for (const auto& entry : r.profiles) {
+    entry.second->reset();
+  }
+}
+
+std::shared_ptr<LockProfile> LockProfiler::attach(const void* owner,
+						  const char* kind) {
+  std::shared_ptr<LockProfile> profile(new LockProfile(owner, kind));
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.profiles.insert(std::make_pair(profile.get(), profile));
+  return profile;
+}
+
+void LockProfiler::detach(const LockProfile* profile) {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.profiles.erase(profile);
+}
@@ -0,0 +1,194 @@
+#ifndef __PISTIS__CONCURRENT__LOCKPROFILER_HPP__
+#define __PISTIS__CONCURRENT__LOCKPROFILER_HPP__
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Set to 0 to compile lock profiling out of ProfiledMutex */
+#ifndef PISTIS_CONCURRENT_LOCK_PROFILING
+#define PISTIS_CONCURRENT_LOCK_PROFILING 1
+#endif
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief Acquisition and hold times of one ProfiledMutex.
+     *
+     *  Updated by the thread that holds the mutex.  Times are in
+     *  TscClock ticks.
+     */
+    class LockProfile {
+    public:
+      LockProfile(const void* owner, const char* kind);
+      LockProfile(const LockProfile&) = delete;
+
+      /** @brief The object that owns the mutex */
+      const void* owner() const { return owner_; }
+
+      /** @brief The owner's class, such as "Queue" */
+      const char* kind() const { return kind_; }
+
+      uint64_t acquisitions() const {
+	return acquisitions_.load(std::memory_order_relaxed);
+      }
+      uint64_t contended() const {
+	return contended_.load(std::memory_order_relaxed);
+      }
+      uint64_t waitTicks() const {
+	return waitTicks_.load(std::memory_order_relaxed);
+      }
+      uint64_t maxWaitTicks() const {
+	return maxWaitTicks_.load(std::memory_order_relaxed);
+      }
+      uint64_t holdSamples() const {
+	return holdSamples_.load(std::memory_order_relaxed);
+      }
+      uint64_t holdTicks() const {
+	return holdTicks_.load(std::memory_order_relaxed);
+      }
+      uint64_t maxHoldTicks() const {
+	return maxHoldTicks_.load(std::memory_order_relaxed);
+      }
+
+      /** @brief Count one acquisition that waited @c ticks, or did not
+       *         wait at all if @c ticks is zero
+       */
+      void recordAcquisition(uint64_t ticks) {
+	acquisitions_.fetch_add(1, std::memory_order_relaxed);
+	if (ticks) {
+	  contended_.fetch_add(1, std::memory_order_relaxed);
+	  waitTicks_.fetch_add(ticks, std::memory_order_relaxed);
+	  recordMax_(maxWaitTicks_, ticks);
+	}
+      }
+
+      void recordHold(uint64_t ticks) {
+	holdSamples_.fetch_add(1, std::memory_order_relaxed);
+	holdTicks_.fetch_add(ticks, std::memory_order_relaxed);
+	recordMax_(maxHoldTicks_, ticks);
+      }
+
+      void reset();
+
+      LockProfile& operator=(const LockProfile&) = delete;
+
+    private:
+      const void* owner_;
+      const char* kind_;
+      std::atomic<uint64_t> acquisitions_;
+      std::atomic<uint64_t> contended_;
+      std::atomic<uint64_t> waitTicks_;
+      std::atomic<uint64_t> maxWaitTicks_;
+      std::atomic<uint64_t> holdSamples_;
+      std::atomic<uint64_t> holdTicks_;
+      std::atomic<uint64_t> maxHoldTicks_;
+
+      static void recordMax_(std::atomic<uint64_t>& m, uint64_t value) {
+	uint64_t current = m.load(std::memory_order_relaxed);
+	while ((value > current) &&
+	       !m.compare_exchange_weak(current, value,
+					std::memory_order_relaxed)) {
+	}
+      }
+    };
+
+    /** @brief One row of a contention report.  Times are in
+     *         nanoseconds.
+     */
+    struct LockContention {
+      const void* owner;
+      std::string kind;
+      std::string name;           ///< From LockProfiler::name(), or empty
+      uint64_t acquisitions;
+      uint64_t contended;         ///< Acquisitions that had to wait
+      double waitNs;              ///< Total time spent waiting
+      double maxWaitNs;
+      uint64_t holdSamples;       ///< Acquisitions whose hold was timed
+      double meanHoldNs;
+      double maxHoldNs;
+    };
+
+    /** @brief Finds the library's most contended mutexes.
+     *
+     *  Queue, PriorityQueue, ShardedQueue and Condition guard their
+     *  state with a ProfiledMutex.  Profiling is off until enable() is called, and
+     *  until then ProfiledMutex costs one relaxed load and a branch
+     *  more than std::mutex.  Defining PISTIS_CONCURRENT_LOCK_PROFILING
+     *  as 0 removes even that.
+     *
+     *  While profiling is on, every acquisition that finds the mutex
+     *  locked is timed, and one in every sampleInterval() acquisitions
+     *  also has its hold time measured.  Each mutex's statistics are
+     *  attributed to the object that owns it, which name() can label.
+     *  A mutex joins the profile the first time it is locked while
+     *  profiling is on and leaves it when it is destroyed.
+     */
+    class LockProfiler {
+    public:
+      static const uint32_t DEFAULT_SAMPLE_INTERVAL = 16;
+
+    public:
+      LockProfiler() = delete;
+
+      static bool enabled() {
+	return PISTIS_CONCURRENT_LOCK_PROFILING &&
+	       enabled_.load(std::memory_order_relaxed);
+      }
+
+      static void enable() { enabled_.store(true, std::memory_order_relaxed); }
+      static void disable() {
+	enabled_.store(false, std::memory_order_relaxed);
+      }
+
+      static uint32_t sampleInterval() {
+	return sampleInterval_.load(std::memory_order_relaxed);
+      }
+
+      /** @brief Time the hold of one in every @c n acquisitions
+       *
+       *  @throws IllegalValueError if @c n is zero
+       */
+      static void setSampleInterval(uint32_t n);
+
+      /** @brief Call @c owner by @c name in reports */
+      static void name(const void* owner, const std::string& name);
+
+      /** @brief Forget the name given to @c owner */
+      static void forget(const void* owner);
+
+      /** @brief The @c n mutexes that have spent the most time waiting,
+       *         most contended first.  Mutexes that never waited are
+       *         ranked by number of acquisitions.
+       */
+      static std::vector<LockContention> report(size_t n = 10);
+
+      /** @brief Write report(n) as a table */
+      static void writeReport(std::ostream& out, size_t n = 10);
+
+      /** @brief Zero the statistics of every profiled mutex */
+      static void reset();
+
+      /** @brief Add a mutex's profile to the report.  Called by
+       *         ProfiledMutex.
+       */
+      static std::shared_ptr<LockProfile> attach(const void* owner,
+						 const char* kind);
+
+      /** @brief Remove a mutex's profile from the report.  Called by
+       *         ProfiledMutex when it is destroyed.
+       */
+      static void detach(const LockProfile* profile);
+
+    private:
+      static std::atomic<bool> enabled_;
+      static std::atomic<uint32_t> sampleInterval_;
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,191 @@
+#include "NumaTopology.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <ctype.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+const char* const NumaTopology::DEFAULT_SYSFS_ROOT =
+    "/sys/devices/system/node";
+
+namespace {
+  // Node set by bindCurrentThread(), or -1
+  thread_local long boundNode = -1;
+
+  bool readLine(const std::string& path, std::string& line) {
+    std::ifstream in(path);
+    return (bool)std::getline(in, line);
+  }
+
+  /** @brief Kernel node numbers of the "nodeN" directories under
+   *         @c root, in increasing order
+   */
+  std::vector<int> listNodes(const std::string& root) {
+    std::vector<int> nodes;
+    DIR* dir = ::opendir(root.c_str());
+    if (!dir) {
+      return nodes;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+      const char* name = entry->d_name;
+      if ((::strncmp(name, "node", 4) == 0) && ::isdigit(name[4])) {
+	char* end = nullptr;
+	const long id = ::strtol(name + 4, &end, 10);
+	if (!*end) {
+	  nodes.push_back((int)id);
+	}
+      }
+    }
+    ::closedir(dir);
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+  }
+
+  std::vector<int> onlineCpus() {
+    std::string line;
+    if (readLine("/sys/devices/system/cpu/online", line)) {
+      return NumaTopology::parseCpuList(line);
+    }
+    std::vector<int> cpus;
+    const unsigned n = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned i = 0; i < n; ++i) {
+      cpus.push_back((int)i);
+    }
+    return cpus;
+  }
+}
+
+NumaTopology::NumaTopology(const std::string& sysfsRoot):
+    nodeCpus_(), kernelNodes_(), cpuNodes_(), simulated_(false) {
+  for (int id : listNodes(sysfsRoot)) {
+    std::ostringstream path;
+    path << sysfsRoot << "/node" << id << "/cpulist";
+    std::string line;
+    kernelNodes_.push_back(id);
+    nodeCpus_.push_back(readLine(path.str(), line) ? parseCpuList(line)
+			                           : std::vector<int>());
+  }
+  if (nodeCpus_.empty()) {
+    kernelNodes_.push_back(0);
+    nodeCpus_.push_back(onlineCpus());
+  }
+  indexCpus_();
+}
+
+NumaTopology::NumaTopology(const std::vector< std::vector<int> >& nodeCpus):
+    nodeCpus_(nodeCpus), kernelNodes_(nodeCpus.size(), -1), cpuNodes_(),
+    simulated_(true) {
+  if (nodeCpus_.empty()) {
+    throw IllegalValueError("A NUMA topology must have at least one node",
+			    PISTIS_EX_HERE);
+  }
+  indexCpus_();
+}
+
+const NumaTopology& NumaTopology::system() {
+  static const NumaTopology topology(DEFAULT_SYSFS_ROOT);
+  return topology;
+}
+
+NumaTopology NumaTopology::simulate(size_t numNodes) {
+  if (!numNodes) {
+    throw IllegalValueError("A NUMA topology must have at least one node",
+			    PISTIS_EX_HERE);
+  }
+
+  std::vector<int> cpus;
+  const NumaTopology& s = system();
+  for (size_t i = 0; i < s.numNodes(); ++i) {
+    cpus.insert(cpus.end(), s.cpus(i).begin(), s.cpus(i).end());
+  }
+  std::sort(cpus.begin(), cpus.end());
+
+  std::vector< std::vector<int> > nodeCpus(numNodes);
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    nodeCpus[i % numNodes].push_back(cpus[i]);
+  }
+  return NumaTopology(nodeCpus);
+}
+
+size_t NumaTopology::currentNode() const {
+  if (boundNode >= 0) {
+    return (size_t)boundNode % numNodes();
+  }
+  return nodeOfCpu(::sched_getcpu());
+}
+
+void NumaTopology::bindCurrentThread(size_t node) const {
+  if (node >= numNodes()) {
+    throw IllegalValueError("Illegal value for NUMA node (out of range)",
+			    PISTIS_EX_HERE);
+  }
+  if (!nodeCpus_[node].empty()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : nodeCpus_[node]) {
+      CPU_SET(cpu, &cpus);
+    }
+    const int result =
+	::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+    if (result) {
+      throw SystemError::fromSystemCode(
+	  "Cannot bind thread to NUMA node: #ERR#", result, PISTIS_EX_HERE
+      );
+    }
+  }
+  boundNode = (long)node;
+}
+
+void NumaTopology::unbindCurrentThread() {
+  boundNode = -1;
+}
+
+std::vector<int> NumaTopology::parseCpuList(const std::string& text) {
+  std::vector<int> cpus;
+  std::istringstream in(text);
+  std::string range;
+  while (std::getline(in, range, ',')) {
+    range.erase(std::remove_if(range.begin(), range.end(), ::isspace),
+		range.end());
+    if (range.empty()) {
+      continue;
+    }
+
+    char* end = nullptr;
+    const long first = ::strtol(range.c_str(), &end, 10);
+    long last = first;
+    if (*end == '-') {
+      last = ::strtol(end + 1, &end, 10);
+    }
+    if (*end || (end == range.c_str()) || (first < 0) || (last < first)) {
+      throw IllegalValueError("Malformed CPU list \"" + text + "\"",
+			      PISTIS_EX_HERE);
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back((int)cpu);
+    }
+  }
+  return cpus;
+}
+
+void NumaTopology::indexCpus_() {
+  for (size_t node = 0; node < nodeCpus_.size(); ++node) {
+    for (int cpu : nodeCpus_[node]) {
+      if ((size_t)cpu >= cpuNodes_.size()) {
+	cpuNodes_.resize(cpu + 1, 0);
+      }
+      cpuNodes_[cpu] = node;
+    }
+  }
+}
@@ -0,0 +1,117 @@
+#ifndef __PISTIS__CONCURRENT__NUMATOPOLOGY_HPP__
+#define __PISTIS__CONCURRENT__NUMATOPOLOGY_HPP__
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief The NUMA nodes of a machine and the CPUs on each.
+     *
+     *  system() reads the topology from /sys/devices/system/node once.
+     *  A machine without that directory, such as a kernel built
+     *  without NUMA support, has a single node holding every CPU.
+     *
+     *  A topology can also be simulated, so code that places threads
+     *  and memory by node can be exercised and benchmarked on a
+     *  single-node machine.  A simulated topology deals the machine's
+     *  CPUs out to its nodes round-robin; when there are more nodes
+     *  than CPUs, some nodes have no CPUs.  Memory placement on a
+     *  simulated node falls back to the default policy.
+     *
+     *  Each thread has a current node.  It is the node of the CPU the
+     *  thread is running on, unless the thread has called
+     *  bindCurrentThread(), which pins it to a node's CPUs and makes
+     *  that node current whether or not the node has any CPUs.
+     */
+    class NumaTopology {
+    public:
+      static const char* const DEFAULT_SYSFS_ROOT;
+
+    public:
+      /** @brief Read the topology from @c sysfsRoot, which has the
+       *         layout of /sys/devices/system/node
+       *
+       *  @throws IllegalValueError if a node's cpulist is malformed
+       */
+      explicit NumaTopology(const std::string& sysfsRoot);
+
+      /** @brief A simulated topology with the given CPUs on each node
+       *
+       *  @throws IllegalValueError if there are no nodes
+       */
+      explicit NumaTopology(
+	  const std::vector< std::vector<int> >& nodeCpus
+      );
+
+      /** @brief The topology of this machine */
+      static const NumaTopology& system();
+
+      /** @brief A topology of @c numNodes nodes sharing this machine's
+       *         CPUs
+       *
+       *  @throws IllegalValueError if @c numNodes is zero
+       */
+      static NumaTopology simulate(size_t numNodes);
+
+      size_t numNodes() const { return nodeCpus_.size(); }
+      bool simulated() const { return simulated_; }
+
+      /** @brief The kernel's number for the given node, or -1 if the
+       *         topology is simulated
+       */
+      int kernelNode(size_t node) const {
+	return simulated_ ? -1 : kernelNodes_[node];
+      }
+
+      /** @brief CPUs on the given node */
+      const std::vector<int>& cpus(size_t node) const {
+	return nodeCpus_[node];
+      }
+
+      /** @brief Node holding the given CPU, or node zero if the CPU is
+       *         unknown
+       */
+      size_t nodeOfCpu(int cpu) const {
+	return ((cpu >= 0) && ((size_t)cpu < cpuNodes_.size()))
+	           ? cpuNodes_[cpu] : 0;
+      }
+
+      /** @brief Current node of the calling thread */
+      size_t currentNode() const;
+
+      /** @brief Pin the calling thread to the CPUs of @c node, if it
+       *         has any, and make @c node its current node for every
+       *         topology.
+       *
+       *  @throws IllegalValueError if @c node is out of range
+       *  @throws SystemError if the thread cannot be pinned
+       */
+      void bindCurrentThread(size_t node) const;
+
+      /** @brief Forget the node set by bindCurrentThread().  Does not
+       *         change the thread's CPU affinity.
+       */
+      static void unbindCurrentThread();
+
+      /** @brief Parse a list of CPUs in the kernel's format, such as
+       *         "0-3,8,10-11"
+       *
+       *  @throws IllegalValueError if @c text is malformed
+       */
+      static std::vector<int> parseCpuList(const std::string& text);
+
+    private:
+      std::vector< std::vector<int> > nodeCpus_;
+      std::vector<int> kernelNodes_;
+      std::vector<size_t> cpuNodes_;
+      bool simulated_;
+
+      void indexCpus_();
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,286 @@
+#ifndef __PISTIS__CONCURRENT__PIPELINE_HPP__
+#define __PISTIS__CONCURRENT__PIPELINE_HPP__
+
+#include <pistis/concurrent/Stage.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A chain of Stages connected by pollable Queues.
+     *
+     *  A pipeline is built by adding stages with then() or thenBatch(),
+     *  each of which returns a new pipeline whose output type is the
+     *  output type of the new stage:
+     *
+     *      auto pipeline = Pipeline<std::string>()
+     *          .then("parse", [](std::string&& s) { return parse(s); })
+     *          .then("score", score, StageConfig{ 4 });
+     *      pipeline.start();
+     *      pipeline.put(line);
+     *      Score s = pipeline.get();
+     *
+     *  put() assigns each item a sequence number, which ORDERED stages
+     *  use to restore the order put() saw.  Backpressure flows from the
+     *  output queue back to the input queue one stage at a time (see
+     *  Stage), so a producer that cannot keep up with the pipeline's
+     *  pace sees the input queue's HIGH_WATER_MARK event and, once the
+     *  input queue is full, blocks in put().
+     *
+     *  Items must be default constructible and movable.
+     */
+    template <typename In, typename Out = In>
+    class Pipeline {
+    public:
+      typedef In InputType;
+      typedef Out OutputType;
+      typedef pollable::Queue< StageEnvelope<In> > InputQueue;
+      typedef pollable::Queue< StageEnvelope<Out> > OutputQueue;
+
+    private:
+      template <typename, typename> friend class Pipeline;
+
+    public:
+      /** @brief Create an empty pipeline
+       *
+       *  @param outputSize  Number of results the pipeline's output
+       *                     queue is sized for.  The last stage pauses
+       *                     at three quarters of this and resumes at one
+       *                     quarter.  The queue itself is unbounded, so
+       *                     that finish() can drain the stages into it
+       *                     while nobody calls get().
+       */
+      explicit Pipeline(size_t outputSize = 1024):
+	  stages_(), input_(nullptr), connectTail_(),
+	  output_(), outputSize_(outputSize),
+	  nextSeq_(new std::atomic<uint64_t>(0)) {
+      }
+
+      Pipeline(const Pipeline&) = delete;
+      Pipeline(Pipeline&&) = default;
+
+      ~Pipeline() { stop(); }
+
+      size_t numStages() const { return stages_.size(); }
+      bool running() const { return (bool)output_; }
+
+      /** @brief Append a stage that calls @c f once per item.  The
+       *         stage's output type is the return type of @c f.
+       */
+      template <typename Function,
+		typename Next = decltype(std::declval<Function>()(
+		    std::declval<Out&&>()
+		))>
+      Pipeline<In, Next> then(const std::string& name, Function f,
+			      const StageConfig& config = StageConfig()) {
+	typedef Stage<Out, Next> NewStage;
+	return append_<Next>(std::unique_ptr<NewStage>(
+	    new NewStage(name, typename NewStage::Function(std::move(f)),
+			 config)
+	));
+      }
+
+      /** @brief Append a stage that calls @c f once per batch of up to
+       *         config.batchSize items.  See Stage.
+       */
+      template <typename Next>
+      Pipeline<In, Next> thenBatch(
+	  const std::string& name,
+	  typename Stage<Out, Next>::BatchFunction f,
+	  const StageConfig& config = StageConfig()
+      ) {
+	typedef Stage<Out, Next> NewStage;
+	return append_<Next>(std::unique_ptr<NewStage>(
+	    new NewStage(name, std::move(f), config)
+	));
+      }
+
+      /** @brief Start every stage */
+      void start() {
+	if (stages_.empty()) {
+	  throw pistis::exceptions::IllegalStateError(
+	      "Pipeline has no stages", PISTIS_EX_HERE
+	  );
+	} else if (running()) {
+	  throw pistis::exceptions::IllegalStateError(
+	      "Pipeline is already running", PISTIS_EX_HERE
+	  );
+	}
+
+	output_.reset(new OutputQueue(OutputQueue::MAX_QUEUE_SIZE,
+				      outputSize_ / 4, outputSize_ * 3 / 4));
+	connectTail_(*output_);
+	for (auto& stage : stages_) {
+	  stage->start();
+	}
+      }
+
+      /** @brief Process every item already put, then stop the stages.
+       *         Results remain available from get().
+       *
+       *  The stages stop pausing for backpressure first, so finish()
+       *  does not need anyone to call get() while it runs.
+       */
+      void finish() {
+	for (auto& stage : stages_) {
+	  stage->ignoreBackpressure();
+	}
+	for (auto& stage : stages_) {
+	  stage->finish();
+	}
+      }
+
+      /** @brief Stop every stage once its current batches are done */
+      void stop() {
+	for (auto& stage : stages_) {
+	  stage->stop();
+	}
+      }
+
+      /** @brief Put an item into the pipeline, waiting up to @c timeout
+       *         ms (-1 = forever) for room in the input queue
+       */
+      bool put(In item, int64_t timeout = -1) {
+	checkStages_();
+	StageEnvelope<In> envelope(nextSeq_->fetch_add(1), StageBase::now(),
+				   true, std::move(item));
+	return input_->put(std::move(envelope), timeout);
+      }
+
+      Out get() {
+	Out result = Out();
+	get(result, -1);
+	return result;
+      }
+
+      /** @brief Take the next result, waiting up to @c timeout ms
+       *         (-1 = forever) for one
+       */
+      bool get(Out& result, int64_t timeout = 0) {
+	checkRunning_();
+	StageEnvelope<Out> envelope;
+	auto deadline = std::chrono::steady_clock::now() +
+	                std::chrono::milliseconds(timeout);
+	while (true) {
+	  int64_t remaining = timeout;
+	  if (timeout > 0) {
+	    remaining = std::max((int64_t)0, (int64_t)
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+		    deadline - std::chrono::steady_clock::now()
+		).count());
+	  }
+	  if (!output_->get(envelope, remaining)) {
+	    return false;
+	  }
+	  // Results of failed batches are dropped here
+	  if (envelope.valid) {
+	    result = std::move(envelope.item);
+	    return true;
+	  }
+	}
+      }
+
+      /** @brief The input queue's state fd.  See Queue::queueStateFd(). */
+      int inputStateFd() {
+	checkStages_();
+	return input_->queueStateFd();
+      }
+
+      /** @brief The output queue's state fd.  Only valid while running. */
+      int outputStateFd() {
+	checkRunning_();
+	return output_->queueStateFd();
+      }
+
+      /** @brief Wait for an event on the input queue, such as
+       *         HIGH_WATER_MARK or LOW_WATER_MARK
+       */
+      bool waitOnInput(int64_t timeout, pollable::QueueEventType eventType) {
+	checkStages_();
+	return input_->wait(timeout, eventType);
+      }
+
+      std::vector<StageStatistics::Snapshot> statistics() const {
+	std::vector<StageStatistics::Snapshot> result;
+	for (const auto& stage : stages_) {
+	  result.push_back(stage->statistics());
+	}
+	return result;
+      }
+
+      Pipeline& operator=(const Pipeline&) = delete;
+      Pipeline& operator=(Pipeline&&) = default;
+
+    private:
+      std::vector< std::unique_ptr<StageBase> > stages_;
+      InputQueue* input_;
+      std::function<void (OutputQueue&)> connectTail_;
+      std::unique_ptr<OutputQueue> output_;
+      size_t outputSize_;
+
+      // Behind a pointer so the pipeline stays movable
+      std::unique_ptr< std::atomic<uint64_t> > nextSeq_;
+
+      template <typename Next>
+      Pipeline<In, Next> append_(std::unique_ptr< Stage<Out, Next> > stage) {
+	if (running()) {
+	  throw pistis::exceptions::IllegalStateError(
+	      "Cannot add a stage to a running pipeline", PISTIS_EX_HERE
+	  );
+	}
+
+	Stage<Out, Next>* s = stage.get();
+	Pipeline<In, Next> result(outputSize_);
+	if (stages_.empty()) {
+	  // Only an empty pipeline has no stages, and its In and Out are
+	  // the same type
+	  result.input_ = firstInput_(&s->input(), std::is_same<In, Out>());
+	} else {
+	  connectTail_(s->input());
+	  result.input_ = input_;
+	}
+	result.stages_ = std::move(stages_);
+	result.stages_.push_back(std::move(stage));
+	result.connectTail_ = [s](typename Stage<Out, Next>::OutputQueue& q) {
+	  s->connect(q);
+	};
+	input_ = nullptr;
+	return result;
+      }
+
+      static InputQueue* firstInput_(InputQueue* q, std::true_type) {
+	return q;
+      }
+
+      template <typename Queue>
+      static InputQueue* firstInput_(Queue*, std::false_type) {
+	return nullptr;
+      }
+
+      void checkStages_() const {
+	if (!input_) {
+	  throw pistis::exceptions::IllegalStateError(
+	      "Pipeline has no stages", PISTIS_EX_HERE
+	  );
+	}
+      }
+
+      void checkRunning_() const {
+	if (!running()) {
+	  throw pistis::exceptions::IllegalStateError(
+	      "Pipeline is not running", PISTIS_EX_HERE
+	  );
+	}
+      }
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,103 @@
+#ifndef __PISTIS__CONCURRENT__POOLALLOCATOR_HPP__
+#define __PISTIS__CONCURRENT__POOLALLOCATOR_HPP__
+
+#include <pistis/concurrent/BlockPool.hpp>
+#include <memory>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A standard allocator that serves requests from a
+     *         thread-safe BlockPool.
+     *
+     *  Requests that fit in one of the pool's blocks come from the pool;
+     *  larger requests go to the global allocator.  With the default
+     *  block size, every node of a std::deque of small items -- and so
+     *  every block a Queue allocates as it grows and shrinks -- comes
+     *  from the pool.
+     *
+     *  Copies of an allocator, including rebound copies, share the same
+     *  pool and compare equal.  A default-constructed allocator creates a
+     *  new pool with the default block size.  To share one pool between
+     *  several containers, construct their allocators from the same
+     *  pool.  The pool lives until the last allocator using it is
+     *  destroyed.
+     */
+    template <typename T>
+    class PoolAllocator {
+    public:
+      typedef T value_type;
+      typedef std::true_type propagate_on_container_copy_assignment;
+      typedef std::true_type propagate_on_container_move_assignment;
+      typedef std::true_type propagate_on_container_swap;
+
+      template <typename U>
+      struct rebind {
+	typedef PoolAllocator<U> other;
+      };
+
+    public:
+      PoolAllocator(): pool_(std::make_shared<BlockPool>()) { }
+      explicit PoolAllocator(const std::shared_ptr<BlockPool>& pool):
+	  pool_(pool) {
+      }
+      template <typename U>
+      PoolAllocator(const PoolAllocator<U>& other): pool_(other.pool()) { }
+
+      /** @brief An allocator with a new pool of default-sized blocks
+       *         whose chunks are placed on the given NUMA node.
+       *
+       *  @param kernelNode  The kernel's number for the node, as from
+       *                     NumaTopology::kernelNode(), or -1 for no
+       *                     placement
+       */
+      static PoolAllocator onNumaNode(int kernelNode) {
+	return PoolAllocator(std::make_shared<BlockPool>(
+	    BlockPool::DEFAULT_BLOCK_SIZE, BlockPool::DEFAULT_BLOCKS_PER_CHUNK,
+	    kernelNode
+	));
+      }
+
+      const std::shared_ptr<BlockPool>& pool() const { return pool_; }
+
+      T* allocate(size_t n) {
+	if (fromPool_(n)) {
+	  return static_cast<T*>(pool_->allocate());
+	} else {
+	  return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+      }
+
+      void deallocate(T* p, size_t n) {
+	if (fromPool_(n)) {
+	  pool_->deallocate(p);
+	} else {
+	  ::operator delete(p);
+	}
+      }
+
+      template <typename U>
+      bool operator==(const PoolAllocator<U>& other) const {
+	return pool_ == other.pool();
+      }
+
+      template <typename U>
+      bool operator!=(const PoolAllocator<U>& other) const {
+	return pool_ != other.pool();
+      }
+
+    private:
+      std::shared_ptr<BlockPool> pool_;
+
+      bool fromPool_(size_t n) const {
+	return (n <= pool_->blockSize() / sizeof(T)) &&
+	       (alignof(T) <= alignof(std::max_align_t));
+      }
+    };
+
+  }
+}
+#endif
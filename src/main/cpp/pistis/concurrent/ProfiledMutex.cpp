@@ -0,0 +1,38 @@
+#include "ProfiledMutex.hpp"
+#include <pistis/concurrent/TscClock.hpp>
+#include <algorithm>
+
+using namespace pistis::concurrent;
+
+ProfiledMutex::~ProfiledMutex() {
+  if (profile_) {
+    LockProfiler::detach(profile_.get());
+  }
+}
+
+void ProfiledMutex::lockProfiled_() {
+  if (m_.try_lock()) {
+    acquired_(0);
+  } else {
+    const uint64_t start = TscClock::now();
+    m_.lock();
+    // A wait too short for the clock to see still counts as contended
+    acquired_(std::max(TscClock::now() - start, (uint64_t)1));
+  }
+}
+
+void ProfiledMutex::acquired_(uint64_t waitTicks) {
+  if (!profile_) {
+    profile_ = LockProfiler::attach(owner_, kind_);
+  }
+  profile_->recordAcquisition(waitTicks);
+  if (++sinceSample_ >= LockProfiler::sampleInterval()) {
+    sinceSample_ = 0;
+    holdStart_ = TscClock::now();
+  }
+}
+
+void ProfiledMutex::releaseProfiled_() {
+  profile_->recordHold(TscClock::now() - holdStart_);
+  holdStart_ = 0;
+}
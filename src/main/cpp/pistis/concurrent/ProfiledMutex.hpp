@@ -0,0 +1,77 @@
+#ifndef __PISTIS__CONCURRENT__PROFILEDMUTEX_HPP__
+#define __PISTIS__CONCURRENT__PROFILEDMUTEX_HPP__
+
+#include <pistis/concurrent/LockProfiler.hpp>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A std::mutex that reports its contention to LockProfiler.
+     *
+     *  Meets the Lockable requirements, so it works with
+     *  std::unique_lock and std::lock_guard.  While LockProfiler is
+     *  disabled it behaves exactly like std::mutex.
+     */
+    class ProfiledMutex {
+    public:
+      /** @brief Create a mutex whose statistics are attributed to
+       *         @c owner, an object of class @c kind.
+       *
+       *  @c kind must be a string literal or otherwise outlive the
+       *  mutex's profile.
+       */
+      ProfiledMutex(const void* owner, const char* kind):
+	  m_(), owner_(owner), kind_(kind), profile_(), holdStart_(0),
+	  sinceSample_(0) {
+      }
+      ProfiledMutex(const ProfiledMutex&) = delete;
+      ~ProfiledMutex();
+
+      void lock() {
+	if (LockProfiler::enabled()) {
+	  lockProfiled_();
+	} else {
+	  m_.lock();
+	}
+      }
+
+      bool try_lock() {
+	if (!m_.try_lock()) {
+	  return false;
+	}
+	if (LockProfiler::enabled()) {
+	  acquired_(0);
+	}
+	return true;
+      }
+
+      void unlock() {
+	if (holdStart_) {
+	  releaseProfiled_();
+	}
+	m_.unlock();
+      }
+
+      ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    private:
+      std::mutex m_;
+      const void* owner_;
+      const char* kind_;
+      std::shared_ptr<LockProfile> profile_;
+
+      // Only touched by the thread holding m_
+      uint64_t holdStart_;    ///< Nonzero if this hold is being timed
+      uint32_t sinceSample_;  ///< Acquisitions since a hold was timed
+
+      void lockProfiled_();
+      void acquired_(uint64_t waitTicks);
+      void releaseProfiled_();
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,84 @@
+#include "Stage.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <sstream>
+
+using namespace pistis::concurrent;
+using namespace pistis::exceptions;
+
+namespace {
+  static const StageConfig& validate(const std::string& name,
+				     const StageConfig& config) {
+    std::ostringstream msg;
+    if (!config.workers) {
+      msg << "Stage " << name << " must have at least one worker";
+    } else if (!config.batchSize) {
+      msg << "Stage " << name << " must have a batch size of at least one";
+    } else {
+      return config;
+    }
+    throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+  }
+}
+
+const int64_t StageBase::POLL_INTERVAL;
+const int StageBase::RUNNING_;
+const int StageBase::DRAINING_;
+const int StageBase::STOPPING_;
+
+StageBase::StageBase(const std::string& name, const StageConfig& config):
+    stats_(), name_(name), config_(validate(name, config)), workers_(),
+    state_(RUNNING_), throttle_(true) {
+}
+
+StageBase::~StageBase() {
+  // Derived classes must stop their workers, because the workers call
+  // back into them
+}
+
+void StageBase::start() {
+  if (running()) {
+    throw IllegalStateError("Stage " + name_ + " is already running",
+			    PISTIS_EX_HERE);
+  }
+  state_.store(RUNNING_, std::memory_order_release);
+  throttle_.store(true, std::memory_order_release);
+  try {
+    for (size_t i = 0; i < config_.workers; ++i) {
+      workers_.push_back(config_.threads.start(i, [this]() { work_(); }));
+    }
+  } catch(...) {
+    stop();
+    throw;
+  }
+}
+
+void StageBase::finish() {
+  join_(DRAINING_);
+}
+
+void StageBase::stop() {
+  join_(STOPPING_);
+}
+
+void StageBase::join_(int state) {
+  state_.store(state, std::memory_order_release);
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+}
+
+void StageBase::work_() {
+  while (true) {
+    const int state = state_.load(std::memory_order_acquire);
+    if (state == STOPPING_) {
+      break;
+    }
+
+    // A draining worker stops once it finds the input queue empty.
+    // Upstream stages have already finished, so nothing more will come.
+    if (!runBatch_() && (state == DRAINING_)) {
+      break;
+    }
+  }
+}
@@ -0,0 +1,360 @@
+#ifndef __PISTIS__CONCURRENT__STAGE_HPP__
+#define __PISTIS__CONCURRENT__STAGE_HPP__
+
+#include <pistis/concurrent/StageStatistics.hpp>
+#include <pistis/concurrent/ThreadConfig.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief Order in which a Stage emits its results */
+    enum class StageOrder {
+      /** @brief Results leave as soon as they are ready */
+      UNORDERED,
+
+      /** @brief Results leave in the order the pipeline received the
+       *         items they came from
+       */
+      ORDERED
+    };
+
+    /** @brief How a pipeline Stage runs */
+    struct StageConfig {
+      /** @brief Number of worker threads */
+      size_t workers = 1;
+
+      /** @brief Maximum number of items in the stage's input queue */
+      size_t queueSize = 1024;
+
+      /** @brief The upstream stage resumes when the input queue drains
+       *         to this size
+       */
+      size_t lowWaterMark = 256;
+
+      /** @brief The upstream stage pauses when the input queue grows
+       *         past this size
+       */
+      size_t highWaterMark = 768;
+
+      /** @brief Maximum number of items a worker takes at once */
+      size_t batchSize = 1;
+
+      StageOrder order = StageOrder::UNORDERED;
+
+      /** @brief Configuration for the workers.  Worker i applies
+       *         threads.forThread(i) when the stage starts.
+       */
+      ThreadConfig threads;
+    };
+
+    /** @brief An item moving through a pipeline, with the bookkeeping
+     *         the stages need.
+     *
+     *  Items whose stage failed continue down the pipeline as invalid
+     *  envelopes so that ordered stages downstream do not wait for them
+     *  forever.  The pipeline drops them at the end.
+     */
+    template <typename Item>
+    struct StageEnvelope {
+      uint64_t seq;
+      int64_t enqueuedAt;   ///< When it entered its current stage, in ns
+      bool valid;
+      Item item;
+
+      StageEnvelope(): seq(0), enqueuedAt(0), valid(false), item() { }
+      StageEnvelope(uint64_t s, int64_t t, bool v, Item&& i):
+	  seq(s), enqueuedAt(t), valid(v), item(std::move(i)) {
+      }
+    };
+
+    /** @brief The part of a pipeline Stage that does not depend on the
+     *         types of its items: worker threads, their lifecycle and
+     *         statistics.
+     */
+    class StageBase {
+    public:
+      /** @brief How long workers wait for input or for downstream room
+       *         before checking whether they should stop, in ms
+       */
+      static const int64_t POLL_INTERVAL = 50;
+
+    public:
+      StageBase(const std::string& name, const StageConfig& config);
+      StageBase(const StageBase&) = delete;
+      virtual ~StageBase();
+
+      const std::string& name() const { return name_; }
+      const StageConfig& config() const { return config_; }
+      bool running() const { return !workers_.empty(); }
+
+      StageStatistics::Snapshot statistics() const {
+	return stats_.snapshot(name_);
+      }
+
+      void resetStatistics() { stats_.reset(); }
+
+      /** @brief Start the stage's workers
+       *
+       *  @throws IllegalValueError, SystemError if a worker cannot
+       *          apply config().threads
+       */
+      void start();
+
+      /** @brief Let the workers process everything in the input queue,
+       *         then stop them.  Callers must stop putting items into the
+       *         stage first.
+       *
+       *  A finishing stage no longer pauses for backpressure.
+       */
+      void finish();
+
+      /** @brief Stop pausing for backpressure until the stage starts
+       *         again.
+       *
+       *  Pipeline::finish() calls this on every stage before finishing
+       *  any of them, so the stages can drain into an output queue that
+       *  nobody is reading.
+       */
+      void ignoreBackpressure() {
+	throttle_.store(false, std::memory_order_release);
+      }
+
+      /** @brief Stop the workers once their current batches are done.
+       *         Items still in the input queue stay there.
+       */
+      void stop();
+
+      StageBase& operator=(const StageBase&) = delete;
+
+      static int64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+      }
+
+    protected:
+      StageStatistics stats_;
+
+      /** @brief True once stop() has been called */
+      bool stopping_() const {
+	return state_.load(std::memory_order_acquire) == STOPPING_;
+      }
+
+      /** @brief True if the workers should pause while the output
+       *         queue is above its high water mark
+       */
+      bool throttled_() const {
+	return throttle_.load(std::memory_order_acquire) &&
+	       (state_.load(std::memory_order_acquire) == RUNNING_);
+      }
+
+      /** @brief Wait up to POLL_INTERVAL for input, then process one
+       *         batch.
+       *
+       *  @returns  False if no input arrived
+       */
+      virtual bool runBatch_() = 0;
+
+    private:
+      static const int RUNNING_ = 0;
+      static const int DRAINING_ = 1;
+      static const int STOPPING_ = 2;
+
+      std::string name_;
+      StageConfig config_;
+      std::vector<std::thread> workers_;
+      std::atomic<int> state_;
+      std::atomic<bool> throttle_;
+
+      void join_(int state);
+      void work_();
+    };
+
+    /** @brief A pipeline stage that turns items of type In into items of
+     *         type Out.
+     *
+     *  The stage takes batches of up to config().batchSize items from
+     *  its input queue, passes them to its function and puts the
+     *  results into its output queue, which is the next stage's input
+     *  queue or the pipeline's output queue.  Each item produces exactly
+     *  one result.  If the function throws, the whole batch is counted
+     *  as an error and its items are dropped.
+     *
+     *  Backpressure is automatic.  When the output queue crosses its
+     *  high water mark, the workers stop taking input until it falls
+     *  back past its low water mark, so the stage's own input queue
+     *  fills and the stage upstream pauses in turn.
+     *
+     *  With StageOrder::ORDERED, results wait in a reorder buffer until
+     *  every result for an earlier item has left the stage.
+     */
+    template <typename In, typename Out>
+    class Stage : public StageBase {
+    public:
+      typedef In InputType;
+      typedef Out OutputType;
+      typedef pollable::Queue< StageEnvelope<In> > InputQueue;
+      typedef pollable::Queue< StageEnvelope<Out> > OutputQueue;
+      typedef std::function<Out (In&&)> Function;
+      typedef std::function<void (std::vector<In>&, std::vector<Out>&)>
+	      BatchFunction;
+
+    public:
+      /** @brief Create a stage that calls @c f once per item */
+      Stage(const std::string& name, Function f,
+	    const StageConfig& config = StageConfig()):
+	  Stage(name, batchOf_(std::move(f)), config) {
+      }
+
+      /** @brief Create a stage that calls @c f once per batch.  @c f
+       *         must append one result to its second argument for each
+       *         item in its first.
+       */
+      Stage(const std::string& name, BatchFunction f,
+	    const StageConfig& config = StageConfig()):
+	  StageBase(name, config),
+	  input_(config.queueSize, config.lowWaterMark, config.highWaterMark),
+	  output_(nullptr), f_(std::move(f)), reorderSync_(), pending_(),
+	  nextSeq_(0) {
+      }
+
+      virtual ~Stage() { stop(); }
+
+      InputQueue& input() { return input_; }
+
+      /** @brief Send results to @c output.  Must be called before
+       *         start().
+       */
+      void connect(OutputQueue& output) { output_ = &output; }
+
+    protected:
+      virtual bool runBatch_() override {
+	waitForDownstream_();
+
+	std::vector< StageEnvelope<In> > batch;
+	StageEnvelope<In> first;
+	if (!input_.get(first, POLL_INTERVAL)) {
+	  return false;
+	}
+	batch.push_back(std::move(first));
+	if (config().batchSize > 1) {
+	  input_.drainInto(batch, config().batchSize - 1);
+	}
+
+	std::vector<In> items;
+	items.reserve(batch.size());
+	for (auto& envelope : batch) {
+	  if (envelope.valid) {
+	    items.push_back(std::move(envelope.item));
+	  }
+	}
+
+	std::vector<Out> results;
+	bool ok = true;
+	const int64_t start = now();
+	try {
+	  if (!items.empty()) {
+	    results.reserve(items.size());
+	    f_(items, results);
+	    if (results.size() != items.size()) {
+	      throw pistis::exceptions::IllegalStateError(
+		  "Stage " + name() + " produced the wrong number of results",
+		  PISTIS_EX_HERE
+	      );
+	    }
+	  }
+	} catch(...) {
+	  stats_.recordError();
+	  ok = false;
+	}
+	const int64_t end = now();
+	stats_.recordBatch(batch.size(), end - start);
+
+	auto result = results.begin();
+	for (auto& envelope : batch) {
+	  const bool valid = envelope.valid && ok;
+	  if (valid) {
+	    stats_.recordLatency(end - envelope.enqueuedAt);
+	  }
+	  StageEnvelope<Out> out(envelope.seq, end, valid,
+				 valid ? std::move(*result++) : Out());
+	  emit_(std::move(out));
+	}
+	return true;
+      }
+
+    private:
+      InputQueue input_;
+      OutputQueue* output_;
+      BatchFunction f_;
+      std::mutex reorderSync_;
+      std::map< uint64_t, StageEnvelope<Out> > pending_;
+      uint64_t nextSeq_;
+
+      static BatchFunction batchOf_(Function f) {
+	return [f](std::vector<In>& items, std::vector<Out>& results) {
+	  for (auto& item : items) {
+	    results.push_back(f(std::move(item)));
+	  }
+	};
+      }
+
+      void waitForDownstream_() {
+	if (!output_->highWaterMarkCrossed() || !throttled_()) {
+	  return;
+	}
+
+	const int64_t start = now();
+	while (output_->highWaterMarkCrossed() && throttled_()) {
+	  output_->wait(POLL_INTERVAL, pollable::QueueEventType::LOW_WATER_MARK);
+	}
+	stats_.recordBackpressure(now() - start);
+      }
+
+      void emit_(StageEnvelope<Out>&& envelope) {
+	if (config().order == StageOrder::UNORDERED) {
+	  put_(std::move(envelope));
+	  return;
+	}
+
+	std::unique_lock<std::mutex> lock(reorderSync_);
+	if (envelope.seq != nextSeq_) {
+	  const uint64_t seq = envelope.seq;
+	  pending_.emplace(seq, std::move(envelope));
+	  return;
+	}
+
+	put_(std::move(envelope));
+	++nextSeq_;
+	for (auto i = pending_.begin();
+	     (i != pending_.end()) && (i->first == nextSeq_);
+	     i = pending_.erase(i)) {
+	  put_(std::move(i->second));
+	  ++nextSeq_;
+	}
+      }
+
+      void put_(StageEnvelope<Out>&& envelope) {
+	while (!output_->put(std::move(envelope), POLL_INTERVAL)) {
+	  if (stopping_()) {
+	    return;
+	  }
+	}
+      }
+    };
+
+  }
+}
+#endif
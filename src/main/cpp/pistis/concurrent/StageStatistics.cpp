@@ -0,0 +1,36 @@
+#include "StageStatistics.hpp"
+#include <chrono>
+
+using namespace pistis::concurrent;
+
+namespace {
+  inline int64_t nowInNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+}
+
+const uint32_t StageStatistics::HISTOGRAM_PRECISION;
+
+StageStatistics::Snapshot StageStatistics::snapshot(
+    const std::string& name
+) const {
+  const double elapsed =
+      (nowInNs() - startTime_.load(std::memory_order_relaxed)) / 1e9;
+  return Snapshot(name, items_.load(std::memory_order_relaxed),
+		  batches_.load(std::memory_order_relaxed),
+		  errors_.load(std::memory_order_relaxed), elapsed,
+		  latency_.snapshot(), serviceTime_.snapshot(),
+		  backpressure_.snapshot());
+}
+
+void StageStatistics::reset() {
+  items_.store(0, std::memory_order_relaxed);
+  batches_.store(0, std::memory_order_relaxed);
+  errors_.store(0, std::memory_order_relaxed);
+  startTime_.store(nowInNs(), std::memory_order_relaxed);
+  latency_.reset();
+  serviceTime_.reset();
+  backpressure_.reset();
+}
@@ -0,0 +1,111 @@
+#ifndef __PISTIS__CONCURRENT__STAGESTATISTICS_HPP__
+#define __PISTIS__CONCURRENT__STAGESTATISTICS_HPP__
+
+#include <pistis/concurrent/HdrHistogram.hpp>
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief What a pipeline Stage records about its own work.
+     *
+     *  Records the number of items, batches and failed batches, a
+     *  histogram of each item's latency from entering the stage's input
+     *  queue to leaving the stage, a histogram of the time spent in the
+     *  stage's function per batch, and a histogram of the time workers
+     *  spent paused by backpressure.  Times are in nanoseconds.  As with
+     *  QueueStatistics, counters are relaxed atomics.
+     */
+    class StageStatistics {
+    public:
+      /** @brief Significant bits kept by each histogram */
+      static const uint32_t HISTOGRAM_PRECISION = 3;
+
+      class Snapshot {
+      public:
+	Snapshot(const std::string& name, uint64_t items, uint64_t batches,
+		 uint64_t errors, double elapsed,
+		 HdrHistogram::Snapshot&& latency,
+		 HdrHistogram::Snapshot&& serviceTime,
+		 HdrHistogram::Snapshot&& backpressure):
+	    name_(name), items_(items), batches_(batches), errors_(errors),
+	    elapsed_(elapsed), latency_(std::move(latency)),
+	    serviceTime_(std::move(serviceTime)),
+	    backpressure_(std::move(backpressure)) {
+	}
+
+	/** @brief Name of the stage */
+	const std::string& name() const { return name_; }
+
+	/** @brief Items that left the stage, including failed ones */
+	uint64_t items() const { return items_; }
+	uint64_t batches() const { return batches_; }
+
+	/** @brief Batches whose function threw an exception */
+	uint64_t errors() const { return errors_; }
+
+	/** @brief Seconds between the last reset and the snapshot */
+	double elapsed() const { return elapsed_; }
+
+	/** @brief Items per second since the last reset */
+	double throughput() const {
+	  return elapsed_ > 0 ? items_ / elapsed_ : 0;
+	}
+
+	const HdrHistogram::Snapshot& latency() const { return latency_; }
+	const HdrHistogram::Snapshot& serviceTime() const {
+	  return serviceTime_;
+	}
+	const HdrHistogram::Snapshot& backpressure() const {
+	  return backpressure_;
+	}
+
+      private:
+	std::string name_;
+	uint64_t items_;
+	uint64_t batches_;
+	uint64_t errors_;
+	double elapsed_;
+	HdrHistogram::Snapshot latency_;
+	HdrHistogram::Snapshot serviceTime_;
+	HdrHistogram::Snapshot backpressure_;
+      };
+
+    public:
+      StageStatistics():
+	  latency_(HISTOGRAM_PRECISION), serviceTime_(HISTOGRAM_PRECISION),
+	  backpressure_(HISTOGRAM_PRECISION) {
+	reset();
+      }
+      StageStatistics(const StageStatistics&) = delete;
+
+      void recordBatch(uint64_t n, uint64_t serviceNs) {
+	items_.fetch_add(n, std::memory_order_relaxed);
+	batches_.fetch_add(1, std::memory_order_relaxed);
+	serviceTime_.record(serviceNs);
+      }
+
+      void recordError() { errors_.fetch_add(1, std::memory_order_relaxed); }
+      void recordLatency(uint64_t ns) { latency_.record(ns); }
+      void recordBackpressure(uint64_t ns) { backpressure_.record(ns); }
+
+      Snapshot snapshot(const std::string& name) const;
+      void reset();
+
+      StageStatistics& operator=(const StageStatistics&) = delete;
+
+    private:
+      std::atomic<uint64_t> items_;
+      std::atomic<uint64_t> batches_;
+      std::atomic<uint64_t> errors_;
+      std::atomic<int64_t> startTime_;
+      HdrHistogram latency_;
+      HdrHistogram serviceTime_;
+      HdrHistogram backpressure_;
+    };
+
+  }
+}
+#endif
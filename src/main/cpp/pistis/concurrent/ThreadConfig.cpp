@@ -0,0 +1,163 @@
+#include "ThreadConfig.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <future>
+#include <sstream>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+namespace {
+  // Longest name pthread_setname_np() accepts, not counting the '\0'
+  static const size_t MAX_NAME_LENGTH = 15;
+
+  int kernelPolicy(SchedulingPolicy policy) {
+    return (policy == SchedulingPolicy::FIFO) ? SCHED_FIFO : SCHED_OTHER;
+  }
+
+  void validate(const ThreadConfig& config) {
+    std::ostringstream msg;
+    for (int cpu : config.cpus) {
+      if ((cpu < 0) || (cpu >= CPU_SETSIZE)) {
+	msg << "Illegal value for CPU " << cpu << " (out of range)";
+	throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+      }
+    }
+
+    if (config.policy == SchedulingPolicy::INHERIT) {
+      if (config.priority) {
+	throw IllegalValueError(
+	    "Illegal value for priority (requires a scheduling policy)",
+	    PISTIS_EX_HERE
+	);
+      }
+    } else {
+      const int policy = kernelPolicy(config.policy);
+      const int low = ::sched_get_priority_min(policy);
+      const int high = ::sched_get_priority_max(policy);
+      if ((config.priority < low) || (config.priority > high)) {
+	msg << "Illegal value for priority (must be between " << low
+	    << " and " << high << " for " << config.policy << ")";
+	throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+      }
+    }
+
+    if ((config.nice != ThreadConfig::KEEP_NICE) &&
+	((config.nice < -20) || (config.nice > 19))) {
+      throw IllegalValueError(
+	  "Illegal value for nice (must be between -20 and 19)",
+	  PISTIS_EX_HERE
+      );
+    }
+  }
+}
+
+const int ThreadConfig::KEEP_NICE;
+
+std::ostream& pistis::concurrent::operator<<(std::ostream& out,
+					     SchedulingPolicy policy) {
+  if (policy == SchedulingPolicy::INHERIT) {
+    return out << "INHERIT";
+  } else if (policy == SchedulingPolicy::OTHER) {
+    return out << "OTHER";
+  } else if (policy == SchedulingPolicy::FIFO) {
+    return out << "FIFO";
+  } else {
+    return out << "**UNKNOWN**";
+  }
+}
+
+ThreadConfig ThreadConfig::forThread(size_t index) const {
+  ThreadConfig config(*this);
+  if (!name.empty()) {
+    std::ostringstream threadName;
+    threadName << name << "-" << index;
+    config.name = threadName.str();
+  }
+  if (onePerThread && !cpus.empty()) {
+    config.cpus.assign(1, cpus[index % cpus.size()]);
+  }
+  return config;
+}
+
+void ThreadConfig::apply() const {
+  validate(*this);
+
+  if (!cpus.empty()) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus) {
+      CPU_SET(cpu, &cpuSet);
+    }
+    const int result =
+	::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result) {
+      throw SystemError::fromSystemCode(
+	  "Cannot set thread affinity: #ERR#", result, PISTIS_EX_HERE
+      );
+    }
+  }
+
+  if (policy != SchedulingPolicy::INHERIT) {
+    struct sched_param param;
+    param.sched_priority = priority;
+    const int result = ::pthread_setschedparam(::pthread_self(),
+					       kernelPolicy(policy), &param);
+    if (result) {
+      throw SystemError::fromSystemCode(
+	  "Cannot set thread scheduling policy: #ERR#", result,
+	  PISTIS_EX_HERE
+      );
+    }
+  }
+
+  // On Linux, the nice level belongs to the thread, not the process
+  if ((nice != KEEP_NICE) &&
+      ::setpriority(PRIO_PROCESS, (id_t)::syscall(SYS_gettid), nice)) {
+    throw SystemError::fromSystemCode(
+	"Cannot set thread nice level: #ERR#", errno, PISTIS_EX_HERE
+    );
+  }
+
+  if (!name.empty()) {
+    const int result = ::pthread_setname_np(
+	::pthread_self(), name.substr(0, MAX_NAME_LENGTH).c_str()
+    );
+    if (result) {
+      throw SystemError::fromSystemCode(
+	  "Cannot set thread name: #ERR#", result, PISTIS_EX_HERE
+      );
+    }
+  }
+}
+
+std::thread ThreadConfig::start(size_t index,
+				std::function<void ()> body) const {
+  std::promise<void> started;
+  std::future<void> result = started.get_future();
+  std::thread t([config = forThread(index), started = std::move(started),
+		 body = std::move(body)]() mutable {
+      try {
+	config.apply();
+      } catch(...) {
+	started.set_exception(std::current_exception());
+	return;
+      }
+      started.set_value();
+      body();
+  });
+
+  try {
+    result.get();
+  } catch(...) {
+    t.join();
+    throw;
+  }
+  return t;
+}
@@ -0,0 +1,106 @@
+#ifndef __PISTIS__CONCURRENT__THREADCONFIG_HPP__
+#define __PISTIS__CONCURRENT__THREADCONFIG_HPP__
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <limits.h>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief Scheduling policy for a thread */
+    enum class SchedulingPolicy {
+      /** @brief Keep the policy and priority the thread already has */
+      INHERIT = 0,
+
+      /** @brief The default time-sharing policy (SCHED_OTHER) */
+      OTHER = 1,
+
+      /** @brief First-in, first-out real-time policy (SCHED_FIFO).
+       *         Usually needs CAP_SYS_NICE or an RLIMIT_RTPRIO.
+       */
+      FIFO = 2
+    };
+
+    std::ostream& operator<<(std::ostream& out, SchedulingPolicy policy);
+
+    /** @brief CPU affinity, scheduling policy, nice level and name for
+     *         a thread.
+     *
+     *  The default configuration changes nothing.  Executor, Stage and
+     *  pollable::Scheduler apply a configuration to their threads when
+     *  they start, so a hot loop can be given an isolated core (one
+     *  taken out of the general scheduler with isolcpus= or a cpuset)
+     *  and a real-time priority.
+     *
+     *  Pools configure their threads with forThread(), which numbers
+     *  the threads' names and, if onePerThread is set, gives each
+     *  thread a single CPU of its own.
+     */
+    struct ThreadConfig {
+      /** @brief Value of nice that leaves the nice level alone */
+      static const int KEEP_NICE = INT_MIN;
+
+      /** @brief CPUs the thread may run on.  Empty leaves the
+       *         affinity alone.
+       */
+      std::vector<int> cpus;
+
+      /** @brief Pin each thread of a pool to one of cpus, in turn,
+       *         instead of letting every thread use all of them
+       */
+      bool onePerThread = false;
+
+      SchedulingPolicy policy = SchedulingPolicy::INHERIT;
+
+      /** @brief Real-time priority, from 1 to 99, for
+       *         SchedulingPolicy::FIFO.  Must be zero for
+       *         SchedulingPolicy::OTHER.
+       */
+      int priority = 0;
+
+      /** @brief Nice level, from -20 to 19, or KEEP_NICE.  Only
+       *         affects threads under SchedulingPolicy::OTHER.
+       */
+      int nice = KEEP_NICE;
+
+      /** @brief Thread name shown by ps and top, truncated to 15
+       *         characters.  Empty leaves the name alone.
+       */
+      std::string name;
+
+      /** @brief The configuration for thread @c index of a pool.
+       *
+       *  Appends "-<index>" to the name and, if onePerThread is set,
+       *  narrows cpus to the single CPU cpus[index % cpus.size()].
+       */
+      ThreadConfig forThread(size_t index) const;
+
+      /** @brief Apply this configuration to the calling thread.
+       *
+       *  Sets the affinity first, so that nothing afterwards runs on
+       *  the wrong CPU, then the policy, nice level and name.
+       *
+       *  @throws IllegalValueError if a CPU, the priority or the nice
+       *                            level is out of range
+       *  @throws SystemError if the kernel refuses a setting
+       */
+      void apply() const;
+
+      /** @brief Start a thread that applies forThread(index), then runs
+       *         @c body.
+       *
+       *  Waits until the new thread has configured itself.  If that
+       *  fails, the thread exits without running @c body and the
+       *  error is rethrown here.
+       */
+      std::thread start(size_t index, std::function<void ()> body) const;
+    };
+
+  }
+}
+#endif
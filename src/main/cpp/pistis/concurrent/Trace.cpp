@@ -0,0 +1,340 @@
+#include "Trace.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+
+const size_t Trace::DEFAULT_CAPACITY;
+std::atomic<bool> Trace::enabled_(false);
+
+namespace {
+  /** @brief One event in a ring.  The fields are atomic so a reader
+   *         can copy a slot while its thread overwrites it.
+   */
+  struct Slot {
+    std::atomic<uint64_t> timestamp;
+    std::atomic<const void*> object;
+    std::atomic<uint64_t> value;
+    std::atomic<uint32_t> type;
+  };
+
+  /** @brief The ring of one thread's events.
+   *
+   *  Only the owning thread writes to it.  head is the number of
+   *  events ever recorded; event i lives in slot i & mask.  The owner
+   *  publishes head only after writing the event's slot, and a release
+   *  fence orders the previous publication before it starts writing
+   *  the next slot, so a reader that copies the slots and then rereads
+   *  head knows which copies might have been overwritten.
+   */
+  struct Ring {
+    const uint32_t thread;
+    std::string name;
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> head;
+    uint64_t cleared;   ///< Events before this one were discarded
+    bool exited;
+
+    Ring(uint32_t t, const std::string& n, size_t capacity):
+        thread(t), name(n), mask(capacity - 1), slots(new Slot[capacity]),
+        head(0), cleared(0), exited(false) {
+    }
+
+    void record(TraceEventType type, const void* object, uint64_t value) {
+      const uint64_t i = head.load(std::memory_order_relaxed);
+      Slot& s = slots[i & mask];
+      std::atomic_thread_fence(std::memory_order_release);
+      s.timestamp.store(TscClock::now(), std::memory_order_relaxed);
+      s.object.store(object, std::memory_order_relaxed);
+      s.value.store(value, std::memory_order_relaxed);
+      s.type.store((uint32_t)type, std::memory_order_relaxed);
+      head.store(i + 1, std::memory_order_release);
+    }
+
+    /** @brief Append the events that survive the copy to @c events.
+     *         Must be called with the registry lock held.
+     */
+    void copyTo(std::vector<TraceEvent>& events) const {
+      const uint64_t capacity = mask + 1;
+      const uint64_t end = head.load(std::memory_order_acquire);
+      const uint64_t start =
+	  std::max(cleared, (end > capacity) ? end - capacity : 0);
+      std::vector<TraceEvent> copy;
+      copy.reserve(end - start);
+      for (uint64_t i = start; i < end; ++i) {
+	const Slot& s = slots[i & mask];
+	copy.push_back(TraceEvent{
+	    s.timestamp.load(std::memory_order_relaxed),
+	    s.object.load(std::memory_order_relaxed),
+	    s.value.load(std::memory_order_relaxed),
+	    (TraceEventType)s.type.load(std::memory_order_relaxed),
+	    thread
+	});
+      }
+
+      // A running owner may be writing event "after" now, which
+      // overwrites event after - capacity, so only later events are
+      // intact.  An owner that has exited has written its last event.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const uint64_t after = head.load(std::memory_order_relaxed);
+      const uint64_t window = exited ? capacity : capacity - 1;
+      const uint64_t firstIntact = (after > window) ? after - window : 0;
+      const size_t skip =
+	  (size_t)(std::min(std::max(firstIntact, start), end) - start);
+      events.insert(events.end(), copy.begin() + skip, copy.end());
+    }
+  };
+
+  struct Registry {
+    std::mutex sync;
+    std::vector< std::shared_ptr<Ring> > rings;
+    std::unordered_map<const void*, std::string> names;
+    size_t capacity;
+
+    Registry():
+        sync(), rings(), names(), capacity(Trace::DEFAULT_CAPACITY) {
+    }
+  };
+
+  Registry& registry() {
+    static Registry* r = new Registry();  // Threads may record at exit
+    return *r;
+  }
+
+  /** @brief Marks the calling thread's ring as exited when the thread
+   *         ends, so clear() can release it
+   */
+  struct RingOwner {
+    std::shared_ptr<Ring> ring;
+
+    ~RingOwner();
+  };
+
+  thread_local Ring* currentRing = nullptr;
+  thread_local bool ringReleased = false;
+  thread_local RingOwner ringOwner;
+
+  RingOwner::~RingOwner() {
+    // Events recorded by destructors that run after this one are dropped
+    currentRing = nullptr;
+    ringReleased = true;
+    if (ring) {
+      std::unique_lock<std::mutex> lock(registry().sync);
+      ring->exited = true;
+    }
+  }
+
+  Ring* attach() {
+    char name[64] = "";
+    ::pthread_getname_np(::pthread_self(), name, sizeof(name));
+    const uint32_t tid = (uint32_t)::syscall(SYS_gettid);
+
+    Registry& r = registry();
+    std::unique_lock<std::mutex> lock(r.sync);
+    std::shared_ptr<Ring> ring(new Ring(tid, name, r.capacity));
+    r.rings.push_back(ring);
+    ringOwner.ring = ring;
+    currentRing = ring.get();
+    return currentRing;
+  }
+
+  size_t roundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  std::string quote(const std::string& s) {
+    std::ostringstream out;
+    out << '"';
+    for (char c : s) {
+      if ((c == '"') || (c == '\\')) {
+	out << '\\' << c;
+      } else if ((unsigned char)c < 0x20) {
+	out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+	    << (int)c << std::dec;
+      } else {
+	out << c;
+      }
+    }
+    out << '"';
+    return out.str();
+  }
+}
+
+const char* pistis::concurrent::traceEventName(TraceEventType type) {
+  switch (type) {
+    case TraceEventType::WAIT_BEGIN:
+    case TraceEventType::WAIT_END: return "wait";
+    case TraceEventType::NOTIFY: return "notify";
+    case TraceEventType::PUT: return "put";
+    case TraceEventType::GET: return "get";
+    case TraceEventType::HIGH_WATER_MARK: return "high_water_mark";
+    case TraceEventType::LOW_WATER_MARK: return "low_water_mark";
+    default: return "unknown";
+  }
+}
+
+std::ostream& pistis::concurrent::operator<<(std::ostream& out,
+					     TraceEventType type) {
+  switch (type) {
+    case TraceEventType::WAIT_BEGIN: return out << "WAIT_BEGIN";
+    case TraceEventType::WAIT_END: return out << "WAIT_END";
+    case TraceEventType::NOTIFY: return out << "NOTIFY";
+    case TraceEventType::PUT: return out << "PUT";
+    case TraceEventType::GET: return out << "GET";
+    case TraceEventType::HIGH_WATER_MARK: return out << "HIGH_WATER_MARK";
+    case TraceEventType::LOW_WATER_MARK: return out << "LOW_WATER_MARK";
+    default: return out << "**UNKNOWN**";
+  }
+}
+
+size_t Trace::capacity() {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  return r.capacity;
+}
+
+void Trace::setCapacity(size_t capacity) {
+  if (!capacity) {
+    throw IllegalValueError("Trace capacity must be greater than zero",
+			    PISTIS_EX_HERE);
+  }
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.capacity = roundUpToPowerOfTwo(capacity);
+}
+
+void Trace::name(const void* object, const std::string& name) {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.names[object] = name;
+}
+
+void Trace::forget(const void* object) {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  r.names.erase(object);
+}
+
+void Trace::nameThread(const std::string& name) {
+  Ring* ring = currentRing;
+  if (!ring) {
+    if (ringReleased) {
+      return;
+    }
+    ring = attach();
+  }
+  std::unique_lock<std::mutex> lock(registry().sync);
+  ring->name = name;
+}
+
+std::vector<TraceEvent> Trace::events() {
+  std::vector<TraceEvent> events;
+  {
+    Registry& r = registry();
+    std::unique_lock<std::mutex> lock(r.sync);
+    for (const auto& ring : r.rings) {
+      ring->copyTo(events);
+    }
+  }
+  std::stable_sort(events.begin(), events.end(),
+		   [](const TraceEvent& x, const TraceEvent& y) {
+		     return x.timestamp < y.timestamp;
+		   });
+  return events;
+}
+
+void Trace::clear() {
+  Registry& r = registry();
+  std::unique_lock<std::mutex> lock(r.sync);
+  auto end = std::remove_if(r.rings.begin(), r.rings.end(),
+			    [](const std::shared_ptr<Ring>& ring) {
+			      return ring->exited;
+			    });
+  r.rings.erase(end, r.rings.end());
+  for (const auto& ring : r.rings) {
+    ring->cleared = ring->head.load(std::memory_order_acquire);
+  }
+}
+
+void Trace::writeChromeJson(std::ostream& out) {
+  const std::vector<TraceEvent> all = events();
+  std::unordered_map<const void*, std::string> names;
+  std::vector< std::pair<uint32_t, std::string> > threads;
+  {
+    Registry& r = registry();
+    std::unique_lock<std::mutex> lock(r.sync);
+    names = r.names;
+    for (const auto& ring : r.rings) {
+      threads.push_back(std::make_pair(ring->thread, ring->name));
+    }
+  }
+
+  const pid_t pid = ::getpid();
+  const uint64_t origin = all.empty() ? 0 : all.front().timestamp;
+  const char* separator = "\n";
+
+  out << "{\"traceEvents\":[";
+  for (const auto& t : threads) {
+    if (!t.second.empty()) {
+      out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"
+	  << pid << ",\"tid\":" << t.first << ",\"args\":{\"name\":"
+	  << quote(t.second) << "}}";
+      separator = ",\n";
+    }
+  }
+
+  out << std::fixed << std::setprecision(3);
+  for (const TraceEvent& e : all) {
+    const char* phase =
+	(e.type == TraceEventType::WAIT_BEGIN) ? "B" :
+	(e.type == TraceEventType::WAIT_END) ? "E" : "i";
+    auto i = names.find(e.object);
+    std::string object;
+    if (i != names.end()) {
+      object = i->second;
+    } else {
+      std::ostringstream address;
+      address << e.object;
+      object = address.str();
+    }
+
+    out << separator << "{\"name\":\"" << traceEventName(e.type)
+	<< "\",\"cat\":\"pistis\",\"ph\":\"" << phase << "\",\"ts\":"
+	<< TscClock::toNs(e.timestamp - origin) / 1000.0 << ",\"pid\":"
+	<< pid << ",\"tid\":" << e.thread;
+    if (*phase == 'i') {
+      out << ",\"s\":\"t\"";
+    }
+    out << ",\"args\":{\"object\":" << quote(object) << ",\"value\":"
+	<< e.value << "}}";
+    separator = ",\n";
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  out.unsetf(std::ios::floatfield);
+}
+
+void Trace::record_(TraceEventType type, const void* object,
+		    uint64_t value) {
+  Ring* ring = currentRing;
+  if (!ring) {
+    if (ringReleased) {
+      return;
+    }
+    ring = attach();
+  }
+  ring->record(type, object, value);
+}
@@ -0,0 +1,204 @@
+#ifndef __PISTIS__CONCURRENT__TRACE_HPP__
+#define __PISTIS__CONCURRENT__TRACE_HPP__
+
+#include <pistis/concurrent/TscClock.hpp>
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Set to 0 to compile the tracing hooks out of Condition, Queue
+ *         and any other code that calls Trace::record()
+ */
+#ifndef PISTIS_CONCURRENT_TRACING
+#define PISTIS_CONCURRENT_TRACING 1
+#endif
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief Kinds of events Trace records */
+    enum class TraceEventType : uint32_t {
+      /** @brief A thread starts waiting on an object */
+      WAIT_BEGIN,
+
+      /** @brief A thread stops waiting on an object */
+      WAIT_END,
+
+      /** @brief A condition variable notifies its waiters.  The value
+       *         is the number of waiters notified.
+       */
+      NOTIFY,
+
+      /** @brief Items are added to a queue.  The value is the queue's
+       *         total cost afterwards.
+       */
+      PUT,
+
+      /** @brief Items are removed from a queue.  The value is the
+       *         queue's total cost afterwards.
+       */
+      GET,
+
+      /** @brief A queue crosses its high water mark.  The value is the
+       *         queue's total cost afterwards.
+       */
+      HIGH_WATER_MARK,
+
+      /** @brief A queue falls back to its low water mark.  The value is
+       *         the queue's total cost afterwards.
+       */
+      LOW_WATER_MARK
+    };
+
+    /** @brief Name of an event type as it appears in a trace, such as
+     *         "wait" or "high_water_mark"
+     */
+    const char* traceEventName(TraceEventType type);
+
+    std::ostream& operator<<(std::ostream& out, TraceEventType type);
+
+    /** @brief One recorded event */
+    struct TraceEvent {
+      uint64_t timestamp;   ///< TscClock::now() when the event occurred
+      const void* object;   ///< Object the event happened to
+      uint64_t value;       ///< Depends on the type
+      TraceEventType type;
+      uint32_t thread;      ///< Kernel thread id of the recording thread
+    };
+
+    /** @brief Records waits, notifications and queue activity into
+     *         per-thread ring buffers, for post-mortem analysis of
+     *         stalls.
+     *
+     *  Tracing is off until enable() is called.  While it is off,
+     *  record() costs one relaxed load of a global flag, and defining
+     *  PISTIS_CONCURRENT_TRACING as 0 removes even that.  While it is
+     *  on, each thread records into its own ring of capacity() events
+     *  with no locks and no atomic read-modify-write operations; a full
+     *  ring overwrites its oldest events.  A thread's ring is allocated
+     *  the first time it records an event and outlives the thread, so
+     *  the events of threads that have exited can still be dumped.
+     *
+     *  events() and writeChromeJson() may be called while other threads
+     *  are recording.  They return the events that were complete when
+     *  they read each ring and skip any that were overwritten while
+     *  they were reading.  Timestamps come from TscClock.
+     *
+     *  Condition records WAIT_BEGIN/WAIT_END around wait() and NOTIFY
+     *  from notifyOne() and notifyAll().  Queue records PUT, GET,
+     *  HIGH_WATER_MARK and LOW_WATER_MARK, and WAIT_BEGIN/WAIT_END when
+     *  put() or get() has to wait.  name() gives an object a name to
+     *  use in the exported trace instead of its address.
+     */
+    class Trace {
+    public:
+      static const size_t DEFAULT_CAPACITY = 65536;
+
+    public:
+      Trace() = delete;
+
+      static bool enabled() {
+	return PISTIS_CONCURRENT_TRACING &&
+	       enabled_.load(std::memory_order_relaxed);
+      }
+
+      static void enable() { enabled_.store(true, std::memory_order_relaxed); }
+      static void disable() {
+	enabled_.store(false, std::memory_order_relaxed);
+      }
+
+      /** @brief Number of events each thread's ring holds */
+      static size_t capacity();
+
+      /** @brief Set the number of events each thread's ring holds,
+       *         rounded up to a power of two.  Rings that already exist
+       *         keep their size.
+       *
+       *  The oldest event in the ring of a thread that is still
+       *  running is not reported, since the thread may be overwriting
+       *  it.
+       *
+       *  @throws IllegalValueError if @c capacity is zero
+       */
+      static void setCapacity(size_t capacity);
+
+      /** @brief Record an event on the calling thread's ring, if
+       *         tracing is enabled
+       */
+      static void record(TraceEventType type, const void* object,
+			 uint64_t value = 0) {
+	if (enabled()) {
+	  record_(type, object, value);
+	}
+      }
+
+      /** @brief Call @c name the object at @c object in exported traces */
+      static void name(const void* object, const std::string& name);
+
+      /** @brief Forget the name given to @c object, as when the object is
+       *         destroyed and its address may be reused
+       */
+      static void forget(const void* object);
+
+      /** @brief Call the calling thread @c name in exported traces.
+       *
+       *  Threads are otherwise called by the name set with
+       *  pthread_setname_np() when they record their first event.
+       */
+      static void nameThread(const std::string& name);
+
+      /** @brief Every event in every thread's ring, oldest first */
+      static std::vector<TraceEvent> events();
+
+      /** @brief Discard every recorded event and the rings of threads
+       *         that have exited
+       */
+      static void clear();
+
+      /** @brief Write every recorded event in the Chrome trace event
+       *         format, which chrome://tracing and Perfetto can open.
+       *
+       *  Waits become duration events on the waiting thread, and the
+       *  other events become instant events.  Each event's arguments
+       *  include its object's name or address and its value.
+       */
+      static void writeChromeJson(std::ostream& out);
+
+      /** @brief Records WAIT_BEGIN on construction and WAIT_END on
+       *         destruction, if tracing was enabled at construction
+       */
+      class WaitScope {
+      public:
+	WaitScope(const void* object):
+	    object_(Trace::enabled() ? object : nullptr) {
+	  if (object_) {
+	    record_(TraceEventType::WAIT_BEGIN, object_, 0);
+	  }
+	}
+	WaitScope(const WaitScope&) = delete;
+
+	~WaitScope() {
+	  if (object_) {
+	    record_(TraceEventType::WAIT_END, object_, 0);
+	  }
+	}
+
+	WaitScope& operator=(const WaitScope&) = delete;
+
+      private:
+	const void* object_;
+      };
+
+    private:
+      static std::atomic<bool> enabled_;
+
+      static void record_(TraceEventType type, const void* object,
+			  uint64_t value);
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,30 @@
+#include "TscClock.hpp"
+#include <thread>
+
+using namespace pistis::concurrent;
+
+namespace {
+  double calibrate() {
+#ifdef PISTIS_CONCURRENT_HAS_TSC
+    typedef std::chrono::steady_clock Clock;
+    const auto start = Clock::now();
+    const uint64_t startTicks = TscClock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const uint64_t endTicks = TscClock::now();
+    const auto end = Clock::now();
+
+    const double seconds =
+	std::chrono::duration_cast< std::chrono::duration<double> >(
+	    end - start
+	).count();
+    return (double)(endTicks - startTicks) / seconds;
+#else
+    return 1e9;
+#endif
+  }
+}
+
+double TscClock::ticksPerSecond() {
+  static const double rate = calibrate();
+  return rate;
+}
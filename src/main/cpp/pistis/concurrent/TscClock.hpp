@@ -0,0 +1,59 @@
+#ifndef __PISTIS__CONCURRENT__TSCCLOCK_HPP__
+#define __PISTIS__CONCURRENT__TSCCLOCK_HPP__
+
+#include <chrono>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PISTIS_CONCURRENT_HAS_TSC 1
+#endif
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief Timestamps from the processor's time-stamp counter.
+     *
+     *  now() is a single RDTSC instruction, which costs a few
+     *  nanoseconds and never enters the kernel, so it can timestamp
+     *  events on hot paths.  Ticks are converted to nanoseconds with a
+     *  rate measured against std::chrono::steady_clock the first time
+     *  it is needed.
+     *
+     *  Comparing timestamps taken on different cores assumes an
+     *  invariant TSC that is synchronized across cores, as on any
+     *  x86-64 processor of the last decade.  On other architectures the
+     *  clock falls back to steady_clock, and a tick is a nanosecond.
+     */
+    class TscClock {
+    public:
+      /** @brief Current value of the time-stamp counter */
+      static uint64_t now() {
+#ifdef PISTIS_CONCURRENT_HAS_TSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+	    std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+#endif
+      }
+
+      /** @brief Ticks per second.  Calibrated on the first call, which
+       *         takes about 10 ms; later calls are free.
+       */
+      static double ticksPerSecond();
+
+      /** @brief Convert a number of ticks to nanoseconds */
+      static double toNs(uint64_t ticks) {
+	return (double)ticks * 1e9 / ticksPerSecond();
+      }
+
+      /** @brief Convert a number of nanoseconds to ticks */
+      static uint64_t fromNs(double ns) {
+	return (uint64_t)(ns * ticksPerSecond() / 1e9);
+      }
+    };
+
+  }
+}
+#endif
@@ -0,0 +1,183 @@
+#ifndef __PISTIS__CONCURRENT__WORKSTEALINGDEQUE_HPP__
+#define __PISTIS__CONCURRENT__WORKSTEALINGDEQUE_HPP__
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+
+    /** @brief A lock-free Chase-Lev work-stealing deque.
+     *
+     *  One thread, the deque's owner, calls push() and pop() to add and
+     *  remove items at the bottom of the deque.  Any other thread may
+     *  call steal() to take an item from the top.  The owner works
+     *  LIFO, which keeps recently-pushed work in its cache, while
+     *  thieves take the oldest work, which tends to be the largest.
+     *
+     *  This follows "Correct and Efficient Work-Stealing for Weak Memory
+     *  Models" (Le, Pop, Cohen and Zappa Nardelli, 2013).  Items must be
+     *  trivially copyable (typically pointers), since a thief may copy
+     *  an item it then fails to claim.  The deque grows by doubling when
+     *  full.  Arrays it has outgrown are kept until the deque is
+     *  destroyed, because a thief may still be reading one.
+     */
+    template <typename T>
+    class WorkStealingDeque {
+    public:
+      static_assert(std::is_trivially_copyable<T>::value,
+		    "WorkStealingDeque items must be trivially copyable");
+
+      static const size_t DEFAULT_CAPACITY = 256;
+
+    public:
+      /** @brief Create an empty deque.
+       *
+       *  @param capacity  Initial capacity, rounded up to a power of two
+       */
+      WorkStealingDeque(size_t capacity = DEFAULT_CAPACITY):
+	  top_(0), bottom_(0), array_(nullptr), arrays_() {
+	size_t n = 1;
+	while (n < capacity) {
+	  n <<= 1;
+	}
+	arrays_.emplace_back(new Array_(n));
+	array_.store(arrays_.back().get(), std::memory_order_relaxed);
+      }
+      WorkStealingDeque(const WorkStealingDeque&) = delete;
+
+      /** @brief Approximate number of items in the deque */
+      size_t size() const {
+	const int64_t b = bottom_.load(std::memory_order_relaxed);
+	const int64_t t = top_.load(std::memory_order_relaxed);
+	return b > t ? (size_t)(b - t) : 0;
+      }
+
+      bool empty() const { return !size(); }
+
+      /** @brief Current capacity of the deque */
+      size_t capacity() const {
+	return array_.load(std::memory_order_relaxed)->size();
+      }
+
+      /** @brief Add an item to the bottom.  Only the owner may call this. */
+      void push(T item) {
+	const int64_t b = bottom_.load(std::memory_order_relaxed);
+	const int64_t t = top_.load(std::memory_order_acquire);
+	Array_* a = array_.load(std::memory_order_relaxed);
+	if ((b - t) >= (int64_t)a->size()) {
+	  a = grow_(a, t, b);
+	}
+	a->put(b, item);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+
+      /** @brief Remove the item at the bottom.  Only the owner may call
+       *         this.
+       *
+       *  @returns  True if an item was removed, false if the deque was
+       *            empty
+       */
+      bool pop(T& item) {
+	const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+	Array_* a = array_.load(std::memory_order_relaxed);
+	bottom_.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = top_.load(std::memory_order_relaxed);
+
+	if (t > b) {
+	  bottom_.store(b + 1, std::memory_order_relaxed);
+	  return false;
+	}
+
+	item = a->get(b);
+	if (t == b) {
+	  // Last item, so race the thieves for it
+	  const bool won =
+	      top_.compare_exchange_strong(t, t + 1,
+					   std::memory_order_seq_cst,
+					   std::memory_order_relaxed);
+	  bottom_.store(b + 1, std::memory_order_relaxed);
+	  return won;
+	}
+	return true;
+      }
+
+      /** @brief Remove the item at the top.  Any thread may call this.
+       *
+       *  @returns  True if an item was removed, false if the deque was
+       *            empty or another thread took the item first
+       */
+      bool steal(T& item) {
+	int64_t t = top_.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64_t b = bottom_.load(std::memory_order_acquire);
+	if (t >= b) {
+	  return false;
+	}
+
+	Array_* a = array_.load(std::memory_order_acquire);
+	T candidate = a->get(t);
+	if (!top_.compare_exchange_strong(t, t + 1,
+					  std::memory_order_seq_cst,
+					  std::memory_order_relaxed)) {
+	  return false;
+	}
+	item = candidate;
+	return true;
+      }
+
+      WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    private:
+      class Array_ {
+      public:
+	Array_(size_t size):
+	    mask_(size - 1), items_(new std::atomic<T>[size]) {
+	}
+
+	size_t size() const { return mask_ + 1; }
+
+	T get(int64_t i) const {
+	  return items_[i & mask_].load(std::memory_order_relaxed);
+	}
+
+	void put(int64_t i, T item) {
+	  items_[i & mask_].store(item, std::memory_order_relaxed);
+	}
+
+      private:
+	size_t mask_;
+	std::unique_ptr<std::atomic<T>[]> items_;
+      };
+
+      // top_ and bottom_ are written by different threads, so keep them
+      // on separate cache lines
+      alignas(64) std::atomic<int64_t> top_;
+      alignas(64) std::atomic<int64_t> bottom_;
+      std::atomic<Array_*> array_;
+      std::vector< std::unique_ptr<Array_> > arrays_;
+
+      Array_* grow_(Array_* a, int64_t t, int64_t b) {
+	std::unique_ptr<Array_> bigger(new Array_(a->size() * 2));
+	for (int64_t i = t; i < b; ++i) {
+	  bigger->put(i, a->get(i));
+	}
+	arrays_.push_back(std::move(bigger));
+	Array_* result = arrays_.back().get();
+	array_.store(result, std::memory_order_release);
+	return result;
+      }
+    };
+
+    template <typename T>
+    const size_t WorkStealingDeque<T>::DEFAULT_CAPACITY;
+
+  }
+}
+#endif
@@ -0,0 +1,273 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__ASYNC_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__ASYNC_HPP__
+
+/** @file Async.hpp
+ *
+ *  Asynchronous operations on Queue, Semaphore and Condition, run by a
+ *  Scheduler.
+ *
+ *  Each operation comes in two forms.  The callback form, available in
+ *  every language version, calls a function when the operation
+ *  completes:
+ *
+ *      asyncGet(scheduler, queue, [](Item item) { ... });
+ *
+ *  When compiled as C++20 or later, each operation also has a form
+ *  without a callback that returns an awaitable for use in a coroutine:
+ *
+ *      Item item = co_await asyncGet(scheduler, queue);
+ *
+ *  Either way, waiters on a queue share its queueStateFd() and waiters
+ *  on a Condition use Condition::whenNotified(), so no waiter needs a
+ *  file descriptor of its own.  Callbacks and resumed coroutines run on
+ *  the thread running the scheduler.  The queue, semaphore or condition
+ *  must outlive the operations waiting on it.
+ *
+ *  asyncGet() and asyncPut() work with any queue that has a
+ *  queueStateFd(), get()/put() with timeouts and whenRoomFor(), such as
+ *  Queue and PriorityQueue.  A byte-bounded queue's state descriptor
+ *  stays writable while any room is left, so when an item does not fit,
+ *  asyncPut() suspends the writers on the descriptor until the queue
+ *  shrinks rather than retrying the put on every pass of the scheduler.
+ */
+
+#include <pistis/concurrent/pollable/Condition.hpp>
+#include <pistis/concurrent/pollable/Scheduler.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <memory>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define PISTIS_CONCURRENT_HAS_COROUTINES 1
+#endif
+#endif
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief Take an item from @c queue when one is available and
+       *         pass it to @c onItem
+       */
+      template <typename QueueType, typename Callback>
+      void asyncGet(Scheduler& scheduler, QueueType& queue, Callback onItem) {
+	scheduler.whenReadable(queue.queueStateFd(), [&queue, onItem]() mutable {
+	    typename QueueType::ItemType item;
+	    if (!queue.get(item, 0)) {
+	      return false;
+	    }
+	    onItem(std::move(item));
+	    return true;
+	});
+      }
+
+      /** @brief Suspend the puts waiting on @c queue's state file
+       *         descriptor until there may be room for @c item.
+       *
+       *  For an attempt whose put did not fit to call before it returns
+       *  false.  The scheduler resumes the puts the next time @c queue
+       *  shrinks, or right away if @c item fits by now.
+       */
+      template <typename QueueType>
+      void suspendUntilRoomFor(Scheduler& scheduler, QueueType& queue,
+			       const typename QueueType::ItemType& item) {
+	// Suspend first, so that room made before whenRoomFor() registers
+	// the callback is not missed
+	Scheduler* s = &scheduler;
+	const int fd = queue.queueStateFd();
+	s->suspendWritable(fd);
+	if (queue.whenRoomFor(item, [s, fd]() { s->resumeWritable(fd); })) {
+	  s->resumeWritable(fd);
+	}
+      }
+
+      /** @brief Put @c item onto @c queue when there is room, then call
+       *         @c onDone
+       */
+      template <typename QueueType, typename Callback>
+      void asyncPut(Scheduler& scheduler, QueueType& queue,
+		    typename QueueType::ItemType item, Callback onDone) {
+	// std::function requires a copyable callable, so the item lives
+	// on the heap until it is put
+	auto holder =
+	    std::make_shared<typename QueueType::ItemType>(std::move(item));
+	Scheduler* s = &scheduler;
+	scheduler.whenWritable(queue.queueStateFd(),
+			       [s, &queue, holder, onDone]() mutable {
+	    if (!queue.put(std::move(*holder), 0)) {
+	      suspendUntilRoomFor(*s, queue, *holder);
+	      return false;
+	    }
+	    onDone();
+	    return true;
+	});
+      }
+
+      /** @brief Decrement @c semaphore when it is positive, then call
+       *         @c onDone
+       *
+       *  If other threads also decrement @c semaphore, create it with
+       *  BlockingMode::DONT_BLOCK, so the scheduler's thread cannot
+       *  block when one of them takes the count first.
+       */
+      template <typename Callback>
+      void asyncDown(Scheduler& scheduler, Semaphore& semaphore,
+		     Callback onDone) {
+	scheduler.whenReadable(semaphore.fd(), [&semaphore, onDone]() mutable {
+	    if (!semaphore.tryDown()) {
+	      return false;
+	    }
+	    onDone();
+	    return true;
+	});
+      }
+
+      /** @brief Call @c onNotified on the scheduler's thread the next time
+       *         @c condition issues a notification
+       */
+      template <typename Callback>
+      void asyncWait(Scheduler& scheduler, Condition& condition,
+		     Callback onNotified) {
+	Scheduler* s = &scheduler;
+	condition.whenNotified([s, onNotified]() { s->post(onNotified); });
+      }
+
+#ifdef PISTIS_CONCURRENT_HAS_COROUTINES
+
+      /** @brief Awaitable returned by asyncGet(scheduler, queue) */
+      template <typename QueueType>
+      class AsyncGet {
+      public:
+	typedef typename QueueType::ItemType ItemType;
+
+      public:
+	AsyncGet(Scheduler& scheduler, QueueType& queue):
+	    scheduler_(scheduler), queue_(queue), item_() {
+	}
+
+	bool await_ready() { return queue_.get(item_, 0); }
+
+	void await_suspend(std::coroutine_handle<> h) {
+	  scheduler_.whenReadable(queue_.queueStateFd(), [this, h]() {
+	      if (!queue_.get(item_, 0)) {
+		return false;
+	      }
+	      h.resume();
+	      return true;
+	  });
+	}
+
+	ItemType await_resume() { return std::move(item_); }
+
+      private:
+	Scheduler& scheduler_;
+	QueueType& queue_;
+	ItemType item_;
+      };
+
+      /** @brief Awaitable returned by asyncPut(scheduler, queue, item) */
+      template <typename QueueType>
+      class AsyncPut {
+      public:
+	typedef typename QueueType::ItemType ItemType;
+
+      public:
+	AsyncPut(Scheduler& scheduler, QueueType& queue, ItemType&& item):
+	    scheduler_(scheduler), queue_(queue), item_(std::move(item)) {
+	}
+
+	bool await_ready() { return queue_.put(std::move(item_), 0); }
+
+	void await_suspend(std::coroutine_handle<> h) {
+	  scheduler_.whenWritable(queue_.queueStateFd(), [this, h]() {
+	      if (!queue_.put(std::move(item_), 0)) {
+		suspendUntilRoomFor(scheduler_, queue_, item_);
+		return false;
+	      }
+	      h.resume();
+	      return true;
+	  });
+	}
+
+	void await_resume() { }
+
+      private:
+	Scheduler& scheduler_;
+	QueueType& queue_;
+	ItemType item_;
+      };
+
+      /** @brief Awaitable returned by asyncDown(scheduler, semaphore) */
+      class AsyncDown {
+      public:
+	AsyncDown(Scheduler& scheduler, Semaphore& semaphore):
+	    scheduler_(scheduler), semaphore_(semaphore) {
+	}
+
+	bool await_ready() { return semaphore_.tryDown(); }
+
+	void await_suspend(std::coroutine_handle<> h) {
+	  scheduler_.whenReadable(semaphore_.fd(), [this, h]() {
+	      if (!semaphore_.tryDown()) {
+		return false;
+	      }
+	      h.resume();
+	      return true;
+	  });
+	}
+
+	void await_resume() { }
+
+      private:
+	Scheduler& scheduler_;
+	Semaphore& semaphore_;
+      };
+
+      /** @brief Awaitable returned by asyncWait(scheduler, condition) */
+      class AsyncWait {
+      public:
+	AsyncWait(Scheduler& scheduler, Condition& condition):
+	    scheduler_(scheduler), condition_(condition) {
+	}
+
+	bool await_ready() { return false; }
+
+	void await_suspend(std::coroutine_handle<> h) {
+	  Scheduler* s = &scheduler_;
+	  condition_.whenNotified([s, h]() { s->post([h]() { h.resume(); }); });
+	}
+
+	void await_resume() { }
+
+      private:
+	Scheduler& scheduler_;
+	Condition& condition_;
+      };
+
+      template <typename QueueType>
+      AsyncGet<QueueType> asyncGet(Scheduler& scheduler, QueueType& queue) {
+	return AsyncGet<QueueType>(scheduler, queue);
+      }
+
+      template <typename QueueType>
+      AsyncPut<QueueType> asyncPut(Scheduler& scheduler, QueueType& queue,
+				   typename QueueType::ItemType item) {
+	return AsyncPut<QueueType>(scheduler, queue, std::move(item));
+      }
+
+      inline AsyncDown asyncDown(Scheduler& scheduler, Semaphore& semaphore) {
+	return AsyncDown(scheduler, semaphore);
+      }
+
+      inline AsyncWait asyncWait(Scheduler& scheduler, Condition& condition) {
+	return AsyncWait(scheduler, condition);
+      }
+
+#endif
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,57 @@
+#include "Barrier.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  inline size_t checkNumParties(size_t n) {
+    if (!n) {
+      throw IllegalValueError("Barrier needs at least one party",
+			      PISTIS_EX_HERE);
+    }
+    return n;
+  }
+}
+
+Barrier::Barrier(size_t numParties, CompletionFunction onCompletion,
+		 OnExecMode onExec):
+    numParties_(checkNumParties(numParties)),
+    onCompletion_(std::move(onCompletion)), remaining_(numParties),
+    phase_(0), done_{ { onExec }, { onExec } } {
+}
+
+uint64_t Barrier::arrive() {
+  // No party can arrive at the next phase until this one ends, so the
+  // phase cannot change under us
+  const uint64_t phase = phase_.load(std::memory_order_acquire);
+  if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    if (onCompletion_) {
+      try {
+	onCompletion_();
+      } catch(...) {
+	endPhase_(phase);
+	throw;
+      }
+    }
+    endPhase_(phase);
+  }
+  return phase;
+}
+
+void Barrier::endPhase_(uint64_t phase) {
+  // Every party has seen the end of the previous phase, since they
+  // all arrived at this one
+  done_[(phase + 1) & 1].clear();
+  remaining_.store(numParties_, std::memory_order_relaxed);
+  phase_.store(phase + 1, std::memory_order_release);
+  done_[phase & 1].set();
+}
+
+bool Barrier::wait(uint64_t phase, int64_t timeout) const {
+  if (phase_.load(std::memory_order_acquire) > phase) {
+    return true;
+  }
+  return done_[phase & 1].wait(timeout);
+}
@@ -0,0 +1,81 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__BARRIER_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__BARRIER_HPP__
+
+#include <pistis/concurrent/pollable/Signal.hpp>
+#include <atomic>
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A reusable barrier for a fixed number of parties.
+       *
+       *  Each phase ends when every party has called arrive().  The last
+       *  party to arrive runs the completion function, if any, and
+       *  releases the others by setting that phase's Signal.  Phases
+       *  alternate between two Signals, so a phase's file descriptor
+       *  stays readable until the following phase ends, which cannot
+       *  happen before every party has arrived again.  Waiters therefore
+       *  never miss the end of their phase, and the barrier never
+       *  recreates its file descriptors.  Arriving is one atomic
+       *  decrement for all but the last party.
+       */
+      class Barrier {
+      public:
+	typedef std::function<void ()> CompletionFunction;
+
+      public:
+	Barrier(size_t numParties,
+		CompletionFunction onCompletion = CompletionFunction(),
+		OnExecMode onExec = OnExecMode::CLOSE);
+	Barrier(const Barrier&) = delete;
+
+	size_t numParties() const { return numParties_; }
+
+	/** @brief The phase parties arriving now will join */
+	uint64_t phase() const { return phase_.load(std::memory_order_acquire); }
+
+	/** @brief Readable once the given phase has ended */
+	int fd(uint64_t phase) const { return done_[phase & 1].fd(); }
+
+	/** @brief Arrive at the barrier without waiting
+	 *
+	 *  If the completion function throws, the phase still ends and
+	 *  the exception propagates to the last party to arrive.
+	 *
+	 *  @returns  The phase the caller arrived at, to pass to wait()
+	 *            or fd()
+	 */
+	uint64_t arrive();
+
+	/** @brief Wait until the given phase ends or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @returns  True if the phase has ended, false on timeout
+	 */
+	bool wait(uint64_t phase, int64_t timeout = -1) const;
+
+	/** @brief arrive(), then wait() for the phase to end */
+	bool arriveAndWait(int64_t timeout = -1) {
+	  return wait(arrive(), timeout);
+	}
+
+	Barrier& operator=(const Barrier&) = delete;
+
+      private:
+	const size_t numParties_;
+	CompletionFunction onCompletion_;
+	std::atomic<size_t> remaining_;
+	std::atomic<uint64_t> phase_;
+	Signal done_[2];
+
+	void endPhase_(uint64_t phase);
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,213 @@
+#include "ByteRing.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <chrono>
+#include <sstream>
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  static size_t roundToPages(size_t n) {
+    const size_t pageSize = (size_t)::sysconf(_SC_PAGESIZE);
+    return n ? (n + pageSize - 1) / pageSize * pageSize : pageSize;
+  }
+
+  /** @brief Map @c size bytes of a new memfd twice in a row */
+  static char* mapMirrored(size_t size) {
+    const int fd = ::memfd_create("pistis-byte-ring", MFD_CLOEXEC);
+    if (fd < 0) {
+      throw SystemError::fromSystemCode("Failed to create memfd: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+    if (::ftruncate(fd, size) < 0) {
+      const int error = errno;
+      ::close(fd);
+      throw SystemError::fromSystemCode("Failed to size memfd: #ERR#",
+					error, PISTIS_EX_HERE);
+    }
+
+    // Reserve the address range first so nothing else can be mapped
+    // between the two halves
+    void* base = ::mmap(nullptr, 2 * size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      throw SystemError::fromSystemCode("Failed to reserve address space: "
+					"#ERR#", error, PISTIS_EX_HERE);
+    }
+
+    char* p = static_cast<char*>(base);
+    for (char* half : { p, p + size }) {
+      if (::mmap(half, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+		 fd, 0) == MAP_FAILED) {
+	const int error = errno;
+	::munmap(base, 2 * size);
+	::close(fd);
+	throw SystemError::fromSystemCode("Failed to map memfd: #ERR#",
+					  error, PISTIS_EX_HERE);
+      }
+    }
+
+    // The mappings keep the memory alive
+    ::close(fd);
+    return p;
+  }
+}
+
+ByteRing::ByteRing(size_t capacity, size_t writeThreshold,
+		   OnExecMode onExec):
+    capacity_(roundToPages(capacity)), buffer_(nullptr), head_(0), tail_(0),
+    reserved_(0), writeThreshold_(writeThreshold),
+    toggle_(onExec, BlockingMode::BLOCK, ReadWriteToggle::WRITE_ONLY),
+    roomCv_(), dataCv_(), sync_() {
+  checkThreshold_(writeThreshold);
+  buffer_ = mapMirrored(capacity_);
+}
+
+ByteRing::~ByteRing() {
+  ::munmap(buffer_, 2 * capacity_);
+}
+
+size_t ByteRing::size() const {
+  Lock_ lock(sync_);
+  return tail_ - head_;
+}
+
+size_t ByteRing::available() const {
+  Lock_ lock(sync_);
+  return capacity_ - (tail_ - head_);
+}
+
+size_t ByteRing::writeThreshold() const {
+  Lock_ lock(sync_);
+  return writeThreshold_;
+}
+
+void ByteRing::setWriteThreshold(size_t threshold) {
+  checkThreshold_(threshold);
+  Lock_ lock(sync_);
+  writeThreshold_ = threshold;
+  updateState_();
+}
+
+char* ByteRing::reserve(size_t n) {
+  return reserve(n, 0);
+}
+
+char* ByteRing::reserve(size_t n, int64_t timeout) {
+  if (!n || (n > capacity_)) {
+    std::ostringstream msg;
+    msg << "Cannot reserve " << n << " bytes in a ring of " << capacity_
+	<< " bytes";
+    throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+  }
+
+  Lock_ lock(sync_);
+  auto hasRoom = [this, n]() { return capacity_ - (tail_ - head_) >= n; };
+  if (!waitFor_(roomCv_, lock, timeout, hasRoom)) {
+    return nullptr;
+  }
+  reserved_ = n;
+  return at_(tail_);
+}
+
+void ByteRing::commit(size_t n) {
+  Lock_ lock(sync_);
+  if (n > reserved_) {
+    std::ostringstream msg;
+    msg << "Cannot commit " << n << " bytes from a reservation of "
+	<< reserved_ << " bytes";
+    throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+  }
+  reserved_ = 0;
+  if (n) {
+    tail_ += n;
+    updateState_();
+    dataCv_.notifyAll();
+  }
+}
+
+const char* ByteRing::peek(size_t& n) const {
+  Lock_ lock(sync_);
+  n = tail_ - head_;
+  return n ? at_(head_) : nullptr;
+}
+
+const char* ByteRing::peek(size_t& n, int64_t timeout) {
+  Lock_ lock(sync_);
+  if (!waitFor_(dataCv_, lock, timeout, [this]() { return tail_ != head_; })) {
+    n = 0;
+    return nullptr;
+  }
+  n = tail_ - head_;
+  return at_(head_);
+}
+
+void ByteRing::release(size_t n) {
+  Lock_ lock(sync_);
+  if (n > tail_ - head_) {
+    std::ostringstream msg;
+    msg << "Cannot release " << n << " bytes when only " << (tail_ - head_)
+	<< " are published";
+    throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+  }
+  if (n) {
+    head_ += n;
+    updateState_();
+    roomCv_.notifyAll();
+  }
+}
+
+void ByteRing::checkThreshold_(size_t threshold) const {
+  if (!threshold || (threshold > capacity_)) {
+    std::ostringstream msg;
+    msg << "Write threshold (" << threshold << ") must be between 1 and "
+	<< "the ring's capacity (" << capacity_ << ")";
+    throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+  }
+}
+
+void ByteRing::updateState_() {
+  const size_t used = tail_ - head_;
+  if (!used) {
+    toggle_.setState(ReadWriteToggle::WRITE_ONLY);
+  } else if (capacity_ - used >= writeThreshold_) {
+    toggle_.setState(ReadWriteToggle::READ_WRITE);
+  } else {
+    toggle_.setState(ReadWriteToggle::READ_ONLY);
+  }
+}
+
+template <typename Predicate>
+bool ByteRing::waitFor_(Condition& cv, Lock_& lock, int64_t timeout,
+			Predicate ready) {
+  if (ready()) {
+    return true;
+  } else if (!timeout) {
+    return false;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeout);
+  while (true) {
+    int64_t remaining = -1;
+    if (timeout > 0) {
+      remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+	  deadline - std::chrono::steady_clock::now()
+      ).count();
+      if (remaining <= 0) {
+	return ready();
+      }
+    }
+    cv.wait(lock, remaining);
+    if (ready()) {
+      return true;
+    }
+  }
+}
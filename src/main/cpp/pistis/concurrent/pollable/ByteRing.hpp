@@ -0,0 +1,139 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__BYTERING_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__BYTERING_HPP__
+
+#include <pistis/concurrent/pollable/Condition.hpp>
+#include <pistis/concurrent/pollable/ReadWriteToggle.hpp>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A pollable ring of bytes for variable-length records.
+       *
+       *  A producer calls reserve() to get space for a record, writes
+       *  the record in place and calls commit() to publish it.  A
+       *  consumer calls peek() to see every published byte, processes
+       *  some or all of them in place and calls release() to give the
+       *  space back.  Nothing is allocated or copied per record.
+       *
+       *  The ring's buffer is mapped twice, back to back, so the bytes
+       *  at the end of the buffer are followed by the bytes at its
+       *  start.  A reservation or a peek is therefore always one
+       *  contiguous range, even when it wraps around the end of the
+       *  buffer.  The capacity is rounded up to a whole number of pages.
+       *
+       *  fd() is readable while the ring holds published bytes and
+       *  writable while at least writeThreshold() bytes are free, like
+       *  Queue::queueStateFd().  As with ReadWriteToggle, it may only be
+       *  polled.
+       *
+       *  One thread at a time may produce (reserve() and commit()) and
+       *  one thread at a time may consume (peek() and release()).  The
+       *  producer and consumer may run concurrently.
+       */
+      class ByteRing {
+      public:
+	/** @brief Create a ring with room for at least @c capacity bytes
+	 *
+	 *  @param capacity        Minimum capacity in bytes
+	 *  @param writeThreshold  Free bytes needed for fd() to be writable
+	 *  @param onExec          What happens to fd() across exec()
+	 */
+	ByteRing(size_t capacity, size_t writeThreshold = 1,
+		 OnExecMode onExec = OnExecMode::CLOSE);
+	ByteRing(const ByteRing&) = delete;
+	~ByteRing();
+
+	int fd() const { return toggle_.fd(); }
+	size_t capacity() const { return capacity_; }
+
+	/** @brief Number of published bytes not yet released */
+	size_t size() const;
+
+	/** @brief Number of bytes that can be reserved right now */
+	size_t available() const;
+
+	size_t writeThreshold() const;
+	void setWriteThreshold(size_t threshold);
+
+	/** @brief Reserve @c n contiguous bytes if they are free.
+	 *
+	 *  The reservation lasts until the next commit().  Reserving again
+	 *  before then replaces the reservation.
+	 *
+	 *  @returns  Where to write, or nullptr if fewer than @c n bytes
+	 *            are free
+	 *  @throws pistis::exceptions::IllegalValueError if @c n is zero
+	 *          or more than capacity()
+	 */
+	char* reserve(size_t n);
+
+	/** @brief Reserve @c n contiguous bytes, waiting up to @c timeout ms
+	 *         (-1 = forever) for them to become free.
+	 *
+	 *  @returns  Where to write, or nullptr on timeout
+	 */
+	char* reserve(size_t n, int64_t timeout);
+
+	/** @brief Publish the first @c n bytes of the reservation and end
+	 *         it
+	 *
+	 *  @throws pistis::exceptions::IllegalValueError if @c n is larger
+	 *          than the reservation
+	 */
+	void commit(size_t n);
+
+	/** @brief Get the published bytes
+	 *
+	 *  @param n  Receives the number of bytes published
+	 *  @returns  The oldest published byte, or nullptr if none are
+	 */
+	const char* peek(size_t& n) const;
+
+	/** @brief Get the published bytes, waiting up to @c timeout ms
+	 *         (-1 = forever) for some to be published.
+	 */
+	const char* peek(size_t& n, int64_t timeout);
+
+	/** @brief Give the oldest @c n published bytes back to the ring
+	 *
+	 *  @throws pistis::exceptions::IllegalValueError if fewer than
+	 *          @c n bytes are published
+	 */
+	void release(size_t n);
+
+	ByteRing& operator=(const ByteRing&) = delete;
+
+      private:
+	typedef std::unique_lock<std::mutex> Lock_;
+
+	size_t capacity_;
+	char* buffer_;
+	uint64_t head_;      ///< Total bytes ever released
+	uint64_t tail_;      ///< Total bytes ever committed
+	size_t reserved_;
+	size_t writeThreshold_;
+	ReadWriteToggle toggle_;
+	Condition roomCv_;
+	Condition dataCv_;
+	mutable std::mutex sync_;
+
+	char* at_(uint64_t position) const {
+	  return buffer_ + (position % capacity_);
+	}
+
+	void checkThreshold_(size_t threshold) const;
+	void updateState_();
+
+	template <typename Predicate>
+	bool waitFor_(Condition& cv, Lock_& lock, int64_t timeout,
+		      Predicate ready);
+      };
+
+    }
+  }
+}
+#endif
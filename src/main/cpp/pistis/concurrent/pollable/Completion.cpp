@@ -0,0 +1,61 @@
+#include "Completion.hpp"
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  inline int createEventFd(OnExecMode onExec) {
+    int fd = ::eventfd(0, EFD_NONBLOCK |
+		            (onExec == OnExecMode::CLOSE ? EFD_CLOEXEC : 0));
+    if (fd < 0) {
+      throw SystemError::fromSystemCode("Failed to create event fd: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+    return fd;
+  }
+}
+
+Completion::State_::~State_() {
+  ::close(fd);
+}
+
+Completion::Completion(OnExecMode onExec):
+    state_(std::make_shared<State_>(createEventFd(onExec))) {
+}
+
+bool Completion::wait(int64_t timeout) const {
+  if (done()) {
+    return true;
+  }
+  EpollSet pollSet(state_->fd, EpollEventType::READ);
+  pollSet.wait(timeout);
+  return done();
+}
+
+void Completion::get() const {
+  wait(-1);
+  if (state_->error) {
+    std::rethrow_exception(state_->error);
+  }
+}
+
+void Completion::complete(std::exception_ptr error) {
+  if (done()) {
+    throw IllegalStateError("Work has already completed", PISTIS_EX_HERE);
+  }
+  state_->error = error;
+  state_->done.store(true, std::memory_order_release);
+
+  // The eventfd is never read, so it stays readable from now on
+  const uint64_t one = 1;
+  if (::write(state_->fd, &one, sizeof(one)) < 0) {
+    throw SystemError::fromSystemCode("Write to eventfd failed: #ERR#", errno,
+				      PISTIS_EX_HERE);
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__COMPLETION_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__COMPLETION_HPP__
+
+#include <pistis/concurrent/OnExecMode.hpp>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A handle that signals when a piece of work finishes.
+       *
+       *  Each Completion owns an eventfd that becomes readable when
+       *  complete() is called and stays readable from then on, so fd()
+       *  can be added to an EpollSet alongside other file descriptors.
+       *  Copies of a Completion share the same state.
+       */
+      class Completion {
+      public:
+	/** @brief Create an unfinished completion */
+	Completion(OnExecMode onExec = OnExecMode::CLOSE);
+
+	/** @brief Readable once the work has finished */
+	int fd() const { return state_->fd; }
+
+	/** @brief True if the work has finished */
+	bool done() const {
+	  return state_->done.load(std::memory_order_acquire);
+	}
+
+	/** @brief True if the work finished by throwing an exception */
+	bool failed() const { return done() && (bool)state_->error; }
+
+	/** @brief Wait until the work has finished or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @returns  True if the work has finished, false on timeout
+	 */
+	bool wait(int64_t timeout = -1) const;
+
+	/** @brief Wait for the work to finish, then rethrow the exception
+	 *         it threw, if any
+	 */
+	void get() const;
+
+	/** @brief Mark the work finished.
+	 *
+	 *  @param error  The exception the work threw, or a null pointer if
+	 *                it succeeded
+	 *  @throws IllegalStateError if the work has already finished
+	 */
+	void complete(std::exception_ptr error = std::exception_ptr());
+
+      private:
+	struct State_ {
+	  int fd;
+	  std::atomic<bool> done;
+	  std::exception_ptr error;
+
+	  State_(int f): fd(f), done(false), error() { }
+	  ~State_();
+	};
+
+	std::shared_ptr<State_> state_;
+      };
+
+    }
+  }
+}
+#endif
@@ -2,8 +2,11 @@
 #define __PISTIS__CONCURRENT__POLLABLE__CONDITION_HPP__
 
 #include <pistis/exceptions/NoSuchItem.hpp>
+#include <pistis/concurrent/ProfiledMutex.hpp>
+#include <pistis/concurrent/Trace.hpp>
 #include <pistis/concurrent/pollable/Semaphore.hpp>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -178,9 +181,28 @@ namespace pistis {
 	};
 	
       public:
-	Condition(): queue_(), observers_(), sync_() { }
+	/** @brief Create a condition variable whose observers' file
+	 *         descriptors use the given BlockingMode.
+	 *
+	 *  With BlockingMode::DONT_BLOCK, tryAck() resets a descriptor
+	 *  without ever waiting.  Threads blocked in wait() are unaffected.
+	 */
+	Condition(BlockingMode blocking = BlockingMode::BLOCK):
+	    queue_(), observers_(), blocking_(blocking),
+	    sync_(this, "Condition") {
+	}
 	Condition(Condition&&) = default;
 
+	BlockingMode blockingMode() const { return blocking_; }
+
+	/** @brief Use @c blocking for descriptors returned by later calls
+	 *         to observe().  Existing observers keep their mode.
+	 */
+	void setBlockingMode(BlockingMode blocking) {
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  blocking_ = blocking;
+	}
+
 	/** @brief Block the calling thread until the condition variable
 	 *         notifies it.
 	 *
@@ -188,11 +210,13 @@ namespace pistis {
 	 *          occurs.
 	 */
 	void wait() {
-	  std::unique_lock<std::mutex> lock(sync_);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
 	  std::shared_ptr<Semaphore> s(new Semaphore);
 
-	  queue_.push_back(s);
+	  queue_.push_back(Waiter_(s));
 	  lock.unlock();
+
+	  Trace::WaitScope trace(this);
 	  s->down();
 	}
 
@@ -207,13 +231,66 @@ namespace pistis {
 	 *            occurs.
 	 */
 	bool wait(int64_t timeout) {
-	  std::unique_lock<std::mutex> lock(sync_);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
 	  std::shared_ptr<Semaphore> s(new Semaphore);
 
-	  queue_.push_back(s);
+	  queue_.push_back(Waiter_(s));
 	  lock.unlock();
 
-	  return s->down(timeout);
+	  Trace::WaitScope trace(this);
+	  return s->down(timeout) || !cancelWait_(s);
+	}
+
+	/** @brief Atomically release @c lock and wait for the condition
+	 *         variable to notify the calling thread or for the timeout
+	 *         (in ms) to expire, then reacquire @c lock.
+	 *
+	 *  The caller is registered as a waiter before @c lock is released,
+	 *  so a notification issued by a thread holding @c lock cannot be
+	 *  missed between the release and the wait.
+	 *
+	 *  @param lock     A held lock, such as std::unique_lock
+	 *  @param timeout  Timeout in milliseconds, or -1 to wait forever
+	 *  @returns  True if the wait terminated because the condition
+	 *            variable notified the waiting thread, false if the
+	 *            timeout expired.
+	 *  @throws   pistis::exceptions::SystemError if an internal error
+	 *            occurs.
+	 */
+	template <typename Lock>
+	bool wait(Lock& lock, int64_t timeout) {
+	  std::shared_ptr<Semaphore> s(new Semaphore);
+	  {
+	    std::unique_lock<ProfiledMutex> queueLock(sync_);
+	    queue_.push_back(Waiter_(s));
+	  }
+
+	  Trace::WaitScope trace(this);
+	  lock.unlock();
+	  bool notified = true;
+	  if (timeout < 0) {
+	    s->down();
+	  } else {
+	    notified = s->down(timeout) || !cancelWait_(s);
+	  }
+	  lock.lock();
+	  return notified;
+	}
+
+	/** @brief Call @c callback once, the next time the condition
+	 *         variable issues a notification.
+	 *
+	 *  The callback counts as one waiter, so notifyOne() may choose it
+	 *  instead of a waiting thread or observer.  It runs on the thread
+	 *  that calls notifyOne() or notifyAll(), after the condition
+	 *  variable's internal lock has been released, so it may register
+	 *  itself again.  It should be short; asynchronous code usually just
+	 *  hands the notification to a Scheduler.  Unlike wait() and
+	 *  observe(), whenNotified() does not need a file descriptor.
+	 */
+	void whenNotified(std::function<void ()> callback) {
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  queue_.push_back(Waiter_(std::move(callback)));
 	}
 
 	/** @brief Returns a file descriptor the condition variable can use
@@ -260,10 +337,12 @@ namespace pistis {
 	 *             occurs.
 	 */
 	int observe() {
-	  std::unique_lock<std::mutex> lock(sync_);
-	  std::shared_ptr<Semaphore> s(new Semaphore);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  std::shared_ptr<Semaphore> s(
+	      new Semaphore(0, OnExecMode::CLOSE, blocking_)
+	  );
 
-	  queue_.push_back(s);
+	  queue_.push_back(Waiter_(s));
 	  observers_.insert(std::make_pair(s->fd(), s));
 	  return s->fd();
 	}
@@ -298,12 +377,39 @@ namespace pistis {
 	 *          occurs
 	 */
 	void ack(int fd) {
-	  std::unique_lock<std::mutex> lock(sync_);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
 	  std::shared_ptr<Semaphore> s = lookup_(fd)->second;
 	  lock.unlock();
 	  s->down();
 	  lock.lock();
-	  queue_.push_back(s);
+	  queue_.push_back(Waiter_(s));
+	}
+
+	/** @brief Reset a file descriptor if it has received a
+	 *         notification, and return immediately if it has not.
+	 *
+	 *  Never waits if the condition variable was created with
+	 *  BlockingMode::DONT_BLOCK.  With BlockingMode::BLOCK, it can
+	 *  block like ack() if @c fd is reset by another thread between
+	 *  the check and the reset.
+	 *
+	 *  @param fd  The file descriptor to reset
+	 *  @returns   True if @c fd had received a notification and has been
+	 *             reset, false if it had not.
+	 *  @throws pistis::exceptions::NoSuchItem if fd was not obtained from
+	 *          this condition variable or if stopObserving() has been
+	 *          called on it.
+	 */
+	bool tryAck(int fd) {
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  std::shared_ptr<Semaphore> s = lookup_(fd)->second;
+	  lock.unlock();
+	  if (!s->tryDown()) {
+	    return false;
+	  }
+	  lock.lock();
+	  queue_.push_back(Waiter_(s));
+	  return true;
 	}
 
 	/** @brief Return a file descriptor obtained from observe() to the
@@ -332,7 +438,7 @@ namespace pistis {
 	 *          occurs.
 	 */
 	void stopObserving(int fd) {
-	  std::unique_lock<std::mutex> lock(sync_);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
 	  auto i = lookup_(fd);
 	  observers_.erase(i);
 	}
@@ -344,10 +450,17 @@ namespace pistis {
 	 *          occurs.
 	 */
 	void notifyOne() {
-	  std::unique_lock<std::mutex> lock(sync_);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  Trace::record(TraceEventType::NOTIFY, this, queue_.empty() ? 0 : 1);
 	  if (queue_.size()) {
-	    queue_.back()->up();
+	    Waiter_ waiter(std::move(queue_.back()));
 	    queue_.pop_back();
+	    if (waiter.semaphore) {
+	      waiter.semaphore->up();
+	    } else {
+	      lock.unlock();
+	      waiter.callback();
+	    }
 	  }
 	}
 
@@ -358,19 +471,59 @@ namespace pistis {
 	 *          occurs.
 	 */
 	void notifyAll() {
-	  std::unique_lock<std::mutex> lock(sync_);
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  Trace::record(TraceEventType::NOTIFY, this, queue_.size());
+	  std::deque<Waiter_> callbacks;
 	  while (queue_.size()) {
-	    queue_.back()->up();
+	    if (queue_.back().semaphore) {
+	      queue_.back().semaphore->up();
+	    } else {
+	      callbacks.push_back(std::move(queue_.back()));
+	    }
 	    queue_.pop_back();
 	  }
+	  lock.unlock();
+
+	  for (auto& waiter : callbacks) {
+	    waiter.callback();
+	  }
 	}
 	
 	Condition& operator=(Condition&&) = default;
 
       private:
-	std::deque< std::shared_ptr<Semaphore> > queue_;
+	/** @brief A thread or observer waiting on a Semaphore, or a callback
+	 *         registered with whenNotified()
+	 */
+	struct Waiter_ {
+	  std::shared_ptr<Semaphore> semaphore;
+	  std::function<void ()> callback;
+
+	  explicit Waiter_(const std::shared_ptr<Semaphore>& s): semaphore(s) { }
+	  explicit Waiter_(std::function<void ()>&& f): callback(std::move(f)) { }
+	};
+
+	std::deque<Waiter_> queue_;
 	std::unordered_map<int, std::shared_ptr<Semaphore> > observers_;
-	std::mutex sync_;
+	BlockingMode blocking_;  ///< Mode of the observers' descriptors
+	ProfiledMutex sync_;
+
+	/** @brief Take the waiter for @c s off the queue after its wait
+	 *         times out, so its Semaphore is not kept until the next
+	 *         notification.
+	 *
+	 *  @returns  False if a notification took the waiter off first
+	 */
+	bool cancelWait_(const std::shared_ptr<Semaphore>& s) {
+	  std::unique_lock<ProfiledMutex> lock(sync_);
+	  for (auto i = queue_.begin(); i != queue_.end(); ++i) {
+	    if (i->semaphore == s) {
+	      queue_.erase(i);
+	      return true;
+	    }
+	  }
+	  return false;
+	}
 
 	std::unordered_map< int, std::shared_ptr<Semaphore> >::iterator
 	    lookup_(int fd) {
@@ -0,0 +1,95 @@
+#include "DeadlineTimer.hpp"
+#include <pistis/exceptions/SystemError.hpp>
+#include <sys/timerfd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  static int createTimerFd(OnExecMode onExec) {
+    const int flags = TFD_NONBLOCK |
+                      (onExec == OnExecMode::CLOSE ? TFD_CLOEXEC : 0);
+    const int fd = ::timerfd_create(CLOCK_MONOTONIC, flags);
+    if (fd < 0) {
+      throw SystemError::fromSystemCode("Failed to create timer fd: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+    return fd;
+  }
+}
+
+DeadlineTimer::DeadlineTimer(OnExecMode onExec):
+    fd_(createTimerFd(onExec)), armed_(false), deadline_() {
+}
+
+DeadlineTimer::DeadlineTimer(DeadlineTimer&& other):
+    fd_(other.fd_), armed_(other.armed_), deadline_(other.deadline_) {
+  other.fd_ = -1;
+  other.armed_ = false;
+}
+
+DeadlineTimer::~DeadlineTimer() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+DeadlineTimer& DeadlineTimer::operator=(DeadlineTimer&& other) {
+  if (fd_ != other.fd_) {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    fd_ = other.fd_;
+    armed_ = other.armed_;
+    deadline_ = other.deadline_;
+    other.fd_ = -1;
+    other.armed_ = false;
+  }
+  return *this;
+}
+
+void DeadlineTimer::arm(TimePoint deadline) {
+  const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      deadline.time_since_epoch()
+  ).count();
+
+  // Zero would disarm the timer, so clamp to the earliest possible
+  // deadline, which has already passed
+  setTime_(ns > 0 ? ns : 1);
+  armed_ = true;
+  deadline_ = deadline;
+}
+
+void DeadlineTimer::disarm() {
+  setTime_(0);
+  armed_ = false;
+}
+
+bool DeadlineTimer::clear() {
+  uint64_t expirations;
+  if (::read(fd_, &expirations, sizeof(expirations)) < 0) {
+    if (errno == EAGAIN) {
+      return false;
+    }
+    throw SystemError::fromSystemCode("Failed to read from timer fd: #ERR#",
+				      errno, PISTIS_EX_HERE);
+  }
+  armed_ = false;
+  return true;
+}
+
+void DeadlineTimer::setTime_(int64_t ns) {
+  struct itimerspec value = { { 0, 0 }, { 0, 0 } };
+  value.it_value.tv_sec = ns / 1000000000;
+  value.it_value.tv_nsec = ns % 1000000000;
+
+  // Setting the time also discards any expiration not yet read
+  if (::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &value, nullptr) < 0) {
+    throw SystemError::fromSystemCode("Failed to set timer fd: #ERR#",
+				      errno, PISTIS_EX_HERE);
+  }
+}
@@ -0,0 +1,70 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__DEADLINETIMER_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__DEADLINETIMER_HPP__
+
+#include <pistis/concurrent/OnExecMode.hpp>
+#include <chrono>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A file descriptor that becomes readable at a deadline.
+       *
+       *  DeadlineTimer wraps a CLOCK_MONOTONIC timerfd, so deadlines are
+       *  std::chrono::steady_clock time points.  Once the deadline
+       *  passes, the descriptor stays readable until the timer is
+       *  re-armed, disarmed or acknowledged with clear().  As with
+       *  ReadWriteToggle, applications should only poll the descriptor
+       *  and never read from it directly.
+       */
+      class DeadlineTimer {
+      public:
+	typedef std::chrono::steady_clock Clock;
+	typedef Clock::time_point TimePoint;
+
+      public:
+	DeadlineTimer(OnExecMode onExec = OnExecMode::CLOSE);
+	DeadlineTimer(const DeadlineTimer&) = delete;
+	DeadlineTimer(DeadlineTimer&& other);
+	~DeadlineTimer();
+
+	int fd() const { return fd_; }
+
+	/** @brief True if the timer is set to a deadline */
+	bool armed() const { return armed_; }
+
+	/** @brief The deadline the timer is set to.  Meaningless unless
+	 *         armed() is true.
+	 */
+	TimePoint deadline() const { return deadline_; }
+
+	/** @brief Make the descriptor readable at @c deadline.  A deadline
+	 *         in the past makes it readable immediately.
+	 */
+	void arm(TimePoint deadline);
+
+	/** @brief Make the descriptor unreadable until the next arm() */
+	void disarm();
+
+	/** @brief Consume a pending expiration, if any.
+	 *
+	 *  @returns  True if the deadline had passed
+	 */
+	bool clear();
+
+	DeadlineTimer& operator=(const DeadlineTimer&) = delete;
+	DeadlineTimer& operator=(DeadlineTimer&& other);
+
+      private:
+	int fd_;
+	bool armed_;
+	TimePoint deadline_;
+
+	void setTime_(int64_t ns);
+      };
+
+    }
+  }
+}
+#endif
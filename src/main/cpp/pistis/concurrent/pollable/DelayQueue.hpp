@@ -0,0 +1,232 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__DELAYQUEUE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__DELAYQUEUE_HPP__
+
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/TimeUtils.hpp>
+#include <pistis/concurrent/pollable/DeadlineTimer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A pollable queue whose items become available at a
+       *         scheduled time.
+       *
+       *  Each item is put into the queue with the time it becomes ready,
+       *  and get() returns ready items in order of that time, with ties
+       *  broken in the order the items were put.  Items are kept in a
+       *  binary heap, so put() and get() take O(log n) time.
+       *
+       *  The queue owns a single DeadlineTimer that is always set to the
+       *  earliest ready time, so fd() becomes readable exactly when at
+       *  least one item is ready and no thread or timer is needed per
+       *  item.  Like Queue::queueStateFd(), fd() may only be polled.
+       *
+       *  The queue is unbounded.
+       */
+      template <typename Item, typename Allocator = std::allocator<Item> >
+      class DelayQueue {
+      public:
+	typedef Item ItemType;
+	typedef Allocator AllocatorType;
+	typedef DeadlineTimer::Clock Clock;
+	typedef DeadlineTimer::TimePoint TimePoint;
+
+	static const size_t MAX_ITEMS = (size_t)-1;
+
+      private:
+	typedef std::unique_lock<std::mutex> Lock_;
+
+	struct Entry_ {
+	  TimePoint readyAt;
+	  uint64_t seq;
+	  Item item;
+
+	  Entry_(TimePoint t, uint64_t s, Item&& i):
+	      readyAt(t), seq(s), item(std::move(i)) {
+	  }
+	};
+
+	/** @brief Orders the heap so the earliest entry is on top */
+	struct Later_ {
+	  bool operator()(const Entry_& a, const Entry_& b) const {
+	    return (a.readyAt > b.readyAt) ||
+	           ((a.readyAt == b.readyAt) && (a.seq > b.seq));
+	  }
+	};
+
+	typedef typename std::allocator_traits<Allocator>::template
+	    rebind_alloc<Entry_> EntryAllocator_;
+	typedef std::vector<Entry_, EntryAllocator_> Heap_;
+
+      public:
+	DelayQueue(OnExecMode onExec = OnExecMode::CLOSE,
+		   const Allocator& allocator = Allocator()):
+	    timer_(onExec), heap_(EntryAllocator_(allocator)), nextSeq_(0) {
+	}
+
+	DelayQueue(const DelayQueue&) = delete;
+
+	/** @brief A descriptor that is readable while an item is ready */
+	int fd() const { return timer_.fd(); }
+
+	bool empty() const { return !size(); }
+
+	size_t size() const {
+	  Lock_ lock(sync_);
+	  return heap_.size();
+	}
+
+	Allocator allocator() const { return Allocator(heap_.get_allocator()); }
+
+	/** @brief Get the time the next item becomes ready.
+	 *
+	 *  @returns  False if the queue is empty
+	 */
+	bool nextReadyAt(TimePoint& readyAt) const {
+	  Lock_ lock(sync_);
+	  if (heap_.empty()) {
+	    return false;
+	  }
+	  readyAt = heap_.front().readyAt;
+	  return true;
+	}
+
+	void put(const Item& item, TimePoint readyAt) {
+	  executePut_(readyAt, Item(item));
+	}
+
+	void put(Item&& item, TimePoint readyAt) {
+	  executePut_(readyAt, std::move(item));
+	}
+
+	/** @brief Put an item that becomes ready @c delay ms from now */
+	void putAfter(const Item& item, int64_t delay) {
+	  put(item, Clock::now() + toMs(delay));
+	}
+
+	void putAfter(Item&& item, int64_t delay) {
+	  put(std::move(item), Clock::now() + toMs(delay));
+	}
+
+	/** @brief Wait for the next item to become ready and take it */
+	Item get() {
+	  Item item;
+	  get(item, -1);
+	  return item;
+	}
+
+	/** @brief Take the next ready item.
+	 *
+	 *  @param result   Receives the item
+	 *  @param timeout  Maximum time to wait for an item to become ready
+	 *                  in ms, or -1 to wait forever
+	 *  @returns  True if an item was retrieved, false on timeout
+	 */
+	bool get(Item& result, int64_t timeout = 0) {
+	  if (tryGet_(result)) {
+	    return true;
+	  } else if (!timeout) {
+	    return false;
+	  }
+
+	  EpollSet epollSet(timer_.fd(), EpollEventType::READ);
+	  auto now = std::chrono::system_clock::now();
+	  auto deadline = now + toMs(timeout);
+	  while (true) {
+	    if (!epollSet.wait(timeout < 0 ? -1 : toMs(deadline - now))) {
+	      return tryGet_(result);
+	    }
+	    if (tryGet_(result)) {
+	      return true;
+	    }
+	    now = std::chrono::system_clock::now();
+	    if ((timeout >= 0) && (now >= deadline)) {
+	      return false;
+	    }
+	  }
+	}
+
+	/** @brief Move up to @c maxItems ready items onto the end of
+	 *         @c buffer, which may be any container with push_back().
+	 *
+	 *  @returns  The number of items moved
+	 */
+	template <typename Container>
+	size_t drainReady(Container& buffer, size_t maxItems = MAX_ITEMS) {
+	  Lock_ lock(sync_);
+	  const TimePoint now = Clock::now();
+	  size_t n = 0;
+	  while ((n < maxItems) && !heap_.empty() &&
+		 (heap_.front().readyAt <= now)) {
+	    buffer.push_back(popTop_());
+	    ++n;
+	  }
+	  if (n) {
+	    rearm_();
+	  }
+	  return n;
+	}
+
+	/** @brief Discard every item, ready or not */
+	void clear() {
+	  Lock_ lock(sync_);
+	  heap_.clear();
+	  rearm_();
+	}
+
+	DelayQueue& operator=(const DelayQueue&) = delete;
+
+      private:
+	DeadlineTimer timer_;
+	Heap_ heap_;
+	uint64_t nextSeq_;
+	mutable std::mutex sync_;
+
+	void executePut_(TimePoint readyAt, Item&& item) {
+	  Lock_ lock(sync_);
+	  heap_.emplace_back(readyAt, nextSeq_++, std::move(item));
+	  std::push_heap(heap_.begin(), heap_.end(), Later_());
+	  rearm_();
+	}
+
+	bool tryGet_(Item& result) {
+	  Lock_ lock(sync_);
+	  if (heap_.empty() || (heap_.front().readyAt > Clock::now())) {
+	    return false;
+	  }
+	  result = popTop_();
+	  rearm_();
+	  return true;
+	}
+
+	Item popTop_() {
+	  std::pop_heap(heap_.begin(), heap_.end(), Later_());
+	  Item item(std::move(heap_.back().item));
+	  heap_.pop_back();
+	  return item;
+	}
+
+	/** @brief Point the timer at the earliest ready time */
+	void rearm_() {
+	  if (heap_.empty()) {
+	    if (timer_.armed()) {
+	      timer_.disarm();
+	    }
+	  } else if (!timer_.armed() ||
+		     (timer_.deadline() != heap_.front().readyAt)) {
+	    timer_.arm(heap_.front().readyAt);
+	  }
+	}
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,390 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__FUTURE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__FUTURE_HPP__
+
+#include <pistis/concurrent/pollable/FutureState.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      template <typename T> class Future;
+      template <typename T> class Promise;
+
+      /** @brief Call @c f with @c args and make @c state ready with its
+       *         result, or with the exception it throws
+       */
+      template <typename R>
+      struct FulfillFrom {
+	template <typename F, typename... Args>
+	static void call(FutureState<R>& state, F& f, Args&&... args) {
+	  try {
+	    state.succeed(f(std::forward<Args>(args)...));
+	  } catch(...) {
+	    state.fail(std::current_exception());
+	  }
+	}
+      };
+
+      template <>
+      struct FulfillFrom<void> {
+	template <typename F, typename... Args>
+	static void call(FutureState<void>& state, F& f, Args&&... args) {
+	  try {
+	    f(std::forward<Args>(args)...);
+	  } catch(...) {
+	    state.fail(std::current_exception());
+	    return;
+	  }
+	  state.succeed();
+	}
+      };
+
+      /** @brief Passes a ready future's value to a continuation */
+      template <typename T>
+      struct Continue {
+	template <typename F>
+	struct Result {
+	  typedef decltype(std::declval<F&>()(std::declval<const T&>())) type;
+	};
+
+	template <typename R, typename F>
+	static void call(FutureState<R>& next, F& f,
+			 const FutureState<T>& state) {
+	  FulfillFrom<R>::call(next, f, state.value());
+	}
+      };
+
+      template <>
+      struct Continue<void> {
+	template <typename F>
+	struct Result {
+	  typedef decltype(std::declval<F&>()()) type;
+	};
+
+	template <typename R, typename F>
+	static void call(FutureState<R>& next, F& f,
+			 const FutureState<void>&) {
+	  FulfillFrom<R>::call(next, f);
+	}
+      };
+
+      /** @brief The result of an operation that may not have finished
+       *         yet.
+       *
+       *  A Future becomes ready when its Promise is given a value or an
+       *  exception.  fd() returns an eventfd that becomes readable when
+       *  the future is ready and stays readable, so a future can sit in
+       *  an EpollSet alongside other file descriptors.  The eventfd is
+       *  created the first time fd() is called, so a future that is only
+       *  waited on or continued with then() needs no file descriptor.
+       *
+       *  Futures are handles to shared state, like std::shared_future:
+       *  copies refer to the same result, and get() returns a reference
+       *  to it.
+       */
+      template <typename T>
+      class Future {
+      public:
+	typedef typename FutureState<T>::Reference Reference;
+
+      public:
+	/** @brief Create a future with no state.  Only valid() and
+	 *         assignment may be called on it.
+	 */
+	Future(): state_() { }
+
+	bool valid() const { return (bool)state_; }
+	bool ready() const { return state_->ready(); }
+
+	/** @brief True if the future is ready with an exception */
+	bool failed() const { return state_->failed(); }
+
+	/** @brief Readable once the future is ready */
+	int fd() const { return state_->fd(); }
+
+	/** @brief Wait until the future is ready or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @returns  True if the future is ready, false on timeout
+	 */
+	bool wait(int64_t timeout = -1) const { return state_->wait(timeout); }
+
+	/** @brief Wait until the future is ready, then return its value or
+	 *         rethrow its exception
+	 */
+	Reference get() const {
+	  state_->wait(-1);
+	  if (state_->error()) {
+	    std::rethrow_exception(state_->error());
+	  }
+	  return state_->value();
+	}
+
+	/** @brief Call @c f with this future's value once it is ready.
+	 *
+	 *  @c f takes a const reference to the value, or nothing if the
+	 *  value type is void.  If this future fails, @c f is not called
+	 *  and the returned future fails with the same exception.  @c f
+	 *  runs on the thread that makes this future ready, or on the
+	 *  calling thread if it is already ready.
+	 *
+	 *  @returns  A future for the value @c f returns
+	 */
+	template <typename F>
+	Future<typename Continue<T>::template Result<F>::type> then(F f) const {
+	  return then(std::allocator_arg, std::allocator<char>(), std::move(f));
+	}
+
+	/** @brief Same as then(F), with the returned future's state
+	 *         allocated by @c allocator
+	 */
+	template <typename Allocator, typename F>
+	Future<typename Continue<T>::template Result<F>::type>
+	    then(std::allocator_arg_t, const Allocator& allocator, F f) const {
+	  return thenOn_(allocator,
+			 [](std::function<void ()> task) { task(); },
+			 std::move(f));
+	}
+
+	/** @brief Call @c f with this future's value on @c executor once it
+	 *         is ready.
+	 *
+	 *  Same as then(F), except that @c f is handed to
+	 *  executor.execute() instead of running on the thread that makes
+	 *  this future ready.  If execute() throws, for instance because
+	 *  the executor is shutting down, the returned future fails with
+	 *  that exception.
+	 */
+	template <typename Executor, typename F>
+	Future<typename Continue<T>::template Result<F>::type>
+	    then(Executor& executor, F f) const {
+	  return then(std::allocator_arg, std::allocator<char>(), executor,
+		      std::move(f));
+	}
+
+	/** @brief Same as then(Executor&, F), with the returned future's
+	 *         state allocated by @c allocator
+	 */
+	template <typename Allocator, typename Executor, typename F>
+	Future<typename Continue<T>::template Result<F>::type>
+	    then(std::allocator_arg_t, const Allocator& allocator,
+		 Executor& executor, F f) const {
+	  return thenOn_(allocator,
+			 [&executor](std::function<void ()> task) {
+			   executor.execute(std::move(task));
+			 }, std::move(f));
+	}
+
+      private:
+	std::shared_ptr< FutureState<T> > state_;
+
+	explicit Future(const std::shared_ptr< FutureState<T> >& state):
+	    state_(state) {
+	}
+
+	template <typename Allocator, typename Dispatch, typename F>
+	Future<typename Continue<T>::template Result<F>::type>
+	    thenOn_(const Allocator& allocator, Dispatch dispatch, F f) const {
+	  typedef typename Continue<T>::template Result<F>::type R;
+	  auto state = state_;
+	  auto next = std::allocate_shared< FutureState<R> >(allocator,
+							     OnExecMode::CLOSE);
+
+	  state->onReady([dispatch, state, next, f]() mutable {
+	      if (state->error()) {
+		next->fail(state->error());
+		return;
+	      }
+	      try {
+		dispatch([state, next, f]() mutable {
+		    Continue<T>::call(*next, f, *state);
+		});
+	      } catch(...) {
+		// Otherwise the exception would escape the callbacks of the
+		// future that became ready, and next would never be ready
+		next->fail(std::current_exception());
+	      }
+	  });
+	  return Future<R>(next);
+	}
+
+	template <typename U> friend class Future;
+	template <typename U> friend class Promise;
+	template <typename U, typename Allocator>
+	friend Future<void> whenAll(std::allocator_arg_t, const Allocator&,
+				    const std::vector< Future<U> >&);
+	template <typename U, typename Allocator>
+	friend Future<size_t> whenAny(std::allocator_arg_t, const Allocator&,
+				      const std::vector< Future<U> >&);
+      };
+
+      /** @brief The producer's side of a Future.
+       *
+       *  A Promise makes its future ready exactly once, with either a
+       *  value or an exception.  Destroying a Promise that has not done
+       *  so fails its future with an IllegalStateError, so consumers
+       *  never wait forever on an abandoned result.
+       *
+       *  The shared state is allocated with std::allocate_shared.  Pass
+       *  an allocator with std::allocator_arg, such as a PoolAllocator,
+       *  to take it from a pool instead of the heap.  Future::then(),
+       *  whenAll(), whenAny() and Executor::async() take an allocator
+       *  for the states they create the same way.
+       */
+      template <typename T>
+      class Promise {
+      public:
+	Promise(OnExecMode onExec = OnExecMode::CLOSE):
+	    state_(std::make_shared< FutureState<T> >(onExec)) {
+	}
+
+	template <typename Allocator>
+	Promise(std::allocator_arg_t, const Allocator& allocator,
+		OnExecMode onExec = OnExecMode::CLOSE):
+	    state_(std::allocate_shared< FutureState<T> >(allocator, onExec)) {
+	}
+
+	Promise(const Promise&) = delete;
+	Promise(Promise&&) = default;
+
+	~Promise() { abandon_(); }
+
+	/** @brief The future this promise makes ready.  May be called
+	 *         any number of times.
+	 */
+	Future<T> future() const { return Future<T>(state_); }
+
+	/** @brief True if the future is ready */
+	bool satisfied() const { return state_->ready(); }
+
+	/** @brief Make the future ready with a value constructed from
+	 *         @c args, or with no arguments if the value type is void.
+	 *
+	 *  @throws IllegalStateError if the future is already ready
+	 */
+	template <typename... Args>
+	void setValue(Args&&... args) {
+	  state_->succeed(std::forward<Args>(args)...);
+	}
+
+	/** @brief Make the future ready with an exception
+	 *
+	 *  @throws IllegalStateError if the future is already ready
+	 */
+	void setError(std::exception_ptr error) { state_->fail(error); }
+
+	/** @brief Call @c f and make the future ready with its result or
+	 *         the exception it throws
+	 */
+	template <typename F>
+	void setFrom(F f) { FulfillFrom<T>::call(*state_, f); }
+
+	Promise& operator=(const Promise&) = delete;
+	Promise& operator=(Promise&& other) {
+	  if (this != &other) {
+	    abandon_();
+	    state_ = std::move(other.state_);
+	  }
+	  return *this;
+	}
+
+      private:
+	std::shared_ptr< FutureState<T> > state_;
+
+	void abandon_() {
+	  if (state_ && !state_->ready()) {
+	    try {
+	      throw pistis::exceptions::IllegalStateError(
+		  "Promise destroyed without a value", PISTIS_EX_HERE
+	      );
+	    } catch(...) {
+	      try {
+		state_->fail(std::current_exception());
+	      } catch(...) {
+		// Set by another thread in the meantime
+	      }
+	    }
+	  }
+	}
+      };
+
+      /** @brief A future that is ready once all of @c futures are ready.
+       *
+       *  The combined future never fails; call get() on the individual
+       *  futures to retrieve their values or exceptions.  Waiting on the
+       *  combined future's fd() replaces polling one fd per future.
+       */
+      template <typename T, typename Allocator>
+      Future<void> whenAll(std::allocator_arg_t, const Allocator& allocator,
+			   const std::vector< Future<T> >& futures) {
+	auto all = std::allocate_shared< FutureState<void> >(
+	    allocator, OnExecMode::CLOSE
+	);
+	if (futures.empty()) {
+	  all->succeed();
+	} else {
+	  auto remaining = std::allocate_shared< std::atomic<size_t> >(
+	      allocator, futures.size()
+	  );
+	  for (const auto& f : futures) {
+	    f.state_->onReady([all, remaining]() {
+		if (remaining->fetch_sub(1) == 1) {
+		  all->succeed();
+		}
+	    });
+	  }
+	}
+	return Future<void>(all);
+      }
+
+      template <typename T>
+      Future<void> whenAll(const std::vector< Future<T> >& futures) {
+	return whenAll(std::allocator_arg, std::allocator<char>(), futures);
+      }
+
+      /** @brief A future for the index of the first of @c futures to
+       *         become ready.
+       *
+       *  The combined future never fails, even if the first future to
+       *  become ready does.
+       *
+       *  @throws IllegalValueError if @c futures is empty
+       */
+      template <typename T, typename Allocator>
+      Future<size_t> whenAny(std::allocator_arg_t, const Allocator& allocator,
+			     const std::vector< Future<T> >& futures) {
+	if (futures.empty()) {
+	  throw pistis::exceptions::IllegalValueError(
+	      "whenAny() needs at least one future", PISTIS_EX_HERE
+	  );
+	}
+
+	auto any = std::allocate_shared< FutureState<size_t> >(
+	    allocator, OnExecMode::CLOSE
+	);
+	auto claimed = std::allocate_shared< std::atomic<bool> >(allocator,
+								 false);
+	for (size_t i = 0; i < futures.size(); ++i) {
+	  futures[i].state_->onReady([any, claimed, i]() {
+	      if (!claimed->exchange(true)) {
+		any->succeed(i);
+	      }
+	  });
+	}
+	return Future<size_t>(any);
+      }
+
+      template <typename T>
+      Future<size_t> whenAny(const std::vector< Future<T> >& futures) {
+	return whenAny(std::allocator_arg, std::allocator<char>(), futures);
+      }
+
+    }
+  }
+}
+#endif
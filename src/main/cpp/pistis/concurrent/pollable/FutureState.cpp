@@ -0,0 +1,112 @@
+#include "FutureState.hpp"
+#include <pistis/concurrent/TimeUtils.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  inline int createEventFd(OnExecMode onExec) {
+    int fd = ::eventfd(0, EFD_NONBLOCK |
+		            (onExec == OnExecMode::CLOSE ? EFD_CLOEXEC : 0));
+    if (fd < 0) {
+      throw SystemError::fromSystemCode("Failed to create event fd: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+    return fd;
+  }
+
+  inline void signal(int fd) {
+    // The eventfd is never read, so it stays readable from now on
+    const uint64_t one = 1;
+    if (::write(fd, &one, sizeof(one)) < 0) {
+      throw SystemError::fromSystemCode("Write to eventfd failed: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+  }
+}
+
+FutureStateBase::FutureStateBase(OnExecMode onExec):
+    sync_(), readyCv_(), callbacks_(), error_(), fd_(-1), ready_(false),
+    onExec_(onExec) {
+}
+
+FutureStateBase::~FutureStateBase() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool FutureStateBase::ready() const {
+  Lock lock(sync_);
+  return ready_;
+}
+
+bool FutureStateBase::failed() const {
+  Lock lock(sync_);
+  return ready_ && (bool)error_;
+}
+
+int FutureStateBase::fd() {
+  Lock lock(sync_);
+  if (fd_ < 0) {
+    fd_ = createEventFd(onExec_);
+    if (ready_) {
+      signal(fd_);
+    }
+  }
+  return fd_;
+}
+
+bool FutureStateBase::wait(int64_t timeout) {
+  Lock lock(sync_);
+  if (timeout < 0) {
+    readyCv_.wait(lock, [this]() { return ready_; });
+    return true;
+  } else {
+    return readyCv_.wait_for(lock, toMs(timeout), [this]() { return ready_; });
+  }
+}
+
+void FutureStateBase::onReady(Callback callback) {
+  Lock lock(sync_);
+  if (ready_) {
+    lock.unlock();
+    callback();
+  } else {
+    callbacks_.push_back(std::move(callback));
+  }
+}
+
+void FutureStateBase::fail(std::exception_ptr error) {
+  Lock lock(sync_);
+  checkNotReady_();
+  error_ = error;
+  complete_(lock);
+}
+
+void FutureStateBase::checkNotReady_() const {
+  if (ready_) {
+    throw IllegalStateError("Future is already ready", PISTIS_EX_HERE);
+  }
+}
+
+void FutureStateBase::complete_(Lock& lock) {
+  ready_ = true;
+  if (fd_ >= 0) {
+    signal(fd_);
+  }
+  readyCv_.notify_all();
+
+  std::vector<Callback> callbacks;
+  callbacks.swap(callbacks_);
+  lock.unlock();
+
+  for (auto& callback : callbacks) {
+    callback();
+  }
+}
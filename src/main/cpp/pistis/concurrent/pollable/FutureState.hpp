@@ -0,0 +1,171 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__FUTURESTATE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__FUTURESTATE_HPP__
+
+#include <pistis/concurrent/OnExecMode.hpp>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief The part of a Future's shared state that does not depend
+       *         on its value type.
+       *
+       *  Tracks whether the future is ready, the exception it failed
+       *  with, the continuations waiting for it and its eventfd.  The
+       *  eventfd is only created when someone asks for it, so futures
+       *  that are only waited on or continued with then() cost no file
+       *  descriptors.  Applications use Future and Promise instead of
+       *  this class.
+       */
+      class FutureStateBase {
+      public:
+	typedef std::function<void ()> Callback;
+
+      public:
+	FutureStateBase(OnExecMode onExec);
+	FutureStateBase(const FutureStateBase&) = delete;
+	~FutureStateBase();
+
+	bool ready() const;
+	bool failed() const;
+
+	/** @brief The exception the future failed with, if any.  Only
+	 *         valid once the future is ready.
+	 */
+	const std::exception_ptr& error() const { return error_; }
+
+	/** @brief File descriptor that becomes readable when the future
+	 *         is ready, created on first use
+	 */
+	int fd();
+
+	/** @brief Wait up to @c timeout ms for the future to be ready */
+	bool wait(int64_t timeout);
+
+	/** @brief Call @c callback once the future is ready.
+	 *
+	 *  If the future is already ready, the callback runs immediately
+	 *  on the calling thread.  Otherwise it runs on the thread that
+	 *  makes the future ready.
+	 */
+	void onReady(Callback callback);
+
+	/** @brief Make the future ready with the given exception
+	 *
+	 *  @throws IllegalStateError if the future is already ready
+	 */
+	void fail(std::exception_ptr error);
+
+	FutureStateBase& operator=(const FutureStateBase&) = delete;
+
+      protected:
+	typedef std::unique_lock<std::mutex> Lock;
+
+	mutable std::mutex sync_;
+
+	/** @brief Throw IllegalStateError if the future is already ready.
+	 *         Call with sync_ held before storing a value.
+	 */
+	void checkNotReady_() const;
+
+	/** @brief Mark the future ready, release @c lock on sync_ and run
+	 *         the continuations
+	 */
+	void complete_(Lock& lock);
+
+      private:
+	std::condition_variable readyCv_;
+	std::vector<Callback> callbacks_;
+	std::exception_ptr error_;
+	int fd_;
+	bool ready_;
+	OnExecMode onExec_;
+      };
+
+      /** @brief Storage for a future's value.  Empty for void. */
+      template <typename T>
+      class FutureValue {
+      public:
+	typedef const T& Reference;
+
+      public:
+	FutureValue(): present_(false) { }
+	FutureValue(const FutureValue&) = delete;
+	~FutureValue() {
+	  if (present_) {
+	    ptr_()->~T();
+	  }
+	}
+
+	template <typename... Args>
+	void set(Args&&... args) {
+	  new (&storage_) T(std::forward<Args>(args)...);
+	  present_ = true;
+	}
+
+	Reference get() const { return *ptr_(); }
+
+	FutureValue& operator=(const FutureValue&) = delete;
+
+      private:
+	typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+	bool present_;
+
+	T* ptr_() { return reinterpret_cast<T*>(&storage_); }
+	const T* ptr_() const { return reinterpret_cast<const T*>(&storage_); }
+      };
+
+      template <>
+      class FutureValue<void> {
+      public:
+	typedef void Reference;
+
+      public:
+	void set() { }
+	void get() const { }
+      };
+
+      /** @brief Shared state behind a Future and its Promise */
+      template <typename T>
+      class FutureState : public FutureStateBase {
+      public:
+	typedef typename FutureValue<T>::Reference Reference;
+
+      public:
+	FutureState(OnExecMode onExec): FutureStateBase(onExec), value_() { }
+
+	/** @brief The future's value.  Only valid once the future is
+	 *         ready and has not failed.
+	 */
+	Reference value() const { return value_.get(); }
+
+	/** @brief Make the future ready with a value constructed from
+	 *         @c args
+	 *
+	 *  @throws IllegalStateError if the future is already ready
+	 */
+	template <typename... Args>
+	void succeed(Args&&... args) {
+	  Lock lock(sync_);
+	  checkNotReady_();
+	  value_.set(std::forward<Args>(args)...);
+	  complete_(lock);
+	}
+
+      private:
+	FutureValue<T> value_;
+      };
+
+    }
+  }
+}
+#endif
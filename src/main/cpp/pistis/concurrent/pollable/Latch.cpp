@@ -0,0 +1,46 @@
+#include "Latch.hpp"
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+Latch::Latch(size_t count, OnExecMode onExec): count_(count), open_(onExec) {
+  if (!count) {
+    open_.set();
+  }
+}
+
+void Latch::countDown(size_t n) {
+  size_t current = count_.load(std::memory_order_relaxed);
+  do {
+    if (n > current) {
+      throw IllegalStateError("Latch counted down below zero",
+			      PISTIS_EX_HERE);
+    }
+  } while (!count_.compare_exchange_weak(current, current - n,
+					 std::memory_order_acq_rel,
+					 std::memory_order_relaxed));
+
+  if (n && (current == n)) {
+    open_.set();
+  }
+}
+
+void Latch::reset(size_t count) {
+  if (!count) {
+    throw IllegalValueError("Latch count must be greater than zero",
+			    PISTIS_EX_HERE);
+  }
+
+  if (count_.load(std::memory_order_acquire)) {
+    throw IllegalStateError("Cannot reset a latch that is still closed",
+			    PISTIS_EX_HERE);
+  }
+
+  // Clear the signal before publishing the count, so the countDown()
+  // that reaches zero again cannot race with clear()
+  open_.clear();
+  count_.store(count, std::memory_order_release);
+}
@@ -0,0 +1,70 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__LATCH_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__LATCH_HPP__
+
+#include <pistis/concurrent/pollable/Signal.hpp>
+#include <atomic>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A countdown latch whose file descriptor becomes readable
+       *         when the count reaches zero.
+       *
+       *  countDown() is a single atomic decrement, except for the call
+       *  that reaches zero, which makes the only system call of the
+       *  phase.  Once all waiters have seen the latch open, reset()
+       *  arms it again with a new count and the same file descriptor.
+       */
+      class Latch {
+      public:
+	Latch(size_t count, OnExecMode onExec = OnExecMode::CLOSE);
+	Latch(const Latch&) = delete;
+
+	/** @brief Readable once the count reaches zero */
+	int fd() const { return open_.fd(); }
+
+	/** @brief Current count */
+	size_t count() const { return count_.load(std::memory_order_acquire); }
+
+	/** @brief True if the count has reached zero */
+	bool tryWait() const { return !count(); }
+
+	/** @brief Decrease the count by @c n
+	 *
+	 *  @throws IllegalStateError if @c n is greater than the count
+	 */
+	void countDown(size_t n = 1);
+
+	/** @brief Wait until the count reaches zero or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @returns  True if the count reached zero, false on timeout
+	 */
+	bool wait(int64_t timeout = -1) const { return open_.wait(timeout); }
+
+	/** @brief countDown(), then wait() */
+	bool arriveAndWait(int64_t timeout = -1) {
+	  countDown();
+	  return wait(timeout);
+	}
+
+	/** @brief Close the latch again with a new count.
+	 *
+	 *  @throws IllegalStateError if the count has not reached zero
+	 *  @throws IllegalValueError if @c count is zero
+	 */
+	void reset(size_t count);
+
+	Latch& operator=(const Latch&) = delete;
+
+      private:
+	std::atomic<size_t> count_;
+	Signal open_;
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,54 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__MUTEX_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__MUTEX_HPP__
+
+#include <pistis/concurrent/pollable/SharedMutex.hpp>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A mutex that event loops can wait for with poll(), epoll()
+       *         or select().
+       *
+       *  Mutex is a SharedMutex restricted to exclusive use, so it has
+       *  the same one-CAS uncontended path, the same observe(),
+       *  acquire() and stopObserving() interface and the same choice of
+       *  LockPolicy.  It satisfies the standard Lockable requirements,
+       *  so it works with std::unique_lock and std::lock_guard.
+       */
+      class Mutex {
+      public:
+	Mutex(LockPolicy policy = LockPolicy::BARGING,
+	      OnExecMode onExec = OnExecMode::CLOSE):
+	    lock_(policy, onExec) {
+	}
+	Mutex(const Mutex&) = delete;
+
+	LockPolicy policy() const { return lock_.policy(); }
+	bool locked() const { return lock_.lockedExclusive(); }
+	size_t numWaiters() const { return lock_.numWaiters(); }
+
+	void lock() { lock_.lock(); }
+	bool lock(int64_t timeout) { return lock_.lock(timeout); }
+	bool tryLock() { return lock_.tryLock(); }
+	bool try_lock() { return lock_.tryLock(); }
+	void unlock() { lock_.unlock(); }
+
+	/** @brief Wait for the mutex through a file descriptor.
+	 *
+	 *  See SharedMutex for the observer protocol.
+	 */
+	int observe() { return lock_.observe(); }
+	bool acquire(int fd) { return lock_.acquire(fd); }
+	void stopObserving(int fd) { lock_.stopObserving(fd); }
+
+	Mutex& operator=(const Mutex&) = delete;
+
+      private:
+	SharedMutex lock_;
+      };
+
+    }
+  }
+}
+#endif
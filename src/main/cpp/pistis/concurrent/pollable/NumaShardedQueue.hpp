@@ -0,0 +1,80 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__NUMASHARDEDQUEUE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__NUMASHARDEDQUEUE_HPP__
+
+#include <pistis/concurrent/pollable/ShardedQueue.hpp>
+#include <pistis/concurrent/NumaTopology.hpp>
+#include <pistis/concurrent/PoolAllocator.hpp>
+#include <memory>
+#include <vector>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief ShardSelector that picks the shard for the calling
+       *         thread's current NUMA node
+       */
+      class NumaShardSelector {
+      public:
+	NumaShardSelector(const NumaTopology& topology):
+	    topology_(std::make_shared<NumaTopology>(topology)) {
+	}
+
+	const NumaTopology& topology() const { return *topology_; }
+
+	size_t operator()(size_t numShards) const {
+	  return topology_->currentNode() % numShards;
+	}
+
+      private:
+	std::shared_ptr<const NumaTopology> topology_;
+      };
+
+      /** @brief A ShardedQueue with one shard per NUMA node.
+       *
+       *  Each shard's items live in blocks placed on its node.  put()
+       *  adds items to the shard for the caller's node, and get() takes
+       *  items from the caller's node before taking them from other
+       *  nodes, so producers and consumers on the same node exchange
+       *  items without touching remote memory while they keep up with
+       *  each other.
+       *
+       *  With a simulated topology, threads choose their node with
+       *  NumaTopology::bindCurrentThread(), and the shards' blocks come
+       *  from the default policy.
+       */
+      template <typename Item>
+      class NumaShardedQueue
+	  : public ShardedQueue<Item, PoolAllocator<Item>, NumaShardSelector> {
+      public:
+	typedef ShardedQueue<Item, PoolAllocator<Item>, NumaShardSelector>
+	    BaseType;
+
+      public:
+	NumaShardedQueue(
+	    const NumaTopology& topology = NumaTopology::system(),
+	    size_t lowWaterMark = BaseType::MAX_QUEUE_SIZE,
+	    size_t highWaterMark = BaseType::MAX_QUEUE_SIZE
+	):
+	    BaseType(nodeAllocators_(topology), lowWaterMark, highWaterMark,
+		     NumaShardSelector(topology)) {
+	}
+
+      private:
+	static std::vector< PoolAllocator<Item> > nodeAllocators_(
+	    const NumaTopology& topology
+	) {
+	  std::vector< PoolAllocator<Item> > allocators;
+	  for (size_t i = 0; i < topology.numNodes(); ++i) {
+	    allocators.push_back(
+		PoolAllocator<Item>::onNumaNode(topology.kernelNode(i))
+	    );
+	  }
+	  return allocators;
+	}
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,354 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__PRIORITYQUEUE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__PRIORITYQUEUE_HPP__
+
+#include <pistis/concurrent/pollable/QueueMonitor.hpp>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief How a PriorityQueue orders items of equal priority */
+      enum class PriorityOrder {
+	/** @brief Items of equal priority come out in no particular order */
+	ANY,
+
+	/** @brief Items of equal priority come out in the order they
+	 *         were put into the queue
+	 */
+	FIFO
+      };
+
+      /** @brief A pollable queue that returns its highest-priority item
+       *         first.
+       *
+       *  PriorityQueue has the same interface as Queue -- water marks,
+       *  timeouts, observe()/ack()/stopObserving(), queueStateFd() and
+       *  Guard -- except that get() returns the item with the highest
+       *  priority instead of the oldest one.  As with
+       *  std::priority_queue, an item @c a has lower priority than an
+       *  item @c b when Compare()(a, b) is true.
+       *
+       *  Items are stored in a 4-ary heap laid out in a single vector.
+       *  Compared to a binary heap, the 4-ary heap is half as deep and
+       *  keeps all children of a node on the same cache line or two, so
+       *  put() is faster and get() touches fewer cache lines.
+       */
+      template <typename Item, typename Compare = std::less<Item>,
+		typename Allocator = std::allocator<Item> >
+      class PriorityQueue {
+      public:
+	typedef Item ItemType;
+	typedef Compare CompareType;
+	typedef Allocator AllocatorType;
+	typedef QueueGuard<PriorityQueue> Guard;
+
+	static const size_t MAX_QUEUE_SIZE = (size_t)-1;
+	static const size_t HEAP_ARITY = 4;
+
+      private:
+	typedef QueueMonitor::Lock Lock_;
+
+	struct Entry_ {
+	  Item item;
+	  uint64_t seq;
+
+	  Entry_(Item&& i, uint64_t s): item(std::move(i)), seq(s) { }
+	};
+
+	typedef typename std::allocator_traits<Allocator>::template
+	    rebind_alloc<Entry_> EntryAllocator_;
+	typedef std::vector<Entry_, EntryAllocator_> Heap_;
+
+      public:
+	PriorityQueue(PriorityOrder order = PriorityOrder::ANY,
+		      const Compare& compare = Compare(),
+		      const Allocator& allocator = Allocator()):
+	    PriorityQueue(MAX_QUEUE_SIZE, order, compare, allocator) {
+	}
+
+	PriorityQueue(size_t maxSize, PriorityOrder order = PriorityOrder::ANY,
+		      const Compare& compare = Compare(),
+		      const Allocator& allocator = Allocator()):
+	    PriorityQueue(maxSize, maxSize, maxSize, order, compare,
+			  allocator) {
+	}
+
+	PriorityQueue(size_t maxSize, size_t lowWaterMark,
+		      size_t highWaterMark,
+		      PriorityOrder order = PriorityOrder::ANY,
+		      const Compare& compare = Compare(),
+		      const Allocator& allocator = Allocator()):
+	    monitor_(maxSize, lowWaterMark, highWaterMark),
+	    heap_(EntryAllocator_(allocator)), compare_(compare),
+	    order_(order), nextSeq_(0), sync_(this, "PriorityQueue") {
+	}
+
+	PriorityQueue(const PriorityQueue&) = delete;
+
+	PriorityQueue(PriorityQueue&& other):
+	    monitor_(std::move(other.monitor_)), heap_(std::move(other.heap_)),
+	    compare_(std::move(other.compare_)), order_(other.order_),
+	    nextSeq_(other.nextSeq_), sync_(this, "PriorityQueue") {
+	  other.heap_.clear();
+	  monitor_.reset(heap_.size());
+	}
+
+	bool empty() const { return !size(); }
+
+	size_t size() const {
+	  Lock_ lock(sync_);
+	  return heap_.size();
+	}
+	size_t maxSize() const { return monitor_.maxSize(); }
+
+	size_t lowWaterMark() const {
+	  Lock_ lock(sync_);
+	  return monitor_.lowWaterMark();
+	}
+
+	size_t highWaterMark() const {
+	  Lock_ lock(sync_);
+	  return monitor_.highWaterMark();
+	}
+
+	PriorityOrder order() const { return order_; }
+	Compare compare() const { return compare_; }
+	Allocator allocator() const { return Allocator(heap_.get_allocator()); }
+
+	bool aboveHighWaterMark() const {
+	  Lock_ lock(sync_);
+	  return heap_.size() > monitor_.highWaterMark();
+	}
+
+	bool atOrBelowLowWaterMark() const {
+	  Lock_ lock(sync_);
+	  return heap_.size() <= monitor_.lowWaterMark();
+	}
+
+	void setLowWaterMark(size_t value) {
+	  Lock_ lock(sync_);
+	  monitor_.setLowWaterMark(value);
+	}
+
+	void setHighWaterMark(size_t value) {
+	  Lock_ lock(sync_);
+	  monitor_.setHighWaterMark(value);
+	}
+
+	Item get() {
+	  Lock_ lock(sync_);
+	  monitor_.waitForItems(-1, lock, currentSize_());
+	  Item item(popTop_());
+	  monitor_.update(heap_.size() + 1, heap_.size());
+	  return item;
+	}
+
+	bool get(Item& result, int64_t timeout = 0) {
+	  if (timeout < 0) {
+	    result = get();
+	    return true;
+	  } else {
+	    Lock_ lock(sync_);
+	    if (!monitor_.waitForItems(timeout, lock, currentSize_())) {
+	      return false;
+	    }
+	    result = popTop_();
+	    monitor_.update(heap_.size() + 1, heap_.size());
+	    return true;
+	  }
+	}
+
+	/** @brief Remove all items from the queue and return them in
+	 *         priority order, highest priority first.
+	 */
+	std::vector<Item, Allocator> getAll() {
+	  std::vector<Item, Allocator> result(allocator());
+	  drainInto(result);
+	  return result;
+	}
+
+	/** @brief Move up to @c maxItems items from the queue onto the end
+	 *         of @c buffer in priority order, highest priority first.
+	 */
+	template <typename Container>
+	size_t drainInto(Container& buffer, size_t maxItems = MAX_QUEUE_SIZE) {
+	  Lock_ lock(sync_);
+	  const size_t oldSize = heap_.size();
+	  const size_t n = std::min(oldSize, maxItems);
+	  for (size_t i = 0; i < n; ++i) {
+	    buffer.push_back(popTop_());
+	  }
+	  monitor_.update(oldSize, heap_.size());
+	  return n;
+	}
+
+	bool put(const Item& item, int64_t timeout = -1) {
+	  return executePut_(timeout, Item(item));
+	}
+
+	bool put(Item&& item, int64_t timeout = -1) {
+	  return executePut_(timeout, std::move(item));
+	}
+
+	/** @brief Call @c callback once, the next time the queue shrinks,
+	 *         unless there is room for another item.
+	 *
+	 *  See Queue::whenRoomFor().
+	 *
+	 *  @returns  True, without registering @c callback, if there is room
+	 */
+	bool whenRoomFor(const Item&, std::function<void ()> callback) {
+	  Lock_ lock(sync_);
+	  if (monitor_.fits(heap_.size(), 1)) {
+	    return true;
+	  }
+	  monitor_.whenRoomMade(std::move(callback));
+	  return false;
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+	  this->put(Item(std::forward<Args>(args)...));
+	}
+
+	template <typename... Args>
+	void tryEmplace(int64_t timeout, Args&&... args) {
+	  this->put(Item(std::forward<Args>(args)...), timeout);
+	}
+
+	void clear() {
+	  Lock_ lock(sync_);
+	  size_t oldSize = heap_.size();
+	  heap_.clear();
+	  monitor_.update(oldSize, 0);
+	}
+
+	bool wait(int64_t timeout, QueueEventType eventType) {
+	  Lock_ lock(sync_);
+	  return monitor_.wait(timeout, eventType, lock, currentSize_());
+	}
+
+	int observe(QueueEventType eventType) {
+	  return monitor_.observe(eventType);
+	}
+
+	void ack(int fd, QueueEventType eventType) {
+	  monitor_.ack(fd, eventType);
+	}
+
+	void stopObserving(int fd, QueueEventType eventType) {
+	  monitor_.stopObserving(fd, eventType);
+	}
+
+	int queueStateFd() { return monitor_.stateFd(); }
+
+	PriorityQueue& operator=(const PriorityQueue&) = delete;
+	PriorityQueue& operator=(PriorityQueue&& other) {
+	  if (this != &other) {
+	    monitor_ = std::move(other.monitor_);
+	    heap_ = std::move(other.heap_);
+	    other.heap_.clear();
+	    compare_ = std::move(other.compare_);
+	    order_ = other.order_;
+	    nextSeq_ = other.nextSeq_;
+	    monitor_.reset(heap_.size());
+	  }
+	  return *this;
+	}
+
+      private:
+	QueueMonitor monitor_;
+	Heap_ heap_;
+	Compare compare_;
+	PriorityOrder order_;
+	uint64_t nextSeq_;
+	mutable ProfiledMutex sync_;
+
+	auto currentSize_() const {
+	  return [this]() { return heap_.size(); };
+	}
+
+	bool executePut_(int64_t timeout, Item&& item) {
+	  Lock_ lock(sync_);
+	  if (!monitor_.waitForRoom(timeout, lock, currentSize_())) {
+	    return false;
+	  }
+
+	  heap_.emplace_back(std::move(item), nextSeq_++);
+	  siftUp_(heap_.size() - 1);
+	  monitor_.update(heap_.size() - 1, heap_.size());
+	  return true;
+	}
+
+	/** @brief True if @c a should come out of the queue before @c b */
+	bool before_(const Entry_& a, const Entry_& b) const {
+	  if (compare_(b.item, a.item)) {
+	    return true;
+	  } else if ((order_ == PriorityOrder::ANY) ||
+		     compare_(a.item, b.item)) {
+	    return false;
+	  } else {
+	    return a.seq < b.seq;
+	  }
+	}
+
+	Item popTop_() {
+	  Item top(std::move(heap_.front().item));
+	  if (heap_.size() > 1) {
+	    heap_.front() = std::move(heap_.back());
+	    heap_.pop_back();
+	    siftDown_(0);
+	  } else {
+	    heap_.pop_back();
+	  }
+	  return top;
+	}
+
+	void siftUp_(size_t i) {
+	  Entry_ entry(std::move(heap_[i]));
+	  while (i) {
+	    const size_t parent = (i - 1) / HEAP_ARITY;
+	    if (!before_(entry, heap_[parent])) {
+	      break;
+	    }
+	    heap_[i] = std::move(heap_[parent]);
+	    i = parent;
+	  }
+	  heap_[i] = std::move(entry);
+	}
+
+	void siftDown_(size_t i) {
+	  const size_t n = heap_.size();
+	  Entry_ entry(std::move(heap_[i]));
+	  while (true) {
+	    const size_t first = i * HEAP_ARITY + 1;
+	    if (first >= n) {
+	      break;
+	    }
+
+	    const size_t last = std::min(first + HEAP_ARITY, n);
+	    size_t best = first;
+	    for (size_t c = first + 1; c < last; ++c) {
+	      if (before_(heap_[c], heap_[best])) {
+		best = c;
+	      }
+	    }
+	    if (!before_(heap_[best], entry)) {
+	      break;
+	    }
+	    heap_[i] = std::move(heap_[best]);
+	    i = best;
+	  }
+	  heap_[i] = std::move(entry);
+	}
+      };
+
+    }
+  }
+}
+#endif
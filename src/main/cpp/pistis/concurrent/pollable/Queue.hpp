@@ -1,99 +1,77 @@
 #ifndef __PISTIS__CONCURRENT__POLLABLE__QUEUE_HPP__
 #define __PISTIS__CONCURRENT__POLLABLE__QUEUE_HPP__
 
-#include <pistis/concurrent/pollable/Condition.hpp>
-#include <pistis/concurrent/pollable/ReadWriteToggle.hpp>
-#include <pistis/concurrent/TimeUtils.hpp>
-#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/concurrent/pollable/QueueMonitor.hpp>
+#include <pistis/concurrent/pollable/QueueStatistics.hpp>
+#include <pistis/concurrent/Trace.hpp>
+#include <algorithm>
+#include <chrono>
 #include <deque>
+#include <functional>
 #include <memory>
 
 namespace pistis {
   namespace concurrent {
     namespace pollable {
-      
-      /** @brief Events one can wait for or observe */
-      enum class QueueEventType {
-	/** @brief Queue goes from being not empty to empty */
-	EMPTY,
-
-	/** @brief Queue goes from being empty to not empty */
-	NOT_EMPTY,
-
-	/** @brief Queue goes from being not full to being full */
-	FULL,
 
-	/** @brief Queue goes from being full to being not full */
-	NOT_FULL,
-	
-	/** @brief Queue crosses the high water mark from below
-	 *
-	 *  Specifically, this event occurs when the queue size goes from
-	 *  being less than or equal to the high water mark to being
-	 *  greater than it.
-	 */
-	HIGH_WATER_MARK,
-
-	/** @brief Queue crosses the low water mark from above
-	 *
-	 *  Specifically, this event occurs when the queue size goes from
-	 *  being greater than the low water mark to being equal to or
-	 *  less than it.
-	 */
-	LOW_WATER_MARK,
+      /** @brief Item cost for queues whose limits count items.
+       *
+       *  This is Queue's default ItemCost.  Every item costs one unit, so
+       *  the maximum size and water marks are item counts.
+       */
+      struct UnitItemCost {
+	template <typename Item>
+	size_t operator()(const Item&) const { return 1; }
       };
 
-      template <typename Item, typename Allocator = std::allocator<Item> >
+      /** @brief A pollable FIFO queue.
+       *
+       *  The Statistics parameter selects what the queue records about
+       *  its own activity.  The default, NoQueueStatistics, records
+       *  nothing and costs nothing; QueueStatistics records rates, an
+       *  occupancy histogram, blocking and lock wait times and water
+       *  mark crossings, available through statistics().
+       *
+       *  The ItemCost parameter is a function object that returns the
+       *  cost of an item, typically its size in bytes.  The queue keeps
+       *  the total cost of its items in totalCost(), and the maximum
+       *  size, the water marks, the FULL/NOT_FULL/HIGH_WATER_MARK/
+       *  LOW_WATER_MARK events and queueStateFd() are all driven by that
+       *  total rather than by the number of items.  A put() blocks until
+       *  the item's cost fits under the maximum size.  An item that costs
+       *  more than the maximum size is admitted only when the queue is
+       *  empty, so that it cannot block the queue forever.  Every item must
+       *  cost at least one unit, and an item's cost must not change while
+       *  it is in the queue.  The default,
+       *  UnitItemCost, makes every limit an item count.
+       *
+       *  The BlockingMode passed to the constructor applies to
+       *  queueStateFd() and the descriptors returned by observe().
+       *  tryGet(), tryPut() and tryAck() never wait for an item, for room
+       *  or for a notification, so an event loop can call them after
+       *  polling the queue without risk of stalling.  tryGet() and
+       *  tryPut() still wait for the queue's lock, which is only held
+       *  briefly, so false always means the queue was empty or full and
+       *  an edge-triggered caller cannot lose a wakeup to a lock race.
+       *  With BlockingMode::DONT_BLOCK, tryAck() does not wait in the
+       *  kernel either.
+       */
+      template <typename Item, typename Allocator = std::allocator<Item>,
+		typename Statistics = NoQueueStatistics,
+		typename ItemCost = UnitItemCost>
       class Queue {
       public:
 	typedef Item ItemType;
 	typedef Allocator AllocatorType;
+	typedef Statistics StatisticsType;
+	typedef ItemCost ItemCostType;
+	typedef std::deque<Item, Allocator> ContainerType;
+	typedef QueueGuard<Queue> Guard;
       
 	static const size_t MAX_QUEUE_SIZE = (size_t)-1;
 
-	class Guard {
-	public:
-	  Guard(Queue& queue, QueueEventType eventType):
-	      q_(&queue), t_(eventType), fd_(q_->observe(eventType)) {
-	  }
-	  Guard(const Guard&) = delete;
-	  Guard(Guard&& other):
-	      q_(other.q_), t_(other.t_), fd_(other.fd_) {
-	    other.q_ = nullptr;
-	    fd_ = -1;
-	  }
-	  ~Guard() { stop(); }
-
-	  bool active() const { return (bool)q_; }
-	  int fd() const { return fd_; }
-	  void ack() { q_->ack(fd_, t_); }
-	  void stop() {
-	    if (active()) {
-	      q_->stopObserving(fd_, t_);
-	      q_ = nullptr;
-	      fd_ = -1;
-	    }
-	  }
-
-	  Guard& operator=(const Guard&) = delete;
-	  Guard& operator=(Guard&& other) {
-	    if (q_ != other.q_) {
-	      q_ = other.q_;
-	      other.q_ = nullptr;
-	      fd_ = other.fd_;
-	      other.fd_ = -1;
-	    }
-	    return *this;
-	  }
-
-	private:
-	  Queue* q_;
-	  QueueEventType t_;
-	  int fd_;
-	};
-
       private:
-	typedef std::unique_lock<std::mutex> Lock_;
+	typedef QueueMonitor::Lock Lock_;
 
       public:
 	Queue(const Allocator& allocator = Allocator()):
@@ -104,33 +82,33 @@ namespace pistis {
 	}
 
 	Queue(size_t maxSize, size_t lowWaterMark, size_t highWaterMark,
+	      const Allocator& allocator = Allocator(),
+	      const ItemCost& itemCost = ItemCost()):
+	    Queue(BlockingMode::BLOCK, maxSize, lowWaterMark, highWaterMark,
+		  allocator, itemCost) {
+	}
+
+	Queue(BlockingMode blocking, size_t maxSize = MAX_QUEUE_SIZE,
 	      const Allocator& allocator = Allocator()):
-	    maxSize_(maxSize), lowWaterMark_(lowWaterMark),
-	    highWaterMark_(highWaterMark), q_(allocator),
-	    highWaterCrossed_(false) {
-	  if (highWaterMark > maxSize) {
-	    throw pistis::exceptions::IllegalValueError(
-		"Illegal value for high water mark (> max queue size)",
-		PISTIS_EX_HERE
-	    );
-	  }
-	  if (lowWaterMark > highWaterMark) {
-	    throw pistis::exceptions::IllegalValueError(
-		"Illegal value for low water mark (> high water mark)",
-		PISTIS_EX_HERE
-	    );
-	  }
-	  queueState_.setState(ReadWriteToggle::WRITE_ONLY);
+	    Queue(blocking, maxSize, maxSize, maxSize, allocator) {
+	}
+
+	Queue(BlockingMode blocking, size_t maxSize, size_t lowWaterMark,
+	      size_t highWaterMark, const Allocator& allocator = Allocator(),
+	      const ItemCost& itemCost = ItemCost()):
+	    monitor_(maxSize, lowWaterMark, highWaterMark, blocking),
+	    q_(allocator), itemCost_(itemCost), totalCost_(0),
+	    sync_(this, "Queue") {
 	}
       
 	Queue(const Queue&) = delete;
 
 	Queue(Queue&& other):
-	    maxSize_(other.maxSize_), lowWaterMark_(other.lowWaterMark_),
-	    highWaterMark_(other.highWaterMark_), q_(std::move(other.q_)),
-	    highWaterCrossed_(other.highWaterCrossed_) {
-	  other.highWaterCrossed_ = false;
-	  other.queueState_.setState(ReadWriteToggle::WRITE_ONLY);
+	    monitor_(std::move(other.monitor_)), q_(std::move(other.q_)),
+	    itemCost_(std::move(other.itemCost_)),
+	    totalCost_(other.totalCost_), sync_(this, "Queue") {
+	  other.totalCost_ = 0;
+	  monitor_.reset(totalCost_);
 	}
 
 	bool empty() const { return !size(); }
@@ -139,67 +117,69 @@ namespace pistis {
 	  Lock_ lock(sync_);
 	  return q_.size();
 	}
-	size_t maxSize() const { return maxSize_; }
+
+	/** @brief Total cost of the items in the queue.  Equal to size()
+	 *         unless the queue has an ItemCost other than UnitItemCost.
+	 */
+	size_t totalCost() const {
+	  Lock_ lock(sync_);
+	  return totalCost_;
+	}
+
+	size_t maxSize() const { return monitor_.maxSize(); }
+	BlockingMode blockingMode() const { return monitor_.blockingMode(); }
 	
 	size_t lowWaterMark() const {
 	  Lock_ lock(sync_);
-	  return lowWaterMark_;
+	  return monitor_.lowWaterMark();
 	}
       
 	size_t highWaterMark() const {
 	  Lock_ lock(sync_);
-	  return highWaterMark_;
+	  return monitor_.highWaterMark();
 	}
       
 	Allocator allocator() const { return q_.get_allocator(); }
+	ItemCost itemCost() const { return itemCost_; }
       
 	bool aboveHighWaterMark() const {
 	  Lock_ lock(sync_);
-	  return q_.size() > highWaterMark_;
+	  return totalCost_ > monitor_.highWaterMark();
 	}
 	
 	bool atOrBelowLowWaterMark() const {
 	  Lock_ lock(sync_);
-	  return q_.size() <= lowWaterMark_;
+	  return totalCost_ <= monitor_.lowWaterMark();
+	}
+
+	/** @brief True from the time the queue crosses its high water mark
+	 *         until it next crosses its low water mark.
+	 *
+	 *  Producers that apply backpressure stop while this is true and
+	 *  wait for the LOW_WATER_MARK event.
+	 */
+	bool highWaterMarkCrossed() const {
+	  Lock_ lock(sync_);
+	  return monitor_.highWaterCrossed();
 	}
 
 	void setLowWaterMark(size_t value) {
 	  Lock_ lock(sync_);
-	  if (value > highWaterMark_) {
-	    throw pistis::exceptions::IllegalValueError(
-	        "Illegal value for low water mark (> high water mark)",
-		PISTIS_EX_HERE
-	    );
-	  }
-	  lowWaterMark_ = value;
+	  monitor_.setLowWaterMark(value);
 	}
 
 	void setHighWaterMark(size_t value) {
 	  Lock_ lock(sync_);
-	  if (value > maxSize_) {
-	    throw pistis::exceptions::IllegalValueError(
-	        "Illegal value for high water mark (> max queue size)",
-		PISTIS_EX_HERE
-	    );
-	  }
-	  if (value < lowWaterMark_) {
-	    throw pistis::exceptions::IllegalValueError(
-		"Illegal value for high water mark (< low water mark)",
-		PISTIS_EX_HERE
-	    );
-	  }
-	  highWaterMark_ = value;
+	  monitor_.setHighWaterMark(value);
 	}
 
 	Item get() {
 	  Lock_ lock(sync_);
-	  while (q_.empty()) {
-	    waitUntilNotEmpty_(-1, lock);
-	  }
-	  Item item(q_.front());
+	  waitForItems_(-1, lock);
+	  Item item(std::move(q_.front()));
 	  q_.pop_front();
-	  issueNotifications_(q_.size() + 1, q_.size());
-	  return std::move(item);
+	  removed_(1, itemCost_(item));
+	  return item;
 	}
       
 	bool get(Item& result, int64_t timeout = 0) {
@@ -208,42 +188,126 @@ namespace pistis {
 	    return true;
 	  } else {
 	    Lock_ lock(sync_);
-	    auto now = std::chrono::system_clock::now();
-	    auto deadline = now + toMs(timeout);
-
-	    while (q_.empty() && (now < deadline)) {
-	      waitUntilNotEmpty_(toMs(deadline - now), lock);
-	      now = std::chrono::system_clock::now();
-	    }
-
-	    if (q_.empty()) {
+	    if (!waitForItems_(timeout, lock)) {
 	      return false;
-	    } else {
-	      result = q_.front();
-	      q_.pop_front();
-	      issueNotifications_(q_.size() + 1, q_.size());
-	      return true;
 	    }
+	    result = std::move(q_.front());
+	    q_.pop_front();
+	    removed_(1, itemCost_(result));
+	    return true;
+	  }
+	}
+
+	/** @brief Remove the item at the front of the queue, if there is
+	 *         one, without waiting.
+	 *
+	 *  @returns  True if an item was moved into @c result, or false if
+	 *            the queue is empty
+	 */
+	bool tryGet(Item& result) {
+	  Lock_ lock(sync_);
+	  if (q_.empty()) {
+	    return false;
 	  }
+	  result = std::move(q_.front());
+	  q_.pop_front();
+	  removed_(1, itemCost_(result));
+	  return true;
 	}
 
-	std::deque<Item, Allocator> getAll() {
+	ContainerType getAll() {
 	  Lock_ lock(sync_);
-	  std::deque<Item> result(std::move(q_));
-	  issueNotifications_(result.size(), 0);
-	  return std::move(result);
+	  ContainerType result(q_.get_allocator());
+	  result.swap(q_);
+	  removed_(result.size(), totalCost_);
+	  return result;
+	}
+
+	/** @brief Swap the queue's items into @c buffer in O(1), leaving
+	 *         the queue with @c buffer's storage.
+	 *
+	 *  Items already in @c buffer are discarded.  The allocator of
+	 *  @c buffer must compare equal to the queue's allocator.
+	 */
+	size_t swapOut(ContainerType& buffer) {
+	  Lock_ lock(sync_);
+	  buffer.clear();
+	  buffer.swap(q_);
+	  removed_(buffer.size(), totalCost_);
+	  return buffer.size();
+	}
+
+	/** @brief Move up to @c maxItems items from the queue onto the end
+	 *         of @c buffer, which may be any container with push_back().
+	 */
+	template <typename Container>
+	size_t drainInto(Container& buffer, size_t maxItems = MAX_QUEUE_SIZE) {
+	  Lock_ lock(sync_);
+	  const size_t n = std::min(q_.size(), maxItems);
+	  const auto end = q_.begin() + n;
+	  size_t cost = 0;
+	  for (auto i = q_.begin(); i != end; ++i) {
+	    cost += itemCost_(*i);
+	    buffer.push_back(std::move(*i));
+	  }
+	  q_.erase(q_.begin(), end);
+	  removed_(n, cost);
+	  return n;
 	}
 
 	bool put(const Item& item, int64_t timeout = -1) {
-	  return executePut_(timeout, [&]() { q_.push_back(item); });
+	  return executePut_(timeout, itemCost_(item),
+			     [&]() { q_.push_back(item); });
 	}
       
 	bool put(Item&& item, int64_t timeout = -1) {
-	  return executePut_(timeout, [&]() {
+	  return executePut_(timeout, itemCost_(item), [&]() {
 	      q_.push_back(std::move(item));
 	  });
 	}
 
+	/** @brief Put @c item on the queue if it fits, without waiting.
+	 *
+	 *  @returns  True if the item was added, or false if it does not
+	 *            fit
+	 */
+	bool tryPut(const Item& item) {
+	  return executeTryPut_(itemCost_(item),
+				[&]() { q_.push_back(item); });
+	}
+
+	/** @brief Move @c item onto the queue if it fits, without waiting.
+	 *  @c item is left untouched if it is not added.
+	 *
+	 *  @returns  True if the item was added, or false if it does not
+	 *            fit
+	 */
+	bool tryPut(Item&& item) {
+	  return executeTryPut_(itemCost_(item), [&]() {
+	      q_.push_back(std::move(item));
+	  });
+	}
+
+	/** @brief Call @c callback once, the next time the queue shrinks,
+	 *         unless @c item already fits.
+	 *
+	 *  Lets asynchronous code wait for room for an item without
+	 *  polling queueStateFd(), which stays writable while any room is
+	 *  left.  The callback runs with the queue's lock held, so it must
+	 *  not call back into the queue.
+	 *
+	 *  @returns  True, without registering @c callback, if @c item fits
+	 */
+	bool whenRoomFor(const Item& item, std::function<void ()> callback) {
+	  const size_t cost = itemCost_(item);
+	  Lock_ lock(sync_);
+	  if (monitor_.fits(totalCost_, cost)) {
+	    return true;
+	  }
+	  monitor_.whenRoomMade(std::move(callback));
+	  return false;
+	}
+
 	template <typename... Args>
 	void emplace(Args&&... args) {
 	  this->put(Item(std::forward<Args>(args)...));
@@ -256,231 +320,164 @@ namespace pistis {
 
 	void clear() {
 	  Lock_ lock(sync_);
-	  size_t oldSize = q_.size();
+	  const size_t oldCost = totalCost_;
 	  q_.clear();
-	  issueNotifications_(oldSize, 0);
+	  totalCost_ = 0;
+	  update_(oldCost, 0);
 	}
 
 	bool wait(int64_t timeout, QueueEventType eventType) {
 	  Lock_ lock(sync_);
-	  switch(eventType) {
-	    case QueueEventType::EMPTY:
-	      return waitUntilEmpty_(timeout, lock);
-	    
-	    case QueueEventType::NOT_EMPTY:
-	      return waitUntilNotEmpty_(timeout, lock);
-	    
-	    case QueueEventType::FULL:
-	      return waitUntilFull_(timeout, lock);
-	    
-	    case QueueEventType::NOT_FULL:
-	      return waitUntilNotFull_(timeout, lock);
-	    
-	    case QueueEventType::HIGH_WATER_MARK:
-	      return waitUntilHighWaterMark_(timeout, lock);
-	    
-	    case QueueEventType::LOW_WATER_MARK:
-	      return waitUntilLowWaterMark_(timeout, lock);
-	    
-	    default:
-	      throw pistis::exceptions::IllegalValueError(
-		  "Illegal value for \"eventType\"", PISTIS_EX_HERE
-	      );
-	  }
+	  return monitor_.wait(timeout, eventType, lock, currentCost_());
 	}
       
 	int observe(QueueEventType eventType) {
-	  return selectCv_(eventType).observe();
+	  return monitor_.observe(eventType);
 	}
 
 	void ack(int fd, QueueEventType eventType) {
-	  selectCv_(eventType).ack(fd);
+	  monitor_.ack(fd, eventType);
+	}
+
+	/** @brief Reset @c fd if it has been notified of @c eventType.
+	 *
+	 *  @returns  False, without waiting, if it has not
+	 */
+	bool tryAck(int fd, QueueEventType eventType) {
+	  return monitor_.tryAck(fd, eventType);
 	}
 
 	void stopObserving(int fd, QueueEventType eventType) {
-	  selectCv_(eventType).stopObserving(fd);
+	  monitor_.stopObserving(fd, eventType);
+	}
+
+	int queueStateFd() { return monitor_.stateFd(); }
+
+	typename Statistics::Snapshot statistics() const {
+	  return stats_.snapshot();
 	}
 
-	int queueStateFd() { return queueState_.fd(); }
+	void resetStatistics() { stats_.reset(); }
       
 	Queue& operator=(const Queue&) = delete;
 	Queue& operator=(Queue&& other) {
 	  if (this != &other) {
-	    maxSize_ = other.maxSize_;
-	    lowWaterMark_ = other.lowWaterMark_;
-	    highWaterMark_ = other.highWaterMark_;
-	    highWaterCrossed_ = other.highWaterCrossed_;
-	    other.highWaterCrossed_ = false;
-	    
+	    monitor_ = std::move(other.monitor_);
 	    q_ = std::move(other.q_);
-
-	    other.queueState_.setState(ReadWriteToggle::WRITE_ONLY);
-	    if (!q_.size()) {
-	      queueState_.setState(ReadWriteToggle::WRITE_ONLY);
-	    } else if (q_.size() < maxSize_) {
-	      queueState_.setState(ReadWriteToggle::READ_WRITE);
-	    } else {
-	      queueState_.setState(ReadWriteToggle::READ_ONLY);
-	    }
+	    itemCost_ = std::move(other.itemCost_);
+	    totalCost_ = other.totalCost_;
+	    other.totalCost_ = 0;
+	    monitor_.reset(totalCost_);
 	  }
 	  return *this;
 	}
 
       private:
-	size_t maxSize_;
-	size_t lowWaterMark_;
-	size_t highWaterMark_;
-	std::deque<Item, Allocator> q_;
-	mutable std::mutex sync_;
-	Condition emptyCv_;
-	Condition notEmptyCv_;
-	Condition fullCv_;
-	Condition notFullCv_;
-	Condition lowWaterMarkCv_;
-	Condition highWaterMarkCv_;
-	ReadWriteToggle queueState_;
-	bool highWaterCrossed_;
-
-	template <typename PutItemFunction>
-	bool executePut_(int64_t timeout, PutItemFunction putItem) {
-	  Lock_ lock(sync_);
-	  if (timeout < 0) {
-	    while (q_.size() >= maxSize_) {
-	      waitUntilNotFull_(-1, lock);
-	    }
-	  } else {
-	    auto now = std::chrono::system_clock::now();
-	    auto deadline = now + toMs(timeout);
+	QueueMonitor monitor_;
+	ContainerType q_;
+	ItemCost itemCost_;
+	size_t totalCost_;
+	mutable ProfiledMutex sync_;
+	mutable Statistics stats_;
 
-	    while ((q_.size() >= maxSize_) && (now < deadline)) {
-	      waitUntilNotFull_(toMs(deadline - now), lock);
-	      now = std::chrono::system_clock::now();
-	    }
-
-	    if (q_.size() >= maxSize_) {
-	      return false;
-	    }
-	  }
-
-	  // At this point, this thread owns the lock and q_.size() < maxSize_
-	  putItem();
-	  issueNotifications_(q_.size() - 1, q_.size());
-	  return true;
+	auto currentCost_() const {
+	  return [this]() { return totalCost_; };
 	}
 
-	bool waitUntilEmpty_(int64_t timeout, Lock_& lock) {
-	  return waitForInvariant_(timeout, lock, emptyCv_,
-				   [=]() { return q_.empty(); });
-	}
-      
-	bool waitUntilNotEmpty_(int64_t timeout, Lock_& lock) {
-	  return waitForInvariant_(timeout, lock, notEmptyCv_,
-				   [=]() { return !q_.empty(); });
+	static uint64_t nsSince_(std::chrono::steady_clock::time_point start) {
+	  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	      std::chrono::steady_clock::now() - start
+	  ).count();
 	}
 
-	bool waitUntilFull_(int64_t timeout, Lock_& lock) {
-	  return waitForInvariant_(timeout, lock, fullCv_,
-				   [=]() { return q_.size() >= maxSize_; });
-	}
-      
-	bool waitUntilNotFull_(int64_t timeout, Lock_& lock) {
-	  return waitForInvariant_(timeout, lock, notFullCv_,
-				   [=]() { return q_.size() < maxSize_; });
+	bool waitForItems_(int64_t timeout, Lock_& lock) {
+	  Trace::WaitScope trace(q_.empty() ? this : nullptr);
+	  if (!Statistics::ENABLED || !q_.empty()) {
+	    return monitor_.waitForItems(timeout, lock, currentCost_());
+	  }
+	  auto start = std::chrono::steady_clock::now();
+	  bool result = monitor_.waitForItems(timeout, lock, currentCost_());
+	  stats_.recordConsumerBlocked(nsSince_(start));
+	  return result;
 	}
-      
-	bool waitUntilLowWaterMark_(int64_t timeout, Lock_& lock) {
-	  auto start = std::chrono::system_clock::now();
 
-	  if (!waitForInvariant_(timeout, lock, highWaterMarkCv_,
-				 [=]() { return highWaterCrossed_; })) {
-	    return false;
+	bool waitForRoom_(int64_t timeout, Lock_& lock, size_t cost) {
+	  Trace::WaitScope trace(monitor_.fits(totalCost_, cost) ? nullptr
+							       : this);
+	  if (!Statistics::ENABLED || monitor_.fits(totalCost_, cost)) {
+	    return monitor_.waitForRoom(timeout, lock, currentCost_(), cost);
 	  }
-
-	  auto now = std::chrono::system_clock::now();
-	  int64_t timeLeft = std::max((int64_t)0, toMs(now - start));
-
-	  return waitForInvariant_(timeLeft, lock, lowWaterMarkCv_,
-				   [=]() {
-	      return (q_.size() <= lowWaterMark_);
-	  });
+	  auto start = std::chrono::steady_clock::now();
+	  bool result = monitor_.waitForRoom(timeout, lock, currentCost_(),
+					     cost);
+	  stats_.recordProducerBlocked(nsSince_(start));
+	  return result;
 	}
 
-	bool waitUntilHighWaterMark_(int64_t timeout, Lock_& lock) {
-	  auto start = std::chrono::system_clock::now();
-
-	  if (!waitForInvariant_(timeout, lock, lowWaterMarkCv_,
-				 [=]() { return !highWaterCrossed_; })) {
+	template <typename PutItemFunction>
+	bool executePut_(int64_t timeout, size_t cost,
+			 PutItemFunction putItem) {
+	  Lock_ lock(sync_);
+	  if (!waitForRoom_(timeout, lock, cost)) {
 	    return false;
 	  }
 
-	  auto now = std::chrono::system_clock::now();
-	  int64_t timeLeft = std::max((int64_t)0, toMs(now - start));
-	  
-	  return waitForInvariant_(timeout, lock, highWaterMarkCv_,
-				   [=]() {
-	      return (q_.size() > highWaterMark_);
-	  });
+	  // At this point, this thread owns the lock and the item fits
+	  putItem();
+	  totalCost_ += cost;
+	  Trace::record(TraceEventType::PUT, this, totalCost_);
+	  update_(totalCost_ - cost, totalCost_);
+	  stats_.recordPuts(1, totalCost_);
+	  return true;
 	}
 
-	template <typename Invariant>
-	static bool waitForInvariant_(int64_t timeout, Lock_& lock,
-				      Condition& condition,
-				      Invariant invariant) {
-	  bool haveTime = true;
-	  while (!invariant() && haveTime) {
-	    lock.unlock();
-	    haveTime = condition.wait(timeout);
-	    lock.lock();
-	  }
-	  return invariant();
-	}
-
-	Condition& selectCv_(QueueEventType eventType) {
-	  switch(eventType) {
-	    case QueueEventType::EMPTY: return emptyCv_;
-	    case QueueEventType::NOT_EMPTY: return notEmptyCv_;
-	    case QueueEventType::FULL: return fullCv_;
-	    case QueueEventType::NOT_FULL: return notFullCv_;
-	    case QueueEventType::HIGH_WATER_MARK: return highWaterMarkCv_;
-	    case QueueEventType::LOW_WATER_MARK: return lowWaterMarkCv_;
-	    default:
-	      throw pistis::exceptions::IllegalValueError(
-		  "Illegal value for \"eventType\"", PISTIS_EX_HERE
-	      );
+	template <typename PutItemFunction>
+	bool executeTryPut_(size_t cost, PutItemFunction putItem) {
+	  Lock_ lock(sync_);
+	  if (!monitor_.fits(totalCost_, cost)) {
+	    return false;
 	  }
+	  putItem();
+	  totalCost_ += cost;
+	  Trace::record(TraceEventType::PUT, this, totalCost_);
+	  update_(totalCost_ - cost, totalCost_);
+	  stats_.recordPuts(1, totalCost_);
+	  return true;
 	}
-      
-	void issueNotifications_(size_t oldSize, size_t newSize) {
-	  if (!oldSize && newSize) {
-	    notEmptyCv_.notifyAll();
-	    queueState_.setState(ReadWriteToggle::READ_WRITE);
-	  }
-	  if (oldSize && !newSize) {
-	    emptyCv_.notifyAll();
-	    queueState_.setState(ReadWriteToggle::WRITE_ONLY);
-	  }
-	  if ((oldSize >= maxSize_) && (newSize < maxSize_)) {
-	    notFullCv_.notifyAll();
-	    queueState_.setState(ReadWriteToggle::READ_WRITE);
-	  }
-	  if ((oldSize < maxSize_) && (newSize >= maxSize_)) {
-	    fullCv_.notifyAll();
-	    queueState_.setState(ReadWriteToggle::READ_ONLY);
-	  }
-	  if ((oldSize <= highWaterMark_) && (newSize > highWaterMark_) &&
-	      !highWaterCrossed_) {
-	    highWaterMarkCv_.notifyAll();
-	    highWaterCrossed_ = true;
-	  }
-	  if ((oldSize > lowWaterMark_) && (newSize <= lowWaterMark_) &&
-	      highWaterCrossed_) {
-	    lowWaterMarkCv_.notifyAll();
-	    highWaterCrossed_ = false;
+
+	/** @brief Account for the removal of @c n items that cost a total
+	 *         of @c cost.
+	 */
+	void removed_(size_t n, size_t cost) {
+	  totalCost_ -= cost;
+	  Trace::record(TraceEventType::GET, this, totalCost_);
+	  update_(totalCost_ + cost, totalCost_);
+	  stats_.recordGets(n, totalCost_);
+	}
+
+	void update_(size_t oldCost, size_t newCost) {
+	  const bool wasCrossed = monitor_.highWaterCrossed();
+	  monitor_.update(oldCost, newCost);
+	  if (monitor_.highWaterCrossed() != wasCrossed) {
+	    if (wasCrossed) {
+	      stats_.recordLowWaterMark();
+	      Trace::record(TraceEventType::LOW_WATER_MARK, this, newCost);
+	    } else {
+	      stats_.recordHighWaterMark();
+	      Trace::record(TraceEventType::HIGH_WATER_MARK, this, newCost);
+	    }
 	  }
 	}
-
       };
 
+      /** @brief A Queue whose capacity and water marks are measured in
+       *         the units returned by ItemCost, typically bytes.
+       */
+      template <typename Item, typename ItemCost,
+		typename Allocator = std::allocator<Item> >
+      using ByteBoundedQueue = Queue<Item, Allocator, NoQueueStatistics,
+				     ItemCost>;
+
     }
   }
 }
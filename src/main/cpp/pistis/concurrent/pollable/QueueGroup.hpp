@@ -0,0 +1,293 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__QUEUEGROUP_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__QUEUEGROUP_HPP__
+
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/exceptions/ItemExistsError.hpp>
+#include <pistis/exceptions/NoSuchItem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief Consumes items from many Queues through a single epoll
+       *         wait, sharing the consumer fairly between them.
+       *
+       *  Each member queue's state file descriptor is registered with
+       *  an EpollSet owned by the group.  get() and getBatch() serve the
+       *  queues that have items using deficit round-robin: on each round,
+       *  every nonempty queue may hand out up to its weight times the
+       *  group's quantum items before the consumer moves on to the next
+       *  queue.  Queues that become nonempty during a round join at the
+       *  next one.
+       *
+       *  A QueueGroup is meant to be used by a single consumer thread and
+       *  is not itself thread-safe, though its member queues may be
+       *  shared with other producers and consumers.  Queues must be
+       *  removed from the group before they are destroyed.  The group's
+       *  own fd() is an epoll file descriptor that is readable whenever
+       *  any member queue has items, so a group can itself be monitored
+       *  by an enclosing EpollSet.
+       */
+      template <typename Item, typename Allocator = std::allocator<Item> >
+      class QueueGroup {
+      public:
+	typedef Queue<Item, Allocator> QueueType;
+
+      public:
+	QueueGroup(uint32_t quantum = 1,
+		   OnExecMode onExec = OnExecMode::CLOSE):
+	    quantum_(checkQuantum_(quantum)), members_(), ready_(),
+	    epollSet_(onExec) {
+	}
+	QueueGroup(const QueueGroup&) = delete;
+	QueueGroup(QueueGroup&&) = default;
+
+	int fd() const { return epollSet_.fd(); }
+	size_t numQueues() const { return members_.size(); }
+	uint32_t quantum() const { return quantum_; }
+
+	bool contains(QueueType& queue) const {
+	  return members_.count(queue.queueStateFd()) > 0;
+	}
+
+	uint32_t weight(QueueType& queue) const {
+	  return lookup_(queue.queueStateFd())->second.weight;
+	}
+
+	/** @brief Add a queue to the group.
+	 *
+	 *  @param queue   The queue to add
+	 *  @param weight  Relative share of the consumer this queue gets
+	 *                 when other queues also have items.  Must be
+	 *                 greater than zero.
+	 *  @throws pistis::exceptions::ItemExistsError if the queue is
+	 *          already a member of this group
+	 */
+	void add(QueueType& queue, uint32_t weight = 1) {
+	  const int fd = queue.queueStateFd();
+	  checkWeight_(weight);
+	  epollSet_.add(fd, EpollEventType::READ);
+	  members_.insert(std::make_pair(fd, Member_(&queue, weight)));
+	}
+
+	void setWeight(QueueType& queue, uint32_t weight) {
+	  checkWeight_(weight);
+	  lookup_(queue.queueStateFd())->second.weight = weight;
+	}
+
+	/** @brief Remove a queue from the group
+	 *
+	 *  @throws pistis::exceptions::NoSuchItem if the queue is not a
+	 *          member of this group
+	 */
+	void remove(QueueType& queue) {
+	  auto i = lookup_(queue.queueStateFd());
+	  epollSet_.remove(i->first);
+	  if (i->second.scheduled) {
+	    ready_.erase(std::remove(ready_.begin(), ready_.end(), i->first),
+			 ready_.end());
+	  }
+	  members_.erase(i);
+	}
+
+	/** @brief Remove the next item from the group's queues.
+	 *
+	 *  @param result   Receives the item
+	 *  @param timeout  Maximum time to wait for an item in ms, or -1
+	 *                  to wait forever.  Zero returns at once.
+	 *  @returns  True if an item was retrieved, false if the timeout
+	 *            expired or the group has no queues.
+	 */
+	bool get(Item& result, int64_t timeout = 0) {
+	  return executeGet_(timeout, [this, &result]() {
+	      while (!ready_.empty()) {
+		Member_& m = members_.find(ready_.front())->second;
+		if (!m.deficit) {
+		  m.deficit = (uint64_t)m.weight * quantum_;
+		}
+		if (!m.queue->get(result, 0)) {
+		  finishTurn_(false);
+		} else {
+		  if (!--m.deficit) {
+		    finishTurn_(true);
+		  }
+		  return (size_t)1;
+		}
+	      }
+	      return (size_t)0;
+	  });
+	}
+
+	/** @brief Pull items from every queue that is ready in one pass
+	 *         of the round, appending them to @c buffer.
+	 *
+	 *  Each queue contributes at most its remaining deficit (its
+	 *  weight times the quantum for a fresh turn), so a batch keeps
+	 *  the same proportions as a sequence of calls to get().
+	 *
+	 *  @param buffer    Receives the items; any container with
+	 *                   push_back()
+	 *  @param maxItems  Maximum number of items to retrieve
+	 *  @param timeout   Maximum time to wait for the first item, as
+	 *                   for get()
+	 *  @returns  The number of items appended to @c buffer
+	 */
+	template <typename Container>
+	size_t getBatch(Container& buffer, size_t maxItems,
+			int64_t timeout = 0) {
+	  return executeGet_(timeout, [this, &buffer, maxItems]() {
+	      size_t total = 0;
+	      size_t turns = ready_.size();
+	      while (turns-- && (total < maxItems)) {
+		Member_& m = members_.find(ready_.front())->second;
+		if (!m.deficit) {
+		  m.deficit = (uint64_t)m.weight * quantum_;
+		}
+		const size_t wanted = std::min((size_t)m.deficit,
+					       maxItems - total);
+		const size_t n = m.queue->drainInto(buffer, wanted);
+		total += n;
+		m.deficit -= n;
+		if (n < wanted) {
+		  finishTurn_(false);
+		} else if (!m.deficit) {
+		  finishTurn_(true);
+		}
+	      }
+	      return total;
+	  });
+	}
+
+	QueueGroup& operator=(const QueueGroup&) = delete;
+	QueueGroup& operator=(QueueGroup&&) = default;
+
+      private:
+	struct Member_ {
+	  QueueType* queue;
+	  uint32_t weight;
+	  uint64_t deficit;
+	  bool scheduled;
+
+	  Member_(QueueType* q, uint32_t w):
+	      queue(q), weight(w), deficit(0), scheduled(false) {
+	  }
+	};
+
+	typedef std::unordered_map<int, Member_> MemberMap_;
+
+	uint32_t quantum_;
+	MemberMap_ members_;
+	std::deque<int> ready_;  ///< State fds of queues in the round
+	EpollSet epollSet_;
+
+	template <typename Take>
+	size_t executeGet_(int64_t timeout, Take take) {
+	  if (members_.empty()) {
+	    return 0;
+	  }
+
+	  auto now = std::chrono::system_clock::now();
+	  auto deadline = now + toMs(timeout);
+	  while (true) {
+	    if (ready_.empty()) {
+	      startRound_(0);
+	    }
+	    const size_t n = take();
+	    if (n) {
+	      return n;
+	    } else if ((timeout >= 0) && (now >= deadline)) {
+	      return 0;
+	    } else if (!startRound_(timeout < 0 ? -1 : toMs(deadline - now))) {
+	      return 0;
+	    }
+	    now = std::chrono::system_clock::now();
+	  }
+	}
+
+	/** @brief Schedule every queue with items for the next round
+	 *
+	 *  @returns  True if any queue has items
+	 */
+	bool startRound_(int64_t timeout) {
+	  if (!epollSet_.wait(timeout)) {
+	    return false;
+	  }
+	  for (const EpollEvent& event : epollSet_.events()) {
+	    auto i = members_.find(event.fd());
+	    if ((i != members_.end()) && !i->second.scheduled) {
+	      i->second.scheduled = true;
+	      ready_.push_back(event.fd());
+	    }
+	  }
+	  return true;
+	}
+
+	/** @brief End the turn of the queue at the head of the round.
+	 *
+	 *  A queue whose deficit ran out may still have items, so it goes
+	 *  to the back of the round.  A queue that ran dry forfeits its
+	 *  remaining deficit and leaves the round.
+	 */
+	void finishTurn_(bool mayHaveMore) {
+	  const int fd = ready_.front();
+	  Member_& m = members_.find(fd)->second;
+	  ready_.pop_front();
+	  if (mayHaveMore) {
+	    ready_.push_back(fd);
+	  } else {
+	    m.deficit = 0;
+	    m.scheduled = false;
+	  }
+	}
+
+	typename MemberMap_::iterator lookup_(int fd) {
+	  auto i = members_.find(fd);
+	  if (i == members_.end()) {
+	    throw pistis::exceptions::NoSuchItem(
+		"queue", "pistis::concurrent::pollable::QueueGroup",
+		PISTIS_EX_HERE
+	    );
+	  }
+	  return i;
+	}
+
+	typename MemberMap_::const_iterator lookup_(int fd) const {
+	  auto i = members_.find(fd);
+	  if (i == members_.end()) {
+	    throw pistis::exceptions::NoSuchItem(
+		"queue", "pistis::concurrent::pollable::QueueGroup",
+		PISTIS_EX_HERE
+	    );
+	  }
+	  return i;
+	}
+
+	static uint32_t checkQuantum_(uint32_t quantum) {
+	  if (!quantum) {
+	    throw pistis::exceptions::IllegalValueError(
+		"Illegal value for quantum (must be > 0)", PISTIS_EX_HERE
+	    );
+	  }
+	  return quantum;
+	}
+
+	static void checkWeight_(uint32_t weight) {
+	  if (!weight) {
+	    throw pistis::exceptions::IllegalValueError(
+		"Illegal value for weight (must be > 0)", PISTIS_EX_HERE
+	    );
+	  }
+	}
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,150 @@
+#include "QueueMonitor.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+QueueMonitor::QueueMonitor(size_t maxSize, size_t lowWaterMark,
+			   size_t highWaterMark, BlockingMode blocking):
+    maxSize_(maxSize), lowWaterMark_(lowWaterMark),
+    highWaterMark_(highWaterMark), blocking_(blocking), emptyCv_(blocking),
+    notEmptyCv_(blocking), fullCv_(blocking), notFullCv_(blocking),
+    lowWaterMarkCv_(blocking), highWaterMarkCv_(blocking), roomCv_(),
+    roomWaiters_(0), roomCallbacks_(false),
+    state_(OnExecMode::CLOSE, blocking, ReadWriteToggle::WRITE_ONLY),
+    highWaterCrossed_(false) {
+  if (highWaterMark > maxSize) {
+    throw IllegalValueError(
+	"Illegal value for high water mark (> max queue size)",
+	PISTIS_EX_HERE
+    );
+  }
+  if (lowWaterMark > highWaterMark) {
+    throw IllegalValueError(
+	"Illegal value for low water mark (> high water mark)",
+	PISTIS_EX_HERE
+    );
+  }
+}
+
+QueueMonitor::QueueMonitor(QueueMonitor&& other):
+    maxSize_(other.maxSize_), lowWaterMark_(other.lowWaterMark_),
+    highWaterMark_(other.highWaterMark_), blocking_(other.blocking_),
+    emptyCv_(blocking_), notEmptyCv_(blocking_), fullCv_(blocking_),
+    notFullCv_(blocking_), lowWaterMarkCv_(blocking_),
+    highWaterMarkCv_(blocking_), roomCv_(), roomWaiters_(0),
+    roomCallbacks_(false),
+    state_(OnExecMode::CLOSE, blocking_, ReadWriteToggle::WRITE_ONLY),
+    highWaterCrossed_(other.highWaterCrossed_) {
+  other.highWaterCrossed_ = false;
+  other.state_.setState(ReadWriteToggle::WRITE_ONLY);
+}
+
+void QueueMonitor::setLowWaterMark(size_t value) {
+  if (value > highWaterMark_) {
+    throw IllegalValueError(
+	"Illegal value for low water mark (> high water mark)",
+	PISTIS_EX_HERE
+    );
+  }
+  lowWaterMark_ = value;
+}
+
+void QueueMonitor::setHighWaterMark(size_t value) {
+  if (value > maxSize_) {
+    throw IllegalValueError(
+        "Illegal value for high water mark (> max queue size)",
+	PISTIS_EX_HERE
+    );
+  }
+  if (value < lowWaterMark_) {
+    throw IllegalValueError(
+	"Illegal value for high water mark (< low water mark)",
+	PISTIS_EX_HERE
+    );
+  }
+  highWaterMark_ = value;
+}
+
+void QueueMonitor::update(size_t oldSize, size_t newSize) {
+  if (!oldSize && newSize) {
+    notEmptyCv_.notifyAll();
+  }
+  if (oldSize && !newSize) {
+    emptyCv_.notifyAll();
+  }
+  if ((oldSize >= maxSize_) && (newSize < maxSize_)) {
+    notFullCv_.notifyAll();
+  }
+  if ((oldSize < maxSize_) && (newSize >= maxSize_)) {
+    fullCv_.notifyAll();
+  }
+  if ((newSize < oldSize) && (roomWaiters_ || roomCallbacks_)) {
+    roomCallbacks_ = false;
+    roomCv_.notifyAll();
+  }
+  if ((oldSize <= highWaterMark_) && (newSize > highWaterMark_) &&
+      !highWaterCrossed_) {
+    highWaterMarkCv_.notifyAll();
+    highWaterCrossed_ = true;
+  }
+  if ((oldSize > lowWaterMark_) && (newSize <= lowWaterMark_) &&
+      highWaterCrossed_) {
+    lowWaterMarkCv_.notifyAll();
+    highWaterCrossed_ = false;
+  }
+  state_.setState(stateForSize_(newSize));
+}
+
+QueueMonitor& QueueMonitor::operator=(QueueMonitor&& other) {
+  if (this != &other) {
+    maxSize_ = other.maxSize_;
+    lowWaterMark_ = other.lowWaterMark_;
+    highWaterMark_ = other.highWaterMark_;
+    highWaterCrossed_ = other.highWaterCrossed_;
+    other.highWaterCrossed_ = false;
+    other.state_.setState(ReadWriteToggle::WRITE_ONLY);
+
+    // Adopt other's BlockingMode, as the move constructor does
+    if (blocking_ != other.blocking_) {
+      blocking_ = other.blocking_;
+      for (Condition* cv : { &emptyCv_, &notEmptyCv_, &fullCv_,
+			     &notFullCv_, &lowWaterMarkCv_,
+			     &highWaterMarkCv_ }) {
+	cv->setBlockingMode(blocking_);
+      }
+      state_ = ReadWriteToggle(OnExecMode::CLOSE, blocking_,
+			       ReadWriteToggle::WRITE_ONLY);
+    }
+  }
+  return *this;
+}
+
+Condition& QueueMonitor::selectCv_(QueueEventType eventType) {
+  switch(eventType) {
+    case QueueEventType::EMPTY: return emptyCv_;
+    case QueueEventType::NOT_EMPTY: return notEmptyCv_;
+    case QueueEventType::FULL: return fullCv_;
+    case QueueEventType::NOT_FULL: return notFullCv_;
+    case QueueEventType::HIGH_WATER_MARK: return highWaterMarkCv_;
+    case QueueEventType::LOW_WATER_MARK: return lowWaterMarkCv_;
+    default:
+      throwIllegalEventType_();
+      return emptyCv_;  // Never reached
+  }
+}
+
+ReadWriteToggle::State QueueMonitor::stateForSize_(size_t size) const {
+  if (!size) {
+    return ReadWriteToggle::WRITE_ONLY;
+  } else if (size < maxSize_) {
+    return ReadWriteToggle::READ_WRITE;
+  } else {
+    return ReadWriteToggle::READ_ONLY;
+  }
+}
+
+void QueueMonitor::throwIllegalEventType_() {
+  throw IllegalValueError("Illegal value for \"eventType\"", PISTIS_EX_HERE);
+}
@@ -0,0 +1,375 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__QUEUEMONITOR_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__QUEUEMONITOR_HPP__
+
+#include <pistis/concurrent/pollable/Condition.hpp>
+#include <pistis/concurrent/pollable/ReadWriteToggle.hpp>
+#include <pistis/concurrent/ProfiledMutex.hpp>
+#include <pistis/concurrent/TimeUtils.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+      
+      /** @brief Events one can wait for or observe */
+      enum class QueueEventType {
+	/** @brief Queue goes from being not empty to empty */
+	EMPTY,
+
+	/** @brief Queue goes from being empty to not empty */
+	NOT_EMPTY,
+
+	/** @brief Queue goes from being not full to being full */
+	FULL,
+
+	/** @brief Queue goes from being full to being not full */
+	NOT_FULL,
+	
+	/** @brief Queue crosses the high water mark from below
+	 *
+	 *  Specifically, this event occurs when the queue size goes from
+	 *  being less than or equal to the high water mark to being
+	 *  greater than it.
+	 */
+	HIGH_WATER_MARK,
+
+	/** @brief Queue crosses the low water mark from above
+	 *
+	 *  Specifically, this event occurs when the queue size goes from
+	 *  being greater than the low water mark to being equal to or
+	 *  less than it.
+	 */
+	LOW_WATER_MARK,
+      };
+
+      /** @brief Tracks the size limits of a pollable queue and issues
+       *         the notifications for each QueueEventType.
+       *
+       *  QueueMonitor holds the Condition for each QueueEventType, the
+       *  ReadWriteToggle behind the queue's state file descriptor and
+       *  the low and high water marks.  It does not hold the queue's
+       *  items or its mutex.  The queue calls update() with its old and
+       *  new sizes whenever its size changes, and calls wait() with
+       *  its lock held to block until an event occurs.  Everything
+       *  except observe(), ack() and stopObserving() must be called
+       *  with the queue's mutex held.
+       */
+      class QueueMonitor {
+      public:
+	typedef std::unique_lock<ProfiledMutex> Lock;
+
+      public:
+	/** @brief Create a monitor whose state and observer file
+	 *         descriptors use the given BlockingMode
+	 */
+	QueueMonitor(size_t maxSize, size_t lowWaterMark,
+		     size_t highWaterMark,
+		     BlockingMode blocking = BlockingMode::BLOCK);
+	QueueMonitor(const QueueMonitor&) = delete;
+
+	/** @brief Take the size limits and water mark state from
+	 *         @c other, which is reset to an empty queue's state.
+	 *
+	 *  The new monitor's state file descriptor is WRITE_ONLY; the
+	 *  queue should call reset() with its size after moving its items.
+	 */
+	QueueMonitor(QueueMonitor&& other);
+
+	size_t maxSize() const { return maxSize_; }
+	size_t lowWaterMark() const { return lowWaterMark_; }
+	size_t highWaterMark() const { return highWaterMark_; }
+	int stateFd() const { return state_.fd(); }
+	BlockingMode blockingMode() const { return blocking_; }
+
+	/** @brief True if the queue has crossed the high water mark and
+	 *         not yet fallen back to the low water mark
+	 */
+	bool highWaterCrossed() const { return highWaterCrossed_; }
+
+	void setLowWaterMark(size_t value);
+	void setHighWaterMark(size_t value);
+
+	int observe(QueueEventType eventType) {
+	  return selectCv_(eventType).observe();
+	}
+
+	void ack(int fd, QueueEventType eventType) {
+	  selectCv_(eventType).ack(fd);
+	}
+
+	bool tryAck(int fd, QueueEventType eventType) {
+	  return selectCv_(eventType).tryAck(fd);
+	}
+
+	void stopObserving(int fd, QueueEventType eventType) {
+	  selectCv_(eventType).stopObserving(fd);
+	}
+
+	/** @brief Issue the notifications for a change in queue size
+	 *         from @c oldSize to @c newSize.
+	 */
+	void update(size_t oldSize, size_t newSize);
+
+	/** @brief Set the state file descriptor to match a queue of
+	 *         the given size without issuing notifications.
+	 */
+	void reset(size_t size) { state_.setState(stateForSize_(size)); }
+
+	/** @brief Wait until the given event occurs or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @param timeout    Timeout in milliseconds, or -1 to wait forever
+	 *  @param eventType  Event to wait for
+	 *  @param lock       Lock on the queue's mutex, which must be held
+	 *  @param size       Function returning the queue's current size
+	 *  @returns  True if the event occurred, false on timeout
+	 */
+	template <typename SizeFunction>
+	bool wait(int64_t timeout, QueueEventType eventType, Lock& lock,
+		  SizeFunction size) {
+	  switch(eventType) {
+	    case QueueEventType::EMPTY:
+	      return waitForInvariant_(timeout, lock, emptyCv_,
+				       [&]() { return !size(); });
+	    
+	    case QueueEventType::NOT_EMPTY:
+	      return waitForInvariant_(timeout, lock, notEmptyCv_,
+				       [&]() { return (bool)size(); });
+	    
+	    case QueueEventType::FULL:
+	      return waitForInvariant_(timeout, lock, fullCv_,
+				       [&]() { return size() >= maxSize_; });
+	    
+	    case QueueEventType::NOT_FULL:
+	      return waitForInvariant_(timeout, lock, notFullCv_,
+				       [&]() { return size() < maxSize_; });
+	    
+	    case QueueEventType::HIGH_WATER_MARK:
+	      return waitForWaterMark_(
+		  timeout, lock, lowWaterMarkCv_,
+		  [this]() { return !highWaterCrossed_; },
+		  highWaterMarkCv_,
+		  [&]() { return size() > highWaterMark_; }
+	      );
+	    
+	    case QueueEventType::LOW_WATER_MARK:
+	      return waitForWaterMark_(
+		  timeout, lock, highWaterMarkCv_,
+		  [this]() { return highWaterCrossed_; },
+		  lowWaterMarkCv_,
+		  [&]() { return size() <= lowWaterMark_; }
+	      );
+	    
+	    default:
+	      throwIllegalEventType_();
+	      return false;
+	  }
+	}
+
+	/** @brief True if @c n more units fit in a queue of the given size
+	 *
+	 *  See waitForRoom() for when units fit.
+	 */
+	bool fits(size_t size, size_t n) const {
+	  return !size || ((size <= maxSize_) && (n <= maxSize_ - size));
+	}
+
+	/** @brief Wait until @c n more units fit in a queue of the given
+	 *         size or the timeout expires.
+	 *
+	 *  The units fit if the new size would not exceed maxSize(), or if
+	 *  the queue is empty, so that an item larger than the queue can
+	 *  still pass through it alone.
+	 *
+	 *  @returns  True if the units fit, false on timeout
+	 */
+	template <typename SizeFunction>
+	bool waitForRoom(int64_t timeout, Lock& lock, SizeFunction size,
+			 size_t n = 1) {
+	  auto hasRoom = [&]() { return fits(size(), n); };
+	  if (hasRoom()) {
+	    return true;
+	  }
+
+	  ++roomWaiters_;
+	  bool result;
+	  if (timeout < 0) {
+	    while (!hasRoom()) {
+	      roomCv_.wait(lock, -1);
+	    }
+	    result = true;
+	  } else {
+	    auto now = std::chrono::system_clock::now();
+	    auto deadline = now + toMs(timeout);
+
+	    while (!hasRoom() && (now < deadline)) {
+	      roomCv_.wait(lock, toMs(deadline - now));
+	      now = std::chrono::system_clock::now();
+	    }
+	    result = hasRoom();
+	  }
+	  --roomWaiters_;
+	  return result;
+	}
+
+	/** @brief Call @c callback once, the next time the queue shrinks.
+	 *
+	 *  Lets asynchronous code wait for room without blocking.  The
+	 *  callback runs with the queue's mutex held, so it must not call
+	 *  back into the queue.
+	 */
+	void whenRoomMade(std::function<void ()> callback) {
+	  roomCallbacks_ = true;
+	  roomCv_.whenNotified(std::move(callback));
+	}
+
+	/** @brief Wait until a queue of the given size is not empty or
+	 *         the timeout expires.
+	 *
+	 *  @returns  True if the queue is not empty, false on timeout
+	 */
+	template <typename SizeFunction>
+	bool waitForItems(int64_t timeout, Lock& lock, SizeFunction size) {
+	  auto notEmpty = [&]() { return (bool)size(); };
+	  if (timeout < 0) {
+	    while (!notEmpty()) {
+	      waitForInvariant_(-1, lock, notEmptyCv_, notEmpty);
+	    }
+	    return true;
+	  } else {
+	    auto now = std::chrono::system_clock::now();
+	    auto deadline = now + toMs(timeout);
+
+	    while (!notEmpty() && (now < deadline)) {
+	      waitForInvariant_(toMs(deadline - now), lock, notEmptyCv_,
+				notEmpty);
+	      now = std::chrono::system_clock::now();
+	    }
+	    return notEmpty();
+	  }
+	}
+
+	QueueMonitor& operator=(const QueueMonitor&) = delete;
+
+	/** @brief Take the size limits, BlockingMode and water mark
+	 *         state from @c other, which is reset to an empty queue's
+	 *         state.
+	 *
+	 *  If the BlockingMode changes, stateFd() changes and only
+	 *  observers created afterwards use the new mode.  The queue
+	 *  should call reset() with its new size afterwards.
+	 */
+	QueueMonitor& operator=(QueueMonitor&& other);
+
+      private:
+	size_t maxSize_;
+	size_t lowWaterMark_;
+	size_t highWaterMark_;
+	BlockingMode blocking_;
+	Condition emptyCv_;
+	Condition notEmptyCv_;
+	Condition fullCv_;
+	Condition notFullCv_;
+	Condition lowWaterMarkCv_;
+	Condition highWaterMarkCv_;
+	Condition roomCv_;          ///< Signaled when items are removed
+	size_t roomWaiters_;        ///< Number of threads waiting on roomCv_
+	bool roomCallbacks_;        ///< True if roomCv_ has callbacks
+	ReadWriteToggle state_;
+	bool highWaterCrossed_;
+
+
+	template <typename Invariant>
+	static bool waitForInvariant_(int64_t timeout, Lock& lock,
+				      Condition& condition,
+				      Invariant invariant) {
+	  bool haveTime = true;
+	  while (!invariant() && haveTime) {
+	    haveTime = condition.wait(lock, timeout);
+	  }
+	  return invariant();
+	}
+
+	template <typename Armed, typename Crossed>
+	static bool waitForWaterMark_(int64_t timeout, Lock& lock,
+				      Condition& armCondition, Armed armed,
+				      Condition& crossCondition,
+				      Crossed crossed) {
+	  auto start = std::chrono::system_clock::now();
+
+	  if (!waitForInvariant_(timeout, lock, armCondition, armed)) {
+	    return false;
+	  }
+
+	  int64_t timeLeft = -1;
+	  if (timeout >= 0) {
+	    int64_t elapsed = toMs(std::chrono::system_clock::now() - start);
+	    timeLeft = std::max((int64_t)0, timeout - elapsed);
+	  }
+	  return waitForInvariant_(timeLeft, lock, crossCondition, crossed);
+	}
+
+	Condition& selectCv_(QueueEventType eventType);
+	ReadWriteToggle::State stateForSize_(size_t size) const;
+	static void throwIllegalEventType_();
+      };
+
+      /** @brief Observes one event on a pollable queue and stops
+       *         observing it when the guard goes out of scope.
+       *
+       *  Works with any queue that provides observe(), ack() and
+       *  stopObserving() taking a QueueEventType.
+       */
+      template <typename QueueType>
+      class QueueGuard {
+      public:
+	QueueGuard(QueueType& queue, QueueEventType eventType):
+	    q_(&queue), t_(eventType), fd_(q_->observe(eventType)) {
+	}
+	QueueGuard(const QueueGuard&) = delete;
+	QueueGuard(QueueGuard&& other):
+	    q_(other.q_), t_(other.t_), fd_(other.fd_) {
+	  other.q_ = nullptr;
+	  other.fd_ = -1;
+	}
+	~QueueGuard() { stop(); }
+
+	bool active() const { return (bool)q_; }
+	int fd() const { return fd_; }
+	void ack() { q_->ack(fd_, t_); }
+	bool tryAck() { return q_->tryAck(fd_, t_); }
+	void stop() {
+	  if (active()) {
+	    q_->stopObserving(fd_, t_);
+	    q_ = nullptr;
+	    fd_ = -1;
+	  }
+	}
+
+	QueueGuard& operator=(const QueueGuard&) = delete;
+	QueueGuard& operator=(QueueGuard&& other) {
+	  if (this != &other) {
+	    stop();
+	    q_ = other.q_;
+	    t_ = other.t_;
+	    fd_ = other.fd_;
+	    other.q_ = nullptr;
+	    other.fd_ = -1;
+	  }
+	  return *this;
+	}
+
+      private:
+	QueueType* q_;
+	QueueEventType t_;
+	int fd_;
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,38 @@
+#include "QueueStatistics.hpp"
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  inline int64_t nowInNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	std::chrono::steady_clock::now().time_since_epoch()
+    ).count();
+  }
+}
+
+const bool NoQueueStatistics::ENABLED;
+const bool QueueStatistics::ENABLED;
+const uint32_t QueueStatistics::HISTOGRAM_PRECISION;
+
+QueueStatistics::Snapshot QueueStatistics::snapshot() const {
+  const double elapsed =
+      (nowInNs() - startTime_.load(std::memory_order_relaxed)) / 1e9;
+  return Snapshot(puts_.load(std::memory_order_relaxed),
+		  gets_.load(std::memory_order_relaxed), elapsed,
+		  highWaterMarks_.load(std::memory_order_relaxed),
+		  lowWaterMarks_.load(std::memory_order_relaxed),
+		  occupancy_.snapshot(), producerBlocked_.snapshot(),
+		  consumerBlocked_.snapshot());
+}
+
+void QueueStatistics::reset() {
+  puts_.store(0, std::memory_order_relaxed);
+  gets_.store(0, std::memory_order_relaxed);
+  highWaterMarks_.store(0, std::memory_order_relaxed);
+  lowWaterMarks_.store(0, std::memory_order_relaxed);
+  startTime_.store(nowInNs(), std::memory_order_relaxed);
+  occupancy_.reset();
+  producerBlocked_.reset();
+  consumerBlocked_.reset();
+}
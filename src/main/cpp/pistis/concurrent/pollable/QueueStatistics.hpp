@@ -0,0 +1,165 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__QUEUESTATISTICS_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__QUEUESTATISTICS_HPP__
+
+#include <pistis/concurrent/HdrHistogram.hpp>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief Statistics policy for Queue that records nothing.
+       *
+       *  This is Queue's default statistics policy.  Its methods are
+       *  empty and ENABLED is false, so the queue skips the clock reads
+       *  that feed the statistics and the compiler removes the rest.
+       */
+      class NoQueueStatistics {
+      public:
+	static const bool ENABLED = false;
+
+	/** @brief NoQueueStatistics has nothing to report */
+	class Snapshot { };
+
+      public:
+	void recordPuts(uint64_t, size_t) { }
+	void recordGets(uint64_t, size_t) { }
+	void recordProducerBlocked(uint64_t) { }
+	void recordConsumerBlocked(uint64_t) { }
+	void recordHighWaterMark() { }
+	void recordLowWaterMark() { }
+
+	Snapshot snapshot() const { return Snapshot(); }
+	void reset() { }
+      };
+
+      /** @brief Statistics policy for Queue that records its activity.
+       *
+       *  Records the number of puts and gets, a histogram of the queue's
+       *  size after each put and get (or bulk get), histograms of the
+       *  time producers and consumers spend blocked on a full or empty
+       *  queue and the number of water mark crossings.  Times are in
+       *  nanoseconds.  LockProfiler reports contention for the queue's
+       *  mutex.  All counters are relaxed atomics, so recording never
+       *  blocks and snapshot() may be called from any thread, but a
+       *  snapshot taken while the queue is in use is not an exact
+       *  point-in-time view.
+       */
+      class QueueStatistics {
+      public:
+	static const bool ENABLED = true;
+
+	/** @brief Significant bits kept by each histogram */
+	static const uint32_t HISTOGRAM_PRECISION = 3;
+
+	class Snapshot {
+	public:
+	  Snapshot(uint64_t puts, uint64_t gets, double elapsed,
+		   uint64_t highWaterMarks, uint64_t lowWaterMarks,
+		   HdrHistogram::Snapshot&& occupancy,
+		   HdrHistogram::Snapshot&& producerBlocked,
+		   HdrHistogram::Snapshot&& consumerBlocked):
+	      puts_(puts), gets_(gets), elapsed_(elapsed),
+	      highWaterMarks_(highWaterMarks), lowWaterMarks_(lowWaterMarks),
+	      occupancy_(std::move(occupancy)),
+	      producerBlocked_(std::move(producerBlocked)),
+	      consumerBlocked_(std::move(consumerBlocked)) {
+	  }
+
+	  uint64_t puts() const { return puts_; }
+	  uint64_t gets() const { return gets_; }
+
+	  /** @brief Seconds between the last reset and the snapshot */
+	  double elapsed() const { return elapsed_; }
+
+	  /** @brief Puts per second since the last reset */
+	  double putRate() const { return elapsed_ > 0 ? puts_ / elapsed_ : 0; }
+
+	  /** @brief Gets per second since the last reset */
+	  double getRate() const { return elapsed_ > 0 ? gets_ / elapsed_ : 0; }
+
+	  uint64_t highWaterMarkCrossings() const { return highWaterMarks_; }
+	  uint64_t lowWaterMarkCrossings() const { return lowWaterMarks_; }
+
+	  /** @brief Queue size after each put or get */
+	  const HdrHistogram::Snapshot& occupancy() const {
+	    return occupancy_;
+	  }
+
+	  /** @brief Time producers spent waiting for a full queue to have
+	   *         room
+	   */
+	  const HdrHistogram::Snapshot& producerBlocked() const {
+	    return producerBlocked_;
+	  }
+
+	  /** @brief Time consumers spent waiting for an empty queue to
+	   *         have items
+	   */
+	  const HdrHistogram::Snapshot& consumerBlocked() const {
+	    return consumerBlocked_;
+	  }
+
+	private:
+	  uint64_t puts_;
+	  uint64_t gets_;
+	  double elapsed_;
+	  uint64_t highWaterMarks_;
+	  uint64_t lowWaterMarks_;
+	  HdrHistogram::Snapshot occupancy_;
+	  HdrHistogram::Snapshot producerBlocked_;
+	  HdrHistogram::Snapshot consumerBlocked_;
+	};
+
+      public:
+	QueueStatistics():
+	    occupancy_(HISTOGRAM_PRECISION),
+	    producerBlocked_(HISTOGRAM_PRECISION),
+	    consumerBlocked_(HISTOGRAM_PRECISION) {
+	  reset();
+	}
+	QueueStatistics(const QueueStatistics&) = delete;
+
+	void recordPuts(uint64_t n, size_t newSize) {
+	  puts_.fetch_add(n, std::memory_order_relaxed);
+	  occupancy_.record(newSize);
+	}
+
+	void recordGets(uint64_t n, size_t newSize) {
+	  gets_.fetch_add(n, std::memory_order_relaxed);
+	  occupancy_.record(newSize);
+	}
+
+	void recordProducerBlocked(uint64_t ns) { producerBlocked_.record(ns); }
+	void recordConsumerBlocked(uint64_t ns) { consumerBlocked_.record(ns); }
+
+	void recordHighWaterMark() {
+	  highWaterMarks_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void recordLowWaterMark() {
+	  lowWaterMarks_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Snapshot snapshot() const;
+	void reset();
+
+	QueueStatistics& operator=(const QueueStatistics&) = delete;
+
+      private:
+	std::atomic<uint64_t> puts_;
+	std::atomic<uint64_t> gets_;
+	std::atomic<uint64_t> highWaterMarks_;
+	std::atomic<uint64_t> lowWaterMarks_;
+	std::atomic<int64_t> startTime_;
+	HdrHistogram occupancy_;
+	HdrHistogram producerBlocked_;
+	HdrHistogram consumerBlocked_;
+      };
+
+    }
+  }
+}
+#endif
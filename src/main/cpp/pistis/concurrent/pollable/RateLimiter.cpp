@@ -0,0 +1,158 @@
+#include "RateLimiter.hpp"
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  typedef std::unique_lock<std::mutex> Lock;
+
+  static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        RateLimiter::Clock::now().time_since_epoch()
+    ).count();
+  }
+
+  static RateLimiter::TimePoint toTimePoint(int64_t ns) {
+    return RateLimiter::TimePoint(
+        std::chrono::duration_cast<RateLimiter::Clock::duration>(
+	    std::chrono::nanoseconds(ns)
+	)
+    );
+  }
+
+  static double nsPerToken(double rate) {
+    if (!(rate > 0.0)) {
+      std::ostringstream msg;
+      msg << "Rate (" << rate << ") must be positive";
+      throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+    }
+    return 1e9 / rate;
+  }
+
+  static uint64_t checkBurst(uint64_t burst) {
+    if (!burst) {
+      throw IllegalValueError("Burst must be at least one", PISTIS_EX_HERE);
+    }
+    return burst;
+  }
+}
+
+RateLimiter::RateLimiter(double rate, uint64_t burst, OnExecMode onExec):
+    burst_(checkBurst(burst)), nsPerToken_(nsPerToken(rate)), emptyAt_(0),
+    timer_(onExec), sync_() {
+  const int64_t now = nowNs();
+  emptyAt_ = now - costOf_(burst_);
+  updateTimer_(now);
+}
+
+double RateLimiter::rate() const {
+  Lock lock(sync_);
+  return 1e9 / nsPerToken_;
+}
+
+uint64_t RateLimiter::available() const {
+  Lock lock(sync_);
+  const int64_t elapsed = nowNs() - emptyAt_;
+  if (elapsed <= 0) {
+    return 0;
+  }
+  return std::min(burst_, (uint64_t)((double)elapsed / nsPerToken_));
+}
+
+RateLimiter::TimePoint RateLimiter::readyAt(uint64_t n) const {
+  validateCount_(n);
+  Lock lock(sync_);
+  const int64_t now = nowNs();
+  return toTimePoint(std::max(now, readyAt_(n, now)));
+}
+
+void RateLimiter::setRate(double rate) {
+  const double newNsPerToken = nsPerToken(rate);
+  Lock lock(sync_);
+  const int64_t now = nowNs();
+  const int64_t oldEmptyAt = std::max(emptyAt_, now - costOf_(burst_));
+
+  // Rescale the distance from now to the empty time, which is the number
+  // of tokens in the bucket (or owed to it) expressed in time
+  emptyAt_ = now - (int64_t)std::llround((double)(now - oldEmptyAt) *
+					 newNsPerToken / nsPerToken_);
+  nsPerToken_ = newNsPerToken;
+  updateTimer_(now);
+}
+
+bool RateLimiter::acquire(uint64_t n, int64_t timeout) {
+  validateCount_(n);
+  const int64_t deadline =
+      (timeout < 0) ? INT64_MAX : nowNs() + timeout * 1000000;
+
+  while (true) {
+    int64_t when;
+    {
+      Lock lock(sync_);
+      const int64_t now = nowNs();
+      if (take_(n, now)) {
+	return true;
+      }
+      when = readyAt_(n, now);
+    }
+
+    // Other threads may take the tokens while this one sleeps, so check
+    // again after waking up
+    if (when > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_until(toTimePoint(when));
+  }
+}
+
+bool RateLimiter::tryAcquire(uint64_t n) {
+  validateCount_(n);
+  Lock lock(sync_);
+  return take_(n, nowNs());
+}
+
+void RateLimiter::validateCount_(uint64_t n) const {
+  if (!n || (n > burst_)) {
+    std::ostringstream msg;
+    msg << "Number of tokens (" << n << ") must be between 1 and the "
+	<< "burst size (" << burst_ << ")";
+    throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+  }
+}
+
+int64_t RateLimiter::costOf_(uint64_t n) const {
+  return (int64_t)std::ceil((double)n * nsPerToken_);
+}
+
+int64_t RateLimiter::readyAt_(uint64_t n, int64_t now) const {
+  return std::max(emptyAt_, now - costOf_(burst_)) + costOf_(n);
+}
+
+bool RateLimiter::take_(uint64_t n, int64_t now) {
+  const int64_t t = readyAt_(n, now);
+  if (t > now) {
+    return false;
+  }
+  emptyAt_ = t;
+  updateTimer_(now);
+  return true;
+}
+
+void RateLimiter::updateTimer_(int64_t now) {
+  const int64_t next = readyAt_(1, now);
+  if (next <= now) {
+    // A token is available.  Any deadline in the past keeps the
+    // descriptor readable, so only re-arm if it is not already readable.
+    if (!timer_.armed() || (timer_.deadline() > toTimePoint(now))) {
+      timer_.arm(toTimePoint(next));
+    }
+  } else if (!timer_.armed() || (timer_.deadline() != toTimePoint(next))) {
+    timer_.arm(toTimePoint(next));
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__RATELIMITER_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__RATELIMITER_HPP__
+
+#include <pistis/concurrent/pollable/DeadlineTimer.hpp>
+#include <mutex>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A pollable token-bucket rate limiter.
+       *
+       *  The bucket holds up to burst() tokens and refills continuously
+       *  at rate() tokens per second.  acquire() takes tokens, waiting
+       *  for them if necessary, while tryAcquire() only takes tokens
+       *  that are already there.
+       *
+       *  fd() is readable exactly when at least one token is available.
+       *  It is driven by a DeadlineTimer set to the time the next token
+       *  arrives, so a sender can wait for tokens in an EpollSet next to
+       *  the descriptors of the queues it drains.  As with
+       *  ReadWriteToggle, the descriptor may only be polled.
+       *
+       *  Internally, the bucket is kept as the time at which it was (or
+       *  will be) empty.  Availability and the timer's deadline are both
+       *  computed from that time with integer arithmetic, so a tryAcquire()
+       *  made after fd() turns readable always succeeds unless another
+       *  thread took the token first.
+       */
+      class RateLimiter {
+      public:
+	typedef DeadlineTimer::Clock Clock;
+	typedef DeadlineTimer::TimePoint TimePoint;
+
+      public:
+	/** @brief Create a rate limiter with a full bucket
+	 *
+	 *  @param rate    Tokens added per second.  Must be positive.
+	 *  @param burst   Capacity of the bucket.  Must be at least one.
+	 *  @param onExec  What happens to fd() across exec()
+	 */
+	RateLimiter(double rate, uint64_t burst = 1,
+		    OnExecMode onExec = OnExecMode::CLOSE);
+	RateLimiter(const RateLimiter&) = delete;
+
+	int fd() const { return timer_.fd(); }
+	double rate() const;
+	uint64_t burst() const { return burst_; }
+
+	/** @brief Number of whole tokens in the bucket right now */
+	uint64_t available() const;
+
+	/** @brief Time at which @c n tokens will be available, assuming
+	 *         no other thread takes any.  Never earlier than now.
+	 */
+	TimePoint readyAt(uint64_t n = 1) const;
+
+	/** @brief Change the refill rate, keeping the tokens already in the
+	 *         bucket.
+	 */
+	void setRate(double rate);
+
+	/** @brief Take @c n tokens, waiting for them as long as necessary */
+	void acquire(uint64_t n = 1) { acquire(n, -1); }
+
+	/** @brief Take @c n tokens, waiting up to @c timeout ms for them.
+	 *
+	 *  The limiter gives up early if the tokens cannot arrive before
+	 *  the timeout expires.  A timeout of -1 waits forever.
+	 *
+	 *  @returns  True if the tokens were taken, false on timeout
+	 */
+	bool acquire(uint64_t n, int64_t timeout);
+
+	/** @brief Take @c n tokens if they are available now */
+	bool tryAcquire(uint64_t n = 1);
+
+	RateLimiter& operator=(const RateLimiter&) = delete;
+
+      private:
+	uint64_t burst_;
+	double nsPerToken_;
+
+	/** @brief Nanoseconds since the clock's epoch at which the bucket
+	 *         was or will be empty.  Never earlier than
+	 *         now - costOf_(burst_).
+	 */
+	int64_t emptyAt_;
+	DeadlineTimer timer_;
+	mutable std::mutex sync_;
+
+	void validateCount_(uint64_t n) const;
+	int64_t costOf_(uint64_t n) const;
+	int64_t readyAt_(uint64_t n, int64_t now) const;
+	bool take_(uint64_t n, int64_t now);
+	void updateTimer_(int64_t now);
+      };
+
+    }
+  }
+}
+#endif
@@ -1,6 +1,8 @@
 #include "ReadWriteToggle.hpp"
 #include <pistis/exceptions/SystemError.hpp>
-#include <sys/eventfd.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/types.h>
 #include <stdint.h>
 #include <unistd.h>
 
@@ -9,82 +11,145 @@ using namespace pistis::concurrent::pollable;
 using namespace pistis::exceptions;
 
 namespace {
-  static const uint64_t STATE_VALUES[] = { (uint64_t)-2, 0, 1 };
-
-  // TODO: Create common code for creating event fd's
-  static int createEventFd(OnExecMode onExec) {
-    const int flags = onExec == OnExecMode::CLOSE ? EFD_CLOEXEC : 0;
-    const int fd = ::eventfd(STATE_VALUES[(int)ReadWriteToggle::READ_WRITE],
-			     flags);
-    if (fd < 0) {
-      throw SystemError::fromSystemCode("Failed to create event fd: #ERR#",
-					errno, PISTIS_EX_HERE);
-    }
+  // Large enough to fill, or drain, a send buffer of the minimum size
+  // in one call
+  static const size_t FILL_SIZE = 16384;
+  static const char FILL[FILL_SIZE] = { 0 };
+
+  inline bool isReadable(ReadWriteToggle::State s) {
+    return (s == ReadWriteToggle::READ_ONLY) ||
+           (s == ReadWriteToggle::READ_WRITE);
+  }
+
+  inline bool isWritable(ReadWriteToggle::State s) {
+    return (s == ReadWriteToggle::WRITE_ONLY) ||
+           (s == ReadWriteToggle::READ_WRITE);
   }
 
-  static uint64_t readValue(int fd) {
-    uint64_t v;
-    int rc = ::read(fd, &v, 8);
-    if (rc < 0) {
-      throw SystemError::fromSystemCode("Failed to read from event fd: #ERR#",
-					errno, PISTIS_EX_HERE);
-    } else if (rc != 8) {
-      throw SystemError("Failed to read from event fd: short read",
-			PISTIS_EX_HERE);
+  inline bool wouldBlock(ssize_t rc) {
+    return (rc < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+  }
+
+  static void checkTransfer(ssize_t rc, const char* what) {
+    if ((rc < 0) && !wouldBlock(rc)) {
+      throw SystemError::fromSystemCode(std::string(what) + ": #ERR#", errno,
+					PISTIS_EX_HERE);
     }
-    return v;
   }
 
-  static void writeValue(int fd, const uint64_t v) {
-    int rc = ::write(fd, &v, 8);
-    if (rc < 0) {
-      throw SystemError::fromSystemCode("Failed to write to event fd: #ERR#",
-					errno, PISTIS_EX_HERE);
-    } else if (rc != 8) {
-      throw SystemError("Failed to write to event fd: short write",
-			PISTIS_EX_HERE);
+  static void createSocketPair(OnExecMode onExec, BlockingMode blocking,
+			       int fds[2]) {
+    const int flags =
+        (onExec == OnExecMode::CLOSE ? SOCK_CLOEXEC : 0) |
+        (blocking == BlockingMode::DONT_BLOCK ? SOCK_NONBLOCK : 0);
+    if (::socketpair(AF_UNIX, SOCK_STREAM | flags, 0, fds) < 0) {
+      throw SystemError::fromSystemCode(
+	  "Failed to create toggle socket pair: #ERR#", errno, PISTIS_EX_HERE
+      );
+    }
+
+    // The kernel rounds this up to its minimum, which keeps the buffer
+    // small enough to fill with one write of FILL_SIZE bytes
+    const int size = 1;
+    if (::setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size,
+		     sizeof(size)) < 0) {
+      const int error = errno;
+      ::close(fds[0]);
+      ::close(fds[1]);
+      throw SystemError::fromSystemCode(
+	  "Failed to size toggle send buffer: #ERR#", error, PISTIS_EX_HERE
+      );
     }
   }
-  
 }
 
-ReadWriteToggle::ReadWriteToggle(OnExecMode onExec):
-    fd_(createEventFd(onExec)), state_(READ_WRITE) {
+ReadWriteToggle::ReadWriteToggle(OnExecMode onExec, BlockingMode blocking,
+				 State initialState):
+    fd_(-1), controlFd_(-1), state_(WRITE_ONLY) {
+  int fds[2];
+  createSocketPair(onExec, blocking, fds);
+  fd_ = fds[0];
+  controlFd_ = fds[1];
+
+  try {
+    setState(initialState);
+  } catch(...) {
+    close_();
+    throw;
+  }
+}
+
+ReadWriteToggle::ReadWriteToggle(int fd, int controlFd, State state):
+    fd_(fd), controlFd_(controlFd), state_(state) {
 }
 
 ReadWriteToggle::ReadWriteToggle(ReadWriteToggle&& other):
-    fd_(other.fd_), state_(other.state_) {
+    fd_(other.fd_), controlFd_(other.controlFd_), state_(other.state_) {
   other.fd_ = -1;
+  other.controlFd_ = -1;
 }
 
 ReadWriteToggle::~ReadWriteToggle() {
-  if (fd_ >= 0) {
-    ::close(fd_);
-  }
+  close_();
 }
 
 ReadWriteToggle& ReadWriteToggle::operator=(ReadWriteToggle&& other) {
   if (fd_ != other.fd_) {
-    if (fd_ >= 0) {
-      ::close(fd_);
-    }
+    close_();
     fd_ = other.fd_;
-    other.fd_ = -1;
+    controlFd_ = other.controlFd_;
     state_ = other.state_;
+    other.fd_ = -1;
+    other.controlFd_ = -1;
   }
   return *this;
 }
 
 void ReadWriteToggle::changeState_(State newState) {
-  const uint64_t oldValue = STATE_VALUES[(int)state_];
-  const uint64_t newValue = STATE_VALUES[(int)newState];
-  if (newValue > oldValue) {
-    writeValue(fd_, newValue - oldValue);
-  } else if (newValue < oldValue) {
-    readValue(fd_);  // Reset to zero
-    if (newValue) {
-      writeValue(fd_, newValue);
-    }
+  if (isReadable(newState) != isReadable(state_)) {
+    setReadable_(isReadable(newState));
+  }
+  if (isWritable(newState) != isWritable(state_)) {
+    setWritable_(isWritable(newState));
   }
   state_ = newState;
 }
+
+void ReadWriteToggle::setReadable_(bool readable) {
+  char byte = 0;
+  if (readable) {
+    checkTransfer(::send(controlFd_, &byte, 1, MSG_DONTWAIT | MSG_NOSIGNAL),
+		  "Failed to make toggle readable");
+  } else {
+    checkTransfer(::recv(fd_, &byte, 1, MSG_DONTWAIT),
+		  "Failed to make toggle unreadable");
+  }
+}
+
+void ReadWriteToggle::setWritable_(bool writable) {
+  if (writable) {
+    char buffer[FILL_SIZE];
+    ssize_t rc;
+    do {
+      rc = ::recv(controlFd_, buffer, FILL_SIZE, MSG_DONTWAIT);
+    } while (rc == (ssize_t)FILL_SIZE);
+    checkTransfer(rc, "Failed to make toggle writable");
+  } else {
+    ssize_t rc;
+    do {
+      rc = ::send(fd_, FILL, FILL_SIZE, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (rc == (ssize_t)FILL_SIZE);
+    checkTransfer(rc, "Failed to make toggle unwritable");
+  }
+}
+
+void ReadWriteToggle::close_() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+  if (controlFd_ >= 0) {
+    ::close(controlFd_);
+    controlFd_ = -1;
+  }
+}
@@ -1,6 +1,7 @@
 #ifndef __PISTIS__CONCURRENT__POLLABLE__READWRITETOGGLE_HPP__
 #define __PISTIS__CONCURRENT__POLLABLE__READWRITETOGGLE_HPP__
 
+#include <pistis/concurrent/BlockingMode.hpp>
 #include <pistis/concurrent/OnExecMode.hpp>
 
 namespace pistis {
@@ -8,7 +9,7 @@ namespace pistis {
     namespace pollable {
 
       /** @brief A "toggle" that provides explicit control over whether
-       *         a file descriptor is readable, writable or both.
+       *         a file descriptor is readable, writable, both or neither.
        *
        *  The purpose behind the ReadWriteToggle is to allow one thread
        *  to signal another thread waiting in select(), poll(), epoll() or
@@ -25,26 +26,29 @@ namespace pistis {
        *  the toggle's file descriptor.  Doing so produces undefined behavior
        *  and probably a deadlock at some point.  
        *
-       *  Because of limitations in the implementation (the current
-       *  implementation uses an eventfd), it is not possible to make
-       *  the toggle's file descriptor neither readable nor writable.
-       *  However, the current set of three states is enough for the toggle's
-       *  intended application.
+       *  The toggle is one end of a unix socket pair; the toggle keeps the
+       *  other end, its control descriptor, to itself.  The descriptor is
+       *  readable while the control end has written a byte to it that has
+       *  not been read back, and writable while its own send buffer (which
+       *  the toggle shrinks to the minimum) has room.  The two directions
+       *  are independent, so each state change touches only the direction
+       *  whose readiness changes, with one system call per direction:
+       *  - Becoming readable writes one byte from the control end.
+       *  - Becoming unreadable reads that byte back.
+       *  - Becoming unwritable fills the send buffer with one write.
+       *  - Becoming writable drains it with one read on the control end.
        *
-       *  Likewise, limitations in the current implementation prevent the
-       *  toggle from transitioning directly from a READ_ONLY state to a
-       *  READ_WRITE state.  Specifically, the value needed to inhibit writes
-       *  on an eventfd is so large that configuring the eventfd as a
-       *  semaphore and decrementing it down to a value that would enable
-       *  simultaneously reading and writing or only writing would not
-       *  be practical.  Instead, the eventfd is configured to reset to
-       *  zero on read, and then a write is done to put the file descriptor
-       *  into a state where it can be read from and written to without
-       *  blocking.  The impact of this limitation is that transitions from
-       *  READ_ONLY to READ_WRITE will incorrectly trigger a call epoll_wait()
-       *  that has been configured to respond to an edge-triggered change in
-       *  the readable status of the toggle's file descriptor, even though
-       *  no change in the readability status of the toggle has taken place.
+       *  The kernel tags each wakeup on a socket with the readiness that
+       *  changed, so an epoll watcher registered for EPOLLIN|EPOLLET is
+       *  woken only when the descriptor becomes readable, and one
+       *  registered for EPOLLOUT|EPOLLET only when it becomes writable.
+       *  (A watcher registered for both is woken by either change and, as
+       *  with any file, told about both.)
+       *
+       *  setState() never waits, whatever the BlockingMode: every send
+       *  and receive passes MSG_DONTWAIT.  The BlockingMode only decides
+       *  whether the descriptors themselves are opened O_NONBLOCK, which
+       *  matters to processes that receive them from a SharedQueue.
        */
       class ReadWriteToggle {
       public:
@@ -56,16 +60,43 @@ namespace pistis {
 	  WRITE_ONLY,
 
 	  /** @brief Toggle's file descriptor is readable and writable */
-	  READ_WRITE
+	  READ_WRITE,
+
+	  /** @brief Toggle's file descriptor is neither readable nor
+	   *         writable
+	   */
+	  NONE
 	};
 	
       public:
-	ReadWriteToggle(OnExecMode onExec = OnExecMode::CLOSE);
+	/** @brief Create a toggle in @c initialState.
+	 *
+	 *  A new socket pair is already WRITE_ONLY, so starting in that
+	 *  state costs no system calls beyond creating the pair.
+	 */
+	ReadWriteToggle(OnExecMode onExec = OnExecMode::CLOSE,
+			BlockingMode blocking = BlockingMode::BLOCK,
+			State initialState = READ_WRITE);
+
+	/** @brief Take ownership of @c fd and @c controlFd, the
+	 *         descriptors of a toggle that is currently in @c state,
+	 *         such as ones received from another process.
+	 */
+	ReadWriteToggle(int fd, int controlFd, State state);
 	ReadWriteToggle(const ReadWriteToggle&) = delete;
 	ReadWriteToggle(ReadWriteToggle&& other);
 	~ReadWriteToggle();
 
 	int fd() const { return fd_; }
+
+	/** @brief The end of the socket pair the toggle writes to and
+	 *         reads from to change its state.
+	 *
+	 *  Only needed to share the toggle with another process.  Like
+	 *  fd(), applications must never read from or write to it.
+	 */
+	int controlFd() const { return controlFd_; }
+
 	State state() const { return state_; }
 
 	void setState(State newState) {
@@ -74,15 +105,27 @@ namespace pistis {
 	  }
 	}
 
+	/** @brief Record that the descriptor is in @c state because
+	 *         another holder of the same descriptor changed it.
+	 *
+	 *  Holders that share a descriptor must keep the true state
+	 *  somewhere they can all see it, and must serialize their calls
+	 *  to setState().
+	 */
+	void assumeState(State state) { state_ = state; }
+
 	ReadWriteToggle& operator=(const ReadWriteToggle&) = delete;
 	ReadWriteToggle& operator=(ReadWriteToggle&& other);
 	
       private:
 	int fd_;
+	int controlFd_;
 	State state_;
 
 	void changeState_(State newState);
-
+	void setReadable_(bool readable);
+	void setWritable_(bool writable);
+	void close_();
       };
 
     }
@@ -0,0 +1,245 @@
+#include "Scheduler.hpp"
+#include <iterator>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef std::unique_lock<std::mutex> Lock;
+
+  static const EpollEventType READY_TO_READ =
+      EpollEventType::READ | EpollEventType::READ_HANGUP |
+      EpollEventType::HANGUP | EpollEventType::ERROR;
+  static const EpollEventType READY_TO_WRITE =
+      EpollEventType::WRITE | EpollEventType::HANGUP | EpollEventType::ERROR;
+}
+
+Scheduler::Scheduler(OnExecMode onExec, const ThreadConfig& thread):
+    epoll_(onExec), wakeup_(onExec, BlockingMode::DONT_BLOCK),
+    thread_(thread), waiters_(),
+    changed_(), tasks_(), numWaiters_(0), wakeupPending_(false),
+    stopped_(false), runner_(), sync_() {
+  epoll_.add(wakeup_.fd(), EpollEventType::READ);
+}
+
+size_t Scheduler::numWaiters() const {
+  Lock lock(sync_);
+  return numWaiters_;
+}
+
+bool Scheduler::idle() const {
+  Lock lock(sync_);
+  return !numWaiters_ && tasks_.empty();
+}
+
+void Scheduler::whenReadable(int fd, Attempt attempt) {
+  addWaiter_(fd, std::move(attempt), true);
+}
+
+void Scheduler::whenWritable(int fd, Attempt attempt) {
+  addWaiter_(fd, std::move(attempt), false);
+}
+
+void Scheduler::suspendWritable(int fd) {
+  Lock lock(sync_);
+  waiters_[fd].writersSuspended = true;
+  changed_.insert(fd);
+  wake_(lock);
+}
+
+void Scheduler::resumeWritable(int fd) {
+  Lock lock(sync_);
+  auto i = waiters_.find(fd);
+  if ((i != waiters_.end()) && i->second.writersSuspended) {
+    i->second.writersSuspended = false;
+    changed_.insert(fd);
+    wake_(lock);
+  }
+}
+
+void Scheduler::post(Task task) {
+  Lock lock(sync_);
+  tasks_.push_back(std::move(task));
+  wake_(lock);
+}
+
+size_t Scheduler::runOnce(int64_t timeout) {
+  {
+    Lock lock(sync_);
+    runner_ = std::this_thread::get_id();
+    if (!tasks_.empty()) {
+      timeout = 0;
+    }
+  }
+
+  // Clear runner_ however this call ends, including when an attempt or
+  // task throws
+  struct RunnerScope {
+    Scheduler& scheduler;
+
+    ~RunnerScope() {
+      Lock lock(scheduler.sync_);
+      scheduler.runner_ = std::thread::id();
+    }
+  } runnerScope{ *this };
+
+  applyChanges_();
+
+  size_t n = 0;
+  if (epoll_.wait(timeout)) {
+    // Copy the events, because attempts may cause epoll_ to change
+    const EpollEventList events(epoll_.events());
+    for (const auto& event : events) {
+      if (event.fd() == wakeup_.fd()) {
+	Lock lock(sync_);
+	wakeup_.tryDown();
+	wakeupPending_ = false;
+      } else {
+	if ((event.events() & READY_TO_READ) != EpollEventType::NONE) {
+	  n += dispatch_(event.fd(), true);
+	}
+	if ((event.events() & READY_TO_WRITE) != EpollEventType::NONE) {
+	  n += dispatch_(event.fd(), false);
+	}
+      }
+    }
+  }
+  n += runTasks_();
+  return n;
+}
+
+void Scheduler::run() {
+  thread_.apply();
+  while (true) {
+    {
+      Lock lock(sync_);
+      if (stopped_) {
+	stopped_ = false;
+	return;
+      }
+    }
+    runOnce(-1);
+  }
+}
+
+void Scheduler::stop() {
+  Lock lock(sync_);
+  stopped_ = true;
+  wake_(lock);
+}
+
+void Scheduler::addWaiter_(int fd, Attempt&& attempt, bool read) {
+  Lock lock(sync_);
+  Waiters_& w = waiters_[fd];
+  (read ? w.readers : w.writers).push_back(std::move(attempt));
+  ++numWaiters_;
+  changed_.insert(fd);
+  wake_(lock);
+}
+
+void Scheduler::wake_(Lock&) {
+  // The runner picks up changes before it waits again, so it only needs
+  // waking when another thread makes them
+  if (!wakeupPending_ && (runner_ != std::this_thread::get_id())) {
+    wakeup_.up();
+    wakeupPending_ = true;
+  }
+}
+
+void Scheduler::applyChanges_() {
+  Lock lock(sync_);
+  for (int fd : changed_) {
+    auto i = waiters_.find(fd);
+    if (i == waiters_.end()) {
+      continue;
+    }
+
+    Waiters_& w = i->second;
+    EpollEventType events = EpollEventType::NONE;
+    if (!w.readers.empty()) {
+      events |= EpollEventType::READ;
+    }
+    if (!w.writers.empty() && !w.writersSuspended) {
+      events |= EpollEventType::WRITE;
+    }
+
+    if (events == w.events) {
+      // Nothing to do
+    } else if (events == EpollEventType::NONE) {
+      epoll_.remove(fd);
+    } else if (w.events == EpollEventType::NONE) {
+      epoll_.add(fd, events);
+    } else {
+      epoll_.modify(fd, events, EpollTrigger::LEVEL, EpollRepeat::REPEATING);
+    }
+
+    if (w.readers.empty() && w.writers.empty()) {
+      waiters_.erase(i);
+    } else {
+      w.events = events;
+    }
+  }
+  changed_.clear();
+}
+
+size_t Scheduler::dispatch_(int fd, bool read) {
+  size_t n = 0;
+  Lock lock(sync_);
+  while (true) {
+    auto i = waiters_.find(fd);
+    if (i == waiters_.end()) {
+      break;
+    }
+
+    std::deque<Attempt>& attempts = read ? i->second.readers
+                                         : i->second.writers;
+    if (attempts.empty()) {
+      break;
+    }
+
+    Attempt attempt(std::move(attempts.front()));
+    attempts.pop_front();
+    --numWaiters_;
+    changed_.insert(fd);
+
+    lock.unlock();
+    const bool done = attempt();
+    lock.lock();
+
+    if (!done) {
+      // The attempt keeps its place at the head of the line.  Attempts
+      // registered meanwhile were added to the back.
+      Waiters_& w = waiters_[fd];
+      (read ? w.readers : w.writers).push_front(std::move(attempt));
+      ++numWaiters_;
+      break;
+    }
+    ++n;
+  }
+  return n;
+}
+
+size_t Scheduler::runTasks_() {
+  std::deque<Task> tasks;
+  {
+    Lock lock(sync_);
+    tasks.swap(tasks_);
+  }
+
+  // Tasks posted by these tasks run on the next call to runOnce()
+  size_t n = 0;
+  while (!tasks.empty()) {
+    Task task(std::move(tasks.front()));
+    tasks.pop_front();
+    try {
+      task();
+    } catch(...) {
+      Lock lock(sync_);
+      tasks_.insert(tasks_.begin(), std::make_move_iterator(tasks.begin()),
+		    std::make_move_iterator(tasks.end()));
+      throw;
+    }
+    ++n;
+  }
+  return n;
+}
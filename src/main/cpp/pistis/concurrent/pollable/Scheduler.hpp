@@ -0,0 +1,152 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__SCHEDULER_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__SCHEDULER_HPP__
+
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/ThreadConfig.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief Runs asynchronous operations on pollable file descriptors
+       *         from a single EpollSet.
+       *
+       *  Operations register an "attempt" with whenReadable() or
+       *  whenWritable().  When the file descriptor becomes ready, the
+       *  scheduler calls the attempts waiting on it in the order they
+       *  were registered.  An attempt returns true if it completed, which
+       *  removes it, or false if the resource was taken by someone else,
+       *  which leaves it and every attempt behind it waiting for the next
+       *  readiness event.  An attempt that fails for a reason its
+       *  descriptor does not reflect, such as an item too large for the
+       *  room left in a byte-bounded queue, calls suspendWritable() before
+       *  it returns, so the scheduler does not call it on every pass
+       *  while the descriptor stays ready.
+       *
+       *  Any number of attempts can wait on the same descriptor, so
+       *  thousands of logical waiters on a Queue share its queueStateFd()
+       *  instead of each owning an eventfd.
+       *
+       *  post() queues a task to run on the scheduler's thread, and is how
+       *  callbacks from other threads (such as Condition::whenNotified())
+       *  hand work to the scheduler.
+       *
+       *  Any thread may register attempts or post tasks, but only one
+       *  thread at a time may call runOnce() or run().  Attempts and
+       *  tasks run on that thread without the scheduler's lock held, so
+       *  they may register further attempts.  An exception thrown by an
+       *  attempt or task propagates out of runOnce() and discards that
+       *  attempt or task.
+       *
+       *  run() applies the scheduler's ThreadConfig to the calling
+       *  thread before it starts dispatching, so the event loop can be
+       *  given a dedicated core and a real-time priority.
+       *
+       *  See Async.hpp for ready-made operations on Queue, Semaphore and
+       *  Condition.
+       */
+      class Scheduler {
+      public:
+	typedef std::function<bool ()> Attempt;
+	typedef std::function<void ()> Task;
+
+      public:
+	Scheduler(OnExecMode onExec = OnExecMode::CLOSE,
+		  const ThreadConfig& thread = ThreadConfig());
+	Scheduler(const Scheduler&) = delete;
+
+	/** @brief Configuration run() applies to its thread */
+	const ThreadConfig& threadConfig() const { return thread_; }
+
+	/** @brief Number of attempts waiting on file descriptors */
+	size_t numWaiters() const;
+
+	/** @brief True if no attempts are waiting and no tasks are queued */
+	bool idle() const;
+
+	/** @brief Call @c attempt when @c fd is readable, until it returns
+	 *         true
+	 */
+	void whenReadable(int fd, Attempt attempt);
+
+	/** @brief Call @c attempt when @c fd is writable, until it returns
+	 *         true
+	 */
+	void whenWritable(int fd, Attempt attempt);
+
+	/** @brief Stop watching @c fd for writability until
+	 *         resumeWritable() is called.
+	 *
+	 *  The attempts waiting on @c fd keep their places in line.
+	 */
+	void suspendWritable(int fd);
+
+	/** @brief Watch @c fd for writability again after
+	 *         suspendWritable().  May be called from any thread.
+	 */
+	void resumeWritable(int fd);
+
+	/** @brief Run @c task on the scheduler's thread */
+	void post(Task task);
+
+	/** @brief Wait up to @c timeout ms for something to do, then do it.
+	 *
+	 *  @returns  The number of attempts completed and tasks run
+	 */
+	size_t runOnce(int64_t timeout = -1);
+
+	/** @brief Apply threadConfig() to the calling thread, then call
+	 *         runOnce() until stop() is called
+	 *
+	 *  @throws IllegalValueError, SystemError if the configuration
+	 *          cannot be applied
+	 */
+	void run();
+
+	/** @brief Make run() return.  May be called from any thread. */
+	void stop();
+
+	Scheduler& operator=(const Scheduler&) = delete;
+
+      private:
+	struct Waiters_ {
+	  std::deque<Attempt> readers;
+	  std::deque<Attempt> writers;
+	  EpollEventType events;
+	  bool writersSuspended;
+
+	  Waiters_(): readers(), writers(), events(EpollEventType::NONE),
+		      writersSuspended(false) {
+	  }
+	};
+
+	EpollSet epoll_;
+	Semaphore wakeup_;
+	ThreadConfig thread_;
+	std::unordered_map<int, Waiters_> waiters_;
+	std::unordered_set<int> changed_;
+	std::deque<Task> tasks_;
+	size_t numWaiters_;
+	bool wakeupPending_;
+	bool stopped_;
+	std::thread::id runner_;
+	mutable std::mutex sync_;
+
+	void addWaiter_(int fd, Attempt&& attempt, bool read);
+	void wake_(std::unique_lock<std::mutex>& lock);
+	void applyChanges_();
+	size_t dispatch_(int fd, bool read);
+	size_t runTasks_();
+      };
+
+    }
+  }
+}
+#endif
@@ -1,6 +1,9 @@
 #include "Semaphore.hpp"
 #include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/TimeUtils.hpp>
 #include <pistis/exceptions/SystemError.hpp>
+#include <chrono>
+#include <poll.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 
@@ -9,13 +12,15 @@ using namespace pistis::concurrent;
 using namespace pistis::concurrent::pollable;
 
 namespace {
-  inline int computeFlags(OnExecMode onExec) {
+  inline int computeFlags(OnExecMode onExec, BlockingMode blocking) {
     return EFD_SEMAPHORE |
-           (onExec == OnExecMode::CLOSE ? EFD_CLOEXEC : 0);
+           (onExec == OnExecMode::CLOSE ? EFD_CLOEXEC : 0) |
+           (blocking == BlockingMode::DONT_BLOCK ? EFD_NONBLOCK : 0);
   }
   
-  inline int createEventFd(uint64_t initialValue, OnExecMode onExec) {
-    int fd = ::eventfd(initialValue, computeFlags(onExec));
+  inline int createEventFd(uint64_t initialValue, OnExecMode onExec,
+			   BlockingMode blocking) {
+    int fd = ::eventfd(initialValue, computeFlags(onExec, blocking));
     if (fd < 0) {
       throw SystemError::fromSystemCode("Failed to create event fd: #ERR#",
 					errno, PISTIS_EX_HERE);
@@ -24,11 +29,13 @@ namespace {
   }
 }
 
-Semaphore::Semaphore(uint64_t initialValue, OnExecMode onExec):
-    fd_(createEventFd(initialValue, onExec)) {
+Semaphore::Semaphore(uint64_t initialValue, OnExecMode onExec,
+		     BlockingMode blocking):
+    fd_(createEventFd(initialValue, onExec, blocking)), blocking_(blocking) {
 }
 
-Semaphore::Semaphore(Semaphore&& other): fd_(other.fd_) {
+Semaphore::Semaphore(Semaphore&& other):
+    fd_(other.fd_), blocking_(other.blocking_) {
   other.fd_ = -1;
 }
 
@@ -42,6 +49,16 @@ bool Semaphore::up(uint64_t v, int64_t timeout) {
   if (timeout < 0) {
     up(v);
     return true;
+  } else if (blocking_ == BlockingMode::DONT_BLOCK) {
+    const auto deadline = std::chrono::steady_clock::now() + toMs(timeout);
+    while (!write_(v)) {
+      const int64_t timeLeft =
+	  toMs(deadline - std::chrono::steady_clock::now());
+      if ((timeLeft < 0) || !await_(false, timeLeft)) {
+	return false;
+      }
+    }
+    return true;
   } else {
     EpollSet pollSet(fd_, EpollEventType::WRITE);
     return pollSet.whenReady(timeout,
@@ -57,6 +74,16 @@ bool Semaphore::down(int64_t timeout) {
   if (timeout < 0) {
     down();
     return true;
+  } else if (blocking_ == BlockingMode::DONT_BLOCK) {
+    const auto deadline = std::chrono::steady_clock::now() + toMs(timeout);
+    while (!read_()) {
+      const int64_t timeLeft =
+	  toMs(deadline - std::chrono::steady_clock::now());
+      if ((timeLeft < 0) || !await_(true, timeLeft)) {
+	return false;
+      }
+    }
+    return true;
   } else {
     EpollSet pollSet(fd_, EpollEventType::READ);
     return pollSet.whenReady(timeout,
@@ -74,6 +101,7 @@ Semaphore& Semaphore::operator=(Semaphore&& other) {
       ::close(fd_);
     }
     fd_ = other.fd_;
+    blocking_ = other.blocking_;
     other.fd_ = -1;
   }
   return *this;
@@ -103,3 +131,21 @@ bool Semaphore::write_(uint64_t v) {
 				      PISTIS_EX_HERE);
   }
 }
+
+bool Semaphore::await_(bool readable, int64_t timeout) {
+  struct pollfd p;
+  p.fd = fd_;
+  p.events = readable ? POLLIN : POLLOUT;
+  p.revents = 0;
+
+  int rc;
+  do {
+    rc = ::poll(&p, 1, (int)timeout);
+  } while ((rc < 0) && (errno == EINTR));
+
+  if (rc < 0) {
+    throw SystemError::fromSystemCode("Poll on eventfd failed: #ERR#", errno,
+				      PISTIS_EX_HERE);
+  }
+  return rc > 0;
+}
@@ -3,44 +3,95 @@
 
 #include <pistis/concurrent/BlockingMode.hpp>
 #include <pistis/concurrent/OnExecMode.hpp>
+#include <stdint.h>
 
 namespace pistis {
   namespace concurrent {
     namespace pollable {
 
+      /** @brief A counting semaphore backed by an eventfd, which can be
+       *         polled for readability (the count is positive) and
+       *         writability (the count can be raised).
+       *
+       *  In BlockingMode::BLOCK mode, the eventfd blocks and down() and
+       *  up() sleep in read() and write().  In BlockingMode::DONT_BLOCK
+       *  mode, the eventfd is nonblocking: tryDown() and tryUp() are a
+       *  single read() or write() that fails instead of waiting, and
+       *  down() and up() wait in poll() whenever that fails.  Event
+       *  loops that decrement a semaphore after polling its fd() should
+       *  use DONT_BLOCK, since another thread may take the count between
+       *  the poll and the read.
+       */
       class Semaphore {
       public:
 	Semaphore(uint64_t initialValue = 0,
-		  OnExecMode onExec = OnExecMode::CLOSE);
-	Semaphore(OnExecMode onExec):
-	    Semaphore(0, onExec) {
+		  OnExecMode onExec = OnExecMode::CLOSE,
+		  BlockingMode blocking = BlockingMode::BLOCK);
+	Semaphore(OnExecMode onExec,
+		  BlockingMode blocking = BlockingMode::BLOCK):
+	    Semaphore(0, onExec, blocking) {
 	}
 	Semaphore(const Semaphore&) = delete;
 	Semaphore(Semaphore&& other);
 	~Semaphore();
 
 	int fd() const { return fd_; }
+	BlockingMode blockingMode() const { return blocking_; }
 	
 	void up(uint64_t v = 1) {
 	  while (!write_(v)) {
+	    await_(false, -1);
 	  }
 	}
 	bool up(uint64_t v, int64_t timeout);
+
+	/** @brief Add @c v to the count if that can be done without
+	 *         waiting.
+	 *
+	 *  Never waits in DONT_BLOCK mode.  In BLOCK mode it is up(v, 0),
+	 *  which can block if another thread fills the count between its
+	 *  poll and its write.
+	 *
+	 *  @returns  True if the count was raised
+	 */
+	bool tryUp(uint64_t v = 1) {
+	  return (blocking_ == BlockingMode::DONT_BLOCK) ? write_(v)
+	                                                 : up(v, 0);
+	}
 	
 	void down() {
 	  while (!read_()) {
+	    await_(true, -1);
 	  }
 	}
 	bool down(int64_t timeout);
+
+	/** @brief Decrement the count if it is positive.
+	 *
+	 *  Never waits in DONT_BLOCK mode.  In BLOCK mode it is down(0),
+	 *  which can block if another thread takes the count between its
+	 *  poll and its read.
+	 *
+	 *  @returns  True if the count was decremented
+	 */
+	bool tryDown() {
+	  return (blocking_ == BlockingMode::DONT_BLOCK) ? read_() : down(0);
+	}
 	
 	Semaphore& operator=(const Semaphore&) = delete;
 	Semaphore& operator=(Semaphore&& other);
 
       private:
 	int fd_;
+	BlockingMode blocking_;
 
 	bool read_();
 	bool write_(uint64_t v);
+
+	/** @brief Wait up to @c timeout ms for the eventfd to become
+	 *         readable or writable
+	 */
+	bool await_(bool readable, int64_t timeout);
       };
       
     }
@@ -0,0 +1,460 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__SHARDEDQUEUE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__SHARDEDQUEUE_HPP__
+
+#include <pistis/concurrent/pollable/QueueMonitor.hpp>
+#include <pistis/concurrent/ProfiledMutex.hpp>
+#include <pistis/concurrent/TimeUtils.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief ShardedQueue's default ShardSelector.  Deals shards out
+       *         to threads round-robin, in the order the threads first
+       *         use any ShardedQueue.
+       */
+      struct ThreadShardSelector {
+	size_t operator()(size_t numShards) const {
+	  static std::atomic<size_t> nextSlot(0);
+	  static thread_local size_t slot = nextSlot++;
+	  return slot % numShards;
+	}
+      };
+
+      /** @brief An unbounded pollable queue split into independently
+       *         locked shards to reduce contention between cores.
+       *
+       *  The ShardSelector parameter is a function object that maps the
+       *  number of shards to the calling thread's "local" shard.  The
+       *  default, ThreadShardSelector, assigns each thread a local shard
+       *  the first time it uses a ShardedQueue, and NumaShardedQueue
+       *  uses the shard for the caller's NUMA node.  Each shard may have
+       *  its own allocator.  put() adds items to the caller's local shard.
+       *  get() takes from the local shard first and, when that shard is
+       *  empty, steals from the other shards.  Items put by one thread
+       *  come out in FIFO order relative to each other, but there is no
+       *  ordering between items put by threads on different shards.
+       *
+       *  There is no global item count for every put and get to update.
+       *  Each shard counts its own items, and size() adds them up, so it
+       *  is only approximate while other threads are putting and
+       *  getting.  The EMPTY and NOT_EMPTY events, empty() and
+       *  queueStateFd() follow a count of non-empty shards, which
+       *  changes only when a shard empties or stops being empty.  The
+       *  water marks are checked against the summed size every
+       *  SAMPLE_INTERVAL operations on a shard, and after every
+       *  operation while the last sum was close enough to a water mark
+       *  that it could have crossed one, so HIGH_WATER_MARK and
+       *  LOW_WATER_MARK fire on the operation that crosses the mark
+       *  unless other threads are changing the size at the same time.
+       *  The queue is unbounded, so the FULL and NOT_FULL events are not
+       *  supported.  queueStateFd() is always writable and is readable
+       *  whenever the queue is not empty.
+       */
+      template <typename Item, typename Allocator = std::allocator<Item>,
+		typename ShardSelector = ThreadShardSelector>
+      class ShardedQueue {
+      public:
+	typedef Item ItemType;
+	typedef Allocator AllocatorType;
+	typedef ShardSelector ShardSelectorType;
+	typedef QueueGuard<ShardedQueue> Guard;
+
+	static const size_t MAX_QUEUE_SIZE = (size_t)-1;
+
+	/** @brief Operations on a shard between checks of the water
+	 *         marks
+	 */
+	static const size_t SAMPLE_INTERVAL = 16;
+
+      private:
+	typedef std::unique_lock<ProfiledMutex> Lock_;
+
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	struct Shard_ {
+	  ProfiledMutex sync;
+	  std::deque<Item, Allocator> items;
+
+	  /** @brief Copy of items.size() for readers that do not hold
+	   *         sync.  Only written with sync held.
+	   */
+	  std::atomic<size_t> count;
+
+	  /** @brief Puts and gets on this shard.  Guarded by sync. */
+	  size_t ops;
+
+	  // Keep neighbouring shards' mutexes off this shard's cache line
+	  char padding[CACHE_LINE_SIZE];
+
+	  Shard_(const void* owner, const Allocator& allocator):
+	      sync(owner, "ShardedQueue::Shard"), items(allocator), count(0),
+	      ops(0) {
+	  }
+	};
+
+      public:
+	ShardedQueue(size_t numShards = defaultNumShards(),
+		     const Allocator& allocator = Allocator()):
+	    ShardedQueue(numShards, MAX_QUEUE_SIZE, MAX_QUEUE_SIZE,
+			 allocator) {
+	}
+
+	ShardedQueue(size_t numShards, size_t lowWaterMark,
+		     size_t highWaterMark,
+		     const Allocator& allocator = Allocator()):
+	    ShardedQueue(std::vector<Allocator>(numShards, allocator),
+			 lowWaterMark, highWaterMark) {
+	}
+
+	/** @brief Create a queue with one shard for each allocator in
+	 *         @c shardAllocators
+	 */
+	ShardedQueue(const std::vector<Allocator>& shardAllocators,
+		     size_t lowWaterMark = MAX_QUEUE_SIZE,
+		     size_t highWaterMark = MAX_QUEUE_SIZE,
+		     const ShardSelector& selector = ShardSelector()):
+	    numShards_(shardAllocators.size()), shards_(), nonEmptyShards_(0),
+	    sampledSize_(0), lowWaterMark_(lowWaterMark),
+	    highWaterMark_(highWaterMark), highWaterCrossed_(false),
+	    stateSync_(this, "ShardedQueue"),
+	    queueState_(OnExecMode::CLOSE, BlockingMode::BLOCK,
+			ReadWriteToggle::WRITE_ONLY),
+	    selector_(selector) {
+	  if (!numShards_) {
+	    throw pistis::exceptions::IllegalValueError(
+		"Illegal value for number of shards (must be > 0)",
+		PISTIS_EX_HERE
+	    );
+	  }
+	  if (lowWaterMark > highWaterMark) {
+	    throw pistis::exceptions::IllegalValueError(
+		"Illegal value for low water mark (> high water mark)",
+		PISTIS_EX_HERE
+	    );
+	  }
+	  shards_.reserve(numShards_);
+	  for (const Allocator& allocator : shardAllocators) {
+	    shards_.emplace_back(new Shard_(this, allocator));
+	  }
+	}
+
+	ShardedQueue(const ShardedQueue&) = delete;
+	ShardedQueue(ShardedQueue&&) = delete;
+
+	/** @brief One shard per hardware thread */
+	static size_t defaultNumShards() {
+	  return std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	size_t numShards() const { return numShards_; }
+
+	/** @brief The shard put() uses for the calling thread */
+	size_t localShard() const { return selector_(numShards_); }
+
+	/** @brief Number of items in the given shard */
+	size_t shardSize(size_t shard) const {
+	  return shards_[shard]->count.load(std::memory_order_acquire);
+	}
+
+	size_t size() const {
+	  size_t n = 0;
+	  for (size_t i = 0; i < numShards_; ++i) {
+	    n += shardSize(i);
+	  }
+	  return n;
+	}
+
+	bool empty() const { return !nonEmptyShards_.load(); }
+	size_t maxSize() const { return MAX_QUEUE_SIZE; }
+	size_t lowWaterMark() const { return lowWaterMark_; }
+	size_t highWaterMark() const { return highWaterMark_; }
+	bool aboveHighWaterMark() const { return size() > highWaterMark_; }
+	bool atOrBelowLowWaterMark() const { return size() <= lowWaterMark_; }
+
+	void put(const Item& item) {
+	  executePut_([&](Shard_& shard) { shard.items.push_back(item); });
+	}
+
+	void put(Item&& item) {
+	  executePut_([&](Shard_& shard) {
+	      shard.items.push_back(std::move(item));
+	  });
+	}
+
+	template <typename... Args>
+	void emplace(Args&&... args) {
+	  executePut_([&](Shard_& shard) {
+	      shard.items.emplace_back(std::forward<Args>(args)...);
+	  });
+	}
+
+	Item get() {
+	  // Move the item straight out of its shard, so Item need not be
+	  // default-constructible
+	  Slot_ slot;
+	  getWith_([&slot](Item& item) { slot.fill(std::move(item)); }, -1);
+	  return std::move(slot.item());
+	}
+
+	/** @brief Take an item from the local shard, or steal one from
+	 *         another shard if the local shard is empty.
+	 *
+	 *  @param result   Receives the item
+	 *  @param timeout  Maximum time to wait in ms, or -1 to wait forever
+	 *  @returns  True if an item was retrieved, false on timeout
+	 */
+	bool get(Item& result, int64_t timeout = 0) {
+	  return getWith_([&result](Item& item) { result = std::move(item); },
+			  timeout);
+	}
+
+	bool wait(int64_t timeout, QueueEventType eventType) {
+	  Condition& cv = selectCv_(eventType);
+	  Lock_ lock(stateSync_);
+	  if (eventHolds_(eventType)) {
+	    return true;
+	  }
+	  return cv.wait(lock, timeout);
+	}
+
+	int observe(QueueEventType eventType) {
+	  return selectCv_(eventType).observe();
+	}
+
+	void ack(int fd, QueueEventType eventType) {
+	  selectCv_(eventType).ack(fd);
+	}
+
+	void stopObserving(int fd, QueueEventType eventType) {
+	  selectCv_(eventType).stopObserving(fd);
+	}
+
+	int queueStateFd() { return queueState_.fd(); }
+
+	ShardedQueue& operator=(const ShardedQueue&) = delete;
+	ShardedQueue& operator=(ShardedQueue&&) = delete;
+
+      private:
+	size_t numShards_;
+	std::vector< std::unique_ptr<Shard_> > shards_;
+	std::atomic<size_t> nonEmptyShards_;
+	std::atomic<size_t> sampledSize_;  ///< size() when last sampled
+	size_t lowWaterMark_;
+	size_t highWaterMark_;
+	std::atomic<bool> highWaterCrossed_;
+	ProfiledMutex stateSync_;
+	Condition emptyCv_;
+	Condition notEmptyCv_;
+	Condition lowWaterMarkCv_;
+	Condition highWaterMarkCv_;
+	ReadWriteToggle queueState_;
+	ShardSelector selector_;
+
+	/** @brief Holds the result of get() until it is returned */
+	class Slot_ {
+	public:
+	  Slot_(): full_(false) { }
+	  Slot_(const Slot_&) = delete;
+	  ~Slot_() {
+	    if (full_) {
+	      item().~Item();
+	    }
+	  }
+
+	  Item& item() { return *reinterpret_cast<Item*>(&storage_); }
+
+	  void fill(Item&& item) {
+	    new(&storage_) Item(std::move(item));
+	    full_ = true;
+	  }
+
+	  Slot_& operator=(const Slot_&) = delete;
+
+	private:
+	  typename std::aligned_storage<sizeof(Item), alignof(Item)>::type
+	      storage_;
+	  bool full_;
+	};
+
+	/** @brief Wait up to @c timeout ms for an item and pass it to
+	 *         @c take while its shard is locked
+	 */
+	template <typename TakeFunction>
+	bool getWith_(TakeFunction take, int64_t timeout) {
+	  if (tryGet_(take)) {
+	    return true;
+	  } else if (!timeout) {
+	    return false;
+	  }
+
+	  auto now = std::chrono::system_clock::now();
+	  const auto deadline = now + toMs(timeout);
+	  while (true) {
+	    {
+	      // notEmptyCv_ is notified after stateSync_ is taken, so the
+	      // notification cannot slip in between the check and the wait
+	      Lock_ lock(stateSync_);
+	      if (empty()) {
+		const int64_t remaining =
+		    (timeout < 0) ? -1
+		                  : std::max((int64_t)toMs(deadline - now),
+					     (int64_t)0);
+		if (!notEmptyCv_.wait(lock, remaining)) {
+		  lock.unlock();
+		  return tryGet_(take);
+		}
+	      }
+	    }
+	    if (tryGet_(take)) {
+	      return true;
+	    }
+	    now = std::chrono::system_clock::now();
+	    if ((timeout >= 0) && (now >= deadline)) {
+	      return false;
+	    }
+	  }
+	}
+
+	template <typename PutItemFunction>
+	void executePut_(PutItemFunction putItem) {
+	  Shard_& shard = *shards_[localShard()];
+	  bool queueFilled = false;
+	  size_t ops;
+	  {
+	    Lock_ lock(shard.sync);
+	    putItem(shard);
+	    shard.count.store(shard.items.size(), std::memory_order_release);
+	    if (shard.items.size() == 1) {
+	      queueFilled = !nonEmptyShards_.fetch_add(1);
+	    }
+	    ops = ++shard.ops;
+	  }
+	  issueNotifications_(queueFilled, false, ops);
+	}
+
+	template <typename TakeFunction>
+	bool tryGet_(TakeFunction& take) {
+	  const size_t local = localShard();
+
+	  // Take from the local shard first, then steal from the others
+	  for (size_t i = 0; i < numShards_; ++i) {
+	    Shard_& shard = *shards_[(local + i) % numShards_];
+	    if (shard.count.load(std::memory_order_acquire)) {
+	      Lock_ lock(shard.sync);
+	      if (!shard.items.empty()) {
+		take(shard.items.front());
+		shard.items.pop_front();
+		bool queueEmptied = false;
+		shard.count.store(shard.items.size(),
+				  std::memory_order_release);
+		if (shard.items.empty()) {
+		  queueEmptied = nonEmptyShards_.fetch_sub(1) == 1;
+		}
+		const size_t ops = ++shard.ops;
+		lock.unlock();
+
+		issueNotifications_(false, queueEmptied, ops);
+		return true;
+	      }
+	    }
+	  }
+	  return false;
+	}
+
+	bool eventHolds_(QueueEventType eventType) {
+	  switch(eventType) {
+	    case QueueEventType::EMPTY: return empty();
+	    case QueueEventType::NOT_EMPTY: return !empty();
+	    default: return false;
+	  }
+	}
+
+	Condition& selectCv_(QueueEventType eventType) {
+	  switch(eventType) {
+	    case QueueEventType::EMPTY: return emptyCv_;
+	    case QueueEventType::NOT_EMPTY: return notEmptyCv_;
+	    case QueueEventType::HIGH_WATER_MARK: return highWaterMarkCv_;
+	    case QueueEventType::LOW_WATER_MARK: return lowWaterMarkCv_;
+	    default:
+	      throw pistis::exceptions::IllegalValueError(
+		  "Illegal value for \"eventType\" (ShardedQueue is unbounded)",
+		  PISTIS_EX_HERE
+	      );
+	  }
+	}
+
+	/** @brief Update the queue's state after an operation on a shard.
+	 *
+	 *  @param queueFilled   The operation made the first shard
+	 *                       non-empty
+	 *  @param queueEmptied  The operation emptied the last non-empty
+	 *                       shard
+	 *  @param ops           The shard's operation count afterward
+	 */
+	void issueNotifications_(bool queueFilled, bool queueEmptied,
+				 size_t ops) {
+	  if (queueFilled || queueEmptied) {
+	    // Re-read the count under stateSync_, so that whichever thread
+	    // updates the toggle last sets it from the latest count.
+	    Lock_ lock(stateSync_);
+	    queueState_.setState(empty() ? ReadWriteToggle::WRITE_ONLY
+				         : ReadWriteToggle::READ_WRITE);
+	    lock.unlock();
+
+	    if (queueFilled) {
+	      notEmptyCv_.notifyAll();
+	    } else {
+	      emptyCv_.notifyAll();
+	    }
+	  }
+	  if ((highWaterMark_ != MAX_QUEUE_SIZE) &&
+	      (!(ops % SAMPLE_INTERVAL) || nearWaterMark_())) {
+	    sampleSize_();
+	  }
+	}
+
+	/** @brief True if the size could have crossed a water mark since
+	 *         it was last sampled
+	 */
+	bool nearWaterMark_() const {
+	  const size_t last = sampledSize_.load(std::memory_order_relaxed);
+	  const size_t margin = numShards_ * SAMPLE_INTERVAL;
+	  auto near = [last, margin](size_t mark) {
+	    return ((last > mark) ? last - mark : mark - last) <= margin;
+	  };
+	  return near(highWaterMark_) || near(lowWaterMark_);
+	}
+
+	void sampleSize_() {
+	  const size_t n = size();
+	  sampledSize_.store(n, std::memory_order_relaxed);
+	  if (n > highWaterMark_) {
+	    bool crossed = false;
+	    if (highWaterCrossed_.compare_exchange_strong(crossed, true)) {
+	      highWaterMarkCv_.notifyAll();
+	    }
+	  } else if (n <= lowWaterMark_) {
+	    bool crossed = true;
+	    if (highWaterCrossed_.compare_exchange_strong(crossed, false)) {
+	      lowWaterMarkCv_.notifyAll();
+	    }
+	  }
+	}
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,230 @@
+#include "SharedMutex.hpp"
+#include <pistis/concurrent/TimeUtils.hpp>
+#include <pistis/exceptions/NoSuchItem.hpp>
+#include <algorithm>
+#include <chrono>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+const uint64_t SharedMutex::WRITER;
+const uint64_t SharedMutex::WAITING;
+const uint64_t SharedMutex::READERS;
+
+SharedMutex::SharedMutex(LockPolicy policy, OnExecMode onExec):
+    state_(0), policy_(policy), onExec_(onExec), queue_(), observers_(),
+    free_(), sync_() {
+}
+
+size_t SharedMutex::numWaiters() const {
+  Lock_ lock(sync_);
+  return queue_.size();
+}
+
+bool SharedMutex::acquire(int fd) {
+  Lock_ lock(sync_);
+  auto i = observers_.find(fd);
+  if (i == observers_.end()) {
+    throw NoSuchItem("file descriptor", "lock observers", PISTIS_EX_HERE);
+  }
+  if (claim_(i->second.get())) {
+    recycle_(fd);
+    return true;
+  }
+  return false;
+}
+
+void SharedMutex::stopObserving(int fd) {
+  Lock_ lock(sync_);
+  auto i = observers_.find(fd);
+  if (i == observers_.end()) {
+    throw NoSuchItem("file descriptor", "lock observers", PISTIS_EX_HERE);
+  }
+  abandon_(i->second.get());
+  recycle_(fd);
+}
+
+bool SharedMutex::lockSlowly_(bool exclusive, int64_t timeout) {
+  Lock_ lock(sync_);
+  // Under HANDOFF, only take the lock directly if nobody is in line
+  if (((policy_ == LockPolicy::BARGING) || queue_.empty()) &&
+      tryTake_(exclusive)) {
+    return true;
+  } else if (!timeout) {
+    return false;
+  }
+
+  Waiter_* w = enqueue_(exclusive);
+  const int fd = w->signal.fd();
+  const auto deadline = std::chrono::system_clock::now() + toMs(timeout);
+
+  while (!claim_(w)) {
+    int64_t timeLeft = -1;
+    if (timeout >= 0) {
+      timeLeft = toMs(deadline - std::chrono::system_clock::now());
+      if (timeLeft <= 0) {
+	abandon_(w);
+	recycle_(fd);
+	return false;
+      }
+    }
+
+    lock.unlock();
+    w->signal.wait(timeLeft);
+    lock.lock();
+  }
+  recycle_(fd);
+  return true;
+}
+
+void SharedMutex::unlockSlowly_(bool exclusive) {
+  Lock_ lock(sync_);
+  release_(exclusive);
+}
+
+int SharedMutex::observe_(bool exclusive) {
+  Lock_ lock(sync_);
+  return enqueue_(exclusive)->signal.fd();
+}
+
+SharedMutex::Waiter_* SharedMutex::enqueue_(bool exclusive) {
+  std::unique_ptr<Waiter_> w;
+  if (free_.empty()) {
+    w.reset(new Waiter_(onExec_));
+  } else {
+    w = std::move(free_.back());
+    free_.pop_back();
+  }
+  w->exclusive = exclusive;
+
+  Waiter_* result = w.get();
+  observers_[result->signal.fd()] = std::move(w);
+  queue_.push_back(result);
+
+  // Send every later acquire and the last release down the slow path,
+  // then hand out the lock in case it was released before that
+  state_.fetch_or(WAITING, std::memory_order_acq_rel);
+  grant_();
+  return result;
+}
+
+bool SharedMutex::tryTake_(bool exclusive) {
+  uint64_t s = state_.load(std::memory_order_relaxed);
+  if (exclusive) {
+    while (!(s & (WRITER | READERS))) {
+      if (state_.compare_exchange_weak(s, s | WRITER,
+				       std::memory_order_acquire,
+				       std::memory_order_relaxed)) {
+	return true;
+      }
+    }
+  } else {
+    while (!(s & WRITER)) {
+      if (state_.compare_exchange_weak(s, s + 1,
+				       std::memory_order_acquire,
+				       std::memory_order_relaxed)) {
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool SharedMutex::claim_(Waiter_* w) {
+  if (policy_ == LockPolicy::HANDOFF) {
+    return w->granted;
+  } else if (!w->notified) {
+    return false;
+  }
+
+  w->notified = false;
+  w->signal.clear();
+  if (tryTake_(w->exclusive)) {
+    dequeue_(w);
+    // Readers behind us may be able to share the lock
+    grant_();
+    return true;
+  }
+  return false;
+}
+
+void SharedMutex::abandon_(Waiter_* w) {
+  if (w->granted) {
+    // Granted waiters have already left the queue
+    release_(w->exclusive);
+  } else {
+    dequeue_(w);
+    if (w->notified) {
+      grant_();
+    }
+  }
+}
+
+void SharedMutex::release_(bool exclusive) {
+  if (exclusive) {
+    state_.fetch_and(~WRITER, std::memory_order_release);
+  } else {
+    state_.fetch_sub(1, std::memory_order_release);
+  }
+  grant_();
+}
+
+void SharedMutex::grant_() {
+  if (policy_ == LockPolicy::HANDOFF) {
+    while (!queue_.empty()) {
+      Waiter_* w = queue_.front();
+      const uint64_t s = state_.load(std::memory_order_acquire);
+      if (w->exclusive ? (bool)(s & (WRITER | READERS)) : (bool)(s & WRITER)) {
+	break;
+      }
+
+      // Fast-path acquires fail while WAITING is set, so the lock cannot
+      // be taken out from under us
+      state_.fetch_add(w->exclusive ? WRITER : 1, std::memory_order_acquire);
+      queue_.pop_front();
+      w->granted = true;
+      w->signal.set();
+      if (w->exclusive) {
+	break;
+      }
+    }
+  } else {
+    for (Waiter_* w : queue_) {
+      const uint64_t s = state_.load(std::memory_order_acquire);
+      if (w->exclusive ? (bool)(s & (WRITER | READERS)) : (bool)(s & WRITER)) {
+	break;
+      }
+      w->notified = true;
+      w->signal.set();
+      if (w->exclusive) {
+	break;
+      }
+    }
+  }
+
+  if (queue_.empty()) {
+    state_.fetch_and(~WAITING, std::memory_order_release);
+  }
+}
+
+void SharedMutex::dequeue_(Waiter_* w) {
+  auto i = std::find(queue_.begin(), queue_.end(), w);
+  if (i != queue_.end()) {
+    queue_.erase(i);
+  }
+  if (queue_.empty()) {
+    state_.fetch_and(~WAITING, std::memory_order_release);
+  }
+}
+
+void SharedMutex::recycle_(int fd) {
+  auto i = observers_.find(fd);
+  std::unique_ptr<Waiter_> w(std::move(i->second));
+  observers_.erase(i);
+
+  w->signal.clear();
+  w->granted = false;
+  w->notified = false;
+  free_.push_back(std::move(w));
+}
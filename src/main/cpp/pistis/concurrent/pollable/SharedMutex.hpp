@@ -0,0 +1,214 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__SHAREDMUTEX_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__SHAREDMUTEX_HPP__
+
+#include <pistis/concurrent/pollable/Signal.hpp>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief What a pollable lock does with waiters when it is
+       *         released
+       */
+      enum class LockPolicy {
+	/** @brief Wake the first waiter, which then competes for the lock
+	 *         with any thread that tries to take it in the meantime
+	 */
+	BARGING,
+
+	/** @brief Grant the lock to the first waiter before waking it, so
+	 *         the lock goes to waiters in the order they arrived
+	 */
+	HANDOFF
+      };
+
+      /** @brief A reader-writer lock that event loops can wait for with
+       *         poll(), epoll() or select().
+       *
+       *  Taking and releasing an uncontended lock is one compare-and-swap
+       *  on an atomic word.  Once a thread has to wait, the word's
+       *  WAITING bit sends every other acquire and the last release
+       *  through a slow path that keeps a FIFO queue of waiters under an
+       *  internal mutex.
+       *
+       *  Besides the blocking lock(), lockShared() and their timed
+       *  versions, an event loop can ask to be told when it can have the
+       *  lock:
+       *  - observe() or observeShared() joins the queue and returns a
+       *    file descriptor that becomes readable when the lock is
+       *    available (BARGING) or has been granted (HANDOFF).
+       *  - acquire(fd) is called once the descriptor is readable.  It
+       *    returns true if the caller now holds the lock, which ends the
+       *    observation and returns the descriptor to the lock.  It
+       *    returns false if another thread got there first, and the
+       *    observer keeps waiting on the same descriptor.
+       *  - stopObserving(fd) abandons an observation that has not
+       *    acquired the lock, passing on a grant it had not yet claimed.
+       *
+       *  As with Condition, the observer must only poll the descriptor,
+       *  never read, write or close it.  Descriptors are recycled once
+       *  an observation ends.
+       */
+      class SharedMutex {
+      public:
+	SharedMutex(LockPolicy policy = LockPolicy::BARGING,
+		    OnExecMode onExec = OnExecMode::CLOSE);
+	SharedMutex(const SharedMutex&) = delete;
+
+	LockPolicy policy() const { return policy_; }
+
+	/** @brief Take the lock for exclusive use, waiting as long as
+	 *         necessary
+	 */
+	void lock() { lock(-1); }
+
+	/** @brief Take the lock for exclusive use, waiting up to
+	 *         @c timeout ms
+	 *
+	 *  @returns  True if the lock was taken, false on timeout
+	 */
+	bool lock(int64_t timeout) {
+	  uint64_t unlocked = 0;
+	  return state_.compare_exchange_strong(unlocked, WRITER,
+						std::memory_order_acquire,
+						std::memory_order_relaxed) ||
+	         lockSlowly_(true, timeout);
+	}
+
+	bool tryLock() { return lock(0); }
+	bool try_lock() { return tryLock(); }
+
+	void unlock() {
+	  uint64_t locked = WRITER;
+	  if (!state_.compare_exchange_strong(locked, 0,
+					      std::memory_order_release,
+					      std::memory_order_relaxed)) {
+	    unlockSlowly_(true);
+	  }
+	}
+
+	/** @brief Take the lock for shared use, waiting as long as
+	 *         necessary
+	 */
+	void lockShared() { lockShared(-1); }
+
+	/** @brief Take the lock for shared use, waiting up to @c timeout ms
+	 *
+	 *  @returns  True if the lock was taken, false on timeout
+	 */
+	bool lockShared(int64_t timeout) {
+	  uint64_t s = state_.load(std::memory_order_relaxed);
+	  while (!(s & (WRITER | WAITING))) {
+	    if (state_.compare_exchange_weak(s, s + 1,
+					     std::memory_order_acquire,
+					     std::memory_order_relaxed)) {
+	      return true;
+	    }
+	  }
+	  return lockSlowly_(false, timeout);
+	}
+
+	bool tryLockShared() { return lockShared(0); }
+	void lock_shared() { lockShared(); }
+	bool try_lock_shared() { return tryLockShared(); }
+
+	void unlockShared() {
+	  uint64_t s = state_.load(std::memory_order_relaxed);
+	  // The last reader out wakes the waiters
+	  while (!((s & WAITING) && ((s & READERS) == 1))) {
+	    if (state_.compare_exchange_weak(s, s - 1,
+					     std::memory_order_release,
+					     std::memory_order_relaxed)) {
+	      return;
+	    }
+	  }
+	  unlockSlowly_(false);
+	}
+
+	void unlock_shared() { unlockShared(); }
+
+	/** @brief True if a thread holds the lock for exclusive use */
+	bool lockedExclusive() const {
+	  return (bool)(state_.load(std::memory_order_relaxed) & WRITER);
+	}
+
+	/** @brief Number of threads holding the lock for shared use */
+	size_t numReaders() const {
+	  return (size_t)(state_.load(std::memory_order_relaxed) & READERS);
+	}
+
+	/** @brief Number of threads and observers waiting for the lock */
+	size_t numWaiters() const;
+
+	/** @brief Wait for exclusive use of the lock through a file
+	 *         descriptor
+	 */
+	int observe() { return observe_(true); }
+
+	/** @brief Wait for shared use of the lock through a file descriptor */
+	int observeShared() { return observe_(false); }
+
+	/** @brief Try to take the lock an observer is waiting for.
+	 *
+	 *  @returns  True if the caller now holds the lock and the
+	 *            observation has ended, false if it must keep waiting
+	 */
+	bool acquire(int fd);
+
+	/** @brief Abandon an observation that has not acquired the lock */
+	void stopObserving(int fd);
+
+	SharedMutex& operator=(const SharedMutex&) = delete;
+
+      private:
+	static const uint64_t WRITER = (uint64_t)1 << 63;
+	static const uint64_t WAITING = (uint64_t)1 << 62;
+	static const uint64_t READERS = WAITING - 1;
+
+	struct Waiter_ {
+	  Signal signal;
+	  bool exclusive;
+	  bool granted;   ///< HANDOFF: the lock is already ours
+	  bool notified;  ///< BARGING: the lock was free when we were woken
+
+	  Waiter_(OnExecMode onExec):
+	      signal(onExec), exclusive(false), granted(false),
+	      notified(false) {
+	  }
+	};
+
+	typedef std::unique_lock<std::mutex> Lock_;
+
+	std::atomic<uint64_t> state_;
+	LockPolicy policy_;
+	OnExecMode onExec_;
+	std::deque<Waiter_*> queue_;
+	std::unordered_map<int, std::unique_ptr<Waiter_> > observers_;
+	std::vector< std::unique_ptr<Waiter_> > free_;
+	mutable std::mutex sync_;
+
+	bool lockSlowly_(bool exclusive, int64_t timeout);
+	void unlockSlowly_(bool exclusive);
+	int observe_(bool exclusive);
+
+	Waiter_* enqueue_(bool exclusive);
+	bool tryTake_(bool exclusive);
+	bool claim_(Waiter_* w);
+	void abandon_(Waiter_* w);
+	void release_(bool exclusive);
+	void grant_();
+	void dequeue_(Waiter_* w);
+	void recycle_(int fd);
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,213 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__SHAREDQUEUE_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__SHAREDQUEUE_HPP__
+
+#include <pistis/concurrent/pollable/SharedQueueSegment.hpp>
+#include <chrono>
+#include <new>
+#include <type_traits>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A bounded pollable queue that can be shared between
+       *         processes.
+       *
+       *  Items live in a ring in shared memory (see SharedQueueSegment),
+       *  so a put in one process and a get in another copy the item
+       *  into and out of the ring and nothing else -- no serialization
+       *  and no trip through the kernel.  putInPlace() and getInPlace()
+       *  skip even those copies by building and reading the item where
+       *  it lies in the ring.  Items must therefore be
+       *  trivially copyable and must not contain pointers that are
+       *  only meaningful in one process.
+       *
+       *  queueStateFd() behaves like Queue::queueStateFd() in every
+       *  attached process: it is readable while the queue is not empty
+       *  and writable while it is not full.  Water marks and the
+       *  observe()/ack() events of Queue are not supported.
+       *
+       *  To share a queue, create it in one process and either send() it
+       *  over a unix socket to a process that calls receive(), or create
+       *  it with OnExecMode::KEEP and pass memoryFd(), queueStateFd() and
+       *  queueControlFd() to a child, which calls attach().
+       */
+      template <typename Item>
+      class SharedQueue {
+	static_assert(std::is_trivially_copyable<Item>::value,
+		      "SharedQueue items must be trivially copyable");
+	static_assert(alignof(Item) <= 64,
+		      "SharedQueue items must be aligned to at most 64 bytes");
+
+      public:
+	typedef Item ItemType;
+
+      public:
+	/** @brief Create a new queue that holds up to @c maxSize items */
+	explicit SharedQueue(size_t maxSize,
+			     OnExecMode onExec = OnExecMode::CLOSE):
+	    segment_(sizeof(Item), maxSize, onExec) {
+	}
+
+	SharedQueue(const SharedQueue&) = delete;
+	SharedQueue(SharedQueue&&) = default;
+
+	/** @brief Attach to a queue created by another process, taking
+	 *         ownership of its descriptors
+	 */
+	static SharedQueue attach(int memoryFd, int queueStateFd,
+				  int queueControlFd) {
+	  return SharedQueue(
+	      SharedQueueSegment(memoryFd, queueStateFd, queueControlFd,
+				 sizeof(Item))
+	  );
+	}
+
+	/** @brief Receive a queue sent with send() from a unix socket */
+	static SharedQueue receive(int socket,
+				   OnExecMode onExec = OnExecMode::CLOSE) {
+	  return SharedQueue(
+	      SharedQueueSegment::receive(socket, sizeof(Item), onExec)
+	  );
+	}
+
+	/** @brief Send this queue to another process over a unix socket */
+	void send(int socket) const { segment_.send(socket); }
+
+	int memoryFd() const { return segment_.memoryFd(); }
+	int queueStateFd() const { return segment_.stateFd(); }
+
+	/** @brief Descriptor another process needs, with memoryFd() and
+	 *         queueStateFd(), to attach() to this queue
+	 */
+	int queueControlFd() const { return segment_.controlFd(); }
+
+	bool empty() const { return !size(); }
+	size_t size() const { return segment_.size(); }
+	size_t maxSize() const { return segment_.capacity(); }
+
+	Item get() {
+	  Item item;
+	  get(item, -1);
+	  return item;
+	}
+
+	/** @brief Take the oldest item, waiting up to @c timeout ms for
+	 *         one (-1 = forever)
+	 *
+	 *  @returns  True if an item was retrieved, false on timeout
+	 */
+	bool get(Item& result, int64_t timeout = 0) {
+	  return retry_(timeout, [this, &result]() {
+	      return segment_.tryGet(&result);
+	    }, [this](int64_t t) { return segment_.waitForItems(t); });
+	}
+
+	/** @brief Move up to @c maxItems items onto the end of @c buffer,
+	 *         which may be any container with push_back()
+	 */
+	template <typename Container>
+	size_t drainInto(Container& buffer, size_t maxItems = (size_t)-1) {
+	  Item item;
+	  size_t n = 0;
+	  while ((n < maxItems) && segment_.tryGet(&item)) {
+	    buffer.push_back(item);
+	    ++n;
+	  }
+	  return n;
+	}
+
+	/** @brief Put @c item at the end of the queue, waiting up to
+	 *         @c timeout ms for room (-1 = forever)
+	 *
+	 *  @returns  True if the item was put, false on timeout
+	 */
+	bool put(const Item& item, int64_t timeout = -1) {
+	  return retry_(timeout, [this, &item]() {
+	      return segment_.tryPut(&item);
+	    }, [this](int64_t t) { return segment_.waitForRoom(t); });
+	}
+
+	/** @brief Call @c fill with a default-initialized item in the
+	 *         ring's next free slot, waiting up to @c timeout ms for
+	 *         room (-1 = forever), then publish it.
+	 *
+	 *  @c fill runs with the queue's mutex held.  If it throws,
+	 *  nothing is put.
+	 *
+	 *  @returns  True if the item was put, false on timeout
+	 */
+	template <typename Fill>
+	bool putInPlace(Fill fill, int64_t timeout = -1) {
+	  return retry_(timeout, [this, &fill]() {
+	      return segment_.tryPutInPlace([&fill](void* slot) {
+		  fill(*new(slot) Item);
+	      });
+	    }, [this](int64_t t) { return segment_.waitForRoom(t); });
+	}
+
+	/** @brief Call @c consume with the oldest item where it lies in
+	 *         the ring, waiting up to @c timeout ms for one
+	 *         (-1 = forever), then release its slot.
+	 *
+	 *  @c consume runs with the queue's mutex held.  If it throws, the
+	 *  item stays in the queue.
+	 *
+	 *  @returns  True if an item was consumed, false on timeout
+	 */
+	template <typename Consume>
+	bool getInPlace(Consume consume, int64_t timeout = 0) {
+	  return retry_(timeout, [this, &consume]() {
+	      return segment_.tryGetInPlace([&consume](const void* slot) {
+		  consume(*static_cast<const Item*>(slot));
+	      });
+	    }, [this](int64_t t) { return segment_.waitForItems(t); });
+	}
+
+	SharedQueue& operator=(const SharedQueue&) = delete;
+	SharedQueue& operator=(SharedQueue&&) = default;
+
+      private:
+	SharedQueueSegment segment_;
+
+	explicit SharedQueue(SharedQueueSegment&& segment):
+	    segment_(std::move(segment)) {
+	}
+
+	template <typename Attempt, typename Wait>
+	static bool retry_(int64_t timeout, Attempt attempt, Wait wait) {
+	  if (attempt()) {
+	    return true;
+	  } else if (!timeout) {
+	    return false;
+	  }
+
+	  auto deadline = std::chrono::steady_clock::now() +
+	                  std::chrono::milliseconds(timeout);
+	  while (true) {
+	    int64_t remaining = -1;
+	    if (timeout >= 0) {
+	      remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+		  deadline - std::chrono::steady_clock::now()
+	      ).count();
+	      if (remaining < 0) {
+		remaining = 0;
+	      }
+	    }
+	    if (!wait(remaining)) {
+	      return attempt();
+	    }
+	    if (attempt()) {
+	      return true;
+	    }
+	    if (!remaining && (timeout >= 0)) {
+	      return false;
+	    }
+	  }
+	}
+      };
+
+    }
+  }
+}
+#endif
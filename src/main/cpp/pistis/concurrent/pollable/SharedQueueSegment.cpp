@@ -0,0 +1,370 @@
+#include "SharedQueueSegment.hpp"
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <sstream>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+struct SharedQueueSegment::Header_ {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t toggleState;
+  uint64_t itemSize;
+  uint64_t capacity;
+  uint64_t head;   ///< Number of items ever taken from the ring
+  uint64_t tail;   ///< Number of items ever put into the ring
+  pthread_mutex_t sync;
+};
+
+namespace {
+  static const uint64_t SEGMENT_MAGIC = 0x5053485251554555ULL;
+  static const uint32_t SEGMENT_VERSION = 1;
+  static const size_t SLOT_ALIGNMENT = 64;
+
+  // receive() makes room for more descriptors than a segment has, so
+  // that it can close any extra ones a sender includes
+  static const size_t MAX_RECEIVED_FDS = 16;
+
+  static size_t roundUp(size_t n, size_t alignment) {
+    return (n + alignment - 1) / alignment * alignment;
+  }
+
+  static void checkSystemCall(int rc, const char* what) {
+    if (rc < 0) {
+      std::ostringstream msg;
+      msg << what << ": #ERR#";
+      throw SystemError::fromSystemCode(msg.str(), errno, PISTIS_EX_HERE);
+    }
+  }
+
+  static int createMemoryFd(OnExecMode onExec) {
+    const unsigned flags = MFD_ALLOW_SEALING |
+                           (onExec == OnExecMode::CLOSE ? MFD_CLOEXEC : 0);
+    const int fd = ::memfd_create("pistis-shared-queue", flags);
+    checkSystemCall(fd, "Failed to create memfd");
+    return fd;
+  }
+
+  /** @brief Locks a segment's robust mutex, recovering it if its
+   *         previous owner died
+   */
+  class SegmentLock {
+  public:
+    SegmentLock(pthread_mutex_t* sync): sync_(sync) {
+      const int rc = ::pthread_mutex_lock(sync_);
+      if (rc == EOWNERDEAD) {
+	::pthread_mutex_consistent(sync_);
+      } else if (rc) {
+	throw SystemError::fromSystemCode(
+	    "Failed to lock shared queue segment: #ERR#", rc, PISTIS_EX_HERE
+	);
+      }
+    }
+    SegmentLock(const SegmentLock&) = delete;
+    ~SegmentLock() { ::pthread_mutex_unlock(sync_); }
+
+    SegmentLock& operator=(const SegmentLock&) = delete;
+
+  private:
+    pthread_mutex_t* sync_;
+  };
+
+  static bool waitForState(int fd, EpollEventType event, int64_t timeout) {
+    EpollSet epollSet(fd, event);
+    return epollSet.wait(timeout);
+  }
+}
+
+SharedQueueSegment::SharedQueueSegment(size_t itemSize, size_t capacity,
+				       OnExecMode onExec):
+    memoryFd_(-1), mappingSize_(0), header_(nullptr), slots_(nullptr),
+    itemSize_(itemSize), capacity_(capacity),
+    toggle_(onExec, BlockingMode::BLOCK, ReadWriteToggle::WRITE_ONLY) {
+  if (!itemSize) {
+    throw IllegalValueError("Item size must be positive", PISTIS_EX_HERE);
+  }
+  if (!capacity) {
+    throw IllegalValueError("Capacity must be positive", PISTIS_EX_HERE);
+  }
+
+  memoryFd_ = createMemoryFd(onExec);
+  mappingSize_ = roundUp(sizeof(Header_), SLOT_ALIGNMENT) +
+                 itemSize * capacity;
+  try {
+    checkSystemCall(::ftruncate(memoryFd_, mappingSize_),
+		    "Failed to size memfd");
+
+    // Seal the size so another process cannot shrink the segment out
+    // from under this one's mapping
+    checkSystemCall(::fcntl(memoryFd_, F_ADD_SEALS,
+			    F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL),
+		    "Failed to seal memfd");
+    map_();
+  } catch(...) {
+    release_();
+    throw;
+  }
+
+  header_->magic = SEGMENT_MAGIC;
+  header_->version = SEGMENT_VERSION;
+  header_->itemSize = itemSize;
+  header_->capacity = capacity;
+  header_->head = 0;
+  header_->tail = 0;
+
+  pthread_mutexattr_t attributes;
+  ::pthread_mutexattr_init(&attributes);
+  ::pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+  ::pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+  ::pthread_mutex_init(&header_->sync, &attributes);
+  ::pthread_mutexattr_destroy(&attributes);
+
+  header_->toggleState = (uint32_t)toggle_.state();
+}
+
+SharedQueueSegment::SharedQueueSegment(int memoryFd, int stateFd,
+				       int controlFd, size_t itemSize):
+    memoryFd_(memoryFd), mappingSize_(0), header_(nullptr), slots_(nullptr),
+    itemSize_(itemSize), capacity_(0),
+    toggle_(stateFd, controlFd, ReadWriteToggle::READ_WRITE) {
+  try {
+    struct stat info;
+    checkSystemCall(::fstat(memoryFd_, &info), "Failed to stat memfd");
+    mappingSize_ = (size_t)info.st_size;
+    if (mappingSize_ < sizeof(Header_)) {
+      throw IllegalValueError("File descriptor is not a shared queue segment",
+			      PISTIS_EX_HERE);
+    }
+    map_();
+
+    if ((header_->magic != SEGMENT_MAGIC) ||
+	(header_->version != SEGMENT_VERSION)) {
+      throw IllegalValueError("File descriptor is not a shared queue segment",
+			      PISTIS_EX_HERE);
+    }
+    if (header_->itemSize != itemSize) {
+      std::ostringstream msg;
+      msg << "Shared queue segment holds items of " << header_->itemSize
+	  << " bytes, not " << itemSize;
+      throw IllegalValueError(msg.str(), PISTIS_EX_HERE);
+    }
+    capacity_ = header_->capacity;
+    if (mappingSize_ < roundUp(sizeof(Header_), SLOT_ALIGNMENT) +
+	                  itemSize_ * capacity_) {
+      throw IllegalValueError("Shared queue segment is truncated",
+			      PISTIS_EX_HERE);
+    }
+  } catch(...) {
+    release_();
+    throw;
+  }
+}
+
+SharedQueueSegment::SharedQueueSegment(SharedQueueSegment&& other):
+    memoryFd_(other.memoryFd_), mappingSize_(other.mappingSize_),
+    header_(other.header_), slots_(other.slots_), itemSize_(other.itemSize_),
+    capacity_(other.capacity_), toggle_(std::move(other.toggle_)) {
+  other.memoryFd_ = -1;
+  other.header_ = nullptr;
+  other.slots_ = nullptr;
+}
+
+SharedQueueSegment::~SharedQueueSegment() {
+  release_();
+}
+
+SharedQueueSegment& SharedQueueSegment::operator=(SharedQueueSegment&& other) {
+  if (this != &other) {
+    release_();
+    memoryFd_ = other.memoryFd_;
+    mappingSize_ = other.mappingSize_;
+    header_ = other.header_;
+    slots_ = other.slots_;
+    itemSize_ = other.itemSize_;
+    capacity_ = other.capacity_;
+    toggle_ = std::move(other.toggle_);
+    other.memoryFd_ = -1;
+    other.header_ = nullptr;
+    other.slots_ = nullptr;
+  }
+  return *this;
+}
+
+size_t SharedQueueSegment::size() const {
+  SegmentLock lock(&header_->sync);
+  return header_->tail - header_->head;
+}
+
+bool SharedQueueSegment::tryPut(const void* item) {
+  const size_t itemSize = itemSize_;
+  return tryPutInPlace([item, itemSize](void* slot) {
+      ::memcpy(slot, item, itemSize);
+  });
+}
+
+bool SharedQueueSegment::tryGet(void* item) {
+  const size_t itemSize = itemSize_;
+  return tryGetInPlace([item, itemSize](const void* slot) {
+      ::memcpy(item, slot, itemSize);
+  });
+}
+
+bool SharedQueueSegment::tryPutInPlace(
+    const std::function<void (void*)>& fill
+) {
+  SegmentLock lock(&header_->sync);
+  const uint64_t size = header_->tail - header_->head;
+  if (size >= capacity_) {
+    return false;
+  }
+  fill(slots_ + (header_->tail % capacity_) * itemSize_);
+  ++header_->tail;
+  updateState_(size + 1);
+  return true;
+}
+
+bool SharedQueueSegment::tryGetInPlace(
+    const std::function<void (const void*)>& consume
+) {
+  SegmentLock lock(&header_->sync);
+  const uint64_t size = header_->tail - header_->head;
+  if (!size) {
+    return false;
+  }
+  consume(slots_ + (header_->head % capacity_) * itemSize_);
+  ++header_->head;
+  updateState_(size - 1);
+  return true;
+}
+
+bool SharedQueueSegment::waitForItems(int64_t timeout) const {
+  return waitForState(toggle_.fd(), EpollEventType::READ, timeout);
+}
+
+bool SharedQueueSegment::waitForRoom(int64_t timeout) const {
+  return waitForState(toggle_.fd(), EpollEventType::WRITE, timeout);
+}
+
+void SharedQueueSegment::send(int socket) const {
+  const int fds[] = { memoryFd_, toggle_.fd(), toggle_.controlFd() };
+  char payload = 'Q';
+  struct iovec iov = { &payload, 1 };
+  union {
+    char buffer[CMSG_SPACE(sizeof(fds))];
+    struct cmsghdr align;
+  } control;
+  ::memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  ::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+  ::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  ssize_t rc;
+  do {
+    rc = ::sendmsg(socket, &msg, MSG_NOSIGNAL);
+  } while ((rc < 0) && (errno == EINTR));
+  checkSystemCall((int)rc, "Failed to send shared queue segment");
+}
+
+SharedQueueSegment SharedQueueSegment::receive(int socket, size_t itemSize,
+					       OnExecMode onExec) {
+  char payload;
+  struct iovec iov = { &payload, 1 };
+  union {
+    char buffer[CMSG_SPACE(sizeof(int) * MAX_RECEIVED_FDS)];
+    struct cmsghdr align;
+  } control;
+
+  struct msghdr msg;
+  ::memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buffer;
+  msg.msg_controllen = sizeof(control.buffer);
+
+  const int flags = onExec == OnExecMode::CLOSE ? MSG_CMSG_CLOEXEC : 0;
+  ssize_t rc;
+  do {
+    rc = ::recvmsg(socket, &msg, flags);
+  } while ((rc < 0) && (errno == EINTR));
+  checkSystemCall((int)rc, "Failed to receive shared queue segment");
+
+  // Collect every descriptor received, so that none leak if the
+  // message is not a segment
+  std::vector<int> fds;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if ((cmsg->cmsg_level == SOL_SOCKET) &&
+	(cmsg->cmsg_type == SCM_RIGHTS)) {
+      const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const size_t start = fds.size();
+      fds.resize(start + n);
+      ::memcpy(fds.data() + start, CMSG_DATA(cmsg), n * sizeof(int));
+    }
+  }
+
+  if ((fds.size() == 3) && !(msg.msg_flags & MSG_CTRUNC)) {
+    return SharedQueueSegment(fds[0], fds[1], fds[2], itemSize);
+  }
+  for (int fd : fds) {
+    ::close(fd);
+  }
+  throw IllegalValueError("Message did not carry a shared queue segment",
+			  PISTIS_EX_HERE);
+}
+
+void SharedQueueSegment::map_() {
+  void* p = ::mmap(nullptr, mappingSize_, PROT_READ | PROT_WRITE,
+		   MAP_SHARED, memoryFd_, 0);
+  if (p == MAP_FAILED) {
+    throw SystemError::fromSystemCode("Failed to map memfd: #ERR#", errno,
+				      PISTIS_EX_HERE);
+  }
+  header_ = static_cast<Header_*>(p);
+  slots_ = static_cast<char*>(p) + roundUp(sizeof(Header_), SLOT_ALIGNMENT);
+}
+
+void SharedQueueSegment::release_() {
+  if (header_) {
+    ::munmap(header_, mappingSize_);
+    header_ = nullptr;
+    slots_ = nullptr;
+  }
+  if (memoryFd_ >= 0) {
+    ::close(memoryFd_);
+    memoryFd_ = -1;
+  }
+}
+
+void SharedQueueSegment::updateState_(uint64_t size) {
+  const ReadWriteToggle::State newState =
+      !size ? ReadWriteToggle::WRITE_ONLY
+            : (size >= capacity_) ? ReadWriteToggle::READ_ONLY
+                                  : ReadWriteToggle::READ_WRITE;
+
+  // Another process may have changed the toggle since this one last did
+  toggle_.assumeState((ReadWriteToggle::State)header_->toggleState);
+  toggle_.setState(newState);
+  header_->toggleState = (uint32_t)newState;
+}
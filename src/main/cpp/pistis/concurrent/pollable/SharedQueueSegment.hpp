@@ -0,0 +1,141 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__SHAREDQUEUESEGMENT_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__SHAREDQUEUESEGMENT_HPP__
+
+#include <pistis/concurrent/OnExecMode.hpp>
+#include <pistis/concurrent/pollable/ReadWriteToggle.hpp>
+#include <functional>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief The shared memory and state descriptor behind a
+       *         SharedQueue.
+       *
+       *  A segment is a ring of fixed-size slots in a sealed memfd
+       *  mapping.  A header at the start of the mapping holds the ring's
+       *  indices, a robust process-shared mutex and the state of a
+       *  ReadWriteToggle whose socket pair every process attached to the
+       *  segment holds a copy of.  The toggle is readable while the ring
+       *  is not empty and writable while it is not full, exactly like
+       *  Queue::queueStateFd().
+       *
+       *  Segments move between processes by passing their three file
+       *  descriptors (memory, toggle and toggle control), either over a
+       *  unix socket with send() and receive() or by inheritance across
+       *  fork() and exec() when created with OnExecMode::KEEP.
+       *
+       *  If a process dies while holding the segment's mutex, the next
+       *  process to lock it recovers the mutex.  Items are published by
+       *  advancing an index after they are copied, so the ring itself
+       *  stays consistent, but the state descriptor may be briefly out
+       *  of date until the next put or get.
+       *
+       *  Most applications should use SharedQueue instead.
+       */
+      class SharedQueueSegment {
+      public:
+	/** @brief Create a segment with room for @c capacity items of
+	 *         @c itemSize bytes each
+	 */
+	SharedQueueSegment(size_t itemSize, size_t capacity,
+			   OnExecMode onExec = OnExecMode::CLOSE);
+
+	/** @brief Attach to an existing segment, taking ownership of
+	 *         @c memoryFd and the state toggle's @c stateFd and
+	 *         @c controlFd
+	 *
+	 *  @throws pistis::exceptions::IllegalValueError if @c memoryFd
+	 *          does not hold a segment of @c itemSize byte items
+	 */
+	SharedQueueSegment(int memoryFd, int stateFd, int controlFd,
+			   size_t itemSize);
+
+	SharedQueueSegment(const SharedQueueSegment&) = delete;
+	SharedQueueSegment(SharedQueueSegment&& other);
+	~SharedQueueSegment();
+
+	int memoryFd() const { return memoryFd_; }
+	int stateFd() const { return toggle_.fd(); }
+	int controlFd() const { return toggle_.controlFd(); }
+	size_t itemSize() const { return itemSize_; }
+	size_t capacity() const { return capacity_; }
+	size_t size() const;
+
+	/** @brief Copy @c itemSize() bytes from @c item into the ring if
+	 *         it is not full
+	 */
+	bool tryPut(const void* item);
+
+	/** @brief Copy the oldest item into @c item if the ring is not
+	 *         empty
+	 */
+	bool tryGet(void* item);
+
+	/** @brief If the ring is not full, call @c fill with the next free
+	 *         slot, then publish the slot.
+	 *
+	 *  @c fill writes the item straight into shared memory instead of
+	 *  into a buffer that tryPut() copies.  It runs with the segment's
+	 *  mutex held, so it should be short.  If it throws, nothing is
+	 *  put.
+	 */
+	bool tryPutInPlace(const std::function<void (void*)>& fill);
+
+	/** @brief If the ring is not empty, call @c consume with the
+	 *         oldest item's slot, then release the slot.
+	 *
+	 *  @c consume reads the item where it lies in shared memory.  It
+	 *  runs with the segment's mutex held, so it should be short.  If
+	 *  it throws, the item stays in the ring.
+	 */
+	bool tryGetInPlace(const std::function<void (const void*)>& consume);
+
+	/** @brief Wait up to @c timeout ms (-1 = forever) for the ring to
+	 *         be not empty.  Another process may empty it again before
+	 *         the caller calls tryGet().
+	 */
+	bool waitForItems(int64_t timeout) const;
+
+	/** @brief Wait up to @c timeout ms (-1 = forever) for the ring to
+	 *         be not full
+	 */
+	bool waitForRoom(int64_t timeout) const;
+
+	/** @brief Send the segment's descriptors over the unix socket
+	 *         @c socket with SCM_RIGHTS
+	 */
+	void send(int socket) const;
+
+	/** @brief Receive a segment sent with send() from the unix socket
+	 *         @c socket
+	 */
+	static SharedQueueSegment receive(int socket, size_t itemSize,
+					  OnExecMode onExec
+					      = OnExecMode::CLOSE);
+
+	SharedQueueSegment& operator=(const SharedQueueSegment&) = delete;
+	SharedQueueSegment& operator=(SharedQueueSegment&& other);
+
+      private:
+	struct Header_;
+
+	int memoryFd_;
+	size_t mappingSize_;
+	Header_* header_;
+	char* slots_;
+	size_t itemSize_;
+	size_t capacity_;
+	ReadWriteToggle toggle_;
+
+	void map_();
+	void release_();
+	void updateState_(uint64_t size);
+      };
+
+    }
+  }
+}
+#endif
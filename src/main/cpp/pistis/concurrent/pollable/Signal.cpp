@@ -0,0 +1,63 @@
+#include "Signal.hpp"
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  inline int createEventFd(OnExecMode onExec) {
+    int fd = ::eventfd(0, EFD_NONBLOCK |
+		            (onExec == OnExecMode::CLOSE ? EFD_CLOEXEC : 0));
+    if (fd < 0) {
+      throw SystemError::fromSystemCode("Failed to create event fd: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+    return fd;
+  }
+}
+
+Signal::Signal(OnExecMode onExec): fd_(createEventFd(onExec)), set_(false) {
+}
+
+Signal::~Signal() {
+  ::close(fd_);
+}
+
+void Signal::set() {
+  if (!set_.exchange(true, std::memory_order_acq_rel)) {
+    const uint64_t one = 1;
+    if (::write(fd_, &one, sizeof(one)) < 0) {
+      throw SystemError::fromSystemCode("Write to eventfd failed: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+  }
+}
+
+void Signal::clear() {
+  if (set_.exchange(false, std::memory_order_acq_rel)) {
+    uint64_t value;
+    if ((::read(fd_, &value, sizeof(value)) < 0) && (errno != EAGAIN)) {
+      throw SystemError::fromSystemCode("Read from eventfd failed: #ERR#",
+					errno, PISTIS_EX_HERE);
+    }
+  }
+}
+
+bool Signal::wait(int64_t timeout) const {
+  if (isSet()) {
+    return true;
+  }
+  EpollSet pollSet(fd_, EpollEventType::READ);
+  if (timeout < 0) {
+    while (!isSet()) {
+      pollSet.wait(-1);
+    }
+    return true;
+  }
+  pollSet.wait(timeout);
+  return isSet();
+}
@@ -0,0 +1,55 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__SIGNAL_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__SIGNAL_HPP__
+
+#include <pistis/concurrent/OnExecMode.hpp>
+#include <atomic>
+#include <stdint.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief A flag whose file descriptor is readable while it is set.
+       *
+       *  set() and clear() only make a system call when they change the
+       *  flag, so setting a set Signal or clearing a clear one is a
+       *  single atomic operation.  Calls to set() and clear() must not
+       *  race with each other; any number of threads may wait.  Latch,
+       *  Barrier and WaitGroup use Signal to wake their waiters exactly
+       *  once per phase.
+       */
+      class Signal {
+      public:
+	Signal(OnExecMode onExec = OnExecMode::CLOSE);
+	Signal(const Signal&) = delete;
+	~Signal();
+
+	/** @brief Readable while the signal is set */
+	int fd() const { return fd_; }
+
+	bool isSet() const { return set_.load(std::memory_order_acquire); }
+
+	/** @brief Set the signal, making fd() readable */
+	void set();
+
+	/** @brief Clear the signal, so fd() is no longer readable */
+	void clear();
+
+	/** @brief Wait until the signal is set or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @returns  True if the signal is set, false on timeout
+	 */
+	bool wait(int64_t timeout = -1) const;
+
+	Signal& operator=(const Signal&) = delete;
+
+      private:
+	int fd_;
+	std::atomic<bool> set_;
+      };
+
+    }
+  }
+}
+#endif
@@ -0,0 +1,44 @@
+#include "WaitGroup.hpp"
+#include <pistis/exceptions/IllegalStateError.hpp>
+
+using namespace pistis::exceptions;
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef std::unique_lock<std::mutex> Lock;
+}
+
+WaitGroup::WaitGroup(OnExecMode onExec): count_(0), idle_(onExec), sync_() {
+  idle_.set();
+}
+
+void WaitGroup::add(size_t n) {
+  if (n && !count_.fetch_add(n, std::memory_order_acq_rel)) {
+    // The count may have gone back to zero since, so check it again
+    // with the lock held
+    Lock lock(sync_);
+    if (count_.load(std::memory_order_acquire)) {
+      idle_.clear();
+    }
+  }
+}
+
+void WaitGroup::done() {
+  size_t current = count_.load(std::memory_order_relaxed);
+  do {
+    if (!current) {
+      throw IllegalStateError("WaitGroup::done() called with no tasks "
+			      "outstanding", PISTIS_EX_HERE);
+    }
+  } while (!count_.compare_exchange_weak(current, current - 1,
+					 std::memory_order_acq_rel,
+					 std::memory_order_relaxed));
+
+  if (current == 1) {
+    Lock lock(sync_);
+    if (!count_.load(std::memory_order_acquire)) {
+      idle_.set();
+    }
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef __PISTIS__CONCURRENT__POLLABLE__WAITGROUP_HPP__
+#define __PISTIS__CONCURRENT__POLLABLE__WAITGROUP_HPP__
+
+#include <pistis/concurrent/pollable/Signal.hpp>
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+
+namespace pistis {
+  namespace concurrent {
+    namespace pollable {
+
+      /** @brief Waits for a changing number of tasks to finish.
+       *
+       *  add() raises the count of outstanding tasks and done() lowers
+       *  it.  fd() is readable whenever the count is zero.  Unlike
+       *  Latch, the count may go back up from zero at any time, which
+       *  starts a new phase on the same file descriptor.  Only the
+       *  transitions to and from zero make system calls; every other
+       *  add() and done() is a single atomic operation.
+       *
+       *  As with Go's sync.WaitGroup, a waiter that does not wake up
+       *  before add() starts the next phase waits for that phase too.
+       */
+      class WaitGroup {
+      public:
+	WaitGroup(OnExecMode onExec = OnExecMode::CLOSE);
+	WaitGroup(const WaitGroup&) = delete;
+
+	/** @brief Readable while the count is zero */
+	int fd() const { return idle_.fd(); }
+
+	/** @brief Number of outstanding tasks */
+	size_t count() const { return count_.load(std::memory_order_acquire); }
+
+	/** @brief Add @c n outstanding tasks */
+	void add(size_t n = 1);
+
+	/** @brief Mark one outstanding task finished
+	 *
+	 *  @throws IllegalStateError if no tasks are outstanding
+	 */
+	void done();
+
+	/** @brief Wait until the count is zero or the timeout (in ms)
+	 *         expires.
+	 *
+	 *  @returns  True if the count is zero, false on timeout
+	 */
+	bool wait(int64_t timeout = -1) const { return idle_.wait(timeout); }
+
+	WaitGroup& operator=(const WaitGroup&) = delete;
+
+      private:
+	std::atomic<size_t> count_;
+	Signal idle_;
+	std::mutex sync_;  ///< Orders the signal changes at zero
+      };
+
+    }
+  }
+}
+#endif
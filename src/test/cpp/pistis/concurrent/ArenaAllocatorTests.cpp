@@ -0,0 +1,124 @@
+#include <pistis/concurrent/ArenaAllocator.hpp>
+#include <pistis/concurrent/pollable/PriorityQueue.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+TEST(ArenaAllocatorTests, ArenaReusesFreedBlocks) {
+  Arena arena(1024);
+
+  void* a = arena.allocate(100);
+  void* b = arena.allocate(100);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(0, (uintptr_t)a % alignof(std::max_align_t));
+  EXPECT_EQ(0, (uintptr_t)b % alignof(std::max_align_t));
+  EXPECT_EQ(1024, arena.bytesReserved());
+
+  arena.deallocate(a, 100);
+  EXPECT_EQ(a, arena.allocate(100));
+
+  // A block of a different size class is not reused
+  arena.deallocate(b, 100);
+  EXPECT_NE(b, arena.allocate(200));
+  EXPECT_EQ(b, arena.allocate(100));
+}
+
+TEST(ArenaAllocatorTests, ArenaOversizedRequests) {
+  Arena arena(1024);
+
+  arena.allocate(16);
+  void* big = arena.allocate(4096);
+  EXPECT_EQ(1024 + 4096, arena.bytesReserved());
+
+  // The rest of the first chunk is still available
+  arena.allocate(512);
+  EXPECT_EQ(1024 + 4096, arena.bytesReserved());
+
+  arena.deallocate(big, 4096);
+  EXPECT_EQ(big, arena.allocate(4096));
+}
+
+TEST(ArenaAllocatorTests, RebindSharesArena) {
+  ArenaAllocator<int> a;
+  ArenaAllocator<std::string> b(a);
+  ArenaAllocator<int> c;
+
+  EXPECT_EQ(a.arena(), b.arena());
+  EXPECT_TRUE(a == b);
+  EXPECT_TRUE(a != c);
+}
+
+TEST(ArenaAllocatorTests, WithQueue) {
+  typedef Queue< std::string, ArenaAllocator<std::string> > StringQueue;
+  StringQueue q;
+  std::shared_ptr<Arena> arena = q.allocator().arena();
+
+  for (int i = 0; i < 1000; ++i) {
+    q.put(std::to_string(i));
+  }
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(std::to_string(i), q.get());
+  }
+
+  // Once the queue has reached its working size, cycling items
+  // through it does not need more memory
+  const size_t reserved = arena->bytesReserved();
+  for (int n = 0; n < 10; ++n) {
+    for (int i = 0; i < 1000; ++i) {
+      q.put(std::to_string(i));
+    }
+    q.clear();
+  }
+  EXPECT_EQ(reserved, arena->bytesReserved());
+}
+
+TEST(ArenaAllocatorTests, WithPriorityQueue) {
+  PriorityQueue< int, std::less<int>, ArenaAllocator<int> > q;
+  for (int i = 0; i < 100; ++i) {
+    q.put(i);
+  }
+  for (int i = 99; i >= 0; --i) {
+    EXPECT_EQ(i, q.get());
+  }
+}
+
+TEST(ArenaAllocatorTests, GetAllWhileProducing) {
+  typedef Queue< int, ArenaAllocator<int> > IntQueue;
+  static const int NUM_ITEMS = 200000;
+  IntQueue q;
+
+  // The containers getAll() and swapOut() return share the queue's
+  // arena, and the consumer frees them without the queue's lock
+  std::thread producer([&q]() {
+      for (int i = 0; i < NUM_ITEMS; ++i) {
+	q.put(i);
+      }
+  });
+
+  std::vector<int> received;
+  IntQueue::ContainerType buffer(q.allocator());
+  bool useSwap = false;
+  while ((int)received.size() < NUM_ITEMS) {
+    if (useSwap) {
+      q.swapOut(buffer);
+      received.insert(received.end(), buffer.begin(), buffer.end());
+    } else {
+      IntQueue::ContainerType items = q.getAll();
+      received.insert(received.end(), items.begin(), items.end());
+    }
+    useSwap = !useSwap;
+  }
+  producer.join();
+
+  ASSERT_EQ(NUM_ITEMS, received.size());
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    ASSERT_EQ(i, received[i]);
+  }
+}
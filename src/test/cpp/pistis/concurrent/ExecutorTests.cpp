@@ -0,0 +1,169 @@
+#include <pistis/concurrent/Executor.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/PoolAllocator.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+TEST(ExecutorTests, Create) {
+  Executor executor(3);
+  EXPECT_EQ(3, executor.numWorkers());
+  EXPECT_FALSE(executor.shuttingDown());
+
+  Executor defaultExecutor;
+  EXPECT_GE(defaultExecutor.numWorkers(), 1);
+}
+
+TEST(ExecutorTests, ConfigureWorkers) {
+  ThreadConfig config;
+  config.name = "exec";
+  Executor executor(2, OnExecMode::CLOSE, config);
+
+  std::vector< pollable::Future<std::string> > names;
+  for (int i = 0; i < 2; ++i) {
+    names.push_back(executor.async([]() {
+	char name[16];
+	::pthread_getname_np(::pthread_self(), name, sizeof(name));
+	return std::string(name);
+    }));
+  }
+  for (auto& name : names) {
+    const std::string n = name.get();
+    EXPECT_TRUE((n == "exec-0") || (n == "exec-1")) << n;
+  }
+
+  config.nice = 20;
+  EXPECT_THROW(Executor(2, OnExecMode::CLOSE, config), IllegalValueError);
+}
+
+TEST(ExecutorTests, Submit) {
+  Executor executor(2);
+  std::atomic<int> value(0);
+
+  Completion c = executor.submit([&value]() { value = 42; });
+  EXPECT_TRUE(c.wait(1000));
+  EXPECT_TRUE(c.done());
+  EXPECT_FALSE(c.failed());
+  EXPECT_EQ(42, value.load());
+  c.get();
+}
+
+TEST(ExecutorTests, CompletionIsPollable) {
+  Executor executor(1);
+  std::atomic<bool> release(false);
+
+  Completion c = executor.submit([&release]() {
+      while (!release) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+  });
+  EpollSet pollSet(c.fd(), EpollEventType::READ);
+  EXPECT_FALSE(pollSet.wait(50));
+  EXPECT_FALSE(c.done());
+
+  release = true;
+  ASSERT_TRUE(pollSet.wait(1000));
+  EXPECT_EQ(c.fd(), pollSet.events().front().fd());
+  EXPECT_TRUE(c.done());
+
+  // Stays readable
+  EXPECT_TRUE(pollSet.wait(0));
+}
+
+TEST(ExecutorTests, ExceptionsPropagate) {
+  Executor executor(2);
+  Completion c = executor.submit([]() { throw std::runtime_error("oops"); });
+  EXPECT_TRUE(c.wait(1000));
+  EXPECT_TRUE(c.failed());
+  EXPECT_THROW(c.get(), std::runtime_error);
+
+  executor.execute([]() { throw std::runtime_error("oops"); });
+  executor.shutdown();
+  EXPECT_EQ(1, executor.numFailed());
+}
+
+TEST(ExecutorTests, ManySmallTasks) {
+  const int NUM_TASKS = 100000;
+  Executor executor(4);
+  std::atomic<int> count(0);
+
+  for (int i = 0; i < NUM_TASKS; ++i) {
+    executor.execute([&count]() { ++count; });
+  }
+  executor.shutdown();
+  EXPECT_EQ(NUM_TASKS, count.load());
+}
+
+TEST(ExecutorTests, TasksSubmitTasks) {
+  Executor executor(4);
+  std::atomic<int> count(0);
+
+  // Each task spawns two more until the tree is 14 levels deep
+  std::function<void (int)> spawn = [&](int depth) {
+    ++count;
+    if (depth < 13) {
+      executor.execute([&spawn, depth]() { spawn(depth + 1); });
+      executor.execute([&spawn, depth]() { spawn(depth + 1); });
+    }
+  };
+  executor.execute([&spawn]() { spawn(0); });
+  executor.shutdown();
+  EXPECT_EQ((1 << 14) - 1, count.load());
+}
+
+TEST(ExecutorTests, IdleWorkersPark) {
+  Executor executor(3);
+  executor.submit([]() { }).wait(1000);
+
+  for (int i = 0; (i < 100) && (executor.numParked() < 3); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(3, executor.numParked());
+
+  Completion c = executor.submit([]() { });
+  EXPECT_TRUE(c.wait(1000));
+}
+
+TEST(ExecutorTests, SubmitAfterShutdown) {
+  Executor executor(2);
+  executor.shutdown();
+  EXPECT_TRUE(executor.shuttingDown());
+  EXPECT_THROW(executor.submit([]() { }), IllegalStateError);
+  EXPECT_THROW(executor.execute([]() { }), IllegalStateError);
+
+  // Shutting down again does nothing
+  executor.shutdown();
+}
+
+TEST(ExecutorTests, Async) {
+  Executor executor(2);
+  Future<int> answer = executor.async([]() { return 42; });
+  Future<void> failed = executor.async([]() {
+      throw std::runtime_error("oops");
+  });
+
+  EXPECT_EQ(42, answer.get());
+  EXPECT_THROW(failed.get(), std::runtime_error);
+  executor.shutdown();
+  EXPECT_EQ(0, executor.numFailed());
+}
+
+TEST(ExecutorTests, AsyncWithAllocator) {
+  auto pool = std::make_shared<BlockPool>(512);
+  PoolAllocator<char> allocator(pool);
+  Executor executor(1);
+
+  Future<int> answer = executor.async(std::allocator_arg, allocator,
+				      []() { return 42; });
+  EXPECT_EQ(42, answer.get());
+  executor.shutdown();
+  EXPECT_LT(pool->numFreeBlocks(), pool->blocksPerChunk());
+}
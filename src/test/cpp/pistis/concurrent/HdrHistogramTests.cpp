@@ -0,0 +1,82 @@
+#include <pistis/concurrent/HdrHistogram.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::exceptions;
+
+TEST(HdrHistogramTests, Buckets) {
+  // With 2 bits of precision, values below 4 are exact and each power
+  // of two above that has four buckets
+  EXPECT_EQ(252, HdrHistogram::numBuckets(2));
+  EXPECT_EQ(0, HdrHistogram::bucketFor(0, 2));
+  EXPECT_EQ(3, HdrHistogram::bucketFor(3, 2));
+  EXPECT_EQ(4, HdrHistogram::bucketFor(4, 2));
+  EXPECT_EQ(7, HdrHistogram::bucketFor(7, 2));
+  EXPECT_EQ(8, HdrHistogram::bucketFor(8, 2));
+  EXPECT_EQ(8, HdrHistogram::bucketFor(9, 2));
+  EXPECT_EQ(9, HdrHistogram::bucketFor(10, 2));
+  EXPECT_EQ(11, HdrHistogram::bucketFor(15, 2));
+  EXPECT_EQ(12, HdrHistogram::bucketFor(16, 2));
+  EXPECT_EQ(251, HdrHistogram::bucketFor((uint64_t)-1, 2));
+
+  EXPECT_EQ(8, HdrHistogram::bucketMin(8, 2));
+  EXPECT_EQ(9, HdrHistogram::bucketMax(8, 2));
+  EXPECT_EQ(16, HdrHistogram::bucketMin(12, 2));
+  EXPECT_EQ(19, HdrHistogram::bucketMax(12, 2));
+  EXPECT_EQ((uint64_t)-1, HdrHistogram::bucketMax(251, 2));
+}
+
+TEST(HdrHistogramTests, BucketsAreContiguous) {
+  const uint32_t precision = HdrHistogram::DEFAULT_PRECISION;
+  const size_t n = HdrHistogram::numBuckets(precision);
+  EXPECT_EQ(0, HdrHistogram::bucketMin(0, precision));
+  for (size_t i = 1; i < n; ++i) {
+    ASSERT_EQ(HdrHistogram::bucketMax(i - 1, precision) + 1,
+	      HdrHistogram::bucketMin(i, precision)) << "Bucket " << i;
+    ASSERT_EQ(i, HdrHistogram::bucketFor(
+		     HdrHistogram::bucketMin(i, precision), precision));
+    ASSERT_EQ(i, HdrHistogram::bucketFor(
+		     HdrHistogram::bucketMax(i, precision), precision));
+  }
+  EXPECT_EQ((uint64_t)-1, HdrHistogram::bucketMax(n - 1, precision));
+}
+
+TEST(HdrHistogramTests, RelativeError) {
+  const uint32_t precision = HdrHistogram::DEFAULT_PRECISION;
+  for (uint64_t v = 1; v < ((uint64_t)1 << 40); v = v * 3 + 1) {
+    const size_t b = HdrHistogram::bucketFor(v, precision);
+    const uint64_t width = HdrHistogram::bucketMax(b, precision) -
+                           HdrHistogram::bucketMin(b, precision);
+    EXPECT_LE((double)width / (double)v, 1.0 / 128.0) << "Value " << v;
+  }
+}
+
+TEST(HdrHistogramTests, Percentiles) {
+  HdrHistogram h;
+  EXPECT_EQ(0, h.snapshot().total());
+  EXPECT_EQ(0, h.snapshot().percentile(50));
+
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    h.record(i * 1000);
+  }
+
+  HdrHistogram::Snapshot s = h.snapshot();
+  EXPECT_EQ(1000, s.total());
+  EXPECT_EQ(1000000, s.max());
+  EXPECT_NEAR(500000.0, (double)s.percentile(50), 500000.0 / 128);
+  EXPECT_NEAR(990000.0, (double)s.percentile(99), 990000.0 / 128);
+  EXPECT_NEAR(999000.0, (double)s.percentile(99.9), 999000.0 / 128);
+  EXPECT_EQ(1000000, s.percentile(100));
+  EXPECT_NEAR(500500.0, s.mean(), 500500.0 / 128);
+
+  h.reset();
+  EXPECT_EQ(0, h.snapshot().total());
+  EXPECT_EQ(0, h.snapshot().max());
+}
+
+TEST(HdrHistogramTests, IllegalPrecision) {
+  EXPECT_THROW(HdrHistogram(0), IllegalValueError);
+  EXPECT_THROW(HdrHistogram(HdrHistogram::MAX_PRECISION + 1),
+	       IllegalValueError);
+}
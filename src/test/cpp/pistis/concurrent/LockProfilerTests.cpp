@@ -0,0 +1,200 @@
+#include <pistis/concurrent/LockProfiler.hpp>
+#include <pistis/concurrent/ProfiledMutex.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/concurrent/pollable/ShardedQueue.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  class LockProfilerTests : public testing::Test {
+  protected:
+    void SetUp() override {
+      LockProfiler::reset();
+      LockProfiler::setSampleInterval(1);
+      LockProfiler::enable();
+    }
+
+    void TearDown() override {
+      LockProfiler::disable();
+      LockProfiler::setSampleInterval(LockProfiler::DEFAULT_SAMPLE_INTERVAL);
+    }
+
+    static bool find(const void* owner, LockContention& row) {
+      for (const LockContention& c : LockProfiler::report((size_t)-1)) {
+	if (c.owner == owner) {
+	  row = c;
+	  return true;
+	}
+      }
+      return false;
+    }
+  };
+}
+
+TEST_F(LockProfilerTests, Uncontended) {
+  int owner = 0;
+  ProfiledMutex m(&owner, "Test");
+  for (int i = 0; i < 3; ++i) {
+    std::unique_lock<ProfiledMutex> lock(m);
+  }
+  EXPECT_TRUE(m.try_lock());
+  m.unlock();
+
+  LockContention row;
+  ASSERT_TRUE(find(&owner, row));
+  EXPECT_EQ("Test", row.kind);
+  EXPECT_EQ("", row.name);
+  EXPECT_EQ(4, row.acquisitions);
+  EXPECT_EQ(0, row.contended);
+  EXPECT_EQ(0.0, row.waitNs);
+  EXPECT_EQ(4, row.holdSamples);
+}
+
+TEST_F(LockProfilerTests, Disabled) {
+  int owner = 0;
+  LockProfiler::disable();
+  ProfiledMutex m(&owner, "Test");
+  {
+    std::unique_lock<ProfiledMutex> lock(m);
+  }
+
+  LockContention row;
+  EXPECT_FALSE(find(&owner, row));
+}
+
+TEST_F(LockProfilerTests, SampleInterval) {
+  int owner = 0;
+  LockProfiler::setSampleInterval(4);
+  ProfiledMutex m(&owner, "Test");
+  for (int i = 0; i < 10; ++i) {
+    std::unique_lock<ProfiledMutex> lock(m);
+  }
+
+  LockContention row;
+  ASSERT_TRUE(find(&owner, row));
+  EXPECT_EQ(10, row.acquisitions);
+  EXPECT_EQ(2, row.holdSamples);
+  EXPECT_THROW(LockProfiler::setSampleInterval(0), IllegalValueError);
+}
+
+TEST_F(LockProfilerTests, Contended) {
+  int owner = 0;
+  ProfiledMutex m(&owner, "Test");
+  std::atomic<bool> locked(false);
+
+  std::thread holder([&]() {
+      std::unique_lock<ProfiledMutex> lock(m);
+      locked = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  });
+  while (!locked) {
+    std::this_thread::yield();
+  }
+  {
+    std::unique_lock<ProfiledMutex> lock(m);
+  }
+  holder.join();
+
+  LockContention row;
+  ASSERT_TRUE(find(&owner, row));
+  EXPECT_EQ(2, row.acquisitions);
+  EXPECT_EQ(1, row.contended);
+  EXPECT_GT(row.waitNs, 10e6);
+  EXPECT_EQ(row.waitNs, row.maxWaitNs);
+  EXPECT_GT(row.maxHoldNs, 10e6);
+}
+
+TEST_F(LockProfilerTests, ReportRanksByWaitTime) {
+  int busy = 0;
+  int quiet = 0;
+  ProfiledMutex m1(&busy, "Test");
+  ProfiledMutex m2(&quiet, "Test");
+  LockProfiler::name(&busy, "busy");
+
+  {
+    std::unique_lock<ProfiledMutex> lock(m2);
+  }
+  std::atomic<bool> locked(false);
+  std::thread holder([&]() {
+      std::unique_lock<ProfiledMutex> lock(m1);
+      locked = true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  });
+  while (!locked) {
+    std::this_thread::yield();
+  }
+  {
+    std::unique_lock<ProfiledMutex> lock(m1);
+  }
+  holder.join();
+
+  std::vector<LockContention> top = LockProfiler::report(1);
+  ASSERT_EQ(1, top.size());
+  EXPECT_EQ(&busy, top[0].owner);
+  EXPECT_EQ("busy", top[0].name);
+
+  std::ostringstream out;
+  LockProfiler::writeReport(out, 1);
+  EXPECT_NE(std::string::npos, out.str().find("Test busy"));
+  LockProfiler::forget(&busy);
+}
+
+TEST_F(LockProfilerTests, DestroyedMutexLeavesReport) {
+  int owner = 0;
+  {
+    ProfiledMutex m(&owner, "Test");
+    std::unique_lock<ProfiledMutex> lock(m);
+  }
+
+  LockContention row;
+  EXPECT_FALSE(find(&owner, row));
+}
+
+TEST_F(LockProfilerTests, Reset) {
+  int owner = 0;
+  ProfiledMutex m(&owner, "Test");
+  {
+    std::unique_lock<ProfiledMutex> lock(m);
+  }
+  LockProfiler::reset();
+
+  LockContention row;
+  ASSERT_TRUE(find(&owner, row));
+  EXPECT_EQ(0, row.acquisitions);
+  EXPECT_EQ(0, row.holdSamples);
+}
+
+TEST_F(LockProfilerTests, Queue) {
+  pistis::concurrent::pollable::Queue<int> q;
+  q.put(1);
+  q.get();
+
+  LockContention row;
+  ASSERT_TRUE(find(&q, row));
+  EXPECT_EQ("Queue", row.kind);
+  EXPECT_LE(2, row.acquisitions);
+}
+
+TEST_F(LockProfilerTests, ShardedQueue) {
+  ShardedQueue<int> q(2);
+  q.put(1);
+  q.get();
+
+  bool sawShard = false;
+  bool sawState = false;
+  for (const LockContention& c : LockProfiler::report((size_t)-1)) {
+    if (c.owner == &q) {
+      sawShard = sawShard || (c.kind == "ShardedQueue::Shard");
+      sawState = sawState || (c.kind == "ShardedQueue");
+    }
+  }
+  EXPECT_TRUE(sawShard);
+  EXPECT_TRUE(sawState);
+}
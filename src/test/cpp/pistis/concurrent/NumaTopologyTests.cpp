@@ -0,0 +1,131 @@
+#include <pistis/concurrent/NumaTopology.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::exceptions;
+
+namespace {
+  /** @brief A temporary directory laid out like /sys/devices/system/node */
+  class FakeSysfs {
+  public:
+    FakeSysfs(): root_() {
+      char path[] = "/tmp/NumaTopologyTests.XXXXXX";
+      root_ = ::mkdtemp(path);
+    }
+
+    ~FakeSysfs() {
+      for (const std::string& p : files_) {
+	::unlink(p.c_str());
+      }
+      for (auto i = dirs_.rbegin(); i != dirs_.rend(); ++i) {
+	::rmdir(i->c_str());
+      }
+      ::rmdir(root_.c_str());
+    }
+
+    const std::string& root() const { return root_; }
+
+    void addNode(const std::string& name, const std::string& cpulist) {
+      const std::string dir = root_ + "/" + name;
+      ::mkdir(dir.c_str(), 0700);
+      dirs_.push_back(dir);
+      files_.push_back(dir + "/cpulist");
+      std::ofstream(files_.back()) << cpulist << "\n";
+    }
+
+  private:
+    std::string root_;
+    std::vector<std::string> dirs_;
+    std::vector<std::string> files_;
+  };
+}
+
+TEST(NumaTopologyTests, ParseCpuList) {
+  EXPECT_EQ(std::vector<int>({ 0 }), NumaTopology::parseCpuList("0"));
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3, 8, 10, 11 }),
+	    NumaTopology::parseCpuList("0-3,8,10-11\n"));
+  EXPECT_EQ(std::vector<int>(), NumaTopology::parseCpuList(""));
+  EXPECT_THROW(NumaTopology::parseCpuList("3-1"), IllegalValueError);
+  EXPECT_THROW(NumaTopology::parseCpuList("a"), IllegalValueError);
+  EXPECT_THROW(NumaTopology::parseCpuList("1-"), IllegalValueError);
+}
+
+TEST(NumaTopologyTests, ReadFromSysfs) {
+  FakeSysfs sysfs;
+  sysfs.addNode("node2", "4-5,7");
+  sysfs.addNode("node0", "0-3");
+  sysfs.addNode("node1", "");
+  sysfs.addNode("nodeX", "6");
+
+  NumaTopology topology(sysfs.root());
+  ASSERT_EQ(3, topology.numNodes());
+  EXPECT_FALSE(topology.simulated());
+  EXPECT_EQ(0, topology.kernelNode(0));
+  EXPECT_EQ(2, topology.kernelNode(2));
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3 }), topology.cpus(0));
+  EXPECT_EQ(std::vector<int>(), topology.cpus(1));
+  EXPECT_EQ(std::vector<int>({ 4, 5, 7 }), topology.cpus(2));
+  EXPECT_EQ(0, topology.nodeOfCpu(3));
+  EXPECT_EQ(2, topology.nodeOfCpu(7));
+  EXPECT_EQ(0, topology.nodeOfCpu(6));
+  EXPECT_EQ(0, topology.nodeOfCpu(100));
+}
+
+TEST(NumaTopologyTests, NoSysfs) {
+  NumaTopology topology("/nonexistent/NumaTopologyTests");
+  ASSERT_EQ(1, topology.numNodes());
+  EXPECT_EQ(0, topology.kernelNode(0));
+  EXPECT_FALSE(topology.cpus(0).empty());
+}
+
+TEST(NumaTopologyTests, System) {
+  const NumaTopology& topology = NumaTopology::system();
+  size_t numCpus = 0;
+  ASSERT_LE(1, topology.numNodes());
+  for (size_t i = 0; i < topology.numNodes(); ++i) {
+    numCpus += topology.cpus(i).size();
+  }
+  EXPECT_LE(1, numCpus);
+  EXPECT_GT(topology.numNodes(), topology.currentNode());
+}
+
+TEST(NumaTopologyTests, Simulate) {
+  const NumaTopology topology = NumaTopology::simulate(3);
+  ASSERT_EQ(3, topology.numNodes());
+  EXPECT_TRUE(topology.simulated());
+  EXPECT_EQ(-1, topology.kernelNode(0));
+
+  const int firstCpu = NumaTopology::system().cpus(0).front();
+  EXPECT_EQ(firstCpu, topology.cpus(0).front());
+  EXPECT_EQ(0, topology.nodeOfCpu(firstCpu));
+  EXPECT_THROW(NumaTopology::simulate(0), IllegalValueError);
+  EXPECT_THROW(NumaTopology(std::vector< std::vector<int> >()),
+	       IllegalValueError);
+}
+
+TEST(NumaTopologyTests, BindCurrentThread) {
+  const NumaTopology topology = NumaTopology::simulate(64);
+  size_t node = 0;
+  size_t otherTopologyNode = 0;
+
+  std::thread t([&]() {
+      // Node 63 has no CPUs unless the machine has at least 64
+      topology.bindCurrentThread(63);
+      node = topology.currentNode();
+      otherTopologyNode = NumaTopology::simulate(2).currentNode();
+      NumaTopology::unbindCurrentThread();
+  });
+  t.join();
+
+  EXPECT_EQ(63, node);
+  EXPECT_EQ(1, otherTopologyNode);
+  EXPECT_THROW(topology.bindCurrentThread(64), IllegalValueError);
+}
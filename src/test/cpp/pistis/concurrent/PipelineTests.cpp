@@ -0,0 +1,263 @@
+#include <pistis/concurrent/Pipeline.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::exceptions;
+
+namespace {
+  StageConfig config(size_t workers, size_t batchSize = 1,
+		     StageOrder order = StageOrder::UNORDERED,
+		     size_t queueSize = 1024) {
+    StageConfig c;
+    c.workers = workers;
+    c.batchSize = batchSize;
+    c.order = order;
+    c.queueSize = queueSize;
+    c.lowWaterMark = queueSize / 4;
+    c.highWaterMark = queueSize * 3 / 4;
+    return c;
+  }
+
+  size_t numOpenFds() {
+    size_t n = 0;
+    DIR* dir = ::opendir("/proc/self/fd");
+    while (::readdir(dir)) {
+      ++n;
+    }
+    ::closedir(dir);
+    return n;
+  }
+
+  void sleepFor(int64_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  }
+}
+
+TEST(PipelineTests, SingleStage) {
+  auto pipeline = Pipeline<int>()
+      .then("double", [](int&& x) { return 2 * x; });
+
+  EXPECT_EQ(1, pipeline.numStages());
+  pipeline.start();
+  pipeline.put(1);
+  pipeline.put(2);
+  EXPECT_EQ(2, pipeline.get());
+  EXPECT_EQ(4, pipeline.get());
+
+  int result;
+  EXPECT_FALSE(pipeline.get(result, 10));
+}
+
+TEST(PipelineTests, StagesChangeTypesAndPreserveOrder) {
+  auto pipeline = Pipeline<int>()
+      .then("format", [](int&& x) {
+	  // Make the workers finish out of order
+	  std::this_thread::sleep_for(std::chrono::microseconds((x % 7) * 100));
+	  return std::to_string(x);
+	}, config(4, 1, StageOrder::ORDERED))
+      .then("length", [](std::string&& s) { return s.size(); },
+	    config(2, 1, StageOrder::ORDERED));
+  pipeline.start();
+
+  for (int i = 0; i < 200; ++i) {
+    pipeline.put(i);
+  }
+  for (int i = 0; i < 200; ++i) {
+    size_t n = 0;
+    ASSERT_TRUE(pipeline.get(n, 1000));
+    ASSERT_EQ(std::to_string(i).size(), n);
+  }
+}
+
+TEST(PipelineTests, OrderedStageRestoresOrder) {
+  auto pipeline = Pipeline<int>()
+      .then("jitter", [](int&& x) {
+	  std::this_thread::sleep_for(std::chrono::microseconds((x % 5) * 200));
+	  return x;
+	}, config(4))
+      .then("identity", [](int&& x) { return x; },
+	    config(1, 1, StageOrder::ORDERED));
+  pipeline.start();
+
+  for (int i = 0; i < 100; ++i) {
+    pipeline.put(i);
+  }
+  for (int i = 0; i < 100; ++i) {
+    int x = -1;
+    ASSERT_TRUE(pipeline.get(x, 1000));
+    EXPECT_EQ(i, x);
+  }
+}
+
+TEST(PipelineTests, Batching) {
+  std::atomic<size_t> largestBatch(0);
+  auto pipeline = Pipeline<int>()
+      .thenBatch<int>("sum", [&](std::vector<int>& in, std::vector<int>& out) {
+	  if (in.size() > largestBatch) {
+	    largestBatch = in.size();
+	  }
+	  for (int x : in) {
+	    out.push_back(x + 1);
+	  }
+	}, config(1, 16));
+
+  // Queue everything before the workers start so batches fill up
+  for (int i = 0; i < 64; ++i) {
+    pipeline.put(i);
+  }
+  pipeline.start();
+  pipeline.finish();
+
+  std::vector<int> results;
+  int x;
+  while (pipeline.get(x, 0)) {
+    results.push_back(x);
+  }
+  EXPECT_EQ(64, results.size());
+  EXPECT_EQ(16, largestBatch.load());
+
+  auto stats = pipeline.statistics();
+  ASSERT_EQ(1, stats.size());
+  EXPECT_EQ("sum", stats[0].name());
+  EXPECT_EQ(64, stats[0].items());
+  EXPECT_EQ(4, stats[0].batches());
+  EXPECT_EQ(64, stats[0].latency().total());
+  EXPECT_EQ(4, stats[0].serviceTime().total());
+  EXPECT_GT(stats[0].throughput(), 0);
+}
+
+TEST(PipelineTests, FailedItemsAreDropped) {
+  auto pipeline = Pipeline<int>()
+      .then("check", [](int&& x) {
+	  if (x % 3 == 0) {
+	    throw std::runtime_error("multiple of three");
+	  }
+	  return x;
+	}, config(2))
+      .then("identity", [](int&& x) { return x; },
+	    config(1, 1, StageOrder::ORDERED));
+  pipeline.start();
+
+  for (int i = 0; i < 10; ++i) {
+    pipeline.put(i);
+  }
+  for (int expected : { 1, 2, 4, 5, 7, 8 }) {
+    int x = -1;
+    ASSERT_TRUE(pipeline.get(x, 1000));
+    EXPECT_EQ(expected, x);
+  }
+
+  pipeline.finish();
+  auto stats = pipeline.statistics();
+  EXPECT_EQ(4, stats[0].errors());
+  EXPECT_EQ(10, stats[0].items());
+  EXPECT_EQ(0, stats[1].errors());
+}
+
+TEST(PipelineTests, BackpressurePausesUpstream) {
+  std::atomic<bool> release(false);
+  auto pipeline = Pipeline<int>()
+      .then("fast", [](int&& x) { return x; }, config(1))
+      .then("slow", [&](int&& x) {
+	  while (!release) {
+	    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	  }
+	  return x;
+	}, config(1, 1, StageOrder::UNORDERED, 8));
+  pipeline.start();
+
+  for (int i = 0; i < 20; ++i) {
+    pipeline.put(i);
+  }
+
+  // "fast" stops once "slow"'s input queue passes its high water mark
+  // of 6, which takes 7 items, plus the one "slow" holds if it took one
+  // before the queue filled.  Wait for the queue to fill, then give
+  // "fast" time to overrun it if backpressure were broken.
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while ((pipeline.statistics()[0].items() < 7) &&
+	 (std::chrono::steady_clock::now() < deadline)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_GE(pipeline.statistics()[0].items(), 7);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_LE(pipeline.statistics()[0].items(), 8);
+
+  release = true;
+  for (int i = 0; i < 20; ++i) {
+    int x;
+    ASSERT_TRUE(pipeline.get(x, 1000));
+  }
+  auto stats = pipeline.statistics();
+  EXPECT_EQ(20, stats[0].items());
+  EXPECT_GE(stats[0].backpressure().total(), 1);
+}
+
+TEST(PipelineTests, FinishDoesNotWaitForGet) {
+  auto pipeline = Pipeline<int>(8).then("id", [](int&& x) { return x; });
+  pipeline.start();
+  for (int i = 0; i < 20; ++i) {
+    pipeline.put(i);
+  }
+
+  // The output queue's high water mark is 6, and nothing takes results
+  // until every item has gone through
+  pipeline.finish();
+  for (int i = 0; i < 20; ++i) {
+    int x;
+    ASSERT_TRUE(pipeline.get(x, 0));
+    EXPECT_EQ(i, x);
+  }
+}
+
+TEST(PipelineTests, IdleWorkersDoNotLeakFds) {
+  auto pipeline = Pipeline<int>()
+      .then("id", [](int&& x) { return x; }, config(2));
+  pipeline.start();
+  sleepFor(2 * StageBase::POLL_INTERVAL);
+
+  // Each worker holds at most one eventfd while it waits for input,
+  // whether or not it is waiting at the moment the fds are counted
+  const size_t before = numOpenFds();
+  sleepFor(10 * StageBase::POLL_INTERVAL);
+  EXPECT_LE(numOpenFds(), before + 2);
+  pipeline.stop();
+}
+
+TEST(PipelineTests, StageWorkersApplyThreadConfig) {
+  StageConfig c = config(2);
+  c.threads.name = "parse";
+  auto pipeline = Pipeline<int>()
+      .then("name", [](int&&) {
+	char name[16];
+	::pthread_getname_np(::pthread_self(), name, sizeof(name));
+	return std::string(name);
+      }, c);
+
+  pipeline.start();
+  pipeline.put(1);
+  const std::string name = pipeline.get();
+  EXPECT_TRUE((name == "parse-0") || (name == "parse-1")) << name;
+  pipeline.stop();
+}
+
+TEST(PipelineTests, IllegalStates) {
+  Pipeline<int> empty;
+  EXPECT_THROW(empty.start(), IllegalStateError);
+  EXPECT_THROW(empty.put(1), IllegalStateError);
+
+  auto pipeline = Pipeline<int>().then("id", [](int&& x) { return x; });
+  int x;
+  EXPECT_THROW(pipeline.get(x, 0), IllegalStateError);
+  pipeline.start();
+  EXPECT_THROW(pipeline.start(), IllegalStateError);
+  pipeline.stop();
+}
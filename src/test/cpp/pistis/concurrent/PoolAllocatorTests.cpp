@@ -0,0 +1,201 @@
+#include <pistis/concurrent/NumaTopology.hpp>
+#include <pistis/concurrent/PoolAllocator.hpp>
+#include <pistis/concurrent/pollable/PriorityQueue.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/concurrent/pollable/ShardedQueue.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+TEST(PoolAllocatorTests, BlockPoolAllocateAndFree) {
+  BlockPool pool(20, 4);
+  std::set<void*> blocks;
+
+  // Block size is rounded up to the fundamental alignment
+  EXPECT_EQ(0, pool.blockSize() % alignof(std::max_align_t));
+  EXPECT_LE(20, pool.blockSize());
+  EXPECT_EQ(0, pool.numChunks());
+
+  for (int i = 0; i < 6; ++i) {
+    void* p = pool.allocate();
+    EXPECT_EQ(0, (uintptr_t)p % alignof(std::max_align_t));
+    EXPECT_TRUE(blocks.insert(p).second);
+  }
+  EXPECT_EQ(2, pool.numChunks());
+  EXPECT_EQ(2, pool.numFreeBlocks());
+
+  void* freed = *blocks.begin();
+  pool.deallocate(freed);
+  EXPECT_EQ(3, pool.numFreeBlocks());
+  EXPECT_EQ(freed, pool.allocate());
+
+  for (void* p : blocks) {
+    pool.deallocate(p);
+  }
+  EXPECT_EQ(8, pool.numFreeBlocks());
+  EXPECT_EQ(2, pool.numChunks());
+}
+
+TEST(PoolAllocatorTests, BlockPoolOnNumaNode) {
+  const NumaTopology& topology = NumaTopology::system();
+  BlockPool pool(64, 4, topology.kernelNode(topology.numNodes() - 1));
+  std::vector<char*> blocks;
+
+  EXPECT_EQ(topology.kernelNode(topology.numNodes() - 1), pool.numaNode());
+  for (int i = 0; i < 6; ++i) {
+    blocks.push_back(static_cast<char*>(pool.allocate()));
+    std::fill(blocks.back(), blocks.back() + 64, (char)i);
+  }
+  EXPECT_EQ(2, pool.numChunks());
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ((char)i, blocks[i][63]);
+    pool.deallocate(blocks[i]);
+  }
+
+  EXPECT_EQ(-1, BlockPool(64, 4, -5).numaNode());
+  EXPECT_EQ(0, PoolAllocator<int>::onNumaNode(0).pool()->numaNode());
+}
+
+TEST(PoolAllocatorTests, BlockPoolIllegalSizes) {
+  EXPECT_THROW(BlockPool(0, 4), IllegalValueError);
+  EXPECT_THROW(BlockPool(16, 0), IllegalValueError);
+}
+
+TEST(PoolAllocatorTests, BlockPoolConcurrentUse) {
+  static const int NUM_THREADS = 4;
+  static const int NUM_ITERATIONS = 10000;
+  BlockPool pool(64, 16);
+  std::vector<WorkerThread> threads(NUM_THREADS);
+
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads[i].start([&pool, i](WorkerThread& t) {
+	std::vector<uint64_t*> blocks;
+	for (int j = 0; j < NUM_ITERATIONS; ++j) {
+	  uint64_t* p = static_cast<uint64_t*>(pool.allocate());
+	  *p = i;
+	  blocks.push_back(p);
+	  if (blocks.size() > 8) {
+	    for (uint64_t* b : blocks) {
+	      if (*b != (uint64_t)i) {
+		t.addError("Block was handed out to two threads");
+	      }
+	      pool.deallocate(b);
+	    }
+	    blocks.clear();
+	  }
+	}
+	for (uint64_t* b : blocks) {
+	  pool.deallocate(b);
+	}
+	t.setState(ThreadState::DONE);
+    });
+  }
+  for (auto& thread : threads) {
+    ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 5000));
+    thread.join();
+    EXPECT_EQ(std::vector<std::string>(), thread.errors());
+  }
+  EXPECT_EQ(pool.numChunks() * pool.blocksPerChunk(), pool.numFreeBlocks());
+}
+
+TEST(PoolAllocatorTests, RebindSharesPool) {
+  PoolAllocator<int> a;
+  PoolAllocator<double> b(a);
+  PoolAllocator<int> c;
+
+  EXPECT_EQ(a.pool(), b.pool());
+  EXPECT_TRUE(a == b);
+  EXPECT_TRUE(a != c);
+
+  // Small requests come from the pool, large ones from the heap
+  int* small = a.allocate(4);
+  EXPECT_EQ(1, a.pool()->numChunks());
+  EXPECT_EQ(BlockPool::DEFAULT_BLOCKS_PER_CHUNK - 1,
+	    a.pool()->numFreeBlocks());
+  int* large = a.allocate(BlockPool::DEFAULT_BLOCK_SIZE);
+  EXPECT_EQ(BlockPool::DEFAULT_BLOCKS_PER_CHUNK - 1,
+	    a.pool()->numFreeBlocks());
+
+  a.deallocate(large, BlockPool::DEFAULT_BLOCK_SIZE);
+  a.deallocate(small, 4);
+  EXPECT_EQ(BlockPool::DEFAULT_BLOCKS_PER_CHUNK, a.pool()->numFreeBlocks());
+}
+
+TEST(PoolAllocatorTests, WithQueue) {
+  typedef Queue< std::string, PoolAllocator<std::string> > StringQueue;
+  std::shared_ptr<BlockPool> pool(new BlockPool);
+  StringQueue q{ PoolAllocator<std::string>(pool) };
+
+  for (int i = 0; i < 1000; ++i) {
+    q.put(std::to_string(i));
+  }
+  EXPECT_LT(0, pool->numChunks());
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(std::to_string(i), q.get());
+  }
+
+  StringQueue::ContainerType buffer(q.allocator());
+  EXPECT_EQ(500, q.swapOut(buffer));
+  EXPECT_EQ("500", buffer.front());
+  EXPECT_EQ("999", buffer.back());
+
+  // Memory freed by the queue goes back to the pool, not the heap
+  const size_t chunks = pool->numChunks();
+  buffer.clear();
+  for (int i = 0; i < 1000; ++i) {
+    q.put(std::to_string(i));
+  }
+  q.clear();
+  EXPECT_EQ(chunks, pool->numChunks());
+}
+
+TEST(PoolAllocatorTests, WithPriorityQueue) {
+  PriorityQueue< int, std::less<int>, PoolAllocator<int> > q;
+  for (int i : { 3, 9, 1, 7 }) {
+    q.put(i);
+  }
+  EXPECT_EQ(9, q.get());
+  EXPECT_EQ(7, q.get());
+  EXPECT_EQ(3, q.get());
+  EXPECT_EQ(1, q.get());
+}
+
+TEST(PoolAllocatorTests, WithShardedQueue) {
+  static const int NUM_THREADS = 4;
+  static const int VALUES_PER_THREAD = 1000;
+  std::shared_ptr<BlockPool> pool(new BlockPool);
+  ShardedQueue< int, PoolAllocator<int> > q(NUM_THREADS,
+					   PoolAllocator<int>(pool));
+  std::vector<WorkerThread> threads(NUM_THREADS);
+
+  for (auto& thread : threads) {
+    thread.start([&q](WorkerThread& t) {
+	for (int i = 0; i < VALUES_PER_THREAD; ++i) {
+	  q.put(i);
+	}
+	t.setState(ThreadState::DONE);
+    });
+  }
+  for (auto& thread : threads) {
+    ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 5000));
+    thread.join();
+  }
+
+  EXPECT_EQ(NUM_THREADS * VALUES_PER_THREAD, q.size());
+  int item;
+  int sum = 0;
+  while (q.get(item, 0)) {
+    sum += item;
+  }
+  EXPECT_EQ(NUM_THREADS * VALUES_PER_THREAD * (VALUES_PER_THREAD - 1) / 2,
+	    sum);
+}
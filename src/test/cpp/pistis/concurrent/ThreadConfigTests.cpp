@@ -0,0 +1,157 @@
+#include <pistis/concurrent/ThreadConfig.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <pistis/exceptions/SystemError.hpp>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::exceptions;
+
+namespace {
+  std::vector<int> currentCpus() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    ::pthread_getaffinity_np(::pthread_self(), sizeof(cpus), &cpus);
+    std::vector<int> result;
+    for (int i = 0; i < CPU_SETSIZE; ++i) {
+      if (CPU_ISSET(i, &cpus)) {
+	result.push_back(i);
+      }
+    }
+    return result;
+  }
+
+  std::string currentName() {
+    char name[16];
+    ::pthread_getname_np(::pthread_self(), name, sizeof(name));
+    return name;
+  }
+
+  int currentNice() {
+    return ::getpriority(PRIO_PROCESS, (id_t)::syscall(SYS_gettid));
+  }
+}
+
+TEST(ThreadConfigTests, DefaultChangesNothing) {
+  std::vector<int> cpus;
+  std::string name;
+  int nice = 0;
+  std::thread t = ThreadConfig().start(0, [&]() {
+      cpus = currentCpus();
+      name = currentName();
+      nice = currentNice();
+  });
+  t.join();
+  EXPECT_EQ(currentCpus(), cpus);
+  EXPECT_EQ(currentName(), name);
+  EXPECT_EQ(currentNice(), nice);
+}
+
+TEST(ThreadConfigTests, ForThread) {
+  ThreadConfig config;
+  config.cpus = { 0, 2, 4 };
+  config.name = "worker";
+  config.nice = 5;
+
+  ThreadConfig second = config.forThread(1);
+  EXPECT_EQ("worker-1", second.name);
+  EXPECT_EQ(std::vector<int>({ 0, 2, 4 }), second.cpus);
+  EXPECT_EQ(5, second.nice);
+
+  config.onePerThread = true;
+  EXPECT_EQ(std::vector<int>({ 2 }), config.forThread(1).cpus);
+  EXPECT_EQ(std::vector<int>({ 0 }), config.forThread(3).cpus);
+
+  config.name.clear();
+  EXPECT_EQ("", config.forThread(1).name);
+}
+
+TEST(ThreadConfigTests, Apply) {
+  const int cpu = currentCpus().front();
+  ThreadConfig config;
+  config.cpus = { cpu };
+  config.policy = SchedulingPolicy::OTHER;
+  config.nice = 5;
+  config.name = "a-very-long-thread-name";
+
+  std::vector<int> cpus;
+  std::string name;
+  int nice = 0;
+  int policy = -1;
+  std::thread t([&]() {
+      config.apply();
+      cpus = currentCpus();
+      name = currentName();
+      nice = currentNice();
+      policy = ::sched_getscheduler(0);
+  });
+  t.join();
+  EXPECT_EQ(std::vector<int>({ cpu }), cpus);
+  EXPECT_EQ("a-very-long-thr", name);
+  EXPECT_EQ(5, nice);
+  EXPECT_EQ(SCHED_OTHER, policy);
+}
+
+TEST(ThreadConfigTests, Start) {
+  ThreadConfig config;
+  config.name = "pool";
+  std::string name;
+  std::thread t = config.start(3, [&]() { name = currentName(); });
+  t.join();
+  EXPECT_EQ("pool-3", name);
+}
+
+TEST(ThreadConfigTests, Fifo) {
+  ThreadConfig config;
+  config.policy = SchedulingPolicy::FIFO;
+  config.priority = 1;
+
+  // Real-time scheduling needs privileges the test may not have, but
+  // either the thread gets SCHED_FIFO or start() reports why not
+  int policy = -1;
+  try {
+    std::thread t = config.start(0, [&]() {
+	policy = ::sched_getscheduler(0);
+    });
+    t.join();
+    EXPECT_EQ(SCHED_FIFO, policy);
+  } catch(const SystemError&) {
+    EXPECT_EQ(-1, policy);
+  }
+}
+
+TEST(ThreadConfigTests, IllegalValues) {
+  ThreadConfig badCpu;
+  badCpu.cpus = { -1 };
+  EXPECT_THROW(badCpu.apply(), IllegalValueError);
+
+  ThreadConfig badPriority;
+  badPriority.policy = SchedulingPolicy::FIFO;
+  badPriority.priority = 100;
+  EXPECT_THROW(badPriority.apply(), IllegalValueError);
+
+  ThreadConfig priorityWithoutPolicy;
+  priorityWithoutPolicy.priority = 1;
+  EXPECT_THROW(priorityWithoutPolicy.apply(), IllegalValueError);
+
+  ThreadConfig badNice;
+  badNice.nice = 20;
+  EXPECT_THROW(badNice.apply(), IllegalValueError);
+
+  bool ran = false;
+  EXPECT_THROW(badCpu.start(0, [&ran]() { ran = true; }),
+	       IllegalValueError);
+  EXPECT_FALSE(ran);
+}
+
+TEST(ThreadConfigTests, WritePolicy) {
+  std::ostringstream out;
+  out << SchedulingPolicy::INHERIT << " " << SchedulingPolicy::OTHER << " "
+      << SchedulingPolicy::FIFO;
+  EXPECT_EQ("INHERIT OTHER FIFO", out.str());
+}
@@ -0,0 +1,207 @@
+#include <pistis/concurrent/Trace.hpp>
+#include <pistis/concurrent/pollable/Condition.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  class TraceTests : public testing::Test {
+  protected:
+    void SetUp() override {
+      Trace::clear();
+      Trace::enable();
+    }
+
+    void TearDown() override {
+      Trace::disable();
+      Trace::setCapacity(Trace::DEFAULT_CAPACITY);
+      Trace::clear();
+    }
+
+    static std::vector<TraceEvent> eventsFor(const void* object) {
+      std::vector<TraceEvent> events;
+      for (const TraceEvent& e : Trace::events()) {
+	if (e.object == object) {
+	  events.push_back(e);
+	}
+      }
+      return events;
+    }
+
+    static std::vector<TraceEventType> typesOf(
+	const std::vector<TraceEvent>& events
+    ) {
+      std::vector<TraceEventType> types;
+      for (const TraceEvent& e : events) {
+	types.push_back(e.type);
+      }
+      return types;
+    }
+  };
+}
+
+TEST_F(TraceTests, Record) {
+  int object = 0;
+  Trace::record(TraceEventType::PUT, &object, 3);
+  Trace::record(TraceEventType::GET, &object, 2);
+
+  std::vector<TraceEvent> events = eventsFor(&object);
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ(TraceEventType::PUT, events[0].type);
+  EXPECT_EQ(3, events[0].value);
+  EXPECT_EQ(TraceEventType::GET, events[1].type);
+  EXPECT_EQ(2, events[1].value);
+  EXPECT_LE(events[0].timestamp, events[1].timestamp);
+  EXPECT_EQ(events[0].thread, events[1].thread);
+}
+
+TEST_F(TraceTests, Disabled) {
+  int object = 0;
+  Trace::disable();
+  EXPECT_FALSE(Trace::enabled());
+  Trace::record(TraceEventType::PUT, &object, 1);
+  {
+    Trace::WaitScope wait(&object);
+  }
+  EXPECT_TRUE(eventsFor(&object).empty());
+}
+
+TEST_F(TraceTests, Clear) {
+  int object = 0;
+  Trace::record(TraceEventType::NOTIFY, &object, 1);
+  Trace::clear();
+  EXPECT_TRUE(eventsFor(&object).empty());
+
+  Trace::record(TraceEventType::NOTIFY, &object, 2);
+  std::vector<TraceEvent> events = eventsFor(&object);
+  ASSERT_EQ(1, events.size());
+  EXPECT_EQ(2, events[0].value);
+}
+
+TEST_F(TraceTests, RingKeepsNewestEvents) {
+  int object = 0;
+  Trace::setCapacity(5);
+  EXPECT_EQ(8, Trace::capacity());
+
+  // Only threads that start recording after setCapacity() get the
+  // smaller ring
+  std::thread t([&]() {
+      for (uint64_t i = 0; i < 20; ++i) {
+	Trace::record(TraceEventType::PUT, &object, i);
+      }
+  });
+  t.join();
+
+  std::vector<TraceEvent> events = eventsFor(&object);
+  ASSERT_EQ(8, events.size());
+  for (size_t i = 0; i < events.size(); ++i) {
+    EXPECT_EQ(12 + i, events[i].value);
+  }
+  EXPECT_THROW(Trace::setCapacity(0), IllegalValueError);
+}
+
+TEST_F(TraceTests, ConditionEvents) {
+  Condition cv;
+  std::mutex sync;
+  bool ready = false;
+
+  std::thread waiter([&]() {
+      std::unique_lock<std::mutex> lock(sync);
+      while (!ready) {
+	cv.wait(lock, -1);
+      }
+  });
+
+  // Wait for the waiter to start waiting before notifying it
+  while (eventsFor(&cv).empty()) {
+    std::this_thread::yield();
+  }
+  {
+    std::unique_lock<std::mutex> lock(sync);
+    ready = true;
+    cv.notifyAll();
+  }
+  waiter.join();
+
+  std::vector<TraceEvent> events = eventsFor(&cv);
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ(TraceEventType::WAIT_BEGIN, events[0].type);
+  EXPECT_EQ(TraceEventType::NOTIFY, events[1].type);
+  EXPECT_EQ(1, events[1].value);
+  EXPECT_EQ(TraceEventType::WAIT_END, events[2].type);
+  EXPECT_EQ(events[0].thread, events[2].thread);
+  EXPECT_NE(events[0].thread, events[1].thread);
+}
+
+TEST_F(TraceTests, QueueEvents) {
+  Queue<int> q(10, 1, 2);
+
+  q.put(1);
+  q.put(2);
+  q.put(3);
+  EXPECT_EQ(1, q.get());
+  EXPECT_EQ(2, q.get());
+
+  const std::vector<TraceEventType> TRUTH{
+    TraceEventType::PUT, TraceEventType::PUT, TraceEventType::PUT,
+    TraceEventType::HIGH_WATER_MARK, TraceEventType::GET,
+    TraceEventType::GET, TraceEventType::LOW_WATER_MARK
+  };
+  std::vector<TraceEvent> events = eventsFor(&q);
+  EXPECT_EQ(TRUTH, typesOf(events));
+  ASSERT_EQ(TRUTH.size(), events.size());
+  EXPECT_EQ(3, events[2].value);
+  EXPECT_EQ(3, events[3].value);
+  EXPECT_EQ(1, events[6].value);
+}
+
+TEST_F(TraceTests, QueueWaits) {
+  Queue<int> q;
+  std::thread consumer([&]() { q.get(); });
+
+  // Only a get() that finds the queue empty waits
+  while (eventsFor(&q).empty()) {
+    std::this_thread::yield();
+  }
+  q.put(1);
+  consumer.join();
+
+  const std::vector<TraceEventType> TRUTH{
+    TraceEventType::WAIT_BEGIN, TraceEventType::PUT,
+    TraceEventType::WAIT_END, TraceEventType::GET
+  };
+  EXPECT_EQ(TRUTH, typesOf(eventsFor(&q)));
+}
+
+TEST_F(TraceTests, WriteChromeJson) {
+  int object = 0;
+  Trace::name(&object, "requests \"in\"");
+  Trace::nameThread("trace-test");
+  {
+    Trace::WaitScope wait(&object);
+  }
+  Trace::record(TraceEventType::PUT, &object, 7);
+
+  std::ostringstream out;
+  Trace::writeChromeJson(out);
+  const std::string json = out.str();
+  Trace::forget(&object);
+
+  EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"trace-test\"}"));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"wait\",\"cat\":\"pistis\","
+					 "\"ph\":\"B\""));
+  EXPECT_NE(std::string::npos, json.find("\"name\":\"wait\",\"cat\":\"pistis\","
+					 "\"ph\":\"E\""));
+  EXPECT_NE(std::string::npos,
+	    json.find("\"s\":\"t\",\"args\":{\"object\":"
+		      "\"requests \\\"in\\\"\",\"value\":7}"));
+  EXPECT_NE(std::string::npos, json.find("\"displayTimeUnit\":\"ns\"}"));
+}
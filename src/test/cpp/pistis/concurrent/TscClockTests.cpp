@@ -0,0 +1,23 @@
+#include <pistis/concurrent/TscClock.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace pistis::concurrent;
+
+TEST(TscClockTests, Advances) {
+  const uint64_t start = TscClock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  const uint64_t end = TscClock::now();
+
+  EXPECT_LT(start, end);
+  EXPECT_GT(TscClock::ticksPerSecond(), 0.0);
+
+  // Allow for the sleep overshooting by a lot on a busy machine
+  const double ns = TscClock::toNs(end - start);
+  EXPECT_LE(19e6, ns);
+  EXPECT_GE(500e6, ns);
+}
+
+TEST(TscClockTests, Conversions) {
+  EXPECT_NEAR(1e6, TscClock::toNs(TscClock::fromNs(1e6)), 1.0);
+}
@@ -0,0 +1,105 @@
+#include <pistis/concurrent/WorkStealingDeque.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+
+TEST(WorkStealingDequeTests, PushAndPopIsLifo) {
+  WorkStealingDeque<int> deque(4);
+  int x = -1;
+
+  EXPECT_TRUE(deque.empty());
+  EXPECT_FALSE(deque.pop(x));
+  EXPECT_FALSE(deque.steal(x));
+
+  for (int i = 0; i < 3; ++i) {
+    deque.push(i);
+  }
+  EXPECT_EQ(3, deque.size());
+  EXPECT_TRUE(deque.pop(x));
+  EXPECT_EQ(2, x);
+  EXPECT_TRUE(deque.pop(x));
+  EXPECT_EQ(1, x);
+  EXPECT_TRUE(deque.pop(x));
+  EXPECT_EQ(0, x);
+  EXPECT_FALSE(deque.pop(x));
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTests, StealIsFifo) {
+  WorkStealingDeque<int> deque(4);
+  int x = -1;
+
+  for (int i = 0; i < 3; ++i) {
+    deque.push(i);
+  }
+  EXPECT_TRUE(deque.steal(x));
+  EXPECT_EQ(0, x);
+  EXPECT_TRUE(deque.pop(x));
+  EXPECT_EQ(2, x);
+  EXPECT_TRUE(deque.steal(x));
+  EXPECT_EQ(1, x);
+  EXPECT_FALSE(deque.steal(x));
+}
+
+TEST(WorkStealingDequeTests, Grow) {
+  WorkStealingDeque<int> deque(2);
+  int x = -1;
+
+  EXPECT_EQ(2, deque.capacity());
+  deque.push(0);
+  EXPECT_TRUE(deque.steal(x));
+  for (int i = 1; i < 100; ++i) {
+    deque.push(i);
+  }
+  EXPECT_EQ(128, deque.capacity());
+  EXPECT_EQ(99, deque.size());
+  for (int i = 1; i < 100; ++i) {
+    ASSERT_TRUE(deque.steal(x));
+    EXPECT_EQ(i, x);
+  }
+}
+
+TEST(WorkStealingDequeTests, ConcurrentStealsTakeEachItemOnce) {
+  const int NUM_ITEMS = 100000;
+  const int NUM_THIEVES = 3;
+  WorkStealingDeque<int> deque(16);
+  std::vector<std::atomic<int> > taken(NUM_ITEMS);
+  std::atomic<bool> done(false);
+  std::vector<std::thread> thieves;
+
+  for (auto& t : taken) {
+    t = 0;
+  }
+  for (int i = 0; i < NUM_THIEVES; ++i) {
+    thieves.emplace_back([&]() {
+	int x;
+	while (!done || !deque.empty()) {
+	  if (deque.steal(x)) {
+	    ++taken[x];
+	  }
+	}
+    });
+  }
+
+  int x;
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    deque.push(i);
+    if ((i % 3 == 0) && deque.pop(x)) {
+      ++taken[x];
+    }
+  }
+  done = true;
+  for (auto& t : thieves) {
+    t.join();
+  }
+  while (deque.pop(x)) {
+    ++taken[x];
+  }
+
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    ASSERT_EQ(1, taken[i].load()) << "Item " << i;
+  }
+}
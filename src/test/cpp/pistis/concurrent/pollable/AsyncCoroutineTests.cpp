@@ -0,0 +1,136 @@
+/** @file AsyncCoroutineTests.cpp
+ *
+ *  Tests for the awaitable forms of the operations in Async.hpp.  The
+ *  test Makefile compiles this file as C++20 when the compiler supports
+ *  it; otherwise the tests compile to nothing.
+ */
+#include <pistis/concurrent/pollable/Async.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#ifdef PISTIS_CONCURRENT_HAS_COROUTINES
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  struct StringLength {
+    size_t operator()(const std::string& s) const { return s.size(); }
+  };
+
+  typedef Queue<std::string, std::allocator<std::string>,
+		NoQueueStatistics, StringLength> ByteQueue;
+
+  /** @brief Minimal coroutine type that starts eagerly and destroys
+   *         itself when it finishes
+   */
+  struct Detached {
+    struct promise_type {
+      Detached get_return_object() { return Detached(); }
+      std::suspend_never initial_suspend() { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() { }
+      void unhandled_exception() { std::terminate(); }
+    };
+  };
+
+  void runUntilIdle(Scheduler& scheduler) {
+    while (scheduler.runOnce(0)) {
+    }
+  }
+
+  int64_t msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+	std::chrono::steady_clock::now() - start
+    ).count();
+  }
+
+  Detached consume(Scheduler& scheduler, Queue<int>& q, int n,
+		   std::vector<int>& items) {
+    for (int i = 0; i < n; ++i) {
+      items.push_back(co_await asyncGet(scheduler, q));
+    }
+  }
+
+  Detached produce(Scheduler& scheduler, Queue<int>& q, int n) {
+    for (int i = 0; i < n; ++i) {
+      co_await asyncPut(scheduler, q, i);
+    }
+  }
+
+  Detached produceOne(Scheduler& scheduler, ByteQueue& q, std::string item,
+		      int& done) {
+    co_await asyncPut(scheduler, q, std::move(item));
+    ++done;
+  }
+
+  Detached signalled(Scheduler& scheduler, Semaphore& semaphore,
+		     Condition& condition, int& stage) {
+    co_await asyncDown(scheduler, semaphore);
+    stage = 1;
+    co_await asyncWait(scheduler, condition);
+    stage = 2;
+  }
+}
+
+TEST(AsyncCoroutineTests, CoroutinesShareQueue) {
+  Scheduler scheduler;
+  Queue<int> q(2);
+  std::vector<int> items;
+
+  consume(scheduler, q, 10, items);
+  produce(scheduler, q, 10);
+  runUntilIdle(scheduler);
+
+  std::vector<int> expected;
+  for (int i = 0; i < 10; ++i) {
+    expected.push_back(i);
+  }
+  EXPECT_EQ(expected, items);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(AsyncCoroutineTests, PutThatDoesNotFitWaitsForQueueToShrink) {
+  Scheduler scheduler;
+  ByteQueue q(10, 10, 10);
+  int done = 0;
+
+  q.put("12345");
+  produceOne(scheduler, q, "abcdefgh", done);
+  runUntilIdle(scheduler);
+  EXPECT_EQ(0, done);
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(0, scheduler.runOnce(100));
+  EXPECT_GE(msSince(start), 90);
+
+  EXPECT_EQ("12345", q.get());
+  runUntilIdle(scheduler);
+  EXPECT_EQ(1, done);
+  EXPECT_EQ("abcdefgh", q.get());
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(AsyncCoroutineTests, DownAndWait) {
+  Scheduler scheduler;
+  Semaphore semaphore(0);
+  Condition condition;
+  int stage = 0;
+
+  signalled(scheduler, semaphore, condition, stage);
+  runUntilIdle(scheduler);
+  EXPECT_EQ(0, stage);
+
+  semaphore.up();
+  runUntilIdle(scheduler);
+  EXPECT_EQ(1, stage);
+
+  condition.notifyOne();
+  runUntilIdle(scheduler);
+  EXPECT_EQ(2, stage);
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include <pistis/concurrent/pollable/Async.hpp>
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  struct StringLength {
+    size_t operator()(const std::string& s) const { return s.size(); }
+  };
+
+  typedef Queue<std::string, std::allocator<std::string>,
+		NoQueueStatistics, StringLength> ByteQueue;
+
+  void runUntilIdle(Scheduler& scheduler) {
+    while (scheduler.runOnce(0)) {
+    }
+  }
+
+  int64_t msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+	std::chrono::steady_clock::now() - start
+    ).count();
+  }
+}
+
+TEST(AsyncTests, GetWaitsForItems) {
+  Scheduler scheduler;
+  Queue<std::string> q;
+  std::vector<std::string> items;
+
+  for (int i = 0; i < 3; ++i) {
+    asyncGet(scheduler, q, [&](std::string item) { items.push_back(item); });
+  }
+  runUntilIdle(scheduler);
+  EXPECT_TRUE(items.empty());
+  EXPECT_EQ(3, scheduler.numWaiters());
+
+  q.put("a");
+  q.put("b");
+  runUntilIdle(scheduler);
+  EXPECT_EQ(std::vector<std::string>({ "a", "b" }), items);
+  EXPECT_EQ(1, scheduler.numWaiters());
+
+  q.put("c");
+  runUntilIdle(scheduler);
+  EXPECT_EQ(std::vector<std::string>({ "a", "b", "c" }), items);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(AsyncTests, PutWaitsForRoom) {
+  Scheduler scheduler;
+  Queue<int> q(1);
+  int done = 0;
+
+  asyncPut(scheduler, q, 1, [&]() { ++done; });
+  asyncPut(scheduler, q, 2, [&]() { ++done; });
+  runUntilIdle(scheduler);
+  EXPECT_EQ(1, done);
+  EXPECT_EQ(1, q.size());
+
+  EXPECT_EQ(1, q.get());
+  runUntilIdle(scheduler);
+  EXPECT_EQ(2, done);
+  EXPECT_EQ(2, q.get());
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(AsyncTests, PutThatDoesNotFitWaitsForQueueToShrink) {
+  Scheduler scheduler;
+  ByteQueue q(10, 10, 10);
+  int done = 0;
+
+  q.put("12345");
+  asyncPut(scheduler, q, "abcdefgh", [&]() { ++done; });
+  runUntilIdle(scheduler);
+  EXPECT_EQ(0, done);
+
+  // queueStateFd() is still writable, but the put should not be retried
+  // until the queue shrinks
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(0, scheduler.runOnce(100));
+  EXPECT_GE(msSince(start), 90);
+
+  EXPECT_EQ("12345", q.get());
+  runUntilIdle(scheduler);
+  EXPECT_EQ(1, done);
+  EXPECT_EQ("abcdefgh", q.get());
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(AsyncTests, Down) {
+  Scheduler scheduler;
+  Semaphore semaphore(0);
+  int done = 0;
+
+  asyncDown(scheduler, semaphore, [&]() { ++done; });
+  runUntilIdle(scheduler);
+  EXPECT_EQ(0, done);
+
+  semaphore.up();
+  runUntilIdle(scheduler);
+  EXPECT_EQ(1, done);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(AsyncTests, WaitRunsOnSchedulerThread) {
+  Scheduler scheduler;
+  Condition condition;
+  int done = 0;
+
+  asyncWait(scheduler, condition, [&]() { ++done; });
+  asyncWait(scheduler, condition, [&]() { ++done; });
+  condition.notifyAll();
+  EXPECT_EQ(0, done);
+
+  runUntilIdle(scheduler);
+  EXPECT_EQ(2, done);
+}
@@ -0,0 +1,90 @@
+#include <pistis/concurrent/pollable/Barrier.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+TEST(BarrierTests, Arrive) {
+  int completions = 0;
+  Barrier barrier(2, [&completions]() { ++completions; });
+
+  EXPECT_EQ(2, barrier.numParties());
+  EXPECT_EQ(0, barrier.phase());
+
+  EpollSet pollSet(barrier.fd(0), EpollEventType::READ);
+  EXPECT_EQ(0, barrier.arrive());
+  EXPECT_FALSE(barrier.wait(0, 0));
+  EXPECT_FALSE(pollSet.wait(0));
+  EXPECT_EQ(0, completions);
+
+  EXPECT_EQ(0, barrier.arrive());
+  EXPECT_TRUE(barrier.wait(0, 0));
+  EXPECT_TRUE(pollSet.wait(0));
+  EXPECT_EQ(1, completions);
+  EXPECT_EQ(1, barrier.phase());
+
+  // Phase 0's fd stays readable until phase 1 ends
+  EpollSet nextPollSet(barrier.fd(1), EpollEventType::READ);
+  EXPECT_EQ(1, barrier.arrive());
+  EXPECT_TRUE(pollSet.wait(0));
+  EXPECT_FALSE(nextPollSet.wait(0));
+  EXPECT_EQ(1, barrier.arrive());
+  EXPECT_TRUE(nextPollSet.wait(0));
+  EXPECT_EQ(2, completions);
+
+  // Phase 2 reuses phase 0's fd
+  EXPECT_EQ(barrier.fd(0), barrier.fd(2));
+  EXPECT_FALSE(pollSet.wait(0));
+  EXPECT_TRUE(barrier.wait(0, 0));
+
+  EXPECT_THROW(Barrier(0), IllegalValueError);
+}
+
+TEST(BarrierTests, ThrowingCompletionEndsPhase) {
+  Barrier barrier(2, []() { throw std::runtime_error("completion"); });
+
+  EXPECT_EQ(0, barrier.arrive());
+  EXPECT_THROW(barrier.arrive(), std::runtime_error);
+  EXPECT_TRUE(barrier.wait(0, 0));
+  EXPECT_EQ(1, barrier.phase());
+
+  // The barrier is still usable
+  EXPECT_EQ(1, barrier.arrive());
+  EXPECT_FALSE(barrier.wait(1, 0));
+}
+
+TEST(BarrierTests, ManyPhases) {
+  const int NUM_THREADS = 4;
+  const int NUM_PHASES = 200;
+  std::atomic<int> arrived(0);
+  std::atomic<int> errors(0);
+  Barrier barrier(NUM_THREADS);
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&]() {
+	for (int p = 0; p < NUM_PHASES; ++p) {
+	  ++arrived;
+	  if (!barrier.arriveAndWait(5000)) {
+	    ++errors;
+	  }
+	  // Nobody passes phase p before everyone has arrived at it
+	  if (arrived.load() < (p + 1) * NUM_THREADS) {
+	    ++errors;
+	  }
+	}
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, errors.load());
+  EXPECT_EQ(NUM_PHASES, barrier.phase());
+}
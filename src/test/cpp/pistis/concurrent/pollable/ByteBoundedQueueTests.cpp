@@ -0,0 +1,132 @@
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <poll.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  struct StringBytes {
+    size_t operator()(const std::string& s) const { return s.size(); }
+  };
+
+  typedef ByteBoundedQueue<std::string, StringBytes> StringQueue;
+
+  bool isReadable(int fd) {
+    ::pollfd p{ fd, POLLIN, 0 };
+    return (::poll(&p, 1, 0) == 1) && (p.revents & POLLIN);
+  }
+
+  bool isWritable(int fd) {
+    ::pollfd p{ fd, POLLOUT, 0 };
+    return (::poll(&p, 1, 0) == 1) && (p.revents & POLLOUT);
+  }
+}
+
+TEST(ByteBoundedQueueTests, TracksTotalCost) {
+  StringQueue q(10, 10, 10);
+  std::vector<std::string> buffer;
+
+  q.put("abc");
+  q.put("defgh");
+  EXPECT_EQ(2, q.size());
+  EXPECT_EQ(8, q.totalCost());
+
+  EXPECT_EQ("abc", q.get());
+  EXPECT_EQ(5, q.totalCost());
+
+  q.put("ij");
+  EXPECT_EQ(1, q.drainInto(buffer, 1));
+  EXPECT_EQ(2, q.totalCost());
+
+  q.clear();
+  EXPECT_EQ(0, q.totalCost());
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(ByteBoundedQueueTests, PutFailsWhenItemDoesNotFit) {
+  StringQueue q(10, 10, 10);
+
+  EXPECT_TRUE(q.put("abcdefg", 0));
+  EXPECT_FALSE(q.put("hijk", 0));
+  EXPECT_TRUE(q.put("hij", 0));
+  EXPECT_EQ(10, q.totalCost());
+  EXPECT_FALSE(q.put("k", 0));
+}
+
+TEST(ByteBoundedQueueTests, OversizedItemFitsOnlyWhenEmpty) {
+  StringQueue q(4, 4, 4);
+
+  EXPECT_TRUE(q.put("abcdefgh", 0));
+  EXPECT_EQ(8, q.totalCost());
+  EXPECT_FALSE(q.put("a", 0));
+
+  q.get();
+  EXPECT_TRUE(q.put("a", 0));
+  EXPECT_FALSE(q.put("abcdefgh", 0));
+}
+
+TEST(ByteBoundedQueueTests, ProducerBlocksUntilItemFits) {
+  StringQueue q(10, 10, 10);
+  WorkerThread thread;
+
+  q.put("abcdef");
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      if (!q.put("ghijkl", 1000)) {
+	t.addError("put() did not complete within 1s");
+      }
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  EXPECT_EQ("abcdef", q.get());
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  EXPECT_EQ(6, q.totalCost());
+}
+
+TEST(ByteBoundedQueueTests, WaterMarksCountBytes) {
+  StringQueue q(100, 4, 8);
+  const int hwm = q.observe(QueueEventType::HIGH_WATER_MARK);
+  const int lwm = q.observe(QueueEventType::LOW_WATER_MARK);
+
+  q.put("abcde");
+  EXPECT_FALSE(q.aboveHighWaterMark());
+  EXPECT_FALSE(isReadable(hwm));
+
+  q.put("fghi");
+  EXPECT_TRUE(q.aboveHighWaterMark());
+  EXPECT_TRUE(isReadable(hwm));
+  EXPECT_FALSE(isReadable(lwm));
+
+  q.get();
+  EXPECT_TRUE(q.atOrBelowLowWaterMark());
+  EXPECT_TRUE(isReadable(lwm));
+
+  q.stopObserving(hwm, QueueEventType::HIGH_WATER_MARK);
+  q.stopObserving(lwm, QueueEventType::LOW_WATER_MARK);
+}
+
+TEST(ByteBoundedQueueTests, QueueStateFdFollowsBytes) {
+  StringQueue q(6, 6, 6);
+  const int fd = q.queueStateFd();
+
+  EXPECT_FALSE(isReadable(fd));
+  EXPECT_TRUE(isWritable(fd));
+
+  q.put("abc");
+  EXPECT_TRUE(isReadable(fd));
+  EXPECT_TRUE(isWritable(fd));
+
+  q.put("def");
+  EXPECT_TRUE(isReadable(fd));
+  EXPECT_FALSE(isWritable(fd));
+
+  q.getAll();
+  EXPECT_FALSE(isReadable(fd));
+  EXPECT_TRUE(isWritable(fd));
+}
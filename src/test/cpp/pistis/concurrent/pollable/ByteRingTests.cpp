@@ -0,0 +1,176 @@
+#include <pistis/concurrent/pollable/ByteRing.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  short pollState(int fd) {
+    ::pollfd p{ fd, POLLIN | POLLOUT, 0 };
+    return (::poll(&p, 1, 0) == 1) ? p.revents : 0;
+  }
+
+  void write(ByteRing& ring, const std::string& text) {
+    char* p = ring.reserve(text.size());
+    ASSERT_NE(nullptr, p);
+    ::memcpy(p, text.data(), text.size());
+    ring.commit(text.size());
+  }
+}
+
+TEST(ByteRingTests, Create) {
+  const size_t pageSize = (size_t)::sysconf(_SC_PAGESIZE);
+  ByteRing ring(100);
+
+  EXPECT_EQ(pageSize, ring.capacity());
+  EXPECT_EQ(0, ring.size());
+  EXPECT_EQ(pageSize, ring.available());
+  EXPECT_EQ(1, ring.writeThreshold());
+  EXPECT_EQ(POLLOUT, pollState(ring.fd()));
+}
+
+TEST(ByteRingTests, ReserveCommitPeekRelease) {
+  ByteRing ring(4096);
+  size_t n = 0;
+
+  EXPECT_EQ(nullptr, ring.peek(n));
+  EXPECT_EQ(0, n);
+
+  char* p = ring.reserve(10);
+  ASSERT_NE(nullptr, p);
+  ::memcpy(p, "hello", 5);
+  EXPECT_EQ(0, ring.size());
+  ring.commit(5);
+  EXPECT_EQ(5, ring.size());
+  EXPECT_EQ(POLLIN | POLLOUT, pollState(ring.fd()));
+
+  write(ring, "world");
+  const char* q = ring.peek(n);
+  ASSERT_EQ(10, n);
+  EXPECT_EQ("helloworld", std::string(q, n));
+
+  ring.release(5);
+  q = ring.peek(n);
+  EXPECT_EQ("world", std::string(q, n));
+  ring.release(5);
+  EXPECT_EQ(0, ring.size());
+  EXPECT_EQ(POLLOUT, pollState(ring.fd()));
+}
+
+TEST(ByteRingTests, RecordsDoNotStraddleWrap) {
+  ByteRing ring(4096);
+  const size_t capacity = ring.capacity();
+  size_t n;
+
+  // Move the ring's position close to the end of the buffer
+  ASSERT_NE(nullptr, ring.reserve(capacity - 3));
+  ring.commit(capacity - 3);
+  ring.peek(n);
+  ring.release(n);
+
+  write(ring, "wrapped record");
+  const char* p = ring.peek(n);
+  ASSERT_EQ(14, n);
+  EXPECT_EQ("wrapped record", std::string(p, n));
+  ring.release(n);
+}
+
+TEST(ByteRingTests, ReserveFailsWhenFull) {
+  ByteRing ring(4096);
+  const size_t capacity = ring.capacity();
+
+  ASSERT_NE(nullptr, ring.reserve(capacity - 10));
+  ring.commit(capacity - 10);
+  EXPECT_EQ(nullptr, ring.reserve(11));
+  EXPECT_EQ(nullptr, ring.reserve(11, 20));
+  EXPECT_NE(nullptr, ring.reserve(10));
+  ring.commit(10);
+  EXPECT_EQ(POLLIN, pollState(ring.fd()));
+
+  EXPECT_THROW(ring.reserve(0), IllegalValueError);
+  EXPECT_THROW(ring.reserve(capacity + 1), IllegalValueError);
+}
+
+TEST(ByteRingTests, IllegalCommitAndRelease) {
+  ByteRing ring(4096);
+
+  ring.reserve(4);
+  EXPECT_THROW(ring.commit(5), IllegalValueError);
+  ring.commit(4);
+  EXPECT_THROW(ring.commit(1), IllegalValueError);
+  EXPECT_THROW(ring.release(5), IllegalValueError);
+}
+
+TEST(ByteRingTests, WriteThreshold) {
+  ByteRing ring(4096, 100);
+  const size_t capacity = ring.capacity();
+
+  ring.reserve(capacity - 100);
+  ring.commit(capacity - 100);
+  EXPECT_EQ(POLLIN | POLLOUT, pollState(ring.fd()));
+
+  write(ring, "x");
+  EXPECT_EQ(POLLIN, pollState(ring.fd()));
+
+  ring.setWriteThreshold(99);
+  EXPECT_EQ(POLLIN | POLLOUT, pollState(ring.fd()));
+  EXPECT_THROW(ring.setWriteThreshold(0), IllegalValueError);
+  EXPECT_THROW(ring.setWriteThreshold(capacity + 1), IllegalValueError);
+}
+
+TEST(ByteRingTests, ConsumerWaitsForData) {
+  ByteRing ring(4096);
+  WorkerThread thread;
+  std::string received;
+
+  thread.start([&](WorkerThread& t) {
+      size_t n;
+      t.setState(ThreadState::WAITING);
+      const char* p = ring.peek(n, 1000);
+      if (!p) {
+	t.addError("No data arrived within 1s");
+      } else {
+	received.assign(p, n);
+	ring.release(n);
+      }
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  write(ring, "record");
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  EXPECT_EQ("record", received);
+}
+
+TEST(ByteRingTests, ProducerWaitsForRoom) {
+  ByteRing ring(4096);
+  const size_t capacity = ring.capacity();
+  WorkerThread thread;
+
+  ring.reserve(capacity);
+  ring.commit(capacity);
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      char* p = ring.reserve(16, 1000);
+      if (!p) {
+	t.addError("No room became available within 1s");
+      } else {
+	ring.commit(16);
+      }
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  ring.release(16);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  EXPECT_EQ(capacity, ring.size());
+}
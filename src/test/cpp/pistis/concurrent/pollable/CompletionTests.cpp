@@ -0,0 +1,38 @@
+#include <pistis/concurrent/pollable/Completion.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+TEST(CompletionTests, Complete) {
+  Completion c;
+  Completion copy(c);
+
+  EXPECT_GE(c.fd(), 0);
+  EXPECT_FALSE(c.done());
+  EXPECT_FALSE(c.wait(0));
+  EXPECT_FALSE(c.wait(10));
+
+  c.complete();
+  EXPECT_TRUE(copy.done());
+  EXPECT_FALSE(copy.failed());
+  EXPECT_TRUE(copy.wait(0));
+  copy.get();
+  EXPECT_THROW(copy.complete(), IllegalStateError);
+}
+
+TEST(CompletionTests, CompleteWithError) {
+  Completion c;
+  std::thread t([c]() mutable {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      c.complete(std::make_exception_ptr(std::runtime_error("oops")));
+  });
+
+  EXPECT_TRUE(c.wait(1000));
+  EXPECT_TRUE(c.failed());
+  EXPECT_THROW(c.get(), std::runtime_error);
+  t.join();
+}
@@ -2,6 +2,7 @@
 #include <pistis/concurrent/EpollSet.hpp>
 #include <pistis/concurrent/WorkerThread.hpp>
 #include <gtest/gtest.h>
+#include <functional>
 
 using namespace pistis::concurrent;
 using namespace pistis::concurrent::pollable;
@@ -291,3 +292,97 @@ TEST(ConditionTests, Guard) {
   ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
   thread.join();
 }
+
+TEST(ConditionTests, WaitWithLock) {
+  Condition condition;
+  std::mutex sync;
+  WorkerThread thread;
+  bool triggered = false;
+  bool ownedLock = false;
+
+  thread.start([&](WorkerThread& t) {
+      std::unique_lock<std::mutex> lock(sync);
+      t.setState(ThreadState::WAITING);
+      triggered = condition.wait(lock, 1000);
+      ownedLock = lock.owns_lock();
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+
+  // Once this thread can acquire the lock, the waiter is registered,
+  // so notifying while holding the lock cannot be missed.
+  {
+    std::unique_lock<std::mutex> lock(sync);
+    condition.notifyOne();
+  }
+
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+  EXPECT_TRUE(triggered);
+  EXPECT_TRUE(ownedLock);
+}
+
+TEST(ConditionTests, WaitWithLockTimesOut) {
+  Condition condition;
+  std::mutex sync;
+  std::unique_lock<std::mutex> lock(sync);
+
+  EXPECT_FALSE(condition.wait(lock, 50));
+  EXPECT_TRUE(lock.owns_lock());
+}
+
+TEST(ConditionTests, WhenNotified) {
+  Condition condition;
+  int calls = 0;
+
+  condition.whenNotified([&]() { ++calls; });
+  condition.whenNotified([&]() { ++calls; });
+  EXPECT_EQ(0, calls);
+
+  condition.notifyOne();
+  EXPECT_EQ(1, calls);
+
+  condition.notifyAll();
+  EXPECT_EQ(2, calls);
+
+  condition.notifyAll();
+  EXPECT_EQ(2, calls);
+}
+
+TEST(ConditionTests, WhenNotifiedCanReregister) {
+  Condition condition;
+  int calls = 0;
+  std::function<void ()> callback = [&]() {
+    if (++calls < 3) {
+      condition.whenNotified(callback);
+    }
+  };
+
+  condition.whenNotified(callback);
+  for (int i = 0; i < 5; ++i) {
+    condition.notifyOne();
+  }
+  EXPECT_EQ(3, calls);
+}
+
+TEST(ConditionTests, TryAck) {
+  Condition cv(BlockingMode::DONT_BLOCK);
+  int fd = cv.observe();
+  EpollSet epollSet(fd, EpollEventType::READ);
+
+  EXPECT_FALSE(cv.tryAck(fd));
+  EXPECT_FALSE(epollSet.wait(0));
+
+  cv.notifyAll();
+  EXPECT_TRUE(epollSet.wait(0));
+  EXPECT_TRUE(cv.tryAck(fd));
+  EXPECT_FALSE(epollSet.wait(0));
+  EXPECT_FALSE(cv.tryAck(fd));
+
+  // The acknowledged descriptor receives the next notification
+  cv.notifyOne();
+  EXPECT_TRUE(cv.tryAck(fd));
+
+  cv.stopObserving(fd);
+  EXPECT_THROW(cv.tryAck(fd), NoSuchItem);
+}
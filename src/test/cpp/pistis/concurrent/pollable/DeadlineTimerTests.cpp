@@ -0,0 +1,57 @@
+#include <pistis/concurrent/pollable/DeadlineTimer.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <poll.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  bool isReadable(int fd, int timeout = 0) {
+    ::pollfd p{ fd, POLLIN, 0 };
+    return (::poll(&p, 1, timeout) == 1) && (p.revents & POLLIN);
+  }
+}
+
+TEST(DeadlineTimerTests, BecomesReadableAtDeadline) {
+  DeadlineTimer timer;
+  const auto deadline = DeadlineTimer::Clock::now() +
+                        std::chrono::milliseconds(30);
+
+  EXPECT_FALSE(timer.armed());
+  timer.arm(deadline);
+  EXPECT_TRUE(timer.armed());
+  EXPECT_EQ(deadline, timer.deadline());
+  EXPECT_FALSE(isReadable(timer.fd()));
+
+  EXPECT_TRUE(isReadable(timer.fd(), 1000));
+  EXPECT_GE(DeadlineTimer::Clock::now(), deadline);
+
+  EXPECT_TRUE(timer.clear());
+  EXPECT_FALSE(timer.armed());
+  EXPECT_FALSE(isReadable(timer.fd()));
+  EXPECT_FALSE(timer.clear());
+}
+
+TEST(DeadlineTimerTests, PastDeadlineIsReadableImmediately) {
+  DeadlineTimer timer;
+
+  timer.arm(DeadlineTimer::TimePoint());
+  EXPECT_TRUE(isReadable(timer.fd(), 100));
+}
+
+TEST(DeadlineTimerTests, ArmAndDisarmDiscardExpiration) {
+  DeadlineTimer timer;
+
+  timer.arm(DeadlineTimer::Clock::now());
+  ASSERT_TRUE(isReadable(timer.fd(), 100));
+
+  timer.arm(DeadlineTimer::Clock::now() + std::chrono::seconds(10));
+  EXPECT_FALSE(isReadable(timer.fd()));
+
+  timer.arm(DeadlineTimer::Clock::now());
+  ASSERT_TRUE(isReadable(timer.fd(), 100));
+  timer.disarm();
+  EXPECT_FALSE(timer.armed());
+  EXPECT_FALSE(isReadable(timer.fd()));
+}
@@ -0,0 +1,122 @@
+#include <pistis/concurrent/pollable/DelayQueue.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <poll.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef DelayQueue<std::string> StringQueue;
+
+  bool isReadable(int fd, int timeout = 0) {
+    ::pollfd p{ fd, POLLIN, 0 };
+    return (::poll(&p, 1, timeout) == 1) && (p.revents & POLLIN);
+  }
+}
+
+TEST(DelayQueueTests, ItemsBecomeReadyInDeadlineOrder) {
+  StringQueue q;
+  const auto now = StringQueue::Clock::now();
+  std::string item;
+
+  q.put("c", now + std::chrono::milliseconds(60));
+  q.put("a", now + std::chrono::milliseconds(20));
+  q.put("b", now + std::chrono::milliseconds(40));
+  EXPECT_EQ(3, q.size());
+  EXPECT_FALSE(q.get(item, 0));
+
+  StringQueue::TimePoint next;
+  ASSERT_TRUE(q.nextReadyAt(next));
+  EXPECT_EQ(now + std::chrono::milliseconds(20), next);
+
+  ASSERT_TRUE(q.get(item, 1000));
+  EXPECT_EQ("a", item);
+  EXPECT_GE(StringQueue::Clock::now(), now + std::chrono::milliseconds(20));
+  EXPECT_EQ("b", q.get());
+  EXPECT_EQ("c", q.get());
+  EXPECT_GE(StringQueue::Clock::now(), now + std::chrono::milliseconds(60));
+  EXPECT_TRUE(q.empty());
+  EXPECT_FALSE(q.nextReadyAt(next));
+}
+
+TEST(DelayQueueTests, EqualDeadlinesAreFifo) {
+  StringQueue q;
+  const auto readyAt = StringQueue::Clock::now();
+  std::vector<std::string> items;
+
+  q.put("a", readyAt);
+  q.put("b", readyAt);
+  q.put("c", readyAt);
+  EXPECT_EQ(3, q.drainReady(items));
+  EXPECT_EQ(std::vector<std::string>({ "a", "b", "c" }), items);
+}
+
+TEST(DelayQueueTests, GetTimesOutBeforeDeadline) {
+  StringQueue q;
+  std::string item;
+
+  q.putAfter("a", 500);
+  EXPECT_FALSE(q.get(item, 20));
+  EXPECT_EQ(1, q.size());
+}
+
+TEST(DelayQueueTests, FdReadableOnlyWhileItemIsReady) {
+  StringQueue q;
+  const auto now = StringQueue::Clock::now();
+
+  EXPECT_FALSE(isReadable(q.fd()));
+
+  q.put("b", now + std::chrono::milliseconds(500));
+  EXPECT_FALSE(isReadable(q.fd(), 20));
+
+  // An earlier item moves the timer forward
+  q.put("a", now + std::chrono::milliseconds(20));
+  EXPECT_TRUE(isReadable(q.fd(), 1000));
+
+  EXPECT_EQ("a", q.get());
+  EXPECT_FALSE(isReadable(q.fd()));
+
+  q.clear();
+  EXPECT_FALSE(isReadable(q.fd()));
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(DelayQueueTests, DrainReadyLeavesPendingItems) {
+  StringQueue q;
+  std::vector<std::string> items;
+
+  q.putAfter("late", 1000);
+  q.putAfter("now", 0);
+  q.putAfter("now2", 0);
+
+  EXPECT_EQ(1, q.drainReady(items, 1));
+  EXPECT_EQ(1, q.drainReady(items));
+  EXPECT_EQ(std::vector<std::string>({ "now", "now2" }), items);
+  EXPECT_EQ(1, q.size());
+  EXPECT_FALSE(isReadable(q.fd()));
+}
+
+TEST(DelayQueueTests, PutWakesBlockedConsumer) {
+  StringQueue q;
+  WorkerThread thread;
+  std::string item;
+
+  q.putAfter("late", 10000);
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      if (!q.get(item, 1000)) {
+	t.addError("get() did not return an item within 1s");
+      }
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  q.putAfter("soon", 10);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 500));
+  EXPECT_EQ("soon", item);
+}
@@ -0,0 +1,268 @@
+#include <pistis/concurrent/pollable/Future.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/PoolAllocator.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  struct FakeExecutor {
+    std::vector< std::function<void ()> > tasks;
+
+    void execute(std::function<void ()> task) {
+      tasks.push_back(std::move(task));
+    }
+  };
+
+  struct StoppedExecutor {
+    void execute(std::function<void ()>) {
+      throw IllegalStateError("Executor is shutting down", PISTIS_EX_HERE);
+    }
+  };
+}
+
+TEST(FutureTests, SetValue) {
+  Promise<std::string> promise;
+  Future<std::string> future = promise.future();
+
+  EXPECT_TRUE(future.valid());
+  EXPECT_FALSE(future.ready());
+  EXPECT_FALSE(promise.satisfied());
+  EXPECT_FALSE(future.wait(0));
+
+  promise.setValue("hello");
+  EXPECT_TRUE(future.ready());
+  EXPECT_FALSE(future.failed());
+  EXPECT_TRUE(promise.satisfied());
+  EXPECT_EQ("hello", future.get());
+  EXPECT_EQ("hello", promise.future().get());
+  EXPECT_THROW(promise.setValue("again"), IllegalStateError);
+
+  EXPECT_FALSE(Future<int>().valid());
+}
+
+TEST(FutureTests, SetError) {
+  Promise<int> promise;
+  Future<int> future = promise.future();
+
+  promise.setError(std::make_exception_ptr(std::runtime_error("oops")));
+  EXPECT_TRUE(future.ready());
+  EXPECT_TRUE(future.failed());
+  EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(FutureTests, SetFrom) {
+  Promise<int> p1;
+  p1.setFrom([]() { return 3; });
+  EXPECT_EQ(3, p1.future().get());
+
+  Promise<void> p2;
+  p2.setFrom([]() { throw std::runtime_error("oops"); });
+  EXPECT_THROW(p2.future().get(), std::runtime_error);
+}
+
+TEST(FutureTests, BrokenPromise) {
+  Future<int> future;
+  {
+    Promise<int> promise;
+    future = promise.future();
+  }
+  EXPECT_TRUE(future.failed());
+  EXPECT_THROW(future.get(), IllegalStateError);
+
+  // Moving a promise does not break it
+  Promise<int> p1;
+  Promise<int> p2(std::move(p1));
+  EXPECT_FALSE(p2.future().ready());
+}
+
+TEST(FutureTests, FdIsReadableWhenReady) {
+  Promise<int> promise;
+  Future<int> future = promise.future();
+  EpollSet pollSet(future.fd(), EpollEventType::READ);
+
+  EXPECT_FALSE(pollSet.wait(0));
+  std::thread t([&promise]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      promise.setValue(7);
+  });
+  ASSERT_TRUE(pollSet.wait(1000));
+  EXPECT_EQ(7, future.get());
+  EXPECT_TRUE(pollSet.wait(0));
+  t.join();
+
+  // A future that is already ready has a readable fd too
+  Promise<void> done;
+  done.setValue();
+  EpollSet donePollSet(done.future().fd(), EpollEventType::READ);
+  EXPECT_TRUE(donePollSet.wait(0));
+}
+
+TEST(FutureTests, WaitAcrossThreads) {
+  Promise<int> promise;
+  Future<int> future = promise.future();
+  std::thread t([&promise]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      promise.setValue(5);
+  });
+
+  EXPECT_FALSE(future.wait(0));
+  EXPECT_TRUE(future.wait(1000));
+  EXPECT_EQ(5, future.get());
+  t.join();
+}
+
+TEST(FutureTests, Then) {
+  Promise<int> promise;
+  Future<std::string> doubled =
+      promise.future()
+          .then([](const int& x) { return 2 * x; })
+          .then([](const int& x) { return std::to_string(x); });
+  Future<void> done = doubled.then([](const std::string&) { });
+  Future<int> afterVoid = done.then([]() { return 1; });
+
+  EXPECT_FALSE(doubled.ready());
+  promise.setValue(21);
+  EXPECT_EQ("42", doubled.get());
+  EXPECT_TRUE(done.ready());
+  EXPECT_EQ(1, afterVoid.get());
+
+  // Continuing a ready future runs the continuation immediately
+  EXPECT_EQ(43, promise.future().then([](const int& x) { return x + 22; })
+	            .get());
+}
+
+TEST(FutureTests, ThenPropagatesErrors) {
+  Promise<int> promise;
+  bool called = false;
+  Future<int> next = promise.future().then([&called](const int& x) {
+      called = true;
+      return x;
+  });
+  Future<int> thrown = next.then([](const int&) -> int {
+      throw std::runtime_error("oops");
+  });
+
+  promise.setError(std::make_exception_ptr(std::logic_error("bad")));
+  EXPECT_FALSE(called);
+  EXPECT_THROW(next.get(), std::logic_error);
+  EXPECT_THROW(thrown.get(), std::logic_error);
+
+  Promise<int> p2;
+  Future<int> thrown2 = p2.future().then([](const int&) -> int {
+      throw std::runtime_error("oops");
+  });
+  p2.setValue(1);
+  EXPECT_THROW(thrown2.get(), std::runtime_error);
+}
+
+TEST(FutureTests, ThenOnExecutor) {
+  FakeExecutor executor;
+  Promise<int> promise;
+  Future<int> next = promise.future().then(executor, [](const int& x) {
+      return x + 1;
+  });
+
+  promise.setValue(1);
+  EXPECT_FALSE(next.ready());
+  ASSERT_EQ(1, executor.tasks.size());
+  executor.tasks[0]();
+  EXPECT_EQ(2, next.get());
+}
+
+TEST(FutureTests, ThenOnStoppedExecutorFails) {
+  StoppedExecutor executor;
+  Promise<int> promise;
+  Future<int> next = promise.future().then(executor, [](const int& x) {
+      return x + 1;
+  });
+  Future<int> after = promise.future().then([](const int& x) {
+      return x + 2;
+  });
+
+  promise.setValue(1);
+  ASSERT_TRUE(next.ready());
+  EXPECT_THROW(next.get(), IllegalStateError);
+  EXPECT_EQ(3, after.get());
+}
+
+TEST(FutureTests, WhenAll) {
+  std::vector< Promise<int> > promises(3);
+  std::vector< Future<int> > futures;
+  for (auto& p : promises) {
+    futures.push_back(p.future());
+  }
+
+  Future<void> all = whenAll(futures);
+  EpollSet pollSet(all.fd(), EpollEventType::READ);
+  promises[2].setValue(2);
+  promises[0].setError(std::make_exception_ptr(std::runtime_error("oops")));
+  EXPECT_FALSE(pollSet.wait(0));
+  promises[1].setValue(1);
+  EXPECT_TRUE(pollSet.wait(0));
+  EXPECT_FALSE(all.failed());
+  EXPECT_TRUE(futures[0].failed());
+  EXPECT_EQ(1, futures[1].get());
+
+  EXPECT_TRUE(whenAll(std::vector< Future<int> >()).ready());
+}
+
+TEST(FutureTests, WhenAny) {
+  std::vector< Promise<void> > promises(3);
+  std::vector< Future<void> > futures;
+  for (auto& p : promises) {
+    futures.push_back(p.future());
+  }
+
+  Future<size_t> any = whenAny(futures);
+  EXPECT_FALSE(any.ready());
+  promises[1].setValue();
+  promises[0].setValue();
+  EXPECT_EQ(1, any.get());
+
+  EXPECT_THROW(whenAny(std::vector< Future<int> >()), IllegalValueError);
+}
+
+TEST(FutureTests, PoolAllocatedState) {
+  auto pool = std::make_shared<BlockPool>(512);
+  PoolAllocator<char> allocator(pool);
+  {
+    Promise<int> promise(std::allocator_arg, allocator);
+    EXPECT_EQ(1, pool->numChunks());
+    promise.setValue(3);
+    EXPECT_EQ(3, promise.future().get());
+  }
+  EXPECT_EQ(pool->blocksPerChunk(), pool->numFreeBlocks());
+}
+
+TEST(FutureTests, PoolAllocatedContinuations) {
+  auto pool = std::make_shared<BlockPool>(512);
+  PoolAllocator<char> allocator(pool);
+  {
+    Promise<int> promise(std::allocator_arg, allocator);
+    std::vector< Future<int> > futures{
+      promise.future(),
+      promise.future().then(std::allocator_arg, allocator,
+			    [](const int& x) { return x + 1; })
+    };
+    Future<void> all = whenAll(std::allocator_arg, allocator, futures);
+    Future<size_t> any = whenAny(std::allocator_arg, allocator, futures);
+
+    // One block for each state and one each for whenAll()'s count and
+    // whenAny()'s flag
+    EXPECT_EQ(pool->blocksPerChunk() - 6, pool->numFreeBlocks());
+    promise.setValue(3);
+    EXPECT_EQ(4, futures[1].get());
+    EXPECT_TRUE(all.ready());
+    EXPECT_TRUE(any.ready());
+  }
+  EXPECT_EQ(pool->blocksPerChunk(), pool->numFreeBlocks());
+}
@@ -0,0 +1,79 @@
+#include <pistis/concurrent/pollable/Latch.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+TEST(LatchTests, CountDown) {
+  Latch latch(3);
+  EpollSet pollSet(latch.fd(), EpollEventType::READ);
+
+  EXPECT_EQ(3, latch.count());
+  EXPECT_FALSE(latch.tryWait());
+  latch.countDown();
+  latch.countDown();
+  EXPECT_FALSE(pollSet.wait(0));
+  EXPECT_FALSE(latch.wait(10));
+
+  latch.countDown();
+  EXPECT_EQ(0, latch.count());
+  EXPECT_TRUE(latch.tryWait());
+  EXPECT_TRUE(latch.wait(0));
+  EXPECT_TRUE(pollSet.wait(0));
+  EXPECT_THROW(latch.countDown(), IllegalStateError);
+
+  EXPECT_TRUE(Latch(0).tryWait());
+}
+
+TEST(LatchTests, CountDownByMoreThanOne) {
+  Latch latch(5);
+  latch.countDown(3);
+  EXPECT_EQ(2, latch.count());
+  EXPECT_THROW(latch.countDown(3), IllegalStateError);
+  EXPECT_EQ(2, latch.count());
+  latch.countDown(2);
+  EXPECT_TRUE(latch.wait(0));
+}
+
+TEST(LatchTests, ReleasesWaiters) {
+  Latch latch(3);
+  std::vector<WorkerThread> threads(3);
+
+  for (auto& thread : threads) {
+    thread.start([&latch](WorkerThread& t) {
+	t.setState(ThreadState::WAITING);
+	if (!latch.arriveAndWait(1000)) {
+	  t.addError("Latch did not open");
+	}
+	t.setState(ThreadState::DONE);
+    });
+  }
+  for (auto& thread : threads) {
+    ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 1000));
+    thread.join();
+    EXPECT_FALSE(thread.hasErrors());
+  }
+}
+
+TEST(LatchTests, Reset) {
+  Latch latch(1);
+  EpollSet pollSet(latch.fd(), EpollEventType::READ);
+  int fd = latch.fd();
+
+  EXPECT_THROW(latch.reset(2), IllegalStateError);
+  latch.countDown();
+  EXPECT_THROW(latch.reset(0), IllegalValueError);
+
+  latch.reset(2);
+  EXPECT_EQ(fd, latch.fd());
+  EXPECT_EQ(2, latch.count());
+  EXPECT_FALSE(pollSet.wait(0));
+  latch.countDown(2);
+  EXPECT_TRUE(pollSet.wait(0));
+}
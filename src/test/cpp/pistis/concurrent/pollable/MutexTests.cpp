@@ -0,0 +1,167 @@
+#include <pistis/concurrent/pollable/Mutex.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+TEST(MutexTests, LockAndUnlock) {
+  Mutex m;
+
+  EXPECT_EQ(LockPolicy::BARGING, m.policy());
+  EXPECT_FALSE(m.locked());
+  m.lock();
+  EXPECT_TRUE(m.locked());
+  EXPECT_FALSE(m.tryLock());
+  EXPECT_FALSE(m.lock(10));
+  m.unlock();
+  EXPECT_FALSE(m.locked());
+  EXPECT_TRUE(m.tryLock());
+  m.unlock();
+
+  {
+    std::lock_guard<Mutex> guard(m);
+    EXPECT_TRUE(m.locked());
+  }
+  EXPECT_FALSE(m.locked());
+  EXPECT_EQ(0, m.numWaiters());
+}
+
+TEST(MutexTests, BlockingLock) {
+  for (auto policy : { LockPolicy::BARGING, LockPolicy::HANDOFF }) {
+    Mutex m(policy);
+    m.lock();
+
+    WorkerThread thread;
+    thread.start([&m](WorkerThread& t) {
+	t.setState(ThreadState::WAITING);
+	if (!m.lock(1000)) {
+	  t.addError("Timed out waiting for the lock");
+	}
+	t.setState(ThreadState::DONE);
+	m.unlock();
+    });
+    ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+    EXPECT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+    m.unlock();
+    ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 1000));
+    thread.join();
+    EXPECT_FALSE(thread.hasErrors());
+  }
+}
+
+TEST(MutexTests, ObserveWithBarging) {
+  Mutex m(LockPolicy::BARGING);
+  m.lock();
+
+  int fd = m.observe();
+  EpollSet pollSet(fd, EpollEventType::READ);
+  EXPECT_EQ(1, m.numWaiters());
+  EXPECT_FALSE(pollSet.wait(0));
+  EXPECT_FALSE(m.acquire(fd));
+
+  // Someone else barges in before the observer acquires the lock
+  m.unlock();
+  ASSERT_TRUE(pollSet.wait(0));
+  EXPECT_TRUE(m.tryLock());
+  EXPECT_FALSE(m.acquire(fd));
+  EXPECT_FALSE(pollSet.wait(0));
+
+  m.unlock();
+  ASSERT_TRUE(pollSet.wait(0));
+  EXPECT_TRUE(m.acquire(fd));
+  EXPECT_TRUE(m.locked());
+  EXPECT_EQ(0, m.numWaiters());
+  m.unlock();
+}
+
+TEST(MutexTests, ObserveWithHandoff) {
+  Mutex m(LockPolicy::HANDOFF);
+  m.lock();
+
+  int fd = m.observe();
+  EpollSet pollSet(fd, EpollEventType::READ);
+  EXPECT_FALSE(pollSet.wait(0));
+
+  // Unlocking hands the lock straight to the observer
+  m.unlock();
+  EXPECT_TRUE(m.locked());
+  EXPECT_FALSE(m.tryLock());
+  ASSERT_TRUE(pollSet.wait(0));
+  EXPECT_TRUE(m.acquire(fd));
+  m.unlock();
+  EXPECT_FALSE(m.locked());
+
+  // Observing an unlocked mutex grants it immediately
+  fd = m.observe();
+  EXPECT_TRUE(m.locked());
+  EXPECT_TRUE(m.acquire(fd));
+  m.unlock();
+}
+
+TEST(MutexTests, StopObservingPassesTheLockOn) {
+  Mutex m(LockPolicy::HANDOFF);
+  m.lock();
+
+  int first = m.observe();
+  int second = m.observe();
+  EpollSet secondPollSet(second, EpollEventType::READ);
+
+  m.unlock();
+  EXPECT_FALSE(secondPollSet.wait(0));
+  m.stopObserving(first);
+  ASSERT_TRUE(secondPollSet.wait(0));
+  EXPECT_TRUE(m.acquire(second));
+  m.unlock();
+  EXPECT_FALSE(m.locked());
+  EXPECT_EQ(0, m.numWaiters());
+}
+
+TEST(MutexTests, HandoffIsFifo) {
+  Mutex m(LockPolicy::HANDOFF);
+  std::vector<int> fds;
+
+  m.lock();
+  for (int i = 0; i < 3; ++i) {
+    fds.push_back(m.observe());
+  }
+  for (int fd : fds) {
+    m.unlock();
+    for (int other : fds) {
+      EpollSet pollSet(other, EpollEventType::READ);
+      EXPECT_EQ(other == fd, pollSet.wait(0));
+    }
+    EXPECT_TRUE(m.acquire(fd));
+  }
+  m.unlock();
+}
+
+TEST(MutexTests, MutualExclusion) {
+  for (auto policy : { LockPolicy::BARGING, LockPolicy::HANDOFF }) {
+    const int NUM_THREADS = 4;
+    const int NUM_ITERATIONS = 20000;
+    Mutex m(policy);
+    int counter = 0;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+      threads.emplace_back([&]() {
+	  for (int j = 0; j < NUM_ITERATIONS; ++j) {
+	    std::lock_guard<Mutex> guard(m);
+	    ++counter;
+	  }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    EXPECT_EQ(NUM_THREADS * NUM_ITERATIONS, counter);
+    EXPECT_FALSE(m.locked());
+    EXPECT_EQ(0, m.numWaiters());
+  }
+}
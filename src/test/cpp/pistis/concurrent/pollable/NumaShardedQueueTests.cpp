@@ -0,0 +1,65 @@
+#include <pistis/concurrent/pollable/NumaShardedQueue.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  template <typename Function>
+  void runOnNode(const NumaTopology& topology, size_t node, Function f) {
+    std::thread t([&]() {
+	topology.bindCurrentThread(node);
+	f();
+	NumaTopology::unbindCurrentThread();
+    });
+    t.join();
+  }
+}
+
+TEST(NumaShardedQueueTests, Create) {
+  NumaShardedQueue<int> q;
+  EXPECT_EQ(NumaTopology::system().numNodes(), q.numShards());
+  EXPECT_TRUE(q.empty());
+
+  NumaShardedQueue<int> simulated(NumaTopology::simulate(4), 2, 8);
+  EXPECT_EQ(4, simulated.numShards());
+  EXPECT_EQ(2, simulated.lowWaterMark());
+  EXPECT_EQ(8, simulated.highWaterMark());
+}
+
+TEST(NumaShardedQueueTests, PutGoesToLocalNode) {
+  const NumaTopology topology = NumaTopology::simulate(2);
+  NumaShardedQueue<int> q(topology);
+
+  runOnNode(topology, 1, [&]() {
+      EXPECT_EQ(1, q.localShard());
+      q.put(1);
+      q.put(2);
+  });
+  runOnNode(topology, 0, [&]() { q.put(3); });
+
+  EXPECT_EQ(3, q.size());
+  EXPECT_EQ(1, q.shardSize(0));
+  EXPECT_EQ(2, q.shardSize(1));
+}
+
+TEST(NumaShardedQueueTests, GetPrefersLocalNode) {
+  const NumaTopology topology = NumaTopology::simulate(2);
+  NumaShardedQueue<int> q(topology);
+  std::vector<int> node1;
+
+  runOnNode(topology, 0, [&]() { q.put(10); });
+  runOnNode(topology, 1, [&]() { q.put(20); q.put(21); });
+
+  runOnNode(topology, 1, [&]() {
+      int item;
+      while (q.get(item, 0)) {
+	node1.push_back(item);
+      }
+  });
+
+  // Node 1 drains its own items before taking node 0's
+  EXPECT_EQ(std::vector<int>({ 20, 21, 10 }), node1);
+  EXPECT_TRUE(q.empty());
+}
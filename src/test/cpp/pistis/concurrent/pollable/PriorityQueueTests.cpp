@@ -0,0 +1,232 @@
+#include <pistis/concurrent/pollable/PriorityQueue.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef std::pair<int, std::string> Message;
+
+  struct ComparePriority {
+    bool operator()(const Message& left, const Message& right) const {
+      return left.first < right.first;
+    }
+  };
+
+  ::testing::AssertionResult verifyQueueState(int fd,
+					      EpollEventType expected) {
+    EpollSet epollSet(fd, EpollEventType::READ|EpollEventType::WRITE);
+    if (!epollSet.wait(0)) {
+      return ::testing::AssertionFailure()
+	  << "EpollSet::wait(0) returned false";
+    }
+    if (epollSet.events().size() != 1) {
+      return ::testing::AssertionFailure()
+	  << "EpollSet::wait() returned " << epollSet.events().size()
+	  << " events.  There should be only one event.";
+    }
+    if (epollSet.events()[0].events() != expected) {
+      return ::testing::AssertionFailure()
+	  << "Signaled events are not correct.  They are "
+	  << epollSet.events()[0].events() << ", but they should be "
+	  << expected;
+    }
+    return ::testing::AssertionSuccess();
+  }
+}
+
+TEST(PriorityQueueTests, GetInPriorityOrder) {
+  PriorityQueue<int> q;
+  std::vector<int> items{ 5, 1, 9, 3, 7, 3, 8, 2, 6, 4, 0 };
+
+  for (int i : items) {
+    q.put(i);
+  }
+  EXPECT_EQ(items.size(), q.size());
+
+  std::vector<int> truth(items);
+  std::sort(truth.begin(), truth.end(), std::greater<int>());
+
+  std::vector<int> result;
+  int item;
+  while (q.get(item, 0)) {
+    result.push_back(item);
+  }
+  EXPECT_EQ(truth, result);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(PriorityQueueTests, CustomCompare) {
+  PriorityQueue< int, std::greater<int> > q;
+  for (int i : { 4, 2, 8, 6 }) {
+    q.put(i);
+  }
+
+  EXPECT_EQ(std::vector<int>({ 2, 4, 6, 8 }), q.getAll());
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(PriorityQueueTests, LargeRandomSequence) {
+  static const int NUM_ITEMS = 10000;
+  PriorityQueue<int> q;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> dist(0, 1000);
+  std::vector<int> truth;
+  std::vector<int> result;
+
+  // Interleave puts and gets so the heap is exercised at many sizes
+  for (int i = 0; i < NUM_ITEMS; ++i) {
+    int v = dist(rng);
+    q.put(v);
+    truth.push_back(v);
+    if (!(i % 3)) {
+      result.push_back(q.get());
+      auto top = std::max_element(truth.begin(), truth.end());
+      ASSERT_EQ(*top, result.back());
+      truth.erase(top);
+    }
+  }
+
+  std::sort(truth.begin(), truth.end(), std::greater<int>());
+  EXPECT_EQ(truth, q.getAll());
+}
+
+TEST(PriorityQueueTests, FifoForEqualPriorities) {
+  PriorityQueue<Message, ComparePriority> q(PriorityOrder::FIFO);
+
+  q.put(Message(1, "bulk-1"));
+  q.put(Message(2, "control-1"));
+  q.put(Message(1, "bulk-2"));
+  q.put(Message(2, "control-2"));
+  q.put(Message(1, "bulk-3"));
+  q.put(Message(2, "control-3"));
+  q.put(Message(1, "bulk-4"));
+
+  std::vector<std::string> truth{
+    "control-1", "control-2", "control-3",
+    "bulk-1", "bulk-2", "bulk-3", "bulk-4"
+  };
+  std::vector<std::string> result;
+  for (const Message& m : q.getAll()) {
+    result.push_back(m.second);
+  }
+  EXPECT_EQ(truth, result);
+}
+
+TEST(PriorityQueueTests, DrainInto) {
+  PriorityQueue<int> q;
+  std::vector<int> buffer;
+
+  for (int i : { 3, 1, 4, 1, 5 }) {
+    q.put(i);
+  }
+
+  EXPECT_EQ(2, q.drainInto(buffer, 2));
+  EXPECT_EQ(std::vector<int>({ 5, 4 }), buffer);
+  EXPECT_EQ(3, q.drainInto(buffer));
+  EXPECT_EQ(std::vector<int>({ 5, 4, 3, 1, 1 }), buffer);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(PriorityQueueTests, GetTimesOut) {
+  PriorityQueue<int> q;
+  int item = -1;
+
+  auto start = std::chrono::system_clock::now();
+  EXPECT_FALSE(q.get(item, 50));
+  EXPECT_LE(45, toMs(std::chrono::system_clock::now() - start));
+  EXPECT_EQ(-1, item);
+}
+
+TEST(PriorityQueueTests, PutTimesOut) {
+  PriorityQueue<int> q(2);
+
+  EXPECT_TRUE(q.put(1, 0));
+  EXPECT_TRUE(q.put(2, 0));
+  EXPECT_FALSE(q.put(3, 50));
+  EXPECT_EQ(2, q.size());
+}
+
+TEST(PriorityQueueTests, GetWaitsForPut) {
+  PriorityQueue<int> q;
+  WorkerThread thread;
+  int item = -1;
+
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      item = q.get();
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  q.put(7);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+  EXPECT_EQ(7, item);
+  EXPECT_EQ(std::vector<std::string>(), thread.errors());
+}
+
+TEST(PriorityQueueTests, ObserveQueueState) {
+  PriorityQueue<int> q(2);
+
+  EXPECT_TRUE(verifyQueueState(q.queueStateFd(), EpollEventType::WRITE));
+  q.put(1);
+  EXPECT_TRUE(verifyQueueState(q.queueStateFd(),
+			       EpollEventType::READ|EpollEventType::WRITE));
+  q.put(2);
+  EXPECT_TRUE(verifyQueueState(q.queueStateFd(), EpollEventType::READ));
+  q.clear();
+  EXPECT_TRUE(verifyQueueState(q.queueStateFd(), EpollEventType::WRITE));
+}
+
+TEST(PriorityQueueTests, PollForWaterMarks) {
+  PriorityQueue<int> q(10, 1, 3);
+  PriorityQueue<int>::Guard highGuard(q, QueueEventType::HIGH_WATER_MARK);
+  PriorityQueue<int>::Guard lowGuard(q, QueueEventType::LOW_WATER_MARK);
+  EpollSet highSet(highGuard.fd(), EpollEventType::READ);
+  EpollSet lowSet(lowGuard.fd(), EpollEventType::READ);
+
+  q.put(1);
+  q.put(2);
+  q.put(3);
+  EXPECT_FALSE(highSet.wait(0));
+  q.put(4);  // Crosses HWM here
+  EXPECT_TRUE(highSet.wait(0));
+  highGuard.ack();
+
+  q.get();
+  q.get();
+  EXPECT_FALSE(lowSet.wait(0));
+  q.get();  // Reaches LWM here
+  EXPECT_TRUE(lowSet.wait(0));
+  lowGuard.ack();
+}
+
+TEST(PriorityQueueTests, ConstructByMove) {
+  PriorityQueue<int> q(10, 2, 4);
+  q.put(2);
+  q.put(3);
+  q.put(1);
+
+  PriorityQueue<int> copy(std::move(q));
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(3, copy.size());
+  EXPECT_EQ(10, copy.maxSize());
+  EXPECT_EQ(2, copy.lowWaterMark());
+  EXPECT_EQ(4, copy.highWaterMark());
+  EXPECT_TRUE(verifyQueueState(q.queueStateFd(), EpollEventType::WRITE));
+  EXPECT_TRUE(verifyQueueState(copy.queueStateFd(),
+			       EpollEventType::READ|EpollEventType::WRITE));
+
+  EXPECT_EQ(3, copy.get());
+  EXPECT_EQ(2, copy.get());
+  EXPECT_EQ(1, copy.get());
+}
@@ -0,0 +1,231 @@
+#include <pistis/concurrent/pollable/QueueGroup.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <pistis/exceptions/ItemExistsError.hpp>
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  // Items are tagged with their queue number times 100
+  void fill(Queue<int>& q, int tag, int n) {
+    for (int i = 0; i < n; ++i) {
+      q.put(tag * 100 + i);
+    }
+  }
+
+  std::map<int, int> countByQueue(const std::vector<int>& items) {
+    std::map<int, int> counts;
+    for (int item : items) {
+      ++counts[item / 100];
+    }
+    return counts;
+  }
+}
+
+TEST(QueueGroupTests, EmptyGroup) {
+  QueueGroup<int> group;
+  int item = -1;
+
+  EXPECT_EQ(0, group.numQueues());
+  EXPECT_FALSE(group.get(item, 0));
+  EXPECT_FALSE(group.get(item, -1));
+  EXPECT_EQ(-1, item);
+}
+
+TEST(QueueGroupTests, AddAndRemove) {
+  Queue<int> q1;
+  Queue<int> q2;
+  QueueGroup<int> group;
+
+  group.add(q1);
+  group.add(q2, 3);
+  EXPECT_EQ(2, group.numQueues());
+  EXPECT_TRUE(group.contains(q1));
+  EXPECT_EQ(1, group.weight(q1));
+  EXPECT_EQ(3, group.weight(q2));
+  EXPECT_THROW(group.add(q1), ItemExistsError);
+
+  group.remove(q1);
+  EXPECT_FALSE(group.contains(q1));
+  EXPECT_EQ(1, group.numQueues());
+  EXPECT_THROW(group.remove(q1), NoSuchItem);
+}
+
+TEST(QueueGroupTests, EqualWeightsAlternate) {
+  Queue<int> q1;
+  Queue<int> q2;
+  QueueGroup<int> group;
+  std::vector<int> items;
+  int item;
+
+  group.add(q1);
+  group.add(q2);
+  fill(q1, 1, 4);
+  fill(q2, 2, 4);
+
+  while (group.get(item, 0)) {
+    items.push_back(item);
+  }
+  ASSERT_EQ(8, items.size());
+
+  // Consecutive items always come from different queues, and each
+  // queue's items come out in order
+  for (size_t i = 1; i < items.size(); ++i) {
+    EXPECT_NE(items[i - 1] / 100, items[i] / 100);
+    if (i >= 2) {
+      EXPECT_EQ(items[i - 2] + 1, items[i]);
+    }
+  }
+}
+
+TEST(QueueGroupTests, WeightsAndQuantum) {
+  Queue<int> q1;
+  Queue<int> q2;
+  QueueGroup<int> group(2);
+  std::vector<int> items;
+  int item;
+
+  group.add(q1, 3);
+  group.add(q2, 1);
+  fill(q1, 1, 60);
+  fill(q2, 2, 60);
+
+  // Each full round hands out 6 items from q1 and 2 from q2
+  for (int i = 0; i < 40; ++i) {
+    ASSERT_TRUE(group.get(item, 0));
+    items.push_back(item);
+  }
+  std::map<int, int> counts = countByQueue(items);
+  EXPECT_EQ(30, counts[1]);
+  EXPECT_EQ(10, counts[2]);
+}
+
+TEST(QueueGroupTests, LargeWeightsDoNotOverflow) {
+  Queue<int> q1;
+  Queue<int> q2;
+  QueueGroup<int> group(2);
+  std::vector<int> items;
+  int item;
+
+  // 0x80000001 * 2 overflows 32 bits to a share of 2
+  group.add(q1, 0x80000001);
+  group.add(q2, 1);
+  fill(q1, 1, 10);
+  fill(q2, 2, 10);
+
+  // q1 hands out all of its items in one turn, whichever queue starts
+  for (int i = 0; i < 12; ++i) {
+    ASSERT_TRUE(group.get(item, 0));
+    items.push_back(item);
+  }
+  std::map<int, int> counts = countByQueue(items);
+  EXPECT_EQ(10, counts[1]);
+  EXPECT_EQ(2, counts[2]);
+}
+
+TEST(QueueGroupTests, DrainedQueueLeavesRound) {
+  Queue<int> q1;
+  Queue<int> q2;
+  QueueGroup<int> group;
+  std::vector<int> items;
+  int item;
+
+  group.add(q1);
+  group.add(q2);
+  fill(q1, 1, 1);
+  fill(q2, 2, 5);
+
+  while (group.get(item, 0)) {
+    items.push_back(item);
+  }
+  std::map<int, int> counts = countByQueue(items);
+  EXPECT_EQ(1, counts[1]);
+  EXPECT_EQ(5, counts[2]);
+}
+
+TEST(QueueGroupTests, GetBatch) {
+  Queue<int> q1;
+  Queue<int> q2;
+  Queue<int> q3;
+  QueueGroup<int> group(4);
+  std::vector<int> items;
+
+  group.add(q1, 2);
+  group.add(q2);
+  group.add(q3);
+  fill(q1, 1, 20);
+  fill(q2, 2, 20);
+  fill(q3, 3, 2);
+
+  // One pass takes 8 from q1, 4 from q2 and everything in q3
+  EXPECT_EQ(14, group.getBatch(items, 100));
+  std::map<int, int> counts = countByQueue(items);
+  EXPECT_EQ(8, counts[1]);
+  EXPECT_EQ(4, counts[2]);
+  EXPECT_EQ(2, counts[3]);
+  EXPECT_EQ(12, q1.size());
+  EXPECT_EQ(16, q2.size());
+  EXPECT_EQ(0, q3.size());
+
+  // maxItems caps the batch
+  items.clear();
+  EXPECT_EQ(5, group.getBatch(items, 5));
+  EXPECT_EQ(5, items.size());
+}
+
+TEST(QueueGroupTests, GetWaitsForItem) {
+  Queue<int> q1;
+  Queue<int> q2;
+  QueueGroup<int> group;
+  WorkerThread thread;
+  int item = -1;
+  bool found = false;
+
+  group.add(q1);
+  group.add(q2);
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      found = group.get(item, 1000);
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  q2.put(7);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+  EXPECT_TRUE(found);
+  EXPECT_EQ(7, item);
+}
+
+TEST(QueueGroupTests, GetTimesOut) {
+  Queue<int> q;
+  QueueGroup<int> group;
+  int item = -1;
+
+  group.add(q);
+  auto start = std::chrono::system_clock::now();
+  EXPECT_FALSE(group.get(item, 50));
+  EXPECT_LE(45, toMs(std::chrono::system_clock::now() - start));
+}
+
+TEST(QueueGroupTests, PollGroupFd) {
+  Queue<int> q;
+  QueueGroup<int> group;
+  int item;
+
+  group.add(q);
+  EpollSet epollSet(group.fd(), EpollEventType::READ);
+  EXPECT_FALSE(epollSet.wait(0));
+
+  q.put(1);
+  EXPECT_TRUE(epollSet.wait(0));
+  EXPECT_TRUE(group.get(item, 0));
+  EXPECT_EQ(1, item);
+  EXPECT_FALSE(epollSet.wait(0));
+}
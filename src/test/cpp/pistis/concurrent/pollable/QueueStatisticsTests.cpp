@@ -0,0 +1,109 @@
+#include <pistis/concurrent/pollable/Queue.hpp>
+#include <pistis/concurrent/pollable/QueueStatistics.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+namespace {
+  typedef Queue<int, std::allocator<int>, QueueStatistics> MonitoredQueue;
+}
+
+TEST(QueueStatisticsTests, CountsPutsAndGets) {
+  MonitoredQueue q;
+  std::vector<int> buffer;
+
+  for (int i = 0; i < 10; ++i) {
+    q.put(i);
+  }
+  q.get();
+  q.get();
+  q.drainInto(buffer, 3);
+  q.getAll();
+
+  QueueStatistics::Snapshot s = q.statistics();
+  EXPECT_EQ(10, s.puts());
+  EXPECT_EQ(10, s.gets());
+  EXPECT_LT(0.0, s.elapsed());
+  EXPECT_LT(0.0, s.putRate());
+  EXPECT_LT(0.0, s.getRate());
+
+  // Occupancy is recorded after each of the 10 puts, 2 gets and 2 bulk gets
+  EXPECT_EQ(14, s.occupancy().total());
+  EXPECT_EQ(1, s.occupancy().counts()[0]);
+  EXPECT_EQ(10, s.occupancy().max());
+  EXPECT_EQ(10, s.occupancy().percentile(100));
+
+  q.resetStatistics();
+  s = q.statistics();
+  EXPECT_EQ(0, s.puts());
+  EXPECT_EQ(0, s.gets());
+  EXPECT_EQ(0, s.occupancy().total());
+}
+
+TEST(QueueStatisticsTests, CountsWaterMarkCrossings) {
+  MonitoredQueue q(10, 2, 4);
+
+  for (int n = 0; n < 3; ++n) {
+    for (int i = 0; i < 5; ++i) {
+      q.put(i);
+    }
+    for (int i = 0; i < 3; ++i) {
+      q.get();
+    }
+  }
+
+  // Third round leaves the queue above the high water mark
+  QueueStatistics::Snapshot s = q.statistics();
+  EXPECT_EQ(2, s.highWaterMarkCrossings());
+  EXPECT_EQ(1, s.lowWaterMarkCrossings());
+}
+
+TEST(QueueStatisticsTests, RecordsConsumerBlocking) {
+  MonitoredQueue q;
+  WorkerThread thread;
+
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      q.get();
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  q.put(1);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+
+  QueueStatistics::Snapshot s = q.statistics();
+  EXPECT_EQ(1, s.consumerBlocked().total());
+  EXPECT_LE(40000000, s.consumerBlocked().percentile(100));
+  EXPECT_EQ(0, s.producerBlocked().total());
+}
+
+TEST(QueueStatisticsTests, RecordsProducerBlocking) {
+  MonitoredQueue q(1);
+
+  q.put(1);
+  EXPECT_FALSE(q.put(2, 20));
+  q.get();
+  EXPECT_TRUE(q.put(3, 20));
+
+  QueueStatistics::Snapshot s = q.statistics();
+  EXPECT_EQ(1, s.producerBlocked().total());
+  EXPECT_LE(10000000, s.producerBlocked().percentile(100));
+  EXPECT_EQ(2, s.puts());
+}
+
+TEST(QueueStatisticsTests, DisabledStatistics) {
+  Queue<int> q;
+  q.put(1);
+  q.get();
+
+  // The default policy records nothing and has an empty snapshot
+  Queue<int>::StatisticsType::Snapshot s = q.statistics();
+  EXPECT_FALSE(Queue<int>::StatisticsType::ENABLED);
+  (void)s;
+}
@@ -7,7 +7,10 @@
 #include <atomic>
 #include <chrono>
 #include <iterator>
+#include <string>
+#include <thread>
 #include <vector>
+#include <fcntl.h>
 
 using namespace pistis::concurrent;
 using namespace pistis::concurrent::pollable;
@@ -829,3 +832,167 @@ TEST(QueueTests, MoveAssignment) {
   EXPECT_EQ(7, copy.get());
   EXPECT_EQ(0, copy.size());  
 }
+
+TEST(QueueTests, MoveAssignmentAdoptsBlockingMode) {
+  Queue<int> q(BlockingMode::BLOCK, 4);
+  Queue<int> other(BlockingMode::DONT_BLOCK, 4);
+  other.put(1);
+
+  q = std::move(other);
+  EXPECT_EQ(BlockingMode::DONT_BLOCK, q.blockingMode());
+  EXPECT_TRUE(::fcntl(q.queueStateFd(), F_GETFL) & O_NONBLOCK);
+
+  Queue<int>::Guard guard(q, QueueEventType::EMPTY);
+  EXPECT_TRUE(::fcntl(guard.fd(), F_GETFL) & O_NONBLOCK);
+  EXPECT_FALSE(guard.tryAck());
+
+  EpollSet epollSet(q.queueStateFd(), EpollEventType::READ);
+  EXPECT_TRUE(epollSet.wait(0));
+  EXPECT_EQ(1, q.get());
+}
+
+TEST(QueueTests, GetAll) {
+  Queue<int> q(10, 2, 4);
+  for (int i = 1; i <= 5; ++i) {
+    q.put(i);
+  }
+
+  Queue<int>::Guard guard(q, QueueEventType::LOW_WATER_MARK);
+  EpollSet epollSet(guard.fd(), EpollEventType::READ);
+
+  std::deque<int> items(q.getAll());
+  EXPECT_EQ(std::deque<int>({ 1, 2, 3, 4, 5 }), items);
+  EXPECT_EQ(0, q.size());
+  EXPECT_TRUE(epollSet.wait(0));
+
+  // The queue should remain usable after getAll()
+  q.put(6);
+  EXPECT_EQ(1, q.size());
+  EXPECT_EQ(6, q.get());
+}
+
+TEST(QueueTests, SwapOut) {
+  Queue<int> q(3);
+  std::deque<int> buffer{ -1, -2 };
+
+  q.put(1);
+  q.put(2);
+  q.put(3);
+
+  EXPECT_EQ(3, q.swapOut(buffer));
+  EXPECT_EQ(std::deque<int>({ 1, 2, 3 }), buffer);
+  EXPECT_EQ(0, q.size());
+
+  EpollSet epollSet(q.queueStateFd(),
+		    EpollEventType::READ|EpollEventType::WRITE);
+  EXPECT_TRUE(epollSet.wait(0));
+  ASSERT_EQ(1, epollSet.events().size());
+  EXPECT_TRUE(verifyEpollEvent(epollSet.events()[0], q.queueStateFd(),
+			       EpollEventType::WRITE));
+
+  // Swapping out an empty queue empties the buffer
+  EXPECT_EQ(0, q.swapOut(buffer));
+  EXPECT_TRUE(buffer.empty());
+}
+
+TEST(QueueTests, DrainInto) {
+  Queue<int> q(3);
+  std::vector<int> buffer{ 0 };
+
+  q.put(1);
+  q.put(2);
+  q.put(3);
+
+  EXPECT_EQ(2, q.drainInto(buffer, 2));
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2 }), buffer);
+  EXPECT_EQ(1, q.size());
+
+  EXPECT_EQ(1, q.drainInto(buffer));
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3 }), buffer);
+  EXPECT_EQ(0, q.size());
+
+  EXPECT_EQ(0, q.drainInto(buffer));
+  EXPECT_EQ(4, buffer.size());
+}
+
+TEST(QueueTests, TryGetAndTryPut) {
+  Queue<std::string> q(BlockingMode::DONT_BLOCK, 2);
+  std::string item("unchanged");
+
+  EXPECT_EQ(BlockingMode::DONT_BLOCK, q.blockingMode());
+  EXPECT_FALSE(q.tryGet(item));
+  EXPECT_EQ("unchanged", item);
+
+  std::string a("a");
+  EXPECT_TRUE(q.tryPut(std::move(a)));
+  EXPECT_TRUE(q.tryPut(std::string("b")));
+
+  std::string c("c");
+  EXPECT_FALSE(q.tryPut(std::move(c)));
+  EXPECT_EQ("c", c);
+  EXPECT_EQ(2, q.size());
+
+  EXPECT_TRUE(q.tryGet(item));
+  EXPECT_EQ("a", item);
+  EXPECT_TRUE(q.tryPut(c));
+  EXPECT_TRUE(q.tryGet(item));
+  EXPECT_EQ("b", item);
+  EXPECT_TRUE(q.tryGet(item));
+  EXPECT_EQ("c", item);
+  EXPECT_FALSE(q.tryGet(item));
+}
+
+TEST(QueueTests, TryGetAndTryPutWaitForLock) {
+  // drainInto() calls push_back() with the queue's lock held, so this
+  // container keeps the lock held until it is released
+  struct StallingBuffer {
+    std::atomic<bool>& holding;
+    std::atomic<bool>& release;
+
+    void push_back(int) {
+      holding = true;
+      while (!release) {
+	std::this_thread::yield();
+      }
+    }
+  };
+
+  Queue<int> q(BlockingMode::DONT_BLOCK, 4);
+  q.put(1);
+  std::atomic<bool> holding(false);
+  std::atomic<bool> release(false);
+  std::thread holder([&]() {
+      StallingBuffer buffer{ holding, release };
+      q.drainInto(buffer, 1);
+  });
+  while (!holding) {
+    std::this_thread::yield();
+  }
+
+  // A lock held by another thread is not mistaken for a full or empty
+  // queue
+  std::thread releaser([&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      release = true;
+  });
+  EXPECT_TRUE(q.tryPut(2));
+  releaser.join();
+  holder.join();
+
+  int item = 0;
+  EXPECT_TRUE(q.tryGet(item));
+  EXPECT_EQ(2, item);
+}
+
+TEST(QueueTests, TryAck) {
+  Queue<int> q(BlockingMode::DONT_BLOCK, 10);
+  Queue<int>::Guard guard(q, QueueEventType::NOT_EMPTY);
+  EpollSet epollSet(guard.fd(), EpollEventType::READ);
+
+  EXPECT_FALSE(guard.tryAck());
+  q.tryPut(1);
+  EXPECT_TRUE(epollSet.wait(0));
+  EXPECT_TRUE(guard.tryAck());
+  EXPECT_FALSE(epollSet.wait(0));
+  EXPECT_FALSE(guard.tryAck());
+}
@@ -0,0 +1,106 @@
+#include <pistis/concurrent/pollable/RateLimiter.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <poll.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  bool isReadable(int fd, int timeout = 0) {
+    ::pollfd p{ fd, POLLIN, 0 };
+    return (::poll(&p, 1, timeout) == 1) && (p.revents & POLLIN);
+  }
+
+  int64_t msSince(RateLimiter::TimePoint start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        RateLimiter::Clock::now() - start
+    ).count();
+  }
+}
+
+TEST(RateLimiterTests, Create) {
+  RateLimiter limiter(100.0, 5);
+
+  EXPECT_EQ(100.0, limiter.rate());
+  EXPECT_EQ(5, limiter.burst());
+  EXPECT_EQ(5, limiter.available());
+  EXPECT_TRUE(isReadable(limiter.fd()));
+}
+
+TEST(RateLimiterTests, CreateWithIllegalArguments) {
+  EXPECT_THROW(RateLimiter(0.0, 1), IllegalValueError);
+  EXPECT_THROW(RateLimiter(-1.0, 1), IllegalValueError);
+  EXPECT_THROW(RateLimiter(10.0, 0), IllegalValueError);
+}
+
+TEST(RateLimiterTests, TryAcquireEmptiesBucket) {
+  RateLimiter limiter(1.0, 3);
+
+  EXPECT_TRUE(limiter.tryAcquire(2));
+  EXPECT_EQ(1, limiter.available());
+  EXPECT_FALSE(limiter.tryAcquire(2));
+  EXPECT_TRUE(limiter.tryAcquire());
+  EXPECT_FALSE(limiter.tryAcquire());
+  EXPECT_EQ(0, limiter.available());
+  EXPECT_FALSE(isReadable(limiter.fd()));
+
+  EXPECT_THROW(limiter.tryAcquire(4), IllegalValueError);
+  EXPECT_THROW(limiter.tryAcquire(0), IllegalValueError);
+}
+
+TEST(RateLimiterTests, FdBecomesReadableWhenTokenArrives) {
+  RateLimiter limiter(20.0, 1);
+
+  ASSERT_TRUE(limiter.tryAcquire());
+  const auto start = RateLimiter::Clock::now();
+  EXPECT_FALSE(isReadable(limiter.fd()));
+
+  EpollSet epollSet(limiter.fd(), EpollEventType::READ);
+  ASSERT_TRUE(epollSet.wait(1000));
+  EXPECT_GE(msSince(start), 45);
+  EXPECT_TRUE(limiter.tryAcquire());
+  EXPECT_FALSE(isReadable(limiter.fd()));
+}
+
+TEST(RateLimiterTests, AcquireWaitsForTokens) {
+  RateLimiter limiter(50.0, 1);
+
+  ASSERT_TRUE(limiter.tryAcquire());
+  const auto start = RateLimiter::Clock::now();
+  limiter.acquire();
+  EXPECT_GE(msSince(start), 15);
+  limiter.acquire();
+  EXPECT_GE(msSince(start), 35);
+  EXPECT_LT(msSince(start), 500);
+}
+
+TEST(RateLimiterTests, AcquireTimesOut) {
+  RateLimiter limiter(1.0, 1);
+
+  ASSERT_TRUE(limiter.tryAcquire());
+  const auto start = RateLimiter::Clock::now();
+  EXPECT_FALSE(limiter.acquire(1, 50));
+
+  // The token cannot arrive within the timeout, so acquire() gives up
+  // without waiting for it
+  EXPECT_LT(msSince(start), 50);
+  EXPECT_TRUE(limiter.readyAt() > RateLimiter::Clock::now());
+}
+
+TEST(RateLimiterTests, SetRateKeepsTokens) {
+  RateLimiter limiter(1.0, 4);
+
+  ASSERT_TRUE(limiter.tryAcquire(2));
+  limiter.setRate(1000.0);
+  EXPECT_EQ(1000.0, limiter.rate());
+  EXPECT_GE(limiter.available(), 2);
+  EXPECT_TRUE(limiter.acquire(4, 1000));
+
+  limiter.setRate(0.5);
+  EXPECT_FALSE(limiter.tryAcquire());
+  EXPECT_THROW(limiter.setRate(0.0), IllegalValueError);
+}
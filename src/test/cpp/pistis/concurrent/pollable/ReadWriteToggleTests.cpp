@@ -1,6 +1,8 @@
 #include <pistis/concurrent/pollable/ReadWriteToggle.hpp>
 #include <pistis/concurrent/EpollSet.hpp>
 #include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <unistd.h>
 
 using namespace pistis::concurrent;
 using namespace pistis::concurrent::pollable;
@@ -27,6 +29,15 @@ namespace {
       EpollSet epollSet(toggle.fd(),
 			EpollEventType::READ|EpollEventType::WRITE);
       EpollEventType desiredEvents = epollEventsFor(expectedState);
+
+      if (expectedState == ReadWriteToggle::NONE) {
+	if (epollSet.wait(0)) {
+	  return ::testing::AssertionFailure()
+	      << "EpollSet::wait(0) returned true, but the toggle should be "
+	      << "neither readable nor writable";
+	}
+	return ::testing::AssertionSuccess();
+      }
       
       if (!epollSet.wait(0)) {
 	return ::testing::AssertionFailure()
@@ -66,6 +77,31 @@ namespace {
     }
     return r;
   }
+
+  /** @brief Watches a single descriptor with edge-triggered epoll */
+  class EdgeWatcher {
+  public:
+    EdgeWatcher(int fd, uint32_t events): epfd_(::epoll_create1(0)) {
+      struct epoll_event ev;
+      ev.events = events | EPOLLET;
+      ev.data.fd = fd;
+      ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+    ~EdgeWatcher() { ::close(epfd_); }
+
+    /** @brief Number of edges reported since the last call */
+    int edges() {
+      struct epoll_event ev;
+      int n = 0;
+      while (::epoll_wait(epfd_, &ev, 1, 0) > 0) {
+	++n;
+      }
+      return n;
+    }
+
+  private:
+    int epfd_;
+  };
 }
 
 TEST(ReadWriteToggleTests, Create) {
@@ -84,6 +120,17 @@ TEST(ReadWriteToggleTests, Create) {
   EXPECT_EQ(EpollEventType::READ|EpollEventType::WRITE, events[0].events());
 }
 
+TEST(ReadWriteToggleTests, CreateInInitialState) {
+  const ReadWriteToggle::State states[] = {
+    ReadWriteToggle::READ_ONLY, ReadWriteToggle::WRITE_ONLY,
+    ReadWriteToggle::READ_WRITE, ReadWriteToggle::NONE
+  };
+  for (ReadWriteToggle::State s : states) {
+    ReadWriteToggle toggle(OnExecMode::CLOSE, BlockingMode::BLOCK, s);
+    EXPECT_TRUE(verifyState(toggle, s));
+  }
+}
+
 TEST(ReadWriteToggleTests, ReadOnlyToReadWrite) {
   ReadWriteToggle toggle;
   ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::READ_ONLY,
@@ -120,3 +167,112 @@ TEST(ReadWriteToggleTests, WriteOnlyToReadWrite) {
 			       ReadWriteToggle::READ_WRITE));  
 }
 
+
+TEST(ReadWriteToggleTests, ReadWriteToNone) {
+  ReadWriteToggle toggle;
+  ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::READ_WRITE,
+			       ReadWriteToggle::NONE));
+}
+
+TEST(ReadWriteToggleTests, ReadOnlyToNone) {
+  ReadWriteToggle toggle;
+  ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::READ_ONLY,
+			       ReadWriteToggle::NONE));
+}
+
+TEST(ReadWriteToggleTests, WriteOnlyToNone) {
+  ReadWriteToggle toggle;
+  ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::WRITE_ONLY,
+			       ReadWriteToggle::NONE));
+}
+
+TEST(ReadWriteToggleTests, NoneToReadOnly) {
+  ReadWriteToggle toggle;
+  ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::NONE,
+			       ReadWriteToggle::READ_ONLY));
+}
+
+TEST(ReadWriteToggleTests, NoneToWriteOnly) {
+  ReadWriteToggle toggle;
+  ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::NONE,
+			       ReadWriteToggle::WRITE_ONLY));
+}
+
+TEST(ReadWriteToggleTests, NoneToReadWrite) {
+  ReadWriteToggle toggle;
+  ASSERT_TRUE(verifyTransition(toggle, ReadWriteToggle::NONE,
+			       ReadWriteToggle::READ_WRITE));
+}
+
+TEST(ReadWriteToggleTests, RepeatedTransitions) {
+  static const ReadWriteToggle::State STATES[] = {
+    ReadWriteToggle::NONE, ReadWriteToggle::READ_ONLY,
+    ReadWriteToggle::READ_WRITE, ReadWriteToggle::WRITE_ONLY,
+    ReadWriteToggle::NONE, ReadWriteToggle::READ_WRITE,
+    ReadWriteToggle::READ_ONLY, ReadWriteToggle::WRITE_ONLY
+  };
+  ReadWriteToggle toggle;
+  for (int i = 0; i < 100; ++i) {
+    for (auto s : STATES) {
+      toggle.setState(s);
+      ASSERT_TRUE(verifyState(toggle, s));
+    }
+  }
+}
+
+TEST(ReadWriteToggleTests, ReadEdgeOnlyWhenBecomingReadable) {
+  ReadWriteToggle toggle;
+  toggle.setState(ReadWriteToggle::NONE);
+
+  EdgeWatcher watcher(toggle.fd(), EPOLLIN);
+  EXPECT_EQ(0, watcher.edges());
+
+  toggle.setState(ReadWriteToggle::READ_ONLY);
+  EXPECT_EQ(1, watcher.edges());
+
+  // Changing only the write direction must not wake a reader
+  toggle.setState(ReadWriteToggle::READ_WRITE);
+  EXPECT_EQ(0, watcher.edges());
+  toggle.setState(ReadWriteToggle::READ_ONLY);
+  EXPECT_EQ(0, watcher.edges());
+
+  toggle.setState(ReadWriteToggle::WRITE_ONLY);
+  EXPECT_EQ(0, watcher.edges());
+  toggle.setState(ReadWriteToggle::READ_WRITE);
+  EXPECT_EQ(1, watcher.edges());
+}
+
+TEST(ReadWriteToggleTests, WriteEdgeOnlyWhenBecomingWritable) {
+  ReadWriteToggle toggle;
+  toggle.setState(ReadWriteToggle::NONE);
+
+  EdgeWatcher watcher(toggle.fd(), EPOLLOUT);
+  EXPECT_EQ(0, watcher.edges());
+
+  toggle.setState(ReadWriteToggle::WRITE_ONLY);
+  EXPECT_EQ(1, watcher.edges());
+
+  // Changing only the read direction must not wake a writer
+  toggle.setState(ReadWriteToggle::READ_WRITE);
+  EXPECT_EQ(0, watcher.edges());
+  toggle.setState(ReadWriteToggle::WRITE_ONLY);
+  EXPECT_EQ(0, watcher.edges());
+
+  toggle.setState(ReadWriteToggle::READ_ONLY);
+  EXPECT_EQ(0, watcher.edges());
+  toggle.setState(ReadWriteToggle::READ_WRITE);
+  EXPECT_EQ(1, watcher.edges());
+}
+
+TEST(ReadWriteToggleTests, AdoptDescriptors) {
+  ReadWriteToggle original;
+  original.setState(ReadWriteToggle::READ_ONLY);
+
+  ReadWriteToggle copy(::dup(original.fd()), ::dup(original.controlFd()),
+		       original.state());
+  EXPECT_EQ(ReadWriteToggle::READ_ONLY, copy.state());
+
+  copy.setState(ReadWriteToggle::WRITE_ONLY);
+  original.assumeState(copy.state());
+  EXPECT_TRUE(verifyState(original, ReadWriteToggle::WRITE_ONLY));
+}
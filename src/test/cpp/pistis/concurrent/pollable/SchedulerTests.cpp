@@ -0,0 +1,150 @@
+#include <pistis/concurrent/pollable/Scheduler.hpp>
+#include <pistis/concurrent/pollable/Semaphore.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+TEST(SchedulerTests, RunPostedTasks) {
+  Scheduler scheduler;
+  std::vector<int> order;
+
+  EXPECT_TRUE(scheduler.idle());
+  scheduler.post([&]() { order.push_back(1); });
+  scheduler.post([&]() {
+      order.push_back(2);
+      scheduler.post([&]() { order.push_back(3); });
+  });
+  EXPECT_FALSE(scheduler.idle());
+
+  EXPECT_EQ(2, scheduler.runOnce(0));
+  EXPECT_EQ(std::vector<int>({ 1, 2 }), order);
+  EXPECT_EQ(1, scheduler.runOnce(0));
+  EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), order);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(SchedulerTests, AttemptsRunInOrderUntilOneFails) {
+  Scheduler scheduler;
+  Semaphore semaphore(0);
+  std::vector<int> order;
+  auto attempt = [&](int id) {
+    return [&, id]() {
+      if (!semaphore.down(0)) {
+	return false;
+      }
+      order.push_back(id);
+      return true;
+    };
+  };
+
+  scheduler.whenReadable(semaphore.fd(), attempt(1));
+  scheduler.whenReadable(semaphore.fd(), attempt(2));
+  scheduler.whenReadable(semaphore.fd(), attempt(3));
+  EXPECT_EQ(3, scheduler.numWaiters());
+  EXPECT_EQ(0, scheduler.runOnce(0));
+
+  semaphore.up(2);
+  EXPECT_EQ(2, scheduler.runOnce(0));
+  EXPECT_EQ(std::vector<int>({ 1, 2 }), order);
+  EXPECT_EQ(1, scheduler.numWaiters());
+  EXPECT_EQ(0, scheduler.runOnce(0));
+
+  semaphore.up();
+  EXPECT_EQ(1, scheduler.runOnce(0));
+  EXPECT_EQ(std::vector<int>({ 1, 2, 3 }), order);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(SchedulerTests, WhenWritable) {
+  Scheduler scheduler;
+  Semaphore semaphore(0);
+  bool called = false;
+
+  scheduler.whenWritable(semaphore.fd(), [&]() { called = true; return true; });
+  EXPECT_EQ(1, scheduler.runOnce(0));
+  EXPECT_TRUE(called);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(SchedulerTests, SuspendedWritersKeepTheirPlaces) {
+  Scheduler scheduler;
+  Semaphore semaphore(0);
+  std::vector<int> order;
+  bool ready = false;
+  int calls = 0;
+  auto attempt = [&](int id) {
+    return [&, id]() {
+      ++calls;
+      if (!ready) {
+	scheduler.suspendWritable(semaphore.fd());
+	return false;
+      }
+      order.push_back(id);
+      return true;
+    };
+  };
+
+  scheduler.whenWritable(semaphore.fd(), attempt(1));
+  scheduler.whenWritable(semaphore.fd(), attempt(2));
+  EXPECT_EQ(0, scheduler.runOnce(0));
+  EXPECT_EQ(0, scheduler.runOnce(0));
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(2, scheduler.numWaiters());
+
+  ready = true;
+  scheduler.resumeWritable(semaphore.fd());
+  EXPECT_EQ(2, scheduler.runOnce(0));
+  EXPECT_EQ(std::vector<int>({ 1, 2 }), order);
+  EXPECT_TRUE(scheduler.idle());
+}
+
+TEST(SchedulerTests, RegistrationFromAnotherThreadWakesRunner) {
+  Scheduler scheduler;
+  bool ran = false;
+
+  std::thread other([&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      scheduler.post([&]() { ran = true; });
+  });
+  EXPECT_EQ(1, scheduler.runOnce(1000));
+  other.join();
+  EXPECT_TRUE(ran);
+}
+
+TEST(SchedulerTests, StopEndsRun) {
+  Scheduler scheduler;
+  int n = 0;
+
+  scheduler.post([&]() { ++n; });
+  scheduler.post([&]() { ++n; scheduler.stop(); });
+  scheduler.run();
+  EXPECT_EQ(2, n);
+
+  std::thread other([&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      scheduler.stop();
+  });
+  scheduler.run();
+  other.join();
+}
+
+TEST(SchedulerTests, RunAppliesThreadConfig) {
+  ThreadConfig config;
+  config.name = "reactor";
+  Scheduler scheduler(OnExecMode::CLOSE, config);
+  EXPECT_EQ("reactor", scheduler.threadConfig().name);
+
+  std::string name;
+  std::thread runner([&]() { scheduler.run(); });
+  scheduler.post([&]() {
+      char buffer[16];
+      ::pthread_getname_np(::pthread_self(), buffer, sizeof(buffer));
+      name = buffer;
+      scheduler.stop();
+  });
+  runner.join();
+  EXPECT_EQ("reactor", name);
+}
@@ -148,3 +148,55 @@ TEST(SemaphoreTests, UpTimesOut) {
   EXPECT_FALSE(signaled);
 }
 
+
+TEST(SemaphoreTests, TryDownAndTryUpWithoutBlocking) {
+  Semaphore s(0, OnExecMode::CLOSE, BlockingMode::DONT_BLOCK);
+  EXPECT_EQ(BlockingMode::DONT_BLOCK, s.blockingMode());
+
+  EXPECT_FALSE(s.tryDown());
+  EXPECT_TRUE(s.tryUp(2));
+  EXPECT_TRUE(s.tryDown());
+  EXPECT_TRUE(s.tryDown());
+  EXPECT_FALSE(s.tryDown());
+
+  // The largest count an eventfd can hold is 2^64 - 2
+  EXPECT_TRUE(s.tryUp((uint64_t)-2));
+  EXPECT_FALSE(s.tryUp());
+}
+
+TEST(SemaphoreTests, TryDownInBlockingMode) {
+  Semaphore s;
+  EXPECT_EQ(BlockingMode::BLOCK, s.blockingMode());
+  EXPECT_FALSE(s.tryDown());
+  EXPECT_TRUE(s.tryUp());
+  EXPECT_TRUE(s.tryDown());
+}
+
+TEST(SemaphoreTests, NonblockingDownWaits) {
+  Semaphore s(0, OnExecMode::CLOSE, BlockingMode::DONT_BLOCK);
+  bool signaled = false;
+
+  WorkerThread downThread;
+  downThread.start([&](WorkerThread& t) {
+      goDownWithTimeout(t, s, 1000, signaled);
+  });
+  ASSERT_TRUE(downThread.waitForState(ThreadState::WAITING, 100));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(ThreadState::WAITING, downThread.state());
+  s.up();
+
+  ASSERT_TRUE(downThread.waitForState(ThreadState::DONE, 100));
+  downThread.join();
+  EXPECT_TRUE(signaled);
+  EXPECT_FALSE(s.tryDown());
+}
+
+TEST(SemaphoreTests, NonblockingDownTimesOut) {
+  Semaphore s(0, OnExecMode::CLOSE, BlockingMode::DONT_BLOCK);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(s.down(50));
+  EXPECT_LE(45, std::chrono::duration_cast<std::chrono::milliseconds>(
+		    std::chrono::steady_clock::now() - start
+		).count());
+}
@@ -0,0 +1,259 @@
+#include <pistis/concurrent/pollable/ShardedQueue.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/concurrent/WorkerThread.hpp>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  EpollEventType pollState(ShardedQueue<int>& q) {
+    EpollSet epollSet(q.queueStateFd(),
+		      EpollEventType::READ|EpollEventType::WRITE);
+    if (!epollSet.wait(0) || (epollSet.events().size() != 1)) {
+      return EpollEventType::NONE;
+    }
+    return epollSet.events()[0].events();
+  }
+
+  class NoDefaultItem {
+  public:
+    explicit NoDefaultItem(int v): value(v) { }
+    NoDefaultItem(NoDefaultItem&&) = default;
+    NoDefaultItem& operator=(NoDefaultItem&&) = default;
+
+    int value;
+  };
+}
+
+TEST(ShardedQueueTests, Create) {
+  ShardedQueue<int> q(4);
+
+  EXPECT_EQ(4, q.numShards());
+  EXPECT_GT(4, q.localShard());
+  EXPECT_EQ(0, q.size());
+  EXPECT_TRUE(q.empty());
+  EXPECT_LE(1, ShardedQueue<int>::defaultNumShards());
+  EXPECT_THROW(ShardedQueue<int>(0), IllegalValueError);
+  EXPECT_THROW(ShardedQueue<int>(2, 5, 4), IllegalValueError);
+}
+
+TEST(ShardedQueueTests, PutGetSameThread) {
+  ShardedQueue<int> q(4);
+  std::vector<int> items;
+  int item;
+
+  for (int i = 0; i < 5; ++i) {
+    q.put(i);
+  }
+  EXPECT_EQ(5, q.size());
+
+  while (q.get(item, 0)) {
+    items.push_back(item);
+  }
+  EXPECT_EQ(std::vector<int>({ 0, 1, 2, 3, 4 }), items);
+  EXPECT_EQ(0, q.size());
+}
+
+TEST(ShardedQueueTests, StealFromOtherShard) {
+  ShardedQueue<int> q(64);
+  WorkerThread thread;
+  size_t producerShard = 0;
+
+  thread.start([&](WorkerThread& t) {
+      producerShard = q.localShard();
+      q.put(1);
+      q.put(2);
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+
+  EXPECT_NE(producerShard, q.localShard());
+  EXPECT_EQ(1, q.get());
+  EXPECT_EQ(2, q.get());
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(ShardedQueueTests, ManyProducersManyConsumers) {
+  static const int NUM_THREADS = 4;
+  static const int VALUES_PER_PRODUCER = 2048;
+  ShardedQueue<int> q(NUM_THREADS);
+  std::vector<WorkerThread> producers(NUM_THREADS);
+  std::vector<WorkerThread> consumers(NUM_THREADS);
+  std::vector< std::vector<int> > buffers(NUM_THREADS);
+  std::atomic<int> remaining(NUM_THREADS * VALUES_PER_PRODUCER);
+
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    consumers[i].start([&, i](WorkerThread& t) {
+	int item;
+	while (remaining.load() > 0) {
+	  if (q.get(item, 10)) {
+	    buffers[i].push_back(item);
+	    --remaining;
+	  }
+	}
+	t.setState(ThreadState::DONE);
+    });
+  }
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    producers[i].start([&, i](WorkerThread& t) {
+	for (int j = 0; j < VALUES_PER_PRODUCER; ++j) {
+	  q.put(i * VALUES_PER_PRODUCER + j);
+	}
+	t.setState(ThreadState::DONE);
+    });
+  }
+
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    ASSERT_TRUE(producers[i].waitForState(ThreadState::DONE, 5000));
+    ASSERT_TRUE(consumers[i].waitForState(ThreadState::DONE, 5000));
+    producers[i].join();
+    consumers[i].join();
+  }
+
+  std::vector<int> collected;
+  for (const auto& buffer : buffers) {
+    std::copy(buffer.begin(), buffer.end(), std::back_inserter(collected));
+  }
+  std::sort(collected.begin(), collected.end());
+  ASSERT_EQ(NUM_THREADS * VALUES_PER_PRODUCER, collected.size());
+  for (int i = 0; i < (int)collected.size(); ++i) {
+    ASSERT_EQ(i, collected[i]);
+  }
+  EXPECT_EQ(0, q.size());
+  EXPECT_EQ(EpollEventType::WRITE, pollState(q));
+}
+
+TEST(ShardedQueueTests, GetWaitsForPut) {
+  ShardedQueue<int> q(4);
+  WorkerThread thread;
+  int item = -1;
+  bool found = false;
+
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      found = q.get(item, 1000);
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  q.put(3);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+  EXPECT_TRUE(found);
+  EXPECT_EQ(3, item);
+}
+
+TEST(ShardedQueueTests, GetTimesOut) {
+  ShardedQueue<int> q(4);
+  int item = -1;
+
+  auto start = std::chrono::system_clock::now();
+  EXPECT_FALSE(q.get(item, 50));
+  EXPECT_LE(45, toMs(std::chrono::system_clock::now() - start));
+}
+
+TEST(ShardedQueueTests, ObserveQueueState) {
+  ShardedQueue<int> q(4);
+
+  EXPECT_EQ(EpollEventType::WRITE, pollState(q));
+  q.put(1);
+  EXPECT_EQ(EpollEventType::READ|EpollEventType::WRITE, pollState(q));
+  q.put(2);
+  EXPECT_EQ(EpollEventType::READ|EpollEventType::WRITE, pollState(q));
+  q.get();
+  q.get();
+  EXPECT_EQ(EpollEventType::WRITE, pollState(q));
+}
+
+TEST(ShardedQueueTests, WaterMarks) {
+  ShardedQueue<int> q(4, 1, 3);
+  ShardedQueue<int>::Guard highGuard(q, QueueEventType::HIGH_WATER_MARK);
+  ShardedQueue<int>::Guard lowGuard(q, QueueEventType::LOW_WATER_MARK);
+  EpollSet highSet(highGuard.fd(), EpollEventType::READ);
+  EpollSet lowSet(lowGuard.fd(), EpollEventType::READ);
+
+  q.put(1);
+  q.put(2);
+  q.put(3);
+  EXPECT_FALSE(highSet.wait(0));
+  EXPECT_FALSE(q.aboveHighWaterMark());
+  q.put(4);
+  EXPECT_TRUE(highSet.wait(0));
+  EXPECT_TRUE(q.aboveHighWaterMark());
+  highGuard.ack();
+
+  q.get();
+  q.get();
+  EXPECT_FALSE(lowSet.wait(0));
+  q.get();
+  EXPECT_TRUE(lowSet.wait(0));
+  EXPECT_TRUE(q.atOrBelowLowWaterMark());
+  lowGuard.ack();
+}
+
+TEST(ShardedQueueTests, WaterMarksCountEveryShard) {
+  ShardedQueue<int> q(64, 1, 3);
+  ShardedQueue<int>::Guard highGuard(q, QueueEventType::HIGH_WATER_MARK);
+  EpollSet highSet(highGuard.fd(), EpollEventType::READ);
+  WorkerThread thread;
+
+  thread.start([&](WorkerThread& t) {
+      q.put(1);
+      q.put(2);
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+
+  q.put(3);
+  EXPECT_EQ(3, q.size());
+  EXPECT_FALSE(highSet.wait(0));
+  q.put(4);
+  EXPECT_EQ(4, q.size());
+  EXPECT_TRUE(highSet.wait(0));
+  highGuard.ack();
+}
+
+TEST(ShardedQueueTests, WaitForNotEmpty) {
+  ShardedQueue<int> q(4);
+  WorkerThread thread;
+  bool result = false;
+
+  thread.start([&](WorkerThread& t) {
+      t.setState(ThreadState::WAITING);
+      result = q.wait(1000, QueueEventType::NOT_EMPTY);
+      t.setState(ThreadState::DONE);
+  });
+  ASSERT_TRUE(thread.waitForState(ThreadState::WAITING, 100));
+  ASSERT_TRUE(thread.remainsInState(ThreadState::WAITING, 50));
+
+  q.put(1);
+  ASSERT_TRUE(thread.waitForState(ThreadState::DONE, 100));
+  thread.join();
+  EXPECT_TRUE(result);
+  EXPECT_TRUE(q.wait(0, QueueEventType::NOT_EMPTY));
+}
+
+TEST(ShardedQueueTests, FullEventsNotSupported) {
+  ShardedQueue<int> q(4);
+  EXPECT_THROW(q.observe(QueueEventType::FULL), IllegalValueError);
+  EXPECT_THROW(q.observe(QueueEventType::NOT_FULL), IllegalValueError);
+}
+
+TEST(ShardedQueueTests, ItemWithoutDefaultConstructor) {
+  ShardedQueue<NoDefaultItem> q(2);
+  q.put(NoDefaultItem(1));
+  q.emplace(2);
+
+  EXPECT_EQ(1, q.get().value);
+  EXPECT_EQ(2, q.get().value);
+  EXPECT_TRUE(q.empty());
+}
@@ -0,0 +1,123 @@
+#include <pistis/concurrent/pollable/SharedMutex.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+TEST(SharedMutexTests, SharedAndExclusive) {
+  SharedMutex m;
+
+  EXPECT_TRUE(m.tryLockShared());
+  EXPECT_TRUE(m.tryLockShared());
+  EXPECT_EQ(2, m.numReaders());
+  EXPECT_FALSE(m.tryLock());
+  m.unlockShared();
+  m.unlockShared();
+  EXPECT_EQ(0, m.numReaders());
+
+  m.lock();
+  EXPECT_TRUE(m.lockedExclusive());
+  EXPECT_FALSE(m.tryLockShared());
+  EXPECT_FALSE(m.lockShared(10));
+  m.unlock();
+  EXPECT_FALSE(m.lockedExclusive());
+}
+
+TEST(SharedMutexTests, HandoffGrantsReadersTogether) {
+  SharedMutex m(LockPolicy::HANDOFF);
+  m.lock();
+
+  int r1 = m.observeShared();
+  int r2 = m.observeShared();
+  int w = m.observe();
+  int r3 = m.observeShared();
+  EXPECT_EQ(4, m.numWaiters());
+
+  // Both readers at the front of the line get the lock, but not the
+  // reader behind the writer
+  m.unlock();
+  EXPECT_EQ(2, m.numReaders());
+  EXPECT_TRUE(m.acquire(r1));
+  EXPECT_TRUE(m.acquire(r2));
+  EXPECT_FALSE(m.acquire(w));
+  EXPECT_FALSE(m.acquire(r3));
+
+  // New readers queue behind the writer too
+  EXPECT_FALSE(m.tryLockShared());
+
+  m.unlockShared();
+  EXPECT_FALSE(m.acquire(w));
+  m.unlockShared();
+  EXPECT_TRUE(m.acquire(w));
+  EXPECT_TRUE(m.lockedExclusive());
+
+  m.unlock();
+  EXPECT_TRUE(m.acquire(r3));
+  m.unlockShared();
+  EXPECT_EQ(0, m.numWaiters());
+  EXPECT_TRUE(m.tryLock());
+  m.unlock();
+}
+
+TEST(SharedMutexTests, BargingNotifiesWhenAvailable) {
+  SharedMutex m(LockPolicy::BARGING);
+  m.lockShared();
+
+  int w = m.observe();
+  EpollSet pollSet(w, EpollEventType::READ);
+  EXPECT_FALSE(pollSet.wait(0));
+
+  m.unlockShared();
+  ASSERT_TRUE(pollSet.wait(0));
+  EXPECT_FALSE(m.lockedExclusive());
+  EXPECT_TRUE(m.acquire(w));
+  EXPECT_TRUE(m.lockedExclusive());
+  m.unlock();
+  EXPECT_EQ(0, m.numWaiters());
+}
+
+TEST(SharedMutexTests, ReadersAndWriters) {
+  for (auto policy : { LockPolicy::BARGING, LockPolicy::HANDOFF }) {
+    const int NUM_ITERATIONS = 10000;
+    SharedMutex m(policy);
+    std::atomic<int> readers(0);
+    std::atomic<int> errors(0);
+    int value = 0;
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < 2; ++i) {
+      threads.emplace_back([&]() {
+	  for (int j = 0; j < NUM_ITERATIONS; ++j) {
+	    m.lock();
+	    if (readers.load()) {
+	      ++errors;
+	    }
+	    ++value;
+	    m.unlock();
+	  }
+      });
+      threads.emplace_back([&]() {
+	  for (int j = 0; j < NUM_ITERATIONS; ++j) {
+	    m.lockShared();
+	    ++readers;
+	    volatile int v = value;
+	    (void)v;
+	    --readers;
+	    m.unlockShared();
+	  }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    EXPECT_EQ(0, errors.load());
+    EXPECT_EQ(2 * NUM_ITERATIONS, value);
+    EXPECT_EQ(0, m.numReaders());
+    EXPECT_FALSE(m.lockedExclusive());
+    EXPECT_EQ(0, m.numWaiters());
+  }
+}
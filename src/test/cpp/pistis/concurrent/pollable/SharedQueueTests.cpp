@@ -0,0 +1,239 @@
+#include <pistis/concurrent/pollable/SharedQueue.hpp>
+#include <pistis/exceptions/IllegalValueError.hpp>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+namespace {
+  struct Message {
+    int id;
+    double value;
+    char text[16];
+  };
+
+  short pollState(int fd) {
+    ::pollfd p{ fd, POLLIN | POLLOUT, 0 };
+    return (::poll(&p, 1, 0) == 1) ? p.revents : 0;
+  }
+
+  bool closeOnExec(int fd) {
+    return (::fcntl(fd, F_GETFD) & FD_CLOEXEC) != 0;
+  }
+
+  size_t numOpenFds() {
+    size_t n = 0;
+    DIR* dir = ::opendir("/proc/self/fd");
+    while (::readdir(dir)) {
+      ++n;
+    }
+    ::closedir(dir);
+    return n;
+  }
+
+  /** @brief Send @c fds over @c socket the way SharedQueueSegment::send()
+   *         sends a segment's descriptors
+   */
+  void sendFds(int socket, const std::vector<int>& fds) {
+    char payload = 'Q';
+    struct iovec iov = { &payload, 1 };
+    std::vector<char> control(CMSG_SPACE(fds.size() * sizeof(int)));
+
+    struct msghdr msg;
+    ::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+    ::memcpy(CMSG_DATA(cmsg), fds.data(), fds.size() * sizeof(int));
+    ASSERT_EQ(1, ::sendmsg(socket, &msg, 0));
+  }
+
+  class SocketPair {
+  public:
+    SocketPair() {
+      if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds_) < 0) {
+	fds_[0] = fds_[1] = -1;
+      }
+    }
+    ~SocketPair() {
+      ::close(fds_[0]);
+      ::close(fds_[1]);
+    }
+
+    int first() const { return fds_[0]; }
+    int second() const { return fds_[1]; }
+
+  private:
+    int fds_[2];
+  };
+}
+
+TEST(SharedQueueTests, PutAndGet) {
+  SharedQueue<Message> q(2);
+  Message m;
+
+  EXPECT_EQ(2, q.maxSize());
+  EXPECT_TRUE(q.empty());
+  EXPECT_EQ(POLLOUT, pollState(q.queueStateFd()));
+  EXPECT_FALSE(q.get(m, 0));
+
+  EXPECT_TRUE(q.put(Message{ 1, 1.5, "one" }));
+  EXPECT_EQ(POLLIN | POLLOUT, pollState(q.queueStateFd()));
+  EXPECT_TRUE(q.put(Message{ 2, 2.5, "two" }));
+  EXPECT_EQ(POLLIN, pollState(q.queueStateFd()));
+  EXPECT_FALSE(q.put(Message{ 3, 3.5, "three" }, 10));
+  EXPECT_EQ(2, q.size());
+
+  m = q.get();
+  EXPECT_EQ(1, m.id);
+  EXPECT_EQ(1.5, m.value);
+  EXPECT_STREQ("one", m.text);
+
+  // Wrap around the end of the ring
+  EXPECT_TRUE(q.put(Message{ 3, 3.5, "three" }, 0));
+  std::vector<Message> items;
+  EXPECT_EQ(2, q.drainInto(items));
+  EXPECT_EQ(2, items[0].id);
+  EXPECT_EQ(3, items[1].id);
+  EXPECT_EQ(POLLOUT, pollState(q.queueStateFd()));
+}
+
+TEST(SharedQueueTests, CreateWithIllegalCapacity) {
+  EXPECT_THROW(SharedQueue<int>(0), IllegalValueError);
+}
+
+TEST(SharedQueueTests, SendAndReceive) {
+  SocketPair sockets;
+  SharedQueue<int> producer(4);
+  producer.send(sockets.first());
+  SharedQueue<int> consumer = SharedQueue<int>::receive(sockets.second());
+
+  EXPECT_NE(producer.memoryFd(), consumer.memoryFd());
+  EXPECT_TRUE(closeOnExec(consumer.memoryFd()));
+  EXPECT_TRUE(closeOnExec(consumer.queueStateFd()));
+  EXPECT_EQ(4, consumer.maxSize());
+
+  producer.put(1);
+  producer.put(2);
+  EXPECT_EQ(2, consumer.size());
+  EXPECT_EQ(POLLIN | POLLOUT, pollState(consumer.queueStateFd()));
+  EXPECT_EQ(1, consumer.get());
+
+  // Changes made through either handle show up in both
+  EXPECT_EQ(2, consumer.get());
+  EXPECT_EQ(POLLOUT, pollState(producer.queueStateFd()));
+  EXPECT_EQ(POLLOUT, pollState(consumer.queueStateFd()));
+}
+
+TEST(SharedQueueTests, ReceiveChecksItemSize) {
+  SocketPair sockets;
+  SharedQueue<int> q(4);
+
+  q.send(sockets.first());
+  EXPECT_THROW(SharedQueue<Message>::receive(sockets.second()),
+	       IllegalValueError);
+}
+
+TEST(SharedQueueTests, ReceiveClosesUnexpectedFds) {
+  SocketPair sockets;
+  SharedQueue<int> q(4);
+
+  sendFds(sockets.first(), { q.memoryFd(), q.queueStateFd(),
+			     q.queueControlFd(), q.memoryFd() });
+  const size_t before = numOpenFds();
+  EXPECT_THROW(SharedQueue<int>::receive(sockets.second()),
+	       IllegalValueError);
+  EXPECT_EQ(before, numOpenFds());
+}
+
+TEST(SharedQueueTests, PutAndGetInPlace) {
+  SharedQueue<Message> q(1);
+
+  EXPECT_TRUE(q.putInPlace([](Message& m) {
+      m.id = 1;
+      m.value = 1.5;
+      ::strcpy(m.text, "one");
+  }));
+  EXPECT_FALSE(q.putInPlace([](Message&) { }, 0));
+
+  // An item the consumer fails on stays in the queue
+  EXPECT_THROW(q.getInPlace([](const Message&) {
+		 throw std::runtime_error("oops");
+	       }), std::runtime_error);
+  EXPECT_EQ(1, q.size());
+
+  Message m;
+  EXPECT_TRUE(q.getInPlace([&m](const Message& item) { m = item; }));
+  EXPECT_EQ(1, m.id);
+  EXPECT_EQ(1.5, m.value);
+  EXPECT_STREQ("one", m.text);
+  EXPECT_FALSE(q.getInPlace([](const Message&) { }));
+
+  // Nor is an item put if the producer fails on it
+  EXPECT_THROW(q.putInPlace([](Message&) {
+		 throw std::runtime_error("oops");
+	       }), std::runtime_error);
+  EXPECT_TRUE(q.empty());
+}
+
+TEST(SharedQueueTests, KeepOnExec) {
+  SharedQueue<int> q(4, OnExecMode::KEEP);
+
+  EXPECT_FALSE(closeOnExec(q.memoryFd()));
+  EXPECT_FALSE(closeOnExec(q.queueStateFd()));
+
+  SharedQueue<int> other =
+      SharedQueue<int>::attach(::dup(q.memoryFd()), ::dup(q.queueStateFd()),
+			       ::dup(q.queueControlFd()));
+  q.put(7);
+  EXPECT_EQ(7, other.get());
+}
+
+TEST(SharedQueueTests, ProducerInAnotherProcess) {
+  SocketPair sockets;
+  SharedQueue<Message> q(8);
+  q.send(sockets.first());
+
+  const pid_t child = ::fork();
+  ASSERT_GE(child, 0);
+  if (!child) {
+    SharedQueue<Message> childQueue =
+        SharedQueue<Message>::receive(sockets.second());
+    for (int i = 0; i < 100; ++i) {
+      if (!childQueue.put(Message{ i, i * 0.5, "child" }, 5000)) {
+	::_exit(1);
+      }
+    }
+    ::_exit(0);
+  }
+
+  for (int i = 0; i < 100; ++i) {
+    Message m;
+    ASSERT_TRUE(q.get(m, 5000));
+    EXPECT_EQ(i, m.id);
+    EXPECT_EQ(i * 0.5, m.value);
+    EXPECT_STREQ("child", m.text);
+  }
+
+  int status = -1;
+  ASSERT_EQ(child, ::waitpid(child, &status, 0));
+  EXPECT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(0, WEXITSTATUS(status));
+  EXPECT_TRUE(q.empty());
+}
@@ -0,0 +1,27 @@
+#include <pistis/concurrent/pollable/Signal.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <gtest/gtest.h>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+
+TEST(SignalTests, SetAndClear) {
+  Signal s;
+  EpollSet pollSet(s.fd(), EpollEventType::READ);
+
+  EXPECT_FALSE(s.isSet());
+  EXPECT_FALSE(s.wait(0));
+  EXPECT_FALSE(pollSet.wait(0));
+
+  s.set();
+  s.set();
+  EXPECT_TRUE(s.isSet());
+  EXPECT_TRUE(s.wait(0));
+  EXPECT_TRUE(pollSet.wait(0));
+
+  s.clear();
+  EXPECT_FALSE(s.isSet());
+  EXPECT_FALSE(pollSet.wait(0));
+  s.clear();
+  EXPECT_FALSE(s.wait(10));
+}
@@ -0,0 +1,67 @@
+#include <pistis/concurrent/pollable/WaitGroup.hpp>
+#include <pistis/concurrent/EpollSet.hpp>
+#include <pistis/exceptions/IllegalStateError.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace pistis::concurrent;
+using namespace pistis::concurrent::pollable;
+using namespace pistis::exceptions;
+
+TEST(WaitGroupTests, AddAndDone) {
+  WaitGroup group;
+  EpollSet pollSet(group.fd(), EpollEventType::READ);
+
+  EXPECT_EQ(0, group.count());
+  EXPECT_TRUE(group.wait(0));
+  EXPECT_TRUE(pollSet.wait(0));
+
+  group.add(2);
+  EXPECT_EQ(2, group.count());
+  EXPECT_FALSE(group.wait(0));
+  EXPECT_FALSE(pollSet.wait(0));
+
+  group.done();
+  EXPECT_FALSE(pollSet.wait(0));
+  group.done();
+  EXPECT_TRUE(pollSet.wait(0));
+  EXPECT_THROW(group.done(), IllegalStateError);
+
+  // Starts another phase with the same fd
+  group.add();
+  EXPECT_FALSE(pollSet.wait(0));
+  group.done();
+  EXPECT_TRUE(group.wait(0));
+}
+
+TEST(WaitGroupTests, ManyThreads) {
+  const int NUM_THREADS = 4;
+  const int NUM_TASKS = 10000;
+  WaitGroup group;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&group]() {
+	for (int j = 0; j < NUM_TASKS; ++j) {
+	  group.add();
+	  group.done();
+	}
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, group.count());
+  EXPECT_TRUE(group.wait(0));
+
+  group.add(NUM_THREADS);
+  threads.clear();
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back([&group]() { group.done(); });
+  }
+  EXPECT_TRUE(group.wait(1000));
+  for (auto& t : threads) {
+    t.join();
+  }
+}